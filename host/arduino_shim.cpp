@@ -0,0 +1,85 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include <time.h>
+#include <inttypes.h>
+
+// Host implementation of the Arduino core subset declared in host/shim/Arduino.h
+
+HostSerial Serial;
+
+static uint64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+// Like on the board, the time base starts at (roughly) program start
+static const uint64_t start_us = monotonic_us();
+
+unsigned long millis(void) {
+    return (unsigned long)((monotonic_us() - start_us) / 1000ULL);
+}
+
+unsigned long micros(void) {
+    return (unsigned long)(monotonic_us() - start_us);
+}
+
+void delay(unsigned long ms) {
+    // The pipeline sprinkles delay() calls to let the SD driver settle;
+    // on the host there is nothing to wait for, so these are no-ops
+    (void)ms;
+}
+
+size_t HostSerial::print(const char* str) {
+    if (!enabled || !str) return 0;
+    return (size_t)fprintf(stderr, "%s", str);
+}
+
+size_t HostSerial::print(char c) {
+    if (!enabled) return 0;
+    fputc(c, stderr);
+    return 1;
+}
+
+size_t HostSerial::print(int value, int base) {
+    return print((long long)value, base);
+}
+
+size_t HostSerial::print(unsigned int value, int base) {
+    return print((unsigned long long)value, base);
+}
+
+size_t HostSerial::print(long value, int base) {
+    return print((long long)value, base);
+}
+
+size_t HostSerial::print(unsigned long value, int base) {
+    return print((unsigned long long)value, base);
+}
+
+size_t HostSerial::print(long long value, int base) {
+    if (!enabled) return 0;
+    if (base == HEX) return (size_t)fprintf(stderr, "%llX", (unsigned long long)value);
+    return (size_t)fprintf(stderr, "%lld", value);
+}
+
+size_t HostSerial::print(unsigned long long value, int base) {
+    if (!enabled) return 0;
+    if (base == HEX) return (size_t)fprintf(stderr, "%llX", value);
+    return (size_t)fprintf(stderr, "%llu", value);
+}
+
+size_t HostSerial::print(double value, int digits) {
+    if (!enabled) return 0;
+    return (size_t)fprintf(stderr, "%.*f", digits, value);
+}
+
+size_t HostSerial::println() {
+    if (!enabled) return 0;
+    fputc('\n', stderr);
+    return 1;
+}
+
+void HostSerial::flush() {
+    fflush(stderr);
+}
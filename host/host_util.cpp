@@ -0,0 +1,185 @@
+#include "host_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <strings.h>
+#include <time.h>
+
+#include "filesystem_interface.h"
+#include "camera_yuv.h"
+
+const char* const Y_FILE = "_y_channel.tmp";
+const char* const U_FILE = "_u_channel.tmp";
+const char* const V_FILE = "_v_channel.tmp";
+const char* const RESULT_FILE = "_icer_result.tmp";
+const char* const Y_DECODED_FILE = "_y_decoded.tmp";
+const char* const U_DECODED_FILE = "_u_decoded.tmp";
+const char* const V_DECODED_FILE = "_v_decoded.tmp";
+
+double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+bool has_suffix(const char* str, const char* suffix) {
+    size_t len = strlen(str);
+    size_t suffix_len = strlen(suffix);
+    return len >= suffix_len && strcasecmp(str + len - suffix_len, suffix) == 0;
+}
+
+const char* base_name(const char* path) {
+    const char* slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+bool parse_list(const char* text, NumberList* list) {
+    list->count = 0;
+    const char* p = text;
+    while (*p) {
+        char* end = NULL;
+        double value = strtod(p, &end);
+        if (end == p || value < 0 || list->count >= MAX_LIST) {
+            return false;
+        }
+        list->values[list->count++] = value;
+        p = end;
+        if (*p == ',') {
+            p++;
+        } else if (*p) {
+            return false;
+        }
+    }
+    return list->count > 0;
+}
+
+uint8_t* read_whole_file(const char* path, size_t* out_size) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) {
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    long len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (len <= 0) {
+        fclose(fp);
+        return NULL;
+    }
+    uint8_t* buf = (uint8_t*)malloc((size_t)len);
+    if (!buf) {
+        fclose(fp);
+        return NULL;
+    }
+    size_t got = fread(buf, 1, (size_t)len, fp);
+    fclose(fp);
+    if (got != (size_t)len) {
+        free(buf);
+        return NULL;
+    }
+    *out_size = (size_t)len;
+    return buf;
+}
+
+uint8_t* read_fs_file(IFileSystem* fs, const char* name, size_t expected) {
+    IFile* file = fs->open(name, FILE_READ);
+    if (!file) {
+        return NULL;
+    }
+    uint8_t* data = (uint8_t*)malloc(expected > 0 ? expected : 1);
+    size_t got = data ? file->read(data, expected) : 0;
+    file->close();
+    delete file;
+    if (got != expected) {
+        free(data);
+        return NULL;
+    }
+    return data;
+}
+
+bool write_fs_file(IFileSystem* fs, const char* name, const uint8_t* data, size_t size) {
+    fs->remove(name);
+    IFile* file = fs->open(name, FILE_WRITE);
+    if (!file) {
+        return false;
+    }
+    size_t written = file->write(data, size);
+    file->close();
+    delete file;
+    return written == size;
+}
+
+bool alloc_planes(Planes* planes, size_t width, size_t height) {
+    planes->width = width;
+    planes->height = height;
+    bool ok = true;
+    for (int c = 0; c < 3; c++) {
+        planes->chan[c] = (uint16_t*)malloc(width * height * sizeof(uint16_t));
+        ok = ok && planes->chan[c] != NULL;
+    }
+    if (!ok) {
+        free_planes(planes);
+    }
+    return ok;
+}
+
+void free_planes(Planes* planes) {
+    for (int c = 0; c < 3; c++) {
+        free(planes->chan[c]);
+        planes->chan[c] = NULL;
+    }
+}
+
+void make_synthetic_rgb(uint8_t* rgb, size_t width, size_t height) {
+    uint32_t rng = 0x9E3779B9u;
+    size_t horizon = height * 2 / 5;
+    for (size_t y = 0; y < height; y++) {
+        for (size_t x = 0; x < width; x++) {
+            double u = (double)x / width;
+            double v = (double)y / height;
+            double r, g, b;
+            if (y < horizon) {
+                r = 90 + 80 * v;
+                g = 140 + 60 * v;
+                b = 230 - 30 * v;
+            } else {
+                double texture = 20 * sin(u * 70 + 9 * sin(v * 23)) * sin(v * 90);
+                r = 120 + 40 * u + texture;
+                g = 100 + 30 * v + texture;
+                b = 70 + texture / 2;
+            }
+            // Objects: a bright disc and a dark bar, with hard edges
+            double dx = u - 0.7, dy = v - 0.3;
+            if (dx * dx + dy * dy < 0.01) {
+                r = 250; g = 240; b = 200;
+            }
+            if (u > 0.15 && u < 0.25 && v > 0.35 && v < 0.85) {
+                r = 40; g = 35; b = 30;
+            }
+            rng ^= rng << 13;
+            rng ^= rng >> 17;
+            rng ^= rng << 5;
+            double noise = (double)(rng % 9) - 4;
+            uint8_t* px = rgb + (y * width + x) * 3;
+            px[0] = clampToUint8((int32_t)(r + noise));
+            px[1] = clampToUint8((int32_t)(g + noise));
+            px[2] = clampToUint8((int32_t)(b + noise));
+        }
+    }
+}
+
+bool make_synthetic_planes(Planes* planes, size_t width, size_t height) {
+    uint8_t* rgb = (uint8_t*)malloc(width * height * 3);
+    if (!rgb || !alloc_planes(planes, width, height)) {
+        free(rgb);
+        return false;
+    }
+    make_synthetic_rgb(rgb, width, height);
+    for (size_t i = 0; i < width * height; i++) {
+        const uint8_t* px = rgb + i * 3;
+        rgb_to_yuv(px[0], px[1], px[2], &planes->chan[0][i], &planes->chan[1][i], &planes->chan[2][i]);
+    }
+    free(rgb);
+    return true;
+}
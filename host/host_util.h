@@ -0,0 +1,92 @@
+// Helpers shared by the host tools: timing, whole-file I/O on the host and on
+// an IFileSystem, command line lists and the names of the intermediate files
+
+#ifndef HOST_UTIL_H
+#define HOST_UTIL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+class IFileSystem;
+
+// Intermediate files, same names as main.cpp uses on the SD card
+extern const char* const Y_FILE;
+extern const char* const U_FILE;
+extern const char* const V_FILE;
+extern const char* const RESULT_FILE;
+extern const char* const Y_DECODED_FILE;
+extern const char* const U_DECODED_FILE;
+extern const char* const V_DECODED_FILE;
+
+#define MAX_LIST 16
+
+// Frame formats the host tools read
+enum InputFormat {
+    INPUT_AUTO,     // Not given; the tools pick JPEG for .jpg/.jpeg
+    INPUT_JPEG,     // JPEG, decoded with tjpgd (same as on the board)
+    INPUT_YUV422,   // 8-bit interleaved YUYV as delivered by the camera
+    INPUT_YUV16     // Planar uint16 Y, U, V planes back to back
+};
+
+// A comma separated list of numbers from the command line
+struct NumberList {
+    double values[MAX_LIST];
+    int count;
+};
+
+// One frame as uint16 Y, U, V planes (malloc'ed)
+struct Planes {
+    size_t width;
+    size_t height;
+    uint16_t* chan[3];
+};
+
+// Monotonic wall clock in milliseconds
+double now_ms(void);
+
+// true if str ends with suffix, ignoring case
+bool has_suffix(const char* str, const char* suffix);
+
+// Last component of a path
+const char* base_name(const char* path);
+
+// Parse "1,2.5,4" into list; false on an empty, negative or malformed entry,
+// or more than MAX_LIST entries
+bool parse_list(const char* text, NumberList* list);
+
+// Read a whole host file into a malloc'ed buffer; NULL if it cannot be read or
+// is empty
+uint8_t* read_whole_file(const char* path, size_t* out_size);
+
+// Read exactly expected bytes of a file of the file system into a malloc'ed
+// buffer; NULL on failure or a short file
+uint8_t* read_fs_file(IFileSystem* fs, const char* name, size_t expected);
+
+// Replace a file of the file system with size bytes of data
+bool write_fs_file(IFileSystem* fs, const char* name, const uint8_t* data, size_t size);
+
+// Split a frame into the channel files Y_FILE, U_FILE, V_FILE of fs, through
+// the converters the board uses. A JPEG sets *width and *height; raw formats
+// take them as given. (host_util_ingest.cpp, needs the pipeline library)
+// Returns 0 on success, -1 if a raw frame is smaller than width x height, -2 on
+// a write error, or the converter's error; no channel file is left on failure
+int ingest_frame(IFileSystem* fs, const uint8_t* input, size_t input_size, InputFormat format, size_t* width,
+                 size_t* height);
+
+// Allocate the three planes of a width x height frame; false if out of memory
+// (the planes are freed again)
+bool alloc_planes(Planes* planes, size_t width, size_t height);
+
+// Free the planes (NULL planes are fine)
+void free_planes(Planes* planes);
+
+// A camera-like scene as RGB888 (width * height * 3 bytes): sky gradient,
+// horizon, textured ground, a bright disc and a dark bar with hard edges, and
+// sensor noise. Deterministic, so runs on different commits see the same input
+void make_synthetic_rgb(uint8_t* rgb, size_t width, size_t height);
+
+// The same scene as Y, U, V planes, converted with rgb_to_yuv as the camera
+// converters do; false if out of memory
+bool make_synthetic_planes(Planes* planes, size_t width, size_t height);
+
+#endif // HOST_UTIL_H
@@ -0,0 +1,42 @@
+// ingest_frame() of host_util.h, in its own object because it calls into the
+// pipeline library, which icer_host_decompress does not link
+
+#include "host_util.h"
+
+#include <Camera.h>
+#include <stdio.h>
+
+#include "filesystem_interface.h"
+#include "camera_yuv.h"
+
+int ingest_frame(IFileSystem* fs, const uint8_t* input, size_t input_size, InputFormat format, size_t* width,
+                 size_t* height) {
+    int result = 0;
+    if (format == INPUT_JPEG) {
+        CamImage img((uint8_t*)input, input_size);  // Only read
+        result = convertJpegToSeparateChannels(img, width, height, Y_FILE, U_FILE, V_FILE, fs);
+    } else if (format == INPUT_YUV422) {
+        if (input_size < *width * *height * 2) {
+            fprintf(stderr, "Input too small for %zux%zu YUV422\n", *width, *height);
+            result = -1;
+        } else {
+            result = convertYuv422ToSeparateChannels(input, *width, *height, Y_FILE, U_FILE, V_FILE, fs);
+        }
+    } else {
+        size_t plane_size = *width * *height * sizeof(uint16_t);
+        if (input_size < plane_size * 3) {
+            fprintf(stderr, "Input too small for %zux%zu planar uint16 YUV\n", *width, *height);
+            result = -1;
+        } else if (!write_fs_file(fs, Y_FILE, input, plane_size) ||
+                   !write_fs_file(fs, U_FILE, input + plane_size, plane_size) ||
+                   !write_fs_file(fs, V_FILE, input + 2 * plane_size, plane_size)) {
+            result = -2;
+        }
+    }
+    if (result != 0) {
+        fs->remove(Y_FILE);
+        fs->remove(U_FILE);
+        fs->remove(V_FILE);
+    }
+    return result;
+}
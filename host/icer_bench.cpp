@@ -0,0 +1,841 @@
+// Micro-benchmarks of the ICER kernels on the host
+//
+// Times the inner loops of the encoder in isolation so a kernel-level change
+// can be measured instead of argued from millis() printouts on the board:
+//   wavelet_1d        icer_wavelet_transform_1d_uint16, per filter and length
+//   bitplane          icer_compress_bitplane_uint16, per subband type and lsb,
+//                     on synthetic (Laplacian) and, with --image, real subbands
+//   encode_bit        icer_encode_bit (including icer_compute_bin and the
+//                     icer_popbuf_while_avail it calls)
+//   compute_bin       icer_compute_bin
+//   popbuf            icer_popbuf_while_avail draining a full circular buffer
+//   crc32buf          crc32buf, per buffer length
+//   deinterleave      icer_deinterleave_uint16, per length
+//   rgb_to_yuv        rgb_to_yuv (camera_yuv.h), per pixel
+//   sign_magnitude    icer_to_sign_magnitude_int16
+//
+// Each benchmark is calibrated to run for --min-time ms and repeated --repeat
+// times; the fastest repetition is reported as ns per sample and MB/s of input
+// (a sample is a pixel or coefficient, a bit for encode_bit and compute_bin, a
+// codeword for popbuf and a byte for crc32buf). Kernels that modify their input
+// in a way that changes the work (wavelet_1d, sign_magnitude) restore it with a
+// memcpy of the same size each iteration, which is included in the time.
+//
+// Usage:
+//   icer_bench [options]
+//   icer_bench --json base.json                  (on the old commit)
+//   icer_bench --compare base.json               (on the new one)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+
+#include "camera_yuv.h"
+
+extern "C" {
+#include "icer.h"
+#include "crc.h"
+}
+
+// Synthetic subbands are about one segment of a 1280x960 frame
+#define BENCH_SUBBAND_W 160
+#define BENCH_SUBBAND_H 120
+#define BENCH_BITS 65536
+#define BENCH_PIXELS 65536
+#define BENCH_MAX_RESULTS 256
+
+typedef void (*BenchFn)(void* state, size_t iterations);
+
+struct BenchResult {
+    char name[96];
+    size_t samples;         // per iteration
+    size_t iterations;      // per repetition
+    double ns_per_sample;
+    double mb_per_s;
+};
+
+struct BenchOptions {
+    const char* only;
+    double min_time_ms;
+    int repeat;
+};
+
+static BenchResult results[BENCH_MAX_RESULTS];
+static size_t result_count = 0;
+
+// Results are consumed here so the compiler cannot drop a kernel
+static volatile uint32_t bench_sink;
+
+// The result table, stderr when the JSON goes to stdout
+static FILE* report;
+
+static void print_usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "\n"
+            "Options:\n"
+            "  --image FILE                Also benchmark the bitplane coder on the subbands of a real frame\n"
+            "  --format yuv422|yuv16       Format of --image (default yuv422)\n"
+            "  --width N, --height N       Size of --image\n"
+            "  --only TEXT                 Run only benchmarks whose name contains TEXT\n"
+            "  --min-time MS               Time per repetition (default 50)\n"
+            "  --repeat N                  Repetitions, the fastest is reported (default 3)\n"
+            "  --json FILE                 Write the results as JSON (- = stdout)\n"
+            "  --label TEXT                Label stored in the JSON, e.g. the commit\n"
+            "  --compare FILE              Show the speedup against an earlier --json file\n",
+            prog);
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Deterministic xorshift32, so every run and every commit sees the same data
+static uint32_t rng_state = 0x12345678u;
+
+static uint32_t rng_next(void) {
+    uint32_t x = rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    rng_state = x;
+    return x;
+}
+
+// Uniform in (0, 1)
+static double rng_uniform(void) {
+    return ((rng_next() >> 8) + 0.5) / 16777216.0;
+}
+
+// Laplacian with the given scale, the usual model of wavelet detail coefficients
+static int32_t rng_laplace(double scale) {
+    double magnitude = -scale * log(rng_uniform());
+    int32_t value = (int32_t)(magnitude + 0.5);
+    return (rng_next() & 1) ? -value : value;
+}
+
+static uint16_t to_sign_magnitude(int32_t value) {
+    if (value > 0x7FFF) value = 0x7FFF;
+    if (value < -0x7FFF) value = -0x7FFF;
+    return (value < 0) ? (uint16_t)(0x8000 | -value) : (uint16_t)value;
+}
+
+// Calibrate the iteration count to min_time_ms, then keep the fastest of the repetitions
+static void run_bench(const BenchOptions* options, const char* name, size_t samples, double bytes_per_sample,
+                      BenchFn fn, void* state) {
+    if (options->only && !strstr(name, options->only)) {
+        return;
+    }
+    if (result_count == BENCH_MAX_RESULTS) {
+        fprintf(stderr, "Too many benchmarks, %s skipped\n", name);
+        return;
+    }
+
+    size_t iterations = 1;
+    double min_ns = options->min_time_ms * 1e6;
+    for (;;) {
+        double start = now_ns();
+        fn(state, iterations);
+        double elapsed = now_ns() - start;
+        if (elapsed >= min_ns / 4 || iterations >= ((size_t)1 << 40)) {
+            if (elapsed > 0) {
+                double scaled = iterations * (min_ns / elapsed);
+                iterations = (scaled < 1.0) ? 1 : (size_t)scaled;
+            }
+            break;
+        }
+        iterations *= 4;
+    }
+
+    double best_ns = 0;
+    for (int rep = 0; rep < options->repeat; rep++) {
+        double start = now_ns();
+        fn(state, iterations);
+        double elapsed = now_ns() - start;
+        if (rep == 0 || elapsed < best_ns) {
+            best_ns = elapsed;
+        }
+    }
+
+    BenchResult* result = &results[result_count++];
+    snprintf(result->name, sizeof(result->name), "%s", name);
+    result->samples = samples;
+    result->iterations = iterations;
+    result->ns_per_sample = best_ns / ((double)iterations * samples);
+    result->mb_per_s = (result->ns_per_sample > 0) ? bytes_per_sample * 1e3 / result->ns_per_sample : 0;
+    fprintf(report, "%-44s %10.3f ns/sample %10.1f MB/s\n", result->name, result->ns_per_sample, result->mb_per_s);
+    fflush(report);
+}
+
+// ---------------------------------------------------------------------------
+// Kernels
+// ---------------------------------------------------------------------------
+
+struct WaveletState {
+    const uint16_t* source;
+    uint16_t* work;
+    size_t length;
+    enum icer_filter_types filter;
+};
+
+static void bench_wavelet_1d(void* context, size_t iterations) {
+    WaveletState* state = static_cast<WaveletState*>(context);
+    uint32_t overflow = 0;
+    for (size_t it = 0; it < iterations; it++) {
+        memcpy(state->work, state->source, state->length * sizeof(uint16_t));
+        overflow += icer_wavelet_transform_1d_uint16(state->work, state->length, 1, state->filter);
+    }
+    bench_sink = overflow + state->work[0];
+}
+
+struct BitplaneState {
+    const uint16_t* data;
+    size_t width;
+    size_t height;
+    size_t rowstride;
+    icer_packet_context pkt_context;
+    uint16_t* circ_buf;
+    uint8_t* output;
+    size_t output_size;
+    int result;
+};
+
+static void bench_bitplane(void* context, size_t iterations) {
+    BitplaneState* state = static_cast<BitplaneState*>(context);
+    icer_context_model_typedef context_model;
+    icer_encoder_context_typedef encoder_context;
+    size_t output_bits = 0;
+    for (size_t it = 0; it < iterations; it++) {
+        icer_init_context_model_vals(&context_model, (enum icer_subband_types)state->pkt_context.subband_type);
+        icer_init_entropy_coder_context(&encoder_context, state->circ_buf, ICER_CIRC_BUF_SIZE,
+                                        state->output, state->output_size);
+        int res = icer_compress_bitplane_uint16(state->data, state->width, state->height, state->rowstride,
+                                                &context_model, &encoder_context, &state->pkt_context);
+        if (res != ICER_RESULT_OK) {
+            state->result = res;
+        }
+        output_bits += encoder_context.output_ind * 8 + encoder_context.output_bit_offset;
+    }
+    bench_sink = (uint32_t)output_bits;
+}
+
+struct EncodeBitState {
+    const uint8_t* bits;
+    const uint32_t* zero_counts;
+    const uint32_t* total_counts;
+    size_t count;
+    uint16_t* circ_buf;
+    uint8_t* output;
+    size_t output_size;
+    int result;
+};
+
+static void bench_encode_bit(void* context, size_t iterations) {
+    EncodeBitState* state = static_cast<EncodeBitState*>(context);
+    icer_encoder_context_typedef encoder_context;
+    for (size_t it = 0; it < iterations; it++) {
+        icer_init_entropy_coder_context(&encoder_context, state->circ_buf, ICER_CIRC_BUF_SIZE,
+                                        state->output, state->output_size);
+        for (size_t i = 0; i < state->count; i++) {
+            int res = icer_encode_bit(&encoder_context, state->bits[i], state->zero_counts[i], state->total_counts[i]);
+            if (res != ICER_RESULT_OK) {
+                state->result = res;
+                break;
+            }
+        }
+    }
+    bench_sink = (uint32_t)encoder_context.output_ind;
+}
+
+static void bench_compute_bin(void* context, size_t iterations) {
+    EncodeBitState* state = static_cast<EncodeBitState*>(context);
+    uint32_t sum = 0;
+    for (size_t it = 0; it < iterations; it++) {
+        for (size_t i = 0; i < state->count; i++) {
+            sum += (uint32_t)icer_compute_bin(state->zero_counts[i], state->total_counts[i]);
+        }
+    }
+    bench_sink = sum;
+}
+
+struct PopbufState {
+    const uint16_t* codewords;     // ICER_CIRC_BUF_SIZE finished codewords
+    uint16_t* circ_buf;
+    uint8_t* output;
+    size_t output_size;
+    int result;
+};
+
+static void bench_popbuf(void* context, size_t iterations) {
+    PopbufState* state = static_cast<PopbufState*>(context);
+    icer_encoder_context_typedef encoder_context;
+    for (size_t it = 0; it < iterations; it++) {
+        icer_init_entropy_coder_context(&encoder_context, state->circ_buf, ICER_CIRC_BUF_SIZE,
+                                        state->output, state->output_size);
+        memcpy(state->circ_buf, state->codewords, ICER_CIRC_BUF_SIZE * sizeof(uint16_t));
+        encoder_context.used = ICER_CIRC_BUF_SIZE;
+        int res = icer_popbuf_while_avail(&encoder_context);
+        if (res != ICER_RESULT_OK) {
+            state->result = res;
+        }
+    }
+    bench_sink = (uint32_t)encoder_context.output_ind;
+}
+
+struct BufferState {
+    uint8_t* data;
+    size_t length;
+};
+
+static void bench_crc32buf(void* context, size_t iterations) {
+    BufferState* state = static_cast<BufferState*>(context);
+    uint32_t crc = 0;
+    for (size_t it = 0; it < iterations; it++) {
+        crc ^= crc32buf((char*)state->data, state->length);
+    }
+    bench_sink = crc;
+}
+
+struct Uint16State {
+    const uint16_t* source;
+    uint16_t* work;
+    size_t length;
+};
+
+static void bench_deinterleave(void* context, size_t iterations) {
+    Uint16State* state = static_cast<Uint16State*>(context);
+    // A permutation, so it can be applied over and over without restoring the input
+    for (size_t it = 0; it < iterations; it++) {
+        icer_deinterleave_uint16(state->work, state->length, 1);
+    }
+    bench_sink = state->work[state->length / 2];
+}
+
+static void bench_sign_magnitude(void* context, size_t iterations) {
+    Uint16State* state = static_cast<Uint16State*>(context);
+    for (size_t it = 0; it < iterations; it++) {
+        memcpy(state->work, state->source, state->length * sizeof(uint16_t));
+        icer_to_sign_magnitude_int16(state->work, state->length);
+    }
+    bench_sink = state->work[state->length / 2];
+}
+
+struct RgbState {
+    const uint8_t* rgb;
+    uint16_t* y;
+    uint16_t* u;
+    uint16_t* v;
+    size_t pixels;
+};
+
+static void bench_rgb_to_yuv(void* context, size_t iterations) {
+    RgbState* state = static_cast<RgbState*>(context);
+    for (size_t it = 0; it < iterations; it++) {
+        for (size_t i = 0; i < state->pixels; i++) {
+            rgb_to_yuv(state->rgb[3 * i], state->rgb[3 * i + 1], state->rgb[3 * i + 2],
+                       &state->y[i], &state->u[i], &state->v[i]);
+        }
+    }
+    bench_sink = state->y[state->pixels / 2] + state->u[0] + state->v[0];
+}
+
+// ---------------------------------------------------------------------------
+// Benchmark groups
+// ---------------------------------------------------------------------------
+
+static const char* const FILTER_NAMES[] = {"A", "B", "C", "D", "E", "F", "Q"};
+static const char* const SUBBAND_NAMES[] = {"LL", "HL", "LH", "HH"};
+
+// A smooth row with texture and noise, in the 8-bit range of the camera channels
+static void fill_image_row(uint16_t* row, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        double smooth = 128.0 + 80.0 * sin(i * 0.013) + 20.0 * sin(i * 0.21);
+        int32_t value = (int32_t)smooth + rng_laplace(3.0);
+        row[i] = (uint16_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+    }
+}
+
+static void run_wavelet_benches(const BenchOptions* options) {
+    static const size_t lengths[] = {64, 640, 1280};
+    for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+        size_t length = lengths[l];
+        uint16_t* source = (uint16_t*)malloc(length * sizeof(uint16_t));
+        uint16_t* work = (uint16_t*)malloc(length * sizeof(uint16_t));
+        fill_image_row(source, length);
+        for (int filter = ICER_FILTER_A; filter <= ICER_FILTER_Q; filter++) {
+            WaveletState state = {source, work, length, (enum icer_filter_types)filter};
+            char name[96];
+            snprintf(name, sizeof(name), "wavelet_1d/filter=%s/len=%zu", FILTER_NAMES[filter], length);
+            run_bench(options, name, length, sizeof(uint16_t), bench_wavelet_1d, &state);
+        }
+        free(source);
+        free(work);
+    }
+}
+
+// One subband for the bitplane benchmarks, sign-magnitude coefficients with rowstride
+struct Subband {
+    const uint16_t* data;
+    size_t width;
+    size_t height;
+    size_t rowstride;
+    uint8_t decomp_level;
+};
+
+static int run_bitplane_benches(const BenchOptions* options, const char* source, const Subband subbands[ICER_SUBBAND_MAX + 1]) {
+    BitplaneState state;
+    memset(&state, 0, sizeof(state));
+    state.circ_buf = (uint16_t*)malloc(ICER_CIRC_BUF_SIZE * sizeof(uint16_t));
+    size_t largest = 0;
+    for (int subband = 0; subband <= ICER_SUBBAND_MAX; subband++) {
+        if (subbands[subband].width * subbands[subband].height > largest) {
+            largest = subbands[subband].width * subbands[subband].height;
+        }
+    }
+    // One plane codes at most a magnitude and a sign bit per coefficient, plus the code overhead
+    state.output_size = largest * 2 + 1024;
+    state.output = (uint8_t*)malloc(state.output_size);
+    if (!state.circ_buf || !state.output) {
+        free(state.circ_buf);
+        free(state.output);
+        return -1;
+    }
+
+    int result = 0;
+    for (int subband = 0; subband <= ICER_SUBBAND_MAX && result == 0; subband++) {
+        const Subband* band = &subbands[subband];
+        if (band->width == 0 || band->height == 0) {
+            continue;
+        }
+        state.data = band->data;
+        state.width = band->width;
+        state.height = band->height;
+        state.rowstride = band->rowstride;
+        for (int lsb = ICER_BITPLANES_TO_COMPRESS_16 - 1; lsb >= 0; lsb--) {
+            memset(&state.pkt_context, 0, sizeof(state.pkt_context));
+            state.pkt_context.subband_type = (uint8_t)subband;
+            state.pkt_context.decomp_level = band->decomp_level;
+            state.pkt_context.lsb = (uint8_t)lsb;
+            state.result = ICER_RESULT_OK;
+
+            char name[96];
+            snprintf(name, sizeof(name), "bitplane/%s/subband=%s/lsb=%d", source, SUBBAND_NAMES[subband], lsb);
+            run_bench(options, name, band->width * band->height, sizeof(uint16_t), bench_bitplane, &state);
+            if (state.result != ICER_RESULT_OK) {
+                fprintf(stderr, "%s: icer_compress_bitplane_uint16 failed: %d\n", name, state.result);
+                result = state.result;
+                break;
+            }
+        }
+    }
+
+    free(state.circ_buf);
+    free(state.output);
+    return result;
+}
+
+// Laplacian subbands with the spread of typical camera frames after 4 stages
+static int run_synthetic_bitplane_benches(const BenchOptions* options) {
+    static const double scales[ICER_SUBBAND_MAX + 1] = {40.0, 6.0, 6.0, 3.0};
+    size_t pixels = BENCH_SUBBAND_W * BENCH_SUBBAND_H;
+    uint16_t* planes = (uint16_t*)malloc((ICER_SUBBAND_MAX + 1) * pixels * sizeof(uint16_t));
+    if (!planes) {
+        return -1;
+    }
+    Subband subbands[ICER_SUBBAND_MAX + 1];
+    for (int subband = 0; subband <= ICER_SUBBAND_MAX; subband++) {
+        uint16_t* plane = planes + subband * pixels;
+        for (size_t i = 0; i < pixels; i++) {
+            plane[i] = to_sign_magnitude(rng_laplace(scales[subband]));
+        }
+        subbands[subband].data = plane;
+        subbands[subband].width = BENCH_SUBBAND_W;
+        subbands[subband].height = BENCH_SUBBAND_H;
+        subbands[subband].rowstride = BENCH_SUBBAND_W;
+        subbands[subband].decomp_level = (subband == ICER_SUBBAND_LL) ? 4 : 1;
+    }
+    int result = run_bitplane_benches(options, "synthetic", subbands);
+    free(planes);
+    return result;
+}
+
+// The Y channel of a frame, transformed the way icer_compress_image_uint16 does it:
+// the detail subbands of the first stage and the LL subband of the last one
+static int run_image_bitplane_benches(const BenchOptions* options, const uint16_t* y, size_t width, size_t height) {
+    const uint8_t stages = 4;
+    uint16_t* image = (uint16_t*)malloc(width * height * sizeof(uint16_t));
+    if (!image) {
+        return -1;
+    }
+    memcpy(image, y, width * height * sizeof(uint16_t));
+
+    int res = icer_wavelet_transform_stages_uint16(image, width, height, stages, ICER_FILTER_A);
+    if (res != ICER_RESULT_OK) {
+        fprintf(stderr, "Wavelet transform of the image failed: %d\n", res);
+        free(image);
+        return res;
+    }
+
+    size_t ll_w = icer_get_dim_n_low_stages(width, stages);
+    size_t ll_h = icer_get_dim_n_low_stages(height, stages);
+    uint64_t sum = 0;
+    for (size_t row = 0; row < ll_h; row++) {
+        for (size_t col = 0; col < ll_w; col++) {
+            sum += image[row * width + col];
+        }
+    }
+    int16_t ll_mean = (int16_t)(sum / (ll_w * ll_h));
+    for (size_t row = 0; row < ll_h; row++) {
+        for (size_t col = 0; col < ll_w; col++) {
+            image[row * width + col] = (uint16_t)((int16_t)image[row * width + col] - ll_mean);
+        }
+    }
+    icer_to_sign_magnitude_int16(image, width * height);
+
+    size_t low_w = icer_get_dim_n_low_stages(width, 1);
+    size_t low_h = icer_get_dim_n_low_stages(height, 1);
+    Subband subbands[ICER_SUBBAND_MAX + 1];
+    subbands[ICER_SUBBAND_LL].data = image;
+    subbands[ICER_SUBBAND_LL].width = ll_w;
+    subbands[ICER_SUBBAND_LL].height = ll_h;
+    subbands[ICER_SUBBAND_LL].decomp_level = stages;
+    subbands[ICER_SUBBAND_HL].data = image + low_w;
+    subbands[ICER_SUBBAND_HL].width = icer_get_dim_n_high_stages(width, 1);
+    subbands[ICER_SUBBAND_HL].height = low_h;
+    subbands[ICER_SUBBAND_HL].decomp_level = 1;
+    subbands[ICER_SUBBAND_LH].data = image + low_h * width;
+    subbands[ICER_SUBBAND_LH].width = low_w;
+    subbands[ICER_SUBBAND_LH].height = icer_get_dim_n_high_stages(height, 1);
+    subbands[ICER_SUBBAND_LH].decomp_level = 1;
+    subbands[ICER_SUBBAND_HH].data = image + low_h * width + low_w;
+    subbands[ICER_SUBBAND_HH].width = icer_get_dim_n_high_stages(width, 1);
+    subbands[ICER_SUBBAND_HH].height = icer_get_dim_n_high_stages(height, 1);
+    subbands[ICER_SUBBAND_HH].decomp_level = 1;
+    for (int subband = 0; subband <= ICER_SUBBAND_MAX; subband++) {
+        subbands[subband].rowstride = width;
+    }
+
+    int result = run_bitplane_benches(options, "image", subbands);
+    free(image);
+    return result;
+}
+
+// Bits with the skew of the context model statistics: mostly confident contexts, some near 1/2
+static int run_entropy_coder_benches(const BenchOptions* options) {
+    EncodeBitState state;
+    memset(&state, 0, sizeof(state));
+    uint8_t* bits = (uint8_t*)malloc(BENCH_BITS);
+    uint32_t* zero_counts = (uint32_t*)malloc(BENCH_BITS * sizeof(uint32_t));
+    uint32_t* total_counts = (uint32_t*)malloc(BENCH_BITS * sizeof(uint32_t));
+    state.circ_buf = (uint16_t*)malloc(ICER_CIRC_BUF_SIZE * sizeof(uint16_t));
+    state.output_size = BENCH_BITS / 4 + 1024;
+    state.output = (uint8_t*)malloc(state.output_size);
+    uint16_t* codewords = (uint16_t*)malloc(ICER_CIRC_BUF_SIZE * sizeof(uint16_t));
+    int result = 0;
+    if (!bits || !zero_counts || !total_counts || !state.circ_buf || !state.output || !codewords) {
+        result = -1;
+    }
+
+    if (result == 0) {
+        for (size_t i = 0; i < BENCH_BITS; i++) {
+            uint32_t total = 2 + rng_next() % 500;
+            double p_zero = 0.5 + 0.5 * (1.0 - sqrt(rng_uniform()));
+            uint32_t zeros = (uint32_t)(p_zero * total);
+            if (rng_next() & 1) {
+                zeros = total - zeros;      // contexts that mostly see ones
+            }
+            bool one = rng_uniform() >= (double)zeros / total;
+            bits[i] = one ? 1 : 0;
+            zero_counts[i] = zeros;
+            total_counts[i] = total;
+        }
+        state.bits = bits;
+        state.zero_counts = zero_counts;
+        state.total_counts = total_counts;
+        state.count = BENCH_BITS;
+        state.result = ICER_RESULT_OK;
+        run_bench(options, "encode_bit", BENCH_BITS, 1.0 / 8, bench_encode_bit, &state);
+        if (state.result != ICER_RESULT_OK) {
+            fprintf(stderr, "encode_bit: icer_encode_bit failed: %d\n", state.result);
+            result = state.result;
+        }
+        run_bench(options, "compute_bin", BENCH_BITS, 1.0 / 8, bench_compute_bin, &state);
+    }
+
+    if (result == 0) {
+        // Finished codewords of 1 to 10 bits, as the bins leave them in the buffer
+        for (size_t i = 0; i < ICER_CIRC_BUF_SIZE; i++) {
+            uint16_t bits_in_code = (uint16_t)(1 + rng_next() % 10);
+            uint16_t code = (uint16_t)(rng_next() & ((1u << bits_in_code) - 1));
+            codewords[i] = (uint16_t)((bits_in_code << ICER_ENC_BUF_BITS_OFFSET) | ICER_ENC_BUF_DONE_MASK |
+                                      (code & ICER_ENC_BUF_DATA_MASK));
+        }
+        PopbufState popbuf;
+        popbuf.codewords = codewords;
+        popbuf.circ_buf = state.circ_buf;
+        popbuf.output = state.output;
+        popbuf.output_size = state.output_size;
+        popbuf.result = ICER_RESULT_OK;
+        run_bench(options, "popbuf", ICER_CIRC_BUF_SIZE, sizeof(uint16_t), bench_popbuf, &popbuf);
+        if (popbuf.result != ICER_RESULT_OK) {
+            fprintf(stderr, "popbuf: icer_popbuf_while_avail failed: %d\n", popbuf.result);
+            result = popbuf.result;
+        }
+    }
+
+    free(bits);
+    free(zero_counts);
+    free(total_counts);
+    free(state.circ_buf);
+    free(state.output);
+    free(codewords);
+    return result;
+}
+
+static int run_buffer_benches(const BenchOptions* options) {
+    static const size_t crc_lengths[] = {28, 4096, 65536};
+    static const size_t deinterleave_lengths[] = {64, 640, 1280};
+    uint8_t* bytes = (uint8_t*)malloc(BENCH_PIXELS * 3);
+    uint16_t* source = (uint16_t*)malloc(BENCH_PIXELS * sizeof(uint16_t));
+    uint16_t* work = (uint16_t*)malloc(BENCH_PIXELS * sizeof(uint16_t));
+    uint16_t* yuv = (uint16_t*)malloc(3 * BENCH_PIXELS * sizeof(uint16_t));
+    if (!bytes || !source || !work || !yuv) {
+        free(bytes);
+        free(source);
+        free(work);
+        free(yuv);
+        return -1;
+    }
+    for (size_t i = 0; i < BENCH_PIXELS * 3; i++) {
+        bytes[i] = (uint8_t)rng_next();
+    }
+
+    char name[96];
+    for (size_t l = 0; l < sizeof(crc_lengths) / sizeof(crc_lengths[0]); l++) {
+        BufferState state = {bytes, crc_lengths[l]};
+        snprintf(name, sizeof(name), "crc32buf/len=%zu", crc_lengths[l]);
+        run_bench(options, name, crc_lengths[l], 1.0, bench_crc32buf, &state);
+    }
+
+    for (size_t l = 0; l < sizeof(deinterleave_lengths) / sizeof(deinterleave_lengths[0]); l++) {
+        size_t length = deinterleave_lengths[l];
+        fill_image_row(work, length);
+        Uint16State state = {work, work, length};
+        snprintf(name, sizeof(name), "deinterleave/len=%zu", length);
+        run_bench(options, name, length, sizeof(uint16_t), bench_deinterleave, &state);
+    }
+
+    // Wavelet coefficients before the conversion, mostly small with both signs
+    for (size_t i = 0; i < BENCH_PIXELS; i++) {
+        source[i] = (uint16_t)(int16_t)rng_laplace(8.0);
+    }
+    Uint16State sign_state = {source, work, BENCH_PIXELS};
+    run_bench(options, "sign_magnitude", BENCH_PIXELS, sizeof(uint16_t), bench_sign_magnitude, &sign_state);
+
+    RgbState rgb_state = {bytes, yuv, yuv + BENCH_PIXELS, yuv + 2 * BENCH_PIXELS, BENCH_PIXELS};
+    run_bench(options, "rgb_to_yuv", BENCH_PIXELS, 3.0, bench_rgb_to_yuv, &rgb_state);
+
+    free(bytes);
+    free(source);
+    free(work);
+    free(yuv);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Input and output
+// ---------------------------------------------------------------------------
+
+// Y channel of a yuv422 (YUYV) or yuv16 (planar uint16) frame
+static uint16_t* load_y_channel(const char* path, bool yuv16, size_t width, size_t height) {
+    size_t pixels = width * height;
+    size_t needed = yuv16 ? pixels * sizeof(uint16_t) : pixels * 2;
+    FILE* fp = fopen(path, "rb");
+    if (!fp) {
+        return NULL;
+    }
+    uint8_t* raw = (uint8_t*)malloc(needed);
+    uint16_t* y = (uint16_t*)malloc(pixels * sizeof(uint16_t));
+    bool ok = raw && y && fread(raw, 1, needed, fp) == needed;
+    fclose(fp);
+    if (ok) {
+        for (size_t i = 0; i < pixels; i++) {
+            y[i] = yuv16 ? (uint16_t)(raw[2 * i] | (raw[2 * i + 1] << 8)) : raw[2 * i];
+        }
+    }
+    free(raw);
+    if (!ok) {
+        free(y);
+        return NULL;
+    }
+    return y;
+}
+
+static bool write_json(const char* path, const char* label, const BenchOptions* options) {
+    FILE* fp = (strcmp(path, "-") == 0) ? stdout : fopen(path, "w");
+    if (!fp) {
+        return false;
+    }
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"label\": \"");
+    for (const char* c = label; *c; c++) {
+        if (*c == '"' || *c == '\\') fputc('\\', fp);
+        if ((unsigned char)*c >= 0x20) fputc(*c, fp);
+    }
+    fprintf(fp, "\",\n");
+    fprintf(fp, "  \"min_time_ms\": %.0f,\n", options->min_time_ms);
+    fprintf(fp, "  \"repeat\": %d,\n", options->repeat);
+    fprintf(fp, "  \"results\": [\n");
+    // One result per line, --compare relies on it
+    for (size_t i = 0; i < result_count; i++) {
+        const BenchResult* r = &results[i];
+        fprintf(fp, "    {\"name\": \"%s\", \"samples\": %zu, \"iterations\": %zu, "
+                    "\"ns_per_sample\": %.4f, \"mb_per_s\": %.2f}%s\n",
+                r->name, r->samples, r->iterations, r->ns_per_sample, r->mb_per_s,
+                (i + 1 < result_count) ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+    bool ok = !ferror(fp);
+    if (fp != stdout) {
+        ok = (fclose(fp) == 0) && ok;
+    }
+    return ok;
+}
+
+// Speedup of every result that is also in an earlier --json file (base time / new time)
+static bool print_comparison(const char* path) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) {
+        return false;
+    }
+    fprintf(report, "\n%-44s %14s %14s %9s\n", "benchmark", "base ns/sample", "ns/sample", "speedup");
+    char line[512];
+    double log_sum = 0;
+    size_t matched = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        const char* name_start = strstr(line, "\"name\": \"");
+        const char* ns_start = strstr(line, "\"ns_per_sample\": ");
+        if (!name_start || !ns_start) {
+            continue;
+        }
+        name_start += strlen("\"name\": \"");
+        const char* name_end = strchr(name_start, '"');
+        if (!name_end) {
+            continue;
+        }
+        double base_ns = strtod(ns_start + strlen("\"ns_per_sample\": "), NULL);
+        for (size_t i = 0; i < result_count; i++) {
+            const BenchResult* r = &results[i];
+            if (strlen(r->name) == (size_t)(name_end - name_start) &&
+                strncmp(r->name, name_start, name_end - name_start) == 0 && r->ns_per_sample > 0 && base_ns > 0) {
+                double speedup = base_ns / r->ns_per_sample;
+                fprintf(report, "%-44s %14.3f %14.3f %8.2fx\n", r->name, base_ns, r->ns_per_sample, speedup);
+                log_sum += log(speedup);
+                matched++;
+                break;
+            }
+        }
+    }
+    fclose(fp);
+    if (matched > 0) {
+        fprintf(report, "%-44s %14s %14s %8.2fx\n", "geometric mean", "", "", exp(log_sum / matched));
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    options.only = NULL;
+    options.min_time_ms = 50;
+    options.repeat = 3;
+    const char* image_path = NULL;
+    bool yuv16 = false;
+    size_t width = 0;
+    size_t height = 0;
+    const char* json_path = NULL;
+    const char* label = "";
+    const char* compare_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool has_value = (i + 1 < argc);
+        if (strcmp(arg, "--image") == 0 && has_value) {
+            image_path = argv[++i];
+        } else if (strcmp(arg, "--format") == 0 && has_value) {
+            const char* value = argv[++i];
+            if (strcmp(value, "yuv422") == 0) yuv16 = false;
+            else if (strcmp(value, "yuv16") == 0) yuv16 = true;
+            else { print_usage(argv[0]); return 2; }
+        } else if (strcmp(arg, "--width") == 0 && has_value) {
+            width = (size_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--height") == 0 && has_value) {
+            height = (size_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--only") == 0 && has_value) {
+            options.only = argv[++i];
+        } else if (strcmp(arg, "--min-time") == 0 && has_value) {
+            options.min_time_ms = atof(argv[++i]);
+        } else if (strcmp(arg, "--repeat") == 0 && has_value) {
+            options.repeat = atoi(argv[++i]);
+        } else if (strcmp(arg, "--json") == 0 && has_value) {
+            json_path = argv[++i];
+        } else if (strcmp(arg, "--label") == 0 && has_value) {
+            label = argv[++i];
+        } else if (strcmp(arg, "--compare") == 0 && has_value) {
+            compare_path = argv[++i];
+        } else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            fprintf(stderr, "Unknown or incomplete option: %s\n", arg);
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (options.min_time_ms <= 0 || options.repeat < 1) {
+        fprintf(stderr, "Invalid --min-time/--repeat\n");
+        return 2;
+    }
+    if (image_path && (width < 16 || height < 16)) {
+        fprintf(stderr, "--width and --height (at least 16) are required with --image\n");
+        return 2;
+    }
+
+    uint16_t* y = NULL;
+    if (image_path) {
+        y = load_y_channel(image_path, yuv16, width, height);
+        if (!y) {
+            fprintf(stderr, "Cannot read %s\n", image_path);
+            return 1;
+        }
+    }
+
+    report = (json_path && strcmp(json_path, "-") == 0) ? stderr : stdout;
+
+    int result = 0;
+    run_wavelet_benches(&options);
+    if (result == 0) result = run_synthetic_bitplane_benches(&options);
+    if (result == 0 && y) result = run_image_bitplane_benches(&options, y, width, height);
+    if (result == 0) result = run_entropy_coder_benches(&options);
+    if (result == 0) result = run_buffer_benches(&options);
+    free(y);
+
+    if (result != 0) {
+        fprintf(stderr, "Benchmarks failed: %d\n", result);
+        return 1;
+    }
+    if (compare_path && !print_comparison(compare_path)) {
+        fprintf(stderr, "Cannot read %s\n", compare_path);
+        return 1;
+    }
+    if (json_path && !write_json(json_path, label, &options)) {
+        fprintf(stderr, "Cannot write %s\n", json_path);
+        return 1;
+    }
+    return 0;
+}
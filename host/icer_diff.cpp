@@ -0,0 +1,511 @@
+// Differential test of the flash pipeline against the in-RAM ICER reference
+//
+// flash_icer_compression.h promises output that is byte for byte the output of
+// standard ICER. This harness holds it to that: every case compresses the same
+// Y, U, V planes twice, once through compressYuvWithIcerFlash (channel files on
+// the POSIX or mmap backend) and once through compressYuvWithIcer in RAM
+// (icer_compress_image_yuv_uint16), and compares the two streams. Both paths
+// are timed, so the same run shows what a change to the flash path gained.
+//
+// The default matrix crosses odd and even sizes, stages 1-5, filters A-F,
+// segment counts and byte budgets (lossless and lossy). The planes are
+// host_util's synthetic scene, the one icer_pipeline_bench encodes as JPEG;
+// --image runs a planar uint16 frame instead.
+// A case that both paths reject with the same error (image too small for the
+// stages, ...) counts as agreeing.
+//
+// Every stream both encoders agree on is then decoded by the flash decoder
+// (decompressYuvWithIcerFlash) and by icer_decompress_image_yuv_uint16, whole and
+// cut short (half the stream, and the first 50 bytes, where only part of the
+// channels has a packet), and the pixels are compared. --no-decode skips this.
+//
+// Usage:
+//   icer_diff [options]
+//   icer_diff --sizes 640x480 --stages 4 --filters 0 --segments 6 --bpp 0,2
+//   icer_diff --image frame.yuv16 --width 640 --height 480
+//
+// Exits with 1 if any case or decode differs.
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "filesystem_interface.h"
+#include "posix_filesystem.h"
+#include "mmap_filesystem.h"
+#include "memory_arena.h"
+#include "icer_compression.h"
+#include "flash_icer_compression.h"
+#include "flash_icer_decompression.h"
+#include "host_util.h"
+
+extern "C" {
+#include "icer.h"
+}
+
+// Outcome of one path of one case
+struct PathResult {
+    int error_code;     // 0 on success
+    uint8_t* data;      // Compressed stream (malloc'ed), NULL on failure
+    size_t size;
+    double ms;
+};
+
+// Totals over the matrix
+struct Totals {
+    int cases;
+    int identical;
+    int both_rejected;
+    int mismatched;
+    int decodes;
+    int decodes_mismatched;
+    double flash_ms;
+    double ram_ms;
+};
+
+static void print_usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "\n"
+            "Options:\n"
+            "  --sizes WxH,...             Frame sizes (default 64x48,65x49,160x120,161x121,320x240,333x251)\n"
+            "  --stages LIST               Wavelet decomposition stages (default 1,2,3,4,5)\n"
+            "  --filters LIST              ICER filter types (default 0,1,2,3,4,5 = A-F)\n"
+            "  --segments LIST             Error containment segments (default 1,6,16)\n"
+            "  --bpp LIST                  Byte budgets in bits per pixel, 0 = lossless (default 0,1,4)\n"
+            "  --image FILE                Planar uint16 Y, U, V frame instead of the synthetic ones\n"
+            "  --width N, --height N       Size of --image\n"
+            "  --backend posix|mmap        File system backend of the flash path (default posix)\n"
+            "  --workdir DIR               Directory for intermediate files (default .)\n"
+            "  --no-decode                 Only compare the encoders, not the decoders\n"
+            "  --stop                      Stop at the first differing case\n"
+            "  --verbose                   Print every case, not only the differing ones\n",
+            prog);
+}
+
+// "WxH,WxH,..." into two parallel lists
+static bool parse_sizes(const char* text, NumberList* widths, NumberList* heights) {
+    widths->count = 0;
+    heights->count = 0;
+    const char* p = text;
+    while (*p) {
+        char* end = NULL;
+        long w = strtol(p, &end, 10);
+        if (end == p || (*end != 'x' && *end != 'X') || widths->count >= MAX_LIST) {
+            return false;
+        }
+        p = end + 1;
+        long h = strtol(p, &end, 10);
+        if (end == p || w <= 0 || h <= 0) {
+            return false;
+        }
+        widths->values[widths->count++] = (double)w;
+        heights->values[heights->count++] = (double)h;
+        p = end;
+        if (*p == ',') {
+            p++;
+        } else if (*p) {
+            return false;
+        }
+    }
+    return widths->count > 0;
+}
+
+static bool load_planes(Planes* planes, const char* path, size_t width, size_t height) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) {
+        return false;
+    }
+    bool ok = alloc_planes(planes, width, height);
+    size_t pixels = width * height;
+    ok = ok && fread(planes->chan[0], sizeof(uint16_t), pixels, fp) == pixels &&
+         fread(planes->chan[1], sizeof(uint16_t), pixels, fp) == pixels &&
+         fread(planes->chan[2], sizeof(uint16_t), pixels, fp) == pixels;
+    fclose(fp);
+    if (!ok) {
+        free_planes(planes);
+    }
+    return ok;
+}
+
+// The flash path: channel files in, result file out
+static void run_flash(IFileSystem* fs, const Planes* planes, uint8_t stages, uint8_t filter_type,
+                      uint8_t segments, size_t target_size, PathResult* out) {
+    memset(out, 0, sizeof(*out));
+    const char* names[3] = {Y_FILE, U_FILE, V_FILE};
+    size_t size = planes->width * planes->height * sizeof(uint16_t);
+    for (int c = 0; c < 3; c++) {
+        if (!write_fs_file(fs, names[c], (const uint8_t*)planes->chan[c], size)) {
+            out->error_code = -1000;
+            return;
+        }
+    }
+    double start = now_ms();
+    IcerCompressionResult result = compressYuvWithIcerFlash(
+        fs, Y_FILE, U_FILE, V_FILE, planes->width, planes->height,
+        stages, filter_type, segments, target_size, RESULT_FILE, false);
+    out->ms = now_ms() - start;
+    if (!result.success) {
+        out->error_code = (result.error_code != 0) ? result.error_code : -1001;
+    } else {
+        out->data = read_fs_file(fs, RESULT_FILE, result.compressed_size);
+        out->size = result.compressed_size;
+        if (!out->data) {
+            out->error_code = -1002;
+        }
+    }
+    fs->remove(Y_FILE);
+    fs->remove(U_FILE);
+    fs->remove(V_FILE);
+    fs->remove(RESULT_FILE);
+}
+
+// The reference: icer_compress_image_yuv_uint16 on copies of the planes
+// (the wavelet transform works in place)
+static void run_ram(const Planes* planes, uint8_t stages, uint8_t filter_type, uint8_t segments,
+                    size_t target_size, PathResult* out) {
+    memset(out, 0, sizeof(*out));
+    Planes copy;
+    if (!alloc_planes(&copy, planes->width, planes->height)) {
+        out->error_code = -1000;
+        return;
+    }
+    size_t size = planes->width * planes->height * sizeof(uint16_t);
+    memcpy(copy.chan[0], planes->chan[0], size);
+    memcpy(copy.chan[1], planes->chan[1], size);
+    memcpy(copy.chan[2], planes->chan[2], size);
+    double start = now_ms();
+    IcerCompressionResult result = compressYuvWithIcer(
+        copy.chan[0], copy.chan[1], copy.chan[2], planes->width, planes->height,
+        stages, filter_type, segments, target_size, NULL, NULL);
+    out->ms = now_ms() - start;
+    free_planes(&copy);
+    if (!result.success) {
+        out->error_code = (result.error_code != 0) ? result.error_code : -1001;
+        return;
+    }
+    out->data = result.compressed_data;
+    out->size = result.compressed_size;
+}
+
+// Decode size bytes of a stream with the flash decoder into planes
+static int decode_flash(IFileSystem* fs, const uint8_t* data, size_t size, uint8_t stages, uint8_t filter_type,
+                        uint8_t segments, Planes* planes) {
+    memset(planes, 0, sizeof(*planes));
+    if (!write_fs_file(fs, RESULT_FILE, data, size)) {
+        return -1000;
+    }
+    size_t width = 0;
+    size_t height = 0;
+    int res = decompressYuvWithIcerFlash(fs, RESULT_FILE, Y_DECODED_FILE, U_DECODED_FILE, V_DECODED_FILE, stages,
+                                         filter_type, segments, &width, &height);
+    fs->remove(RESULT_FILE);
+    if (res != 0) {
+        return res;
+    }
+    const char* names[3] = {Y_DECODED_FILE, U_DECODED_FILE, V_DECODED_FILE};
+    planes->width = width;
+    planes->height = height;
+    for (int c = 0; c < 3; c++) {
+        planes->chan[c] = (uint16_t*)read_fs_file(fs, names[c], width * height * sizeof(uint16_t));
+        fs->remove(names[c]);
+        if (!planes->chan[c]) {
+            res = -1002;
+        }
+    }
+    if (res != 0) {
+        free_planes(planes);
+    }
+    return res;
+}
+
+// Decode size bytes of a stream with icer_decompress_image_yuv_uint16 into planes
+// of at most width x height
+static int decode_ram(const uint8_t* data, size_t size, size_t width, size_t height, uint8_t stages,
+                      uint8_t filter_type, uint8_t segments, Planes* planes) {
+    if (!alloc_planes(planes, width, height)) {
+        return -1000;
+    }
+    size_t decoded_w = 0;
+    size_t decoded_h = 0;
+    int res = icer_decompress_image_yuv_uint16(planes->chan[0], planes->chan[1], planes->chan[2], &decoded_w,
+                                               &decoded_h, width * height, data, size, stages,
+                                               (enum icer_filter_types)filter_type, segments);
+    if (res == ICER_RESULT_OK && (decoded_w == 0 || decoded_h == 0)) {
+        res = -1003;  // No packet at all, the flash decoder rejects this too
+    }
+    if (res != ICER_RESULT_OK) {
+        free_planes(planes);
+        return res;
+    }
+    planes->width = decoded_w;
+    planes->height = decoded_h;
+    return 0;
+}
+
+// Decode prefixes of a stream with both decoders and compare the pixels;
+// returns false if they disagree (both failing counts as agreeing)
+static bool check_decoders(IFileSystem* fs, const Planes* original, const uint8_t* data, size_t size,
+                           uint8_t stages, uint8_t filter_type, uint8_t segments, const char* label, bool verbose,
+                           Totals* totals) {
+    const size_t prefixes[3] = {size, size / 2, (size < 50) ? size : 50};
+    bool all_agree = true;
+    for (int p = 0; p < 3; p++) {
+        if (p > 0 && prefixes[p] == prefixes[p - 1]) {
+            continue;
+        }
+        Planes flash_planes;
+        Planes ram_planes;
+        int flash_res = decode_flash(fs, data, prefixes[p], stages, filter_type, segments, &flash_planes);
+        int ram_res = decode_ram(data, prefixes[p], original->width, original->height, stages, filter_type,
+                                 segments, &ram_planes);
+        totals->decodes++;
+        bool agree;
+        if (flash_res != 0 || ram_res != 0) {
+            agree = (flash_res != 0 && ram_res != 0);
+            if (!agree) {
+                printf("  DIFF  %-48s decode of %zu bytes: flash %d, ram %d\n", label, prefixes[p], flash_res,
+                       ram_res);
+            }
+        } else {
+            agree = (flash_planes.width == ram_planes.width && flash_planes.height == ram_planes.height);
+            size_t bytes = flash_planes.width * flash_planes.height * sizeof(uint16_t);
+            for (int c = 0; c < 3 && agree; c++) {
+                agree = (memcmp(flash_planes.chan[c], ram_planes.chan[c], bytes) == 0);
+            }
+            if (!agree) {
+                printf("  DIFF  %-48s decode of %zu bytes: pixels differ\n", label, prefixes[p]);
+            }
+        }
+        if (agree && verbose) {
+            printf("  ok    %-48s decode of %zu bytes%s\n", label, prefixes[p],
+                   (flash_res != 0) ? " rejected by both" : "");
+        }
+        if (!agree) {
+            totals->decodes_mismatched++;
+            all_agree = false;
+        }
+        free_planes(&flash_planes);
+        free_planes(&ram_planes);
+    }
+    return all_agree;
+}
+
+// Run one case and add it to totals; returns false if the paths disagree
+static bool run_case(IFileSystem* fs, const Planes* planes, int stages, int filter_type, int segments,
+                     double bpp, bool decode, bool verbose, Totals* totals) {
+    size_t target_size = (size_t)(bpp * planes->width * planes->height / 8);
+    PathResult flash;
+    PathResult ram;
+    run_flash(fs, planes, (uint8_t)stages, (uint8_t)filter_type, (uint8_t)segments, target_size, &flash);
+    run_ram(planes, (uint8_t)stages, (uint8_t)filter_type, (uint8_t)segments, target_size, &ram);
+
+    char label[96];
+    snprintf(label, sizeof(label), "%zux%zu stages %d filter %c segments %2d bpp %g", planes->width,
+             planes->height, stages, 'A' + filter_type, segments, bpp);
+    totals->cases++;
+    bool agree;
+    if (flash.error_code != 0 || ram.error_code != 0) {
+        agree = (flash.error_code == ram.error_code);
+        if (agree) {
+            totals->both_rejected++;
+            if (verbose) {
+                printf("  ok    %-48s both rejected (%d)\n", label, flash.error_code);
+            }
+        } else {
+            printf("  DIFF  %-48s flash %d, ram %d\n", label, flash.error_code, ram.error_code);
+        }
+    } else {
+        size_t common = (flash.size < ram.size) ? flash.size : ram.size;
+        size_t first = 0;
+        while (first < common && flash.data[first] == ram.data[first]) {
+            first++;
+        }
+        agree = (flash.size == ram.size && first == common);
+        totals->flash_ms += flash.ms;
+        totals->ram_ms += ram.ms;
+        if (agree) {
+            totals->identical++;
+            if (verbose) {
+                printf("  ok    %-48s %8zu bytes  flash %8.2f ms  ram %8.2f ms\n", label, flash.size, flash.ms,
+                       ram.ms);
+            }
+        } else {
+            printf("  DIFF  %-48s flash %zu bytes, ram %zu bytes, first difference at byte %zu\n", label,
+                   flash.size, ram.size, first);
+        }
+    }
+    if (!agree) {
+        totals->mismatched++;
+    }
+    // Decoder mismatches are counted in totals->decodes_mismatched
+    bool decoders_agree = true;
+    if (agree && decode && flash.data) {
+        decoders_agree = check_decoders(fs, planes, flash.data, flash.size, (uint8_t)stages, (uint8_t)filter_type,
+                                        (uint8_t)segments, label, verbose, totals);
+    }
+    free(flash.data);
+    free(ram.data);
+    return agree && decoders_agree;
+}
+
+int main(int argc, char** argv) {
+    NumberList widths;
+    NumberList heights;
+    NumberList stage_list;
+    NumberList filter_list;
+    NumberList segment_list;
+    NumberList bpp_list;
+    parse_sizes("64x48,65x49,160x120,161x121,320x240,333x251", &widths, &heights);
+    parse_list("1,2,3,4,5", &stage_list);
+    parse_list("0,1,2,3,4,5", &filter_list);
+    parse_list("1,6,16", &segment_list);
+    parse_list("0,1,4", &bpp_list);
+    const char* image_path = NULL;
+    size_t image_width = 0;
+    size_t image_height = 0;
+    const char* backend = "posix";
+    const char* workdir = ".";
+    bool stop = false;
+    bool decode = true;
+    bool verbose = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool has_value = (i + 1 < argc);
+        bool ok = true;
+        if (strcmp(arg, "--sizes") == 0 && has_value) {
+            ok = parse_sizes(argv[++i], &widths, &heights);
+        } else if (strcmp(arg, "--stages") == 0 && has_value) {
+            ok = parse_list(argv[++i], &stage_list);
+        } else if (strcmp(arg, "--filters") == 0 && has_value) {
+            ok = parse_list(argv[++i], &filter_list);
+        } else if (strcmp(arg, "--segments") == 0 && has_value) {
+            ok = parse_list(argv[++i], &segment_list);
+        } else if (strcmp(arg, "--bpp") == 0 && has_value) {
+            ok = parse_list(argv[++i], &bpp_list);
+        } else if (strcmp(arg, "--image") == 0 && has_value) {
+            image_path = argv[++i];
+        } else if (strcmp(arg, "--width") == 0 && has_value) {
+            image_width = (size_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--height") == 0 && has_value) {
+            image_height = (size_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--backend") == 0 && has_value) {
+            backend = argv[++i];
+        } else if (strcmp(arg, "--workdir") == 0 && has_value) {
+            workdir = argv[++i];
+        } else if (strcmp(arg, "--no-decode") == 0) {
+            decode = false;
+        } else if (strcmp(arg, "--stop") == 0) {
+            stop = true;
+        } else if (strcmp(arg, "--verbose") == 0) {
+            verbose = true;
+        } else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            print_usage(argv[0]);
+            return 2;
+        }
+        if (!ok) {
+            fprintf(stderr, "Invalid value for %s\n", arg);
+            return 2;
+        }
+    }
+    if (image_path && (image_width == 0 || image_height == 0)) {
+        fprintf(stderr, "--width and --height are required with --image\n");
+        return 2;
+    }
+    for (int i = 0; i < stage_list.count; i++) {
+        if (stage_list.values[i] < 1 || stage_list.values[i] > ICER_MAX_DECOMP_STAGES) {
+            fprintf(stderr, "Stages must be 1-%d\n", ICER_MAX_DECOMP_STAGES);
+            return 2;
+        }
+    }
+    for (int i = 0; i < filter_list.count; i++) {
+        if (filter_list.values[i] < 0 || filter_list.values[i] > 6) {
+            fprintf(stderr, "Filters must be 0-6\n");
+            return 2;
+        }
+    }
+    for (int i = 0; i < segment_list.count; i++) {
+        if (segment_list.values[i] < 1 || segment_list.values[i] > ICER_MAX_SEGMENTS) {
+            fprintf(stderr, "Segments must be 1-%d\n", ICER_MAX_SEGMENTS);
+            return 2;
+        }
+    }
+
+    Serial.setEnabled(false);  // Both paths report progress on Serial
+    initMemoryPools(false);
+#ifdef USER_PROVIDED_BUFFERS
+    // Packet table of the in-RAM decoder (the flash decoder keeps its own index)
+    icer_reconstruct_data_16 = (decltype(icer_reconstruct_data_16))calloc(ICER_CHANNEL_MAX + 1,
+                                                                          sizeof(*icer_reconstruct_data_16));
+    if (!icer_reconstruct_data_16) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+#endif
+
+    IFileSystem* fs = NULL;
+    if (strcmp(backend, "posix") == 0) {
+        fs = createPosixFileSystem(workdir);
+    } else if (strcmp(backend, "mmap") == 0) {
+        fs = createMmapFileSystem(workdir);
+    } else {
+        fprintf(stderr, "Unknown backend: %s\n", backend);
+        return 2;
+    }
+    if (!fs || !fs->begin()) {
+        fprintf(stderr, "Failed to initialize %s file system in %s\n", backend, workdir);
+        delete fs;
+        return 1;
+    }
+
+    int frame_count = image_path ? 1 : widths.count;
+    Totals totals;
+    memset(&totals, 0, sizeof(totals));
+    bool stopped = false;
+    for (int f = 0; f < frame_count && !stopped; f++) {
+        Planes planes;
+        bool loaded;
+        if (image_path) {
+            loaded = load_planes(&planes, image_path, image_width, image_height);
+        } else {
+            loaded = make_synthetic_planes(&planes, (size_t)widths.values[f], (size_t)heights.values[f]);
+        }
+        if (!loaded) {
+            fprintf(stderr, "Failed to %s frame %d\n", image_path ? "read" : "allocate", f);
+            delete fs;
+            return 1;
+        }
+        printf("%zux%zu\n", planes.width, planes.height);
+        for (int s = 0; s < stage_list.count && !stopped; s++) {
+            for (int k = 0; k < filter_list.count && !stopped; k++) {
+                for (int g = 0; g < segment_list.count && !stopped; g++) {
+                    for (int b = 0; b < bpp_list.count && !stopped; b++) {
+                        bool agree = run_case(fs, &planes, (int)stage_list.values[s], (int)filter_list.values[k],
+                                              (int)segment_list.values[g], bpp_list.values[b], decode, verbose,
+                                              &totals);
+                        stopped = stop && !agree;
+                    }
+                }
+            }
+        }
+        free_planes(&planes);
+    }
+    delete fs;
+
+    printf("\n%d cases: %d identical, %d rejected by both, %d differ\n", totals.cases, totals.identical,
+           totals.both_rejected, totals.mismatched);
+    if (decode) {
+        printf("%d decodes: %d differ\n", totals.decodes, totals.decodes_mismatched);
+    }
+    if (totals.identical > 0) {
+        printf("time over identical cases: flash %.1f ms, ram %.1f ms (flash / ram %.2fx)\n", totals.flash_ms,
+               totals.ram_ms, (totals.ram_ms > 0) ? totals.flash_ms / totals.ram_ms : 0.0);
+    }
+    return (totals.mismatched > 0 || totals.decodes_mismatched > 0) ? 1 : 0;
+}
@@ -0,0 +1,338 @@
+/*
+ * Generator for src/icer_tables.c, the entropy coder tables of ICER
+ *
+ * The tables used to be filled in RAM by icer_init() at run time. They are fixed, so this host
+ * program runs the same table definitions once and prints them as const arrays, which the
+ * firmware keeps in .rodata with nothing to initialise. The output is checked in; rerun after
+ * changing a table below:
+ *
+ *   cmake --build build --target icer_tables
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "icer.h"
+
+static icer_custom_code_typedef coding_scheme[ICER_ENCODER_BIN_MAX + 1][CUSTOM_CODING_MAX_LOOKUP];
+static icer_custom_code_typedef decode_scheme[ICER_ENCODER_BIN_MAX + 1][CUSTOM_CODING_MAX_LOOKUP];
+static icer_custom_flush_typedef flush_bits[ICER_ENCODER_BIN_MAX + 1][CUSTOM_CODE_FLUSH_MAX_LOOKUP + 1][MAX_NUM_BITS_BEFORE_FLUSH + 1];
+static icer_golomb_code_typedef golomb_coders[ICER_ENCODER_BIN_MAX + 1];
+
+#define INIT_CODING_SCHEME(bin, inp, inp_bits, out, out_bits) { \
+coding_scheme[bin][inp].input_code_bits = inp_bits;       \
+coding_scheme[bin][inp].output_code = out;                \
+coding_scheme[bin][inp].output_code_bits = out_bits;      \
+}
+
+#define INIT_FLUSH_BITS(bin, inp, inp_bits, out, out_bits) { \
+flush_bits[bin][inp][inp_bits].flush_bit = out;   \
+flush_bits[bin][inp][inp_bits].flush_bit_numbers = out_bits; \
+}
+
+#define INIT_DECODE_SCHEME(bin, out, out_bits, inp, inp_bits) { \
+decode_scheme[bin][inp].input_code_bits = inp_bits;       \
+decode_scheme[bin][inp].output_code = out;                \
+decode_scheme[bin][inp].output_code_bits = out_bits;      \
+}
+
+static void init_decodescheme(void) {
+    for (int it = 0; it <= ICER_ENCODER_BIN_MAX; it++) {
+        for (int j = 0; j < CUSTOM_CODING_MAX_LOOKUP; j++) {
+            decode_scheme[it][j].input_code_bits = 0;
+            decode_scheme[it][j].output_code_bits = 0;
+        }
+    }
+
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_2, 0b01, 2, 0b10, 2);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_2, 0b011, 3, 0b011, 3);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_2, 0b0111, 4, 0b1111, 4);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_2, 0b1111, 4, 0b10000, 5);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_2, 0b10, 2, 0b01, 2);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_2, 0b100, 3, 0b100, 3);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_2, 0b1000, 4, 0b1000, 4);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_2, 0b10000, 5, 0b00000, 5);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_2, 0b00000, 5, 0b0111, 4);
+
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_3, 0b10, 2, 0b01, 2);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_3, 0b100, 3, 0b00, 2);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_3, 0b0000, 4, 0b011, 3);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_3, 0b11000, 5, 0b10010, 5);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_3, 0b01000, 5, 0b1111, 4);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_3, 0b01, 2, 0b110, 3);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_3, 0b0011, 4, 0b0111, 4);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_3, 0b1011, 4, 0b00010, 5);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_3, 0b111, 3, 0b1010, 4);
+
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_4, 0b10, 2, 0b10, 2);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_4, 0b100, 3, 0b011, 3);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_4, 0b000, 3, 0b00, 2);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_4, 0b01, 2, 0b01, 2);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_4, 0b11, 2, 0b111, 3);
+
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_5, 0b00, 2, 0b1, 1);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_5, 0b010, 3, 0b000, 3);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_5, 0b110, 3, 0b1010, 4);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_5, 0b101, 3, 0b0010, 4);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_5, 0b1001, 4, 0b1110, 4);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_5, 0b00001, 5, 0b0100, 4);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_5, 0b10001, 5, 0b00110, 5);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_5, 0b011, 3, 0b1100, 4);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_5, 0b111, 3, 0b10110, 5);
+
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_6, 0b1, 1, 0b10, 2);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_6, 0b010, 3, 0b011, 3);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_6, 0b110, 3, 0b1111, 4);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_6, 0b100, 3, 0b101, 3);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_6, 0b1000, 4, 0b001, 3);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_6, 0b10000, 5, 0b0111, 4);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_6, 0b00000, 5, 0b00, 2);
+
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_7, 0b000, 3, 0b0, 1);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_7, 0b100, 3, 0b001, 3);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_7, 0b010, 3, 0b101, 3);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_7, 0b110, 3, 0b01111, 5);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_7, 0b11, 2, 0b0111, 4);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_7, 0b001, 3, 0b011, 3);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_7, 0b101, 3, 0b11111, 5);
+
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_8, 0b10, 2, 0b101, 3);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_8, 0b100, 3, 0b001, 3);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_8, 0b0000, 4, 0b0, 1);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_8, 0b01000, 5, 0b0111, 4);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_8, 0b11000, 5, 0b01111, 5);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_8, 0b01, 2, 0b011, 3);
+    INIT_DECODE_SCHEME(ICER_ENC_BIN_8, 0b11, 2, 0b11111, 5);
+
+
+    for (int it = 0; it <= ICER_ENCODER_BIN_MAX; it++) {
+        for (int j = 0; j < CUSTOM_CODING_MAX_LOOKUP; j++) {
+            if (decode_scheme[it][j].output_code_bits != 0) {
+                uint8_t reversed = 0;
+                for (int b = 0; b < decode_scheme[it][j].output_code_bits; b++) {
+                    reversed <<= 1;
+                    reversed |= decode_scheme[it][j].output_code & 1;
+                    decode_scheme[it][j].output_code >>= 1;
+                }
+                decode_scheme[it][j].output_code = reversed;
+            }
+        }
+    }
+}
+
+static void init_codingscheme(void) {
+    for (int it = 0; it <= ICER_ENCODER_BIN_MAX; it++) {
+        for (int j = 0; j < CUSTOM_CODING_MAX_LOOKUP; j++) coding_scheme[it][j].input_code_bits = 0;
+    }
+
+    INIT_CODING_SCHEME(ICER_ENC_BIN_2, 0b01, 2, 0b10, 2);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_2, 0b011, 3, 0b011, 3);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_2, 0b0111, 4, 0b1111, 4);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_2, 0b1111, 4, 0b10000, 5);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_2, 0b10, 2, 0b01, 2);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_2, 0b100, 3, 0b100, 3);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_2, 0b1000, 4, 0b1000, 4);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_2, 0b10000, 5, 0b00000, 5);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_2, 0b00000, 5, 0b0111, 4);
+
+    INIT_CODING_SCHEME(ICER_ENC_BIN_3, 0b10, 2, 0b01, 2);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_3, 0b100, 3, 0b00, 2);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_3, 0b0000, 4, 0b011, 3);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_3, 0b11000, 5, 0b10010, 5);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_3, 0b01000, 5, 0b1111, 4);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_3, 0b01, 2, 0b110, 3);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_3, 0b0011, 4, 0b0111, 4);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_3, 0b1011, 4, 0b00010, 5);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_3, 0b111, 3, 0b1010, 4);
+
+    INIT_CODING_SCHEME(ICER_ENC_BIN_4, 0b10, 2, 0b10, 2);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_4, 0b100, 3, 0b011, 3);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_4, 0b000, 3, 0b00, 2);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_4, 0b01, 2, 0b01, 2);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_4, 0b11, 2, 0b111, 3);
+
+    INIT_CODING_SCHEME(ICER_ENC_BIN_5, 0b00, 2, 0b1, 1);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_5, 0b010, 3, 0b000, 3);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_5, 0b110, 3, 0b1010, 4);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_5, 0b101, 3, 0b0010, 4);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_5, 0b1001, 4, 0b1110, 4);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_5, 0b00001, 5, 0b0100, 4);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_5, 0b10001, 5, 0b00110, 5);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_5, 0b011, 3, 0b1100, 4);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_5, 0b111, 3, 0b10110, 5);
+
+    INIT_CODING_SCHEME(ICER_ENC_BIN_6, 0b1, 1, 0b10, 2);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_6, 0b010, 3, 0b011, 3);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_6, 0b110, 3, 0b1111, 4);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_6, 0b100, 3, 0b101, 3);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_6, 0b1000, 4, 0b001, 3);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_6, 0b10000, 5, 0b0111, 4);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_6, 0b00000, 5, 0b00, 2);
+
+    INIT_CODING_SCHEME(ICER_ENC_BIN_7, 0b000, 3, 0b0, 1);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_7, 0b100, 3, 0b001, 3);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_7, 0b010, 3, 0b101, 3);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_7, 0b110, 3, 0b01111, 5);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_7, 0b11, 2, 0b0111, 4);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_7, 0b001, 3, 0b011, 3);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_7, 0b101, 3, 0b11111, 5);
+
+    INIT_CODING_SCHEME(ICER_ENC_BIN_8, 0b10, 2, 0b101, 3);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_8, 0b100, 3, 0b001, 3);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_8, 0b0000, 4, 0b0, 1);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_8, 0b01000, 5, 0b0111, 4);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_8, 0b11000, 5, 0b01111, 5);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_8, 0b01, 2, 0b011, 3);
+    INIT_CODING_SCHEME(ICER_ENC_BIN_8, 0b11, 2, 0b11111, 5);
+}
+
+static void init_flushbits(void) {
+    INIT_FLUSH_BITS(ICER_ENC_BIN_2, 0b1, 1, 0, 1);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_2, 0b11, 2, 0, 1);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_2, 0b111, 3, 0, 1);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_2, 0b0, 1, 1, 1);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_2, 0b00, 2, 1, 1);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_2, 0b000, 3, 1, 1);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_2, 0b0000, 4, 0, 1);
+
+    INIT_FLUSH_BITS(ICER_ENC_BIN_3, 0b0, 1, 1, 1);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_3, 0b00, 2, 1, 1);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_3, 0b000, 3, 0, 1);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_3, 0b1000, 4, 0, 1);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_3, 0b1, 1, 0, 1);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_3, 0b11, 2, 1, 1);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_3, 0b011, 3, 0, 1);
+
+    INIT_FLUSH_BITS(ICER_ENC_BIN_4, 0b0, 1, 1, 1);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_4, 0b00, 2, 0, 1);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_4, 0b1, 1, 0, 1);
+
+    INIT_FLUSH_BITS(ICER_ENC_BIN_5, 0b0, 1, 0, 1);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_5, 0b10, 2, 0, 1);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_5, 0b01, 2, 1, 1);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_5, 0b001, 3, 1, 1);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_5, 0b0001, 4, 0, 1);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_5, 0b1, 1, 0b01, 2);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_5, 0b11, 2, 0, 1);
+
+    INIT_FLUSH_BITS(ICER_ENC_BIN_6, 0b0, 1, 0b01, 2);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_6, 0b01, 2, 0, 1);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_6, 0b00, 2, 1, 1);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_6, 0b000, 3, 1, 1);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_6, 0b0000, 4, 0, 1);
+
+    INIT_FLUSH_BITS(ICER_ENC_BIN_7, 0b0, 1, 0b00, 2);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_7, 0b00, 2, 0, 1);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_7, 0b10, 2, 0, 1);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_7, 0b1, 1, 1, 1);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_7, 0b01, 2, 0, 1);
+
+    INIT_FLUSH_BITS(ICER_ENC_BIN_8, 0b0, 1, 1, 1);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_8, 0b00, 2, 1, 1);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_8, 0b000, 3, 0, 1);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_8, 0b1000, 4, 0, 1);
+    INIT_FLUSH_BITS(ICER_ENC_BIN_8, 0b1, 1, 0, 1);
+}
+
+static void init_golombcoder(void) {
+    for (int it = 0; it <= ICER_ENCODER_BIN_MAX; it++) {
+        if (icer_bin_coding_scheme[it] > 0) {
+            unsigned int m = icer_bin_coding_scheme[it];
+            golomb_coders[it].m = m;
+
+            // compute ceil( log2( m ) )
+            unsigned int l = 31 - __builtin_clz(m);
+            l += ((m ^ (1 << l)) != 0);
+
+            // compute 2^l - m
+            unsigned int i = icer_pow_uint(2, l) - m;
+
+            golomb_coders[it].i = i;
+            golomb_coders[it].l = l;
+        }
+    }
+}
+
+static const char *bin_names[ICER_ENCODER_BIN_MAX + 1] = {
+    "ICER_ENC_BIN_1", "ICER_ENC_BIN_2", "ICER_ENC_BIN_3", "ICER_ENC_BIN_4", "ICER_ENC_BIN_5", "ICER_ENC_BIN_6",
+    "ICER_ENC_BIN_7", "ICER_ENC_BIN_8", "ICER_ENC_BIN_9", "ICER_ENC_BIN_10", "ICER_ENC_BIN_11", "ICER_ENC_BIN_12",
+    "ICER_ENC_BIN_13", "ICER_ENC_BIN_14", "ICER_ENC_BIN_15", "ICER_ENC_BIN_16", "ICER_ENC_BIN_17"
+};
+
+/* entries that are all zero are left to the zero initialisation of the array */
+static void print_code_table(FILE *out, const char *name, icer_custom_code_typedef table[][CUSTOM_CODING_MAX_LOOKUP]) {
+    fprintf(out, "const icer_custom_code_typedef %s[ICER_ENCODER_BIN_MAX + 1][CUSTOM_CODING_MAX_LOOKUP] = {\n", name);
+    for (int it = 0; it <= ICER_ENCODER_BIN_MAX; it++) {
+        int used = 0;
+        for (int j = 0; j < CUSTOM_CODING_MAX_LOOKUP; j++) {
+            const icer_custom_code_typedef *c = &table[it][j];
+            if (c->input_code_bits == 0 && c->output_code_bits == 0 && c->output_code == 0) continue;
+            if (!used) fprintf(out, "    [%s] = {\n", bin_names[it]);
+            used = 1;
+            fprintf(out, "        [0x%02x] = { %u, %u, 0x%02x },\n", j, c->input_code_bits, c->output_code_bits, c->output_code);
+        }
+        if (used) fprintf(out, "    },\n");
+    }
+    fprintf(out, "};\n");
+}
+
+static void print_flush_table(FILE *out) {
+    fprintf(out, "const icer_custom_flush_typedef icer_custom_code_flush_bits[ICER_ENCODER_BIN_MAX + 1][CUSTOM_CODE_FLUSH_MAX_LOOKUP + 1][MAX_NUM_BITS_BEFORE_FLUSH + 1] = {\n");
+    for (int it = 0; it <= ICER_ENCODER_BIN_MAX; it++) {
+        int used_bin = 0;
+        for (int j = 0; j <= CUSTOM_CODE_FLUSH_MAX_LOOKUP; j++) {
+            int used = 0;
+            for (int k = 0; k <= MAX_NUM_BITS_BEFORE_FLUSH; k++) {
+                const icer_custom_flush_typedef *f = &flush_bits[it][j][k];
+                if (f->flush_bit == 0 && f->flush_bit_numbers == 0) continue;
+                if (!used_bin) fprintf(out, "    [%s] = {\n", bin_names[it]);
+                if (!used) fprintf(out, "        [0x%02x] = {", j);
+                fprintf(out, " [%d] = { %u, %u },", k, f->flush_bit, f->flush_bit_numbers);
+                used_bin = used = 1;
+            }
+            if (used) fprintf(out, " },\n");
+        }
+        if (used_bin) fprintf(out, "    },\n");
+    }
+    fprintf(out, "};\n");
+}
+
+static void print_golomb_table(FILE *out) {
+    fprintf(out, "const icer_golomb_code_typedef icer_golomb_coders[ICER_ENCODER_BIN_MAX + 1] = {\n");
+    for (int it = 0; it <= ICER_ENCODER_BIN_MAX; it++) {
+        const icer_golomb_code_typedef *g = &golomb_coders[it];
+        if (g->m == 0) continue;
+        fprintf(out, "    [%s] = { %u, %u, %u },\n", bin_names[it], g->m, g->l, g->i);
+    }
+    fprintf(out, "};\n");
+}
+
+int main(int argc, char *argv[]) {
+    FILE *out = stdout;
+    if (argc > 1 && (out = fopen(argv[1], "w")) == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    init_golombcoder();
+    init_codingscheme();
+    init_decodescheme();
+    init_flushbits();
+
+    fprintf(out, "/* Generated by host/icer_gen_tables.c - do not edit, rerun the generator instead */\n\n");
+    fprintf(out, "#include \"icer.h\"\n\n");
+    fprintf(out, "#ifdef USE_ENCODE_FUNCTIONS\n");
+    print_code_table(out, "icer_custom_coding_scheme", coding_scheme);
+    fprintf(out, "#endif\n\n");
+    fprintf(out, "#ifdef USE_DECODE_FUNCTIONS\n");
+    print_code_table(out, "icer_custom_decode_scheme", decode_scheme);
+    fprintf(out, "#endif\n\n");
+    print_flush_table(out);
+    fprintf(out, "\n");
+    print_golomb_table(out);
+
+    if (out != stdout && fclose(out) != 0) {
+        perror(argv[1]);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,419 @@
+// Host driver for the flash-based ICER pipeline
+//
+// Runs exactly the same code path as the Spresense firmware (camera_yuv.cpp ->
+// flash_wavelet.cpp -> flash_partition.cpp -> flash_icer_compression.cpp), but
+// with the POSIX or mmap IFileSystem backend instead of the SD card. Useful for
+// profiling the pipeline with perf on x86 and for compressing archived raw
+// frames on the ground with the flight compressor.
+//
+// Usage:
+//   icer_host_compress [options] <input> <output>
+//
+// Input formats:
+//   jpeg    JPEG file, decoded with tjpgd (same as on the board)
+//   yuv422  8-bit interleaved YUYV as delivered by the Spresense camera
+//   yuv16   Planar uint16 Y, U, V planes back to back (width * height each)
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "filesystem_interface.h"
+#include "posix_filesystem.h"
+#include "mmap_filesystem.h"
+#include "tiered_filesystem.h"
+#include "async_filesystem.h"
+#include "handle_cache_filesystem.h"
+#include "task_pool.h"
+#include "io_stats_filesystem.h"
+#include "icer_telemetry.h"
+#include "icer_profile.h"
+#include "icer_log.h"
+#include "memory_arena.h"
+#include "flash_icer_compression.h"
+#include "flash_icer_decompression.h"
+#include "host_util.h"
+#include <math.h>
+
+extern "C" {
+#include "icer.h"
+}
+
+// Trace events kept for --trace (24 MB); a VGA frame records about 150k
+static const size_t TRACE_MAX_EVENTS = 1 << 20;
+
+static void print_usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s [options] <input> <output>\n"
+            "\n"
+            "Options:\n"
+            "  --format jpeg|yuv422|yuv16  Input format (default: from extension, .jpg/.jpeg = jpeg)\n"
+            "  --width N, --height N       Image size (required for yuv422/yuv16)\n"
+            "  --stages N                  Wavelet decomposition stages (default 4)\n"
+            "  --filter N                  ICER filter type 0-6 (default 0)\n"
+            "  --segments N                Error containment segments (default 6)\n"
+            "  --target BYTES              Target compressed size, 0 = lossless (default 409600)\n"
+            "  --backend posix|mmap        File system backend (default posix)\n"
+            "  --workdir DIR               Directory for intermediate files (default .)\n"
+            "  --async                     Background writer thread and prefetching reads\n"
+            "  --ram-budget BYTES          Keep intermediates that fit in a RAM tier (default 0 = off)\n"
+            "  --handle-cache N            Keep N read handles open across reopens (default 4, 0 = off)\n"
+            "  --io-stats                  Print per-phase I/O counters of the backend\n"
+            "  --telemetry                 Print phase times, packet counts, peak RAM and output bytes\n"
+            "  --profile                   Print the hot-path zone profile (build with -DICER_PROFILE=ON)\n"
+            "  --trace FILE                Write every zone pass as Chrome trace JSON (build with -DICER_PROFILE=ON)\n"
+            "  --gnss-pool                 Simulate the 640 KB GNSS RAM pool and print pool usage\n"
+            "  --threads N                 Encode the segments of a packet on N threads (default 1)\n"
+            "  --verify                    Decode the result with the flash decoder and compare it to the input\n"
+            "  --keep                      Keep intermediate files\n"
+            "  --quiet                     Suppress pipeline progress output\n",
+            prog);
+}
+
+// Copy the compressed result out of the file system to a regular output path
+static bool copy_result(IFileSystem* fs, const char* name, const char* out_path, size_t expected) {
+    IFile* in = fs->open(name, FILE_READ);
+    if (!in) {
+        return false;
+    }
+    FILE* out = fopen(out_path, "wb");
+    if (!out) {
+        in->close();
+        delete in;
+        return false;
+    }
+    uint8_t buf[4096];
+    size_t total = 0;
+    size_t n;
+    while ((n = in->read(buf, sizeof(buf))) > 0) {
+        if (fwrite(buf, 1, n, out) != n) {
+            break;
+        }
+        total += n;
+    }
+    in->close();
+    delete in;
+    bool ok = (fclose(out) == 0) && (total == expected);
+    return ok;
+}
+
+// Compare a decoded channel file with the original, accumulating the squared error
+static bool compare_plane(IFileSystem* fs, const char* original, const char* decoded, size_t pixels,
+                          uint64_t* squared_error, unsigned* max_error) {
+    IFile* a = fs->open(original, FILE_READ);
+    IFile* b = fs->open(decoded, FILE_READ);
+    bool ok = (a != NULL && b != NULL);
+    uint16_t row_a[1024];
+    uint16_t row_b[1024];
+    while (ok && pixels > 0) {
+        size_t n = (pixels < 1024) ? pixels : 1024;
+        if (a->read((uint8_t*)row_a, n * 2) != n * 2 || b->read((uint8_t*)row_b, n * 2) != n * 2) {
+            ok = false;
+            break;
+        }
+        for (size_t i = 0; i < n; i++) {
+            unsigned diff = (row_a[i] > row_b[i]) ? row_a[i] - row_b[i] : row_b[i] - row_a[i];
+            *squared_error += (uint64_t)diff * diff;
+            if (diff > *max_error) {
+                *max_error = diff;
+            }
+        }
+        pixels -= n;
+    }
+    if (a) { a->close(); delete a; }
+    if (b) { b->close(); delete b; }
+    return ok;
+}
+
+// Decode RESULT_FILE with the flash decoder and compare it with the channel files
+static int verify_result(IFileSystem* fs, size_t width, size_t height, int stages, int filter_type, int segments) {
+    size_t decoded_w = 0;
+    size_t decoded_h = 0;
+    unsigned long start_ms = millis();
+    int res = decompressYuvWithIcerFlash(fs, RESULT_FILE, Y_DECODED_FILE, U_DECODED_FILE, V_DECODED_FILE,
+                                         (uint8_t)stages, (uint8_t)filter_type, (uint8_t)segments,
+                                         &decoded_w, &decoded_h);
+    unsigned long decode_ms = millis() - start_ms;
+    if (res != 0) {
+        fprintf(stderr, "verify: flash decoder failed: %d\n", res);
+        return 1;
+    }
+    if (decoded_w != width || decoded_h != height) {
+        fprintf(stderr, "verify: decoded size %zux%zu, expected %zux%zu\n", decoded_w, decoded_h, width, height);
+        return 1;
+    }
+    uint64_t squared_error = 0;
+    unsigned max_error = 0;
+    bool ok = compare_plane(fs, Y_FILE, Y_DECODED_FILE, width * height, &squared_error, &max_error) &&
+              compare_plane(fs, U_FILE, U_DECODED_FILE, width * height, &squared_error, &max_error) &&
+              compare_plane(fs, V_FILE, V_DECODED_FILE, width * height, &squared_error, &max_error);
+    if (!ok) {
+        fprintf(stderr, "verify: failed to read the channel files\n");
+        return 1;
+    }
+    if (max_error == 0) {
+        printf("verify: lossless (decode %lu ms)\n", decode_ms);
+    } else {
+        double mse = (double)squared_error / (double)(width * height * 3);
+        printf("verify: max error %u, PSNR %.2f dB (decode %lu ms)\n", max_error, 10.0 * log10(255.0 * 255.0 / mse),
+               decode_ms);
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    InputFormat format = INPUT_AUTO;
+    size_t width = 0;
+    size_t height = 0;
+    int stages = 4;
+    int filter_type = 0;
+    int segments = 6;
+    size_t target_size = 400 * 1024;
+    const char* backend = "posix";
+    const char* workdir = ".";
+    size_t ram_budget = 0;
+    bool async_io = false;
+    int handle_cache = 4;
+    bool io_stats = false;
+    bool telemetry = false;
+    bool profile = false;
+    const char* trace_path = NULL;
+    bool gnss_pool = false;
+    int threads = 1;
+    bool keep = false;
+    bool verify = false;
+    const char* input_path = NULL;
+    const char* output_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool has_value = (i + 1 < argc);
+        if (strcmp(arg, "--format") == 0 && has_value) {
+            const char* value = argv[++i];
+            if (strcmp(value, "jpeg") == 0) format = INPUT_JPEG;
+            else if (strcmp(value, "yuv422") == 0) format = INPUT_YUV422;
+            else if (strcmp(value, "yuv16") == 0) format = INPUT_YUV16;
+            else { print_usage(argv[0]); return 2; }
+        } else if (strcmp(arg, "--width") == 0 && has_value) {
+            width = (size_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--height") == 0 && has_value) {
+            height = (size_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--stages") == 0 && has_value) {
+            stages = atoi(argv[++i]);
+        } else if (strcmp(arg, "--filter") == 0 && has_value) {
+            filter_type = atoi(argv[++i]);
+        } else if (strcmp(arg, "--segments") == 0 && has_value) {
+            segments = atoi(argv[++i]);
+        } else if (strcmp(arg, "--target") == 0 && has_value) {
+            target_size = (size_t)strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--backend") == 0 && has_value) {
+            backend = argv[++i];
+        } else if (strcmp(arg, "--workdir") == 0 && has_value) {
+            workdir = argv[++i];
+        } else if (strcmp(arg, "--ram-budget") == 0 && has_value) {
+            ram_budget = (size_t)strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--handle-cache") == 0 && has_value) {
+            handle_cache = atoi(argv[++i]);
+        } else if (strcmp(arg, "--io-stats") == 0) {
+            io_stats = true;
+        } else if (strcmp(arg, "--telemetry") == 0) {
+            telemetry = true;
+        } else if (strcmp(arg, "--profile") == 0) {
+            profile = true;
+        } else if (strcmp(arg, "--trace") == 0 && has_value) {
+            trace_path = argv[++i];
+        } else if (strcmp(arg, "--threads") == 0 && has_value) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(arg, "--gnss-pool") == 0) {
+            gnss_pool = true;
+        } else if (strcmp(arg, "--async") == 0) {
+            async_io = true;
+        } else if (strcmp(arg, "--verify") == 0) {
+            verify = true;
+        } else if (strcmp(arg, "--keep") == 0) {
+            keep = true;
+        } else if (strcmp(arg, "--quiet") == 0) {
+            Serial.setEnabled(false);
+        } else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (arg[0] == '-' && arg[1] != '\0') {
+            fprintf(stderr, "Unknown or incomplete option: %s\n", arg);
+            print_usage(argv[0]);
+            return 2;
+        } else if (!input_path) {
+            input_path = arg;
+        } else if (!output_path) {
+            output_path = arg;
+        } else {
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (!input_path || !output_path) {
+        print_usage(argv[0]);
+        return 2;
+    }
+    if (format == INPUT_AUTO) {
+        format = (has_suffix(input_path, ".jpg") || has_suffix(input_path, ".jpeg")) ? INPUT_JPEG : INPUT_YUV422;
+    }
+    if (format != INPUT_JPEG && (width == 0 || height == 0)) {
+        fprintf(stderr, "--width and --height are required for raw input\n");
+        return 2;
+    }
+    if (stages < 1 || stages > ICER_MAX_DECOMP_STAGES || segments < 1 || segments > ICER_MAX_SEGMENTS ||
+        filter_type < 0 || filter_type > 6) {
+        fprintf(stderr, "Invalid stages/segments/filter\n");
+        return 2;
+    }
+    if (threads < 1) {
+        fprintf(stderr, "Invalid thread count\n");
+        return 2;
+    }
+    if ((profile || trace_path) && !ICER_PROFILE) {
+        fprintf(stderr, "--profile and --trace need a build with -DICER_PROFILE=ON\n");
+        return 2;
+    }
+
+    initMemoryPools(gnss_pool);
+
+    IFileSystem* fs = NULL;
+    if (strcmp(backend, "posix") == 0) {
+        fs = createPosixFileSystem(workdir);
+    } else if (strcmp(backend, "mmap") == 0) {
+        fs = createMmapFileSystem(workdir);
+    } else {
+        fprintf(stderr, "Unknown backend: %s\n", backend);
+        return 2;
+    }
+    if (fs && io_stats) {
+        // Directly over the backend, so the counters show real file system traffic
+        fs = createIoStatsFileSystem(fs, true);
+    }
+    if (fs && async_io) {
+        fs = createAsyncFileSystem(fs, 16384, 3, true);
+    }
+    if (fs && ram_budget > 0) {
+        fs = createTieredFileSystem(fs, ram_budget, NULL, NULL, true);
+    }
+    if (fs && handle_cache > 0) {
+        fs = createHandleCacheFileSystem(fs, (uint8_t)handle_cache, true);
+    }
+    if (!fs || !fs->begin()) {
+        fprintf(stderr, "Failed to initialize %s file system in %s\n", backend, workdir);
+        delete fs;
+        return 1;
+    }
+
+    size_t input_size = 0;
+    uint8_t* input = read_whole_file(input_path, &input_size);
+    if (!input) {
+        fprintf(stderr, "Failed to read %s\n", input_path);
+        delete fs;
+        return 1;
+    }
+
+    icerProfileReset();
+    if (trace_path && icerProfileTraceStart(TRACE_MAX_EVENTS) != 0) {
+        fprintf(stderr, "Not enough memory for the trace\n");
+        free(input);
+        delete fs;
+        return 1;
+    }
+
+    unsigned long start_ms = millis();
+
+    // Step 1: split the input into Y, U, V uint16 channel files
+    ioStatsSetPhase(IO_PHASE_INGEST);
+    int convert_result = ingest_frame(fs, input, input_size, format, &width, &height);
+    free(input);
+    icerLogFlush();
+
+    if (convert_result != 0) {
+        fprintf(stderr, "Channel conversion failed: %d\n", convert_result);
+        delete fs;
+        return 1;
+    }
+
+    unsigned long convert_ms = millis() - start_ms;
+
+    // Step 2: run the flash pipeline
+    // Segments are committed in segment order, so the output does not depend on the thread count
+    ITaskPool* segment_pool = NULL;
+    if (threads > 1) {
+        segment_pool = createThreadTaskPool(threads);
+        setSegmentTaskPool(segment_pool);
+    }
+    IcerCompressionResult result = compressYuvWithIcerFlash(
+        fs, Y_FILE, U_FILE, V_FILE, width, height,
+        (uint8_t)stages, (uint8_t)filter_type, (uint8_t)segments,
+        target_size, RESULT_FILE, false);
+    setSegmentTaskPool(NULL);
+    delete segment_pool;
+
+    unsigned long total_ms = millis() - start_ms;
+    icerTelemetryAddPhase(ICER_PHASE_INGEST, convert_ms * 1000);
+
+    // Step 3: decode the result on the same file system and compare
+    int verify_status = 0;
+    if (verify && result.success) {
+        unsigned long verify_start_us = micros();
+        verify_status = verify_result(fs, width, height, stages, filter_type, segments);
+        icerTelemetryAddPhase(ICER_PHASE_VERIFY, (uint32_t)(micros() - verify_start_us));
+    }
+
+    if (!keep) {
+        fs->remove(Y_FILE);
+        fs->remove(U_FILE);
+        fs->remove(V_FILE);
+        fs->remove(Y_DECODED_FILE);
+        fs->remove(U_DECODED_FILE);
+        fs->remove(V_DECODED_FILE);
+    }
+
+    if (result.io_stats) {
+        Serial.setEnabled(true);  // Report even with --quiet
+        printIoStats(result.io_stats);
+    }
+    if (telemetry) {
+        Serial.setEnabled(true);
+        printIcerTelemetry(result.telemetry);
+    }
+    if (gnss_pool) {
+        Serial.setEnabled(true);
+        printPoolStats("after compression");
+    }
+    if (profile) {
+        Serial.setEnabled(true);
+        printIcerProfile();
+    }
+    if (trace_path) {
+        if (icerProfileWriteChromeTrace(trace_path) != 0) {
+            fprintf(stderr, "Failed to write %s\n", trace_path);
+        }
+        icerProfileTraceStop();
+    }
+
+    if (!result.success) {
+        fprintf(stderr, "ICER compression failed: %d\n", result.error_code);
+        delete fs;
+        return 1;
+    }
+
+    bool copied = copy_result(fs, RESULT_FILE, output_path, result.compressed_size);
+    if (!keep) {
+        fs->remove(RESULT_FILE);
+    }
+    delete fs;
+    if (!copied) {
+        fprintf(stderr, "Failed to write %s\n", output_path);
+        return 1;
+    }
+
+    printf("%s: %zux%zu -> %zu bytes (convert %lu ms, total %lu ms, backend %s)\n",
+           output_path, width, height, result.compressed_size, convert_ms, total_ms, backend);
+    return verify_status;
+}
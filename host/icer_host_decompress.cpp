@@ -0,0 +1,300 @@
+// Host decoder for ICER files written by the flash pipeline
+//
+// Turns CAPTURE.ICER (or the output of icer_host_compress) back into pixels:
+// the file is mmapped, its packets are indexed with
+// icer_find_packet_in_bytestream, the Y, U and V channels are decoded with the
+// uint16 ICER decoder and the result is written as an image. Used for ground
+// side turnaround and for checking on-device output against the host pipeline.
+//
+// Usage:
+//   icer_host_decompress [options] <input> <output>
+//
+// Output formats:
+//   png     RGB PNG (BT.601 YUV -> RGB, the inverse of camera_yuv.cpp)
+//   pgm     Y channel as 8-bit greyscale PGM
+//   yuv16   Planar uint16 Y, U, V planes back to back (icer_host_compress input)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "task_pool.h"
+#include "camera_yuv.h"
+#include "host_util.h"
+
+extern "C" {
+#include "icer.h"
+}
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+enum OutputFormat {
+    OUTPUT_AUTO,
+    OUTPUT_PNG,
+    OUTPUT_PGM,
+    OUTPUT_YUV16
+};
+
+// One decode job per channel, run on the task pool
+struct ChannelJob {
+    uint16_t* planes[ICER_CHANNEL_MAX + 1];
+    uint16_t ll_mean[ICER_CHANNEL_MAX + 1];
+    int results[ICER_CHANNEL_MAX + 1];
+    size_t width;
+    size_t height;
+    uint8_t stages;
+    enum icer_filter_types filter;
+    uint8_t segments;
+};
+
+static void print_usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s [options] <input> <output>\n"
+            "\n"
+            "Options:\n"
+            "  --format png|pgm|yuv16      Output format (default: from extension, .pgm = pgm,\n"
+            "                              .yuv16/.raw = yuv16, anything else png)\n"
+            "  --stages N                  Wavelet decomposition stages used to encode (default 4)\n"
+            "  --filter N                  ICER filter type 0-6 used to encode (default 0)\n"
+            "  --segments N                Error containment segments used to encode (default 6)\n"
+            "  --budget BYTES              Decode only the first BYTES of the file (default 0 = all),\n"
+            "                              e.g. to preview what a partial downlink gives\n"
+            "  --threads N                 Decode the Y, U and V channels on up to N threads (default 1)\n"
+            "  --quiet                     Only report errors\n",
+            prog);
+}
+
+static void decode_channel(void* context, size_t index, int worker) {
+    (void)worker;
+    ChannelJob* job = static_cast<ChannelJob*>(context);
+    job->results[index] = icer_decompress_channel_uint16(job->planes[index], (enum icer_color_channels)index,
+                                                         job->width, job->height, job->stages, job->filter,
+                                                         job->segments, job->ll_mean[index]);
+}
+
+// Packets found by the last icer_index_yuv_packets_uint16 call
+static size_t count_indexed_packets(void) {
+    size_t count = 0;
+    for (int chan = ICER_CHANNEL_MIN; chan <= ICER_CHANNEL_MAX; chan++) {
+        for (int stage = 0; stage <= ICER_MAX_DECOMP_STAGES; stage++) {
+            for (int subband = 0; subband <= ICER_SUBBAND_MAX; subband++) {
+                for (int seg = 0; seg <= ICER_MAX_SEGMENTS; seg++) {
+                    for (int lsb = 0; lsb < ICER_BITPLANES_TO_COMPRESS_16; lsb++) {
+                        if (icer_reconstruct_data_16[chan][stage][subband][seg][lsb] != NULL) {
+                            count++;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return count;
+}
+
+static bool write_pgm(const char* path, const uint16_t* y, size_t width, size_t height) {
+    FILE* fp = fopen(path, "wb");
+    if (!fp) {
+        return false;
+    }
+    fprintf(fp, "P5\n%zu %zu\n255\n", width, height);
+    uint8_t* row = (uint8_t*)malloc(width);
+    bool ok = row != NULL;
+    for (size_t r = 0; ok && r < height; r++) {
+        for (size_t c = 0; c < width; c++) {
+            row[c] = clampToUint8(y[r * width + c]);
+        }
+        ok = fwrite(row, 1, width, fp) == width;
+    }
+    free(row);
+    return (fclose(fp) == 0) && ok;
+}
+
+static bool write_yuv16(const char* path, uint16_t* const planes[], size_t pixels) {
+    FILE* fp = fopen(path, "wb");
+    if (!fp) {
+        return false;
+    }
+    bool ok = true;
+    for (int chan = ICER_CHANNEL_MIN; ok && chan <= ICER_CHANNEL_MAX; chan++) {
+        ok = fwrite(planes[chan], sizeof(uint16_t), pixels, fp) == pixels;
+    }
+    return (fclose(fp) == 0) && ok;
+}
+
+int main(int argc, char** argv) {
+    OutputFormat format = OUTPUT_AUTO;
+    int stages = 4;
+    int filter_type = 0;
+    int segments = 6;
+    size_t budget = 0;
+    int threads = 1;
+    bool quiet = false;
+    const char* input_path = NULL;
+    const char* output_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool has_value = (i + 1 < argc);
+        if (strcmp(arg, "--format") == 0 && has_value) {
+            const char* value = argv[++i];
+            if (strcmp(value, "png") == 0) format = OUTPUT_PNG;
+            else if (strcmp(value, "pgm") == 0) format = OUTPUT_PGM;
+            else if (strcmp(value, "yuv16") == 0) format = OUTPUT_YUV16;
+            else { print_usage(argv[0]); return 2; }
+        } else if (strcmp(arg, "--stages") == 0 && has_value) {
+            stages = atoi(argv[++i]);
+        } else if (strcmp(arg, "--filter") == 0 && has_value) {
+            filter_type = atoi(argv[++i]);
+        } else if (strcmp(arg, "--segments") == 0 && has_value) {
+            segments = atoi(argv[++i]);
+        } else if (strcmp(arg, "--budget") == 0 && has_value) {
+            budget = (size_t)strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--threads") == 0 && has_value) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(arg, "--quiet") == 0) {
+            quiet = true;
+        } else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (arg[0] == '-' && arg[1] != '\0') {
+            fprintf(stderr, "Unknown or incomplete option: %s\n", arg);
+            print_usage(argv[0]);
+            return 2;
+        } else if (!input_path) {
+            input_path = arg;
+        } else if (!output_path) {
+            output_path = arg;
+        } else {
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (!input_path || !output_path) {
+        print_usage(argv[0]);
+        return 2;
+    }
+    if (format == OUTPUT_AUTO) {
+        if (has_suffix(output_path, ".pgm")) format = OUTPUT_PGM;
+        else if (has_suffix(output_path, ".yuv16") || has_suffix(output_path, ".raw")) format = OUTPUT_YUV16;
+        else format = OUTPUT_PNG;
+    }
+    if (stages < 1 || stages > ICER_MAX_DECOMP_STAGES || segments < 1 || segments > ICER_MAX_SEGMENTS ||
+        filter_type < 0 || filter_type > 6) {
+        fprintf(stderr, "Invalid stages/segments/filter\n");
+        return 2;
+    }
+    if (threads < 1) {
+        fprintf(stderr, "Invalid thread count\n");
+        return 2;
+    }
+
+    int fd = open(input_path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to open %s\n", input_path);
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        fprintf(stderr, "Empty or unreadable input %s\n", input_path);
+        close(fd);
+        return 1;
+    }
+    size_t file_size = (size_t)st.st_size;
+    void* map = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "Failed to map %s\n", input_path);
+        return 1;
+    }
+    const uint8_t* datastream = (const uint8_t*)map;
+    size_t data_length = (budget > 0 && budget < file_size) ? budget : file_size;
+
+    double start_ms = now_ms();
+
+    // Step 1: index the packets (the decoder reads them in place from the mapping)
+    size_t width = 0;
+    size_t height = 0;
+    ChannelJob job;
+    icer_index_yuv_packets_uint16(datastream, data_length, &width, &height, job.ll_mean);
+    size_t packets = count_indexed_packets();
+    if (packets == 0 || width == 0 || height == 0) {
+        fprintf(stderr, "No ICER packets in the first %zu bytes of %s\n", data_length, input_path);
+        munmap(map, file_size);
+        return 1;
+    }
+    double index_ms = now_ms() - start_ms;
+
+    // Step 2: decode the channels, one task each
+    size_t pixels = width * height;
+    bool planes_ok = true;
+    for (int chan = ICER_CHANNEL_MIN; chan <= ICER_CHANNEL_MAX; chan++) {
+        job.planes[chan] = (uint16_t*)malloc(pixels * sizeof(uint16_t));
+        job.results[chan] = ICER_RESULT_OK;
+        planes_ok = planes_ok && job.planes[chan] != NULL;
+    }
+    job.width = width;
+    job.height = height;
+    job.stages = (uint8_t)stages;
+    job.filter = (enum icer_filter_types)filter_type;
+    job.segments = (uint8_t)segments;
+
+    int exit_code = 0;
+    ITaskPool* pool = NULL;
+    if (planes_ok) {
+        pool = createThreadTaskPool(threads < ICER_CHANNEL_MAX + 1 ? threads : ICER_CHANNEL_MAX + 1);
+    }
+    if (!pool) {
+        fprintf(stderr, "Out of memory for a %zux%zu image\n", width, height);
+        exit_code = 1;
+    } else {
+        pool->run(ICER_CHANNEL_MAX + 1, decode_channel, &job);
+        delete pool;
+        for (int chan = ICER_CHANNEL_MIN; chan <= ICER_CHANNEL_MAX; chan++) {
+            if (job.results[chan] != ICER_RESULT_OK) {
+                fprintf(stderr, "ICER decode of channel %d failed: %d\n", chan, job.results[chan]);
+                exit_code = 1;
+            }
+        }
+    }
+    munmap(map, file_size);
+    double decode_ms = now_ms() - start_ms - index_ms;
+
+    // Step 3: write the image
+    if (exit_code == 0) {
+        bool written = false;
+        if (format == OUTPUT_PGM) {
+            written = write_pgm(output_path, job.planes[ICER_CHANNEL_Y], width, height);
+        } else if (format == OUTPUT_YUV16) {
+            written = write_yuv16(output_path, job.planes, pixels);
+        } else {
+            uint8_t* rgb = (uint8_t*)malloc(pixels * 3);
+            if (rgb) {
+                yuvToRgb888(job.planes[ICER_CHANNEL_Y], job.planes[ICER_CHANNEL_U], job.planes[ICER_CHANNEL_V],
+                            pixels, rgb);
+                written = stbi_write_png(output_path, (int)width, (int)height, 3, rgb, (int)(width * 3)) != 0;
+                free(rgb);
+            }
+        }
+        if (!written) {
+            fprintf(stderr, "Failed to write %s\n", output_path);
+            exit_code = 1;
+        }
+    }
+
+    for (int chan = ICER_CHANNEL_MIN; chan <= ICER_CHANNEL_MAX; chan++) {
+        free(job.planes[chan]);
+    }
+
+    if (exit_code == 0 && !quiet) {
+        printf("%s: %zu of %zu bytes, %zu packets -> %zux%zu (index %.1f ms, decode %.1f ms, %d threads)\n",
+               output_path, data_length, file_size, packets, width, height, index_ms, decode_ms, threads);
+    }
+    return exit_code;
+}
@@ -0,0 +1,456 @@
+// End-to-end benchmark of the flash pipeline on a simulated SD card
+//
+// Runs convertJpegToSeparateChannels -> compressYuvWithIcerFlash, the path
+// main.cpp takes for every capture, with a simulated SD card layer
+// (simulated_sd_filesystem.h) directly over the POSIX or mmap backend. For
+// every frame it reports the real wall and CPU time on this machine next to
+// the card time the same I/O would take on the board, and an estimate of the
+// on-device time:
+//   (wall - host I/O) * cpu-scale + simulated card time
+// cpu-scale accounts for the slower CPU of the board (measure it once as the
+// ratio of the compute time on the board to the compute time here).
+//
+// Without --image the frames are synthetic JPEGs at QVGA, VGA and QUADVGA,
+// generated deterministically, so runs on different commits see the same input.
+//
+// Usage:
+//   icer_pipeline_bench [options]
+//   icer_pipeline_bench --async --json async.json
+//   icer_pipeline_bench --image capture.jpg --sd-write-kbps 2000
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "filesystem_interface.h"
+#include "posix_filesystem.h"
+#include "mmap_filesystem.h"
+#include "tiered_filesystem.h"
+#include "async_filesystem.h"
+#include "handle_cache_filesystem.h"
+#include "io_stats_filesystem.h"
+#include "simulated_sd_filesystem.h"
+#include "task_pool.h"
+#include "memory_arena.h"
+#include "flash_icer_compression.h"
+#include "host_util.h"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+#define MAX_FRAMES 16
+
+// One input frame, a JPEG in memory
+struct Frame {
+    char name[64];
+    uint8_t* jpeg;
+    size_t jpeg_size;
+};
+
+// Measurements of one pipeline run
+struct RunResult {
+    const char* name;   // Frame::name (the frames outlive the results)
+    size_t width;
+    size_t height;
+    size_t compressed_size;
+    double wall_ms;
+    double cpu_ms;
+    double host_io_ms;
+    double estimate_ms;
+    SimulatedSdStats sd;
+};
+
+static void print_usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "\n"
+            "Options:\n"
+            "  --image FILE                JPEG frame to run (repeatable, default: synthetic QVGA, VGA, QUADVGA)\n"
+            "  --stages N                  Wavelet decomposition stages (default 4)\n"
+            "  --filter N                  ICER filter type 0-6 (default 0)\n"
+            "  --segments N                Error containment segments (default 6)\n"
+            "  --target BYTES              Target compressed size, 0 = lossless (default 409600)\n"
+            "  --backend posix|mmap        File system backend (default posix)\n"
+            "  --workdir DIR               Directory for intermediate files (default .)\n"
+            "  --async                     Background writer thread and prefetching reads\n"
+            "  --ram-budget BYTES          Keep intermediates that fit in a RAM tier (default 0 = off)\n"
+            "  --handle-cache N            Keep N read handles open across reopens (default 4, 0 = off)\n"
+            "  --threads N                 Encode the segments of a packet on N threads (default 1)\n"
+            "  --repeat N                  Runs per frame, the fastest is reported (default 1)\n"
+            "  --cpu-scale X               Board / host compute time ratio for the estimate (default 1)\n"
+            "  --sd-command-us N           Card model, see simulated_sd_filesystem.h (defaults from\n"
+            "  --sd-sector N                 simulatedSdDefaultParams)\n"
+            "  --sd-read-kbps N\n"
+            "  --sd-write-kbps N\n"
+            "  --sd-random-ratio N\n"
+            "  --sd-lookup-us N\n"
+            "  --sd-create-us N\n"
+            "  --sd-sync-us N\n"
+            "  --sd-stall-us N\n"
+            "  --sd-stall-bytes N\n"
+            "  --json FILE                 Write the results as JSON (- = stdout)\n"
+            "  --verbose                   Pipeline progress and the card breakdown of every run\n",
+            prog);
+}
+
+static double cpu_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// stbi_write_jpg_to_func sink: append to a growing buffer
+struct JpegSink {
+    uint8_t* data;
+    size_t size;
+    size_t capacity;
+    bool failed;
+};
+
+static void jpeg_sink_write(void* context, void* data, int size) {
+    JpegSink* sink = static_cast<JpegSink*>(context);
+    if (sink->failed || size <= 0) {
+        return;
+    }
+    if (sink->size + (size_t)size > sink->capacity) {
+        size_t capacity = (sink->capacity > 0) ? sink->capacity * 2 : 65536;
+        while (capacity < sink->size + (size_t)size) {
+            capacity *= 2;
+        }
+        uint8_t* grown = (uint8_t*)realloc(sink->data, capacity);
+        if (!grown) {
+            sink->failed = true;
+            return;
+        }
+        sink->data = grown;
+        sink->capacity = capacity;
+    }
+    memcpy(sink->data + sink->size, data, (size_t)size);
+    sink->size += (size_t)size;
+}
+
+// The synthetic scene of host_util, JPEG compressed at the quality the camera is
+// configured for
+static bool make_synthetic_frame(Frame* frame, const char* name, int width, int height) {
+    uint8_t* rgb = (uint8_t*)malloc((size_t)width * height * 3);
+    if (!rgb) {
+        return false;
+    }
+    make_synthetic_rgb(rgb, (size_t)width, (size_t)height);
+
+    JpegSink sink = {NULL, 0, 0, false};
+    int ok = stbi_write_jpg_to_func(jpeg_sink_write, &sink, width, height, 3, rgb, 90);
+    free(rgb);
+    if (!ok || sink.failed) {
+        free(sink.data);
+        return false;
+    }
+    snprintf(frame->name, sizeof(frame->name), "%s", name);
+    frame->jpeg = sink.data;
+    frame->jpeg_size = sink.size;
+    return true;
+}
+
+// One pipeline run of frame on fs; false if conversion or compression failed
+static bool run_frame(IFileSystem* fs, const Frame* frame, uint8_t stages, uint8_t filter_type, uint8_t segments,
+                      size_t target_size, double cpu_scale, RunResult* out) {
+    simulatedSdReset();
+    double wall_start = now_ms();
+    double cpu_start = cpu_ms();
+
+    size_t width = 0;
+    size_t height = 0;
+    ioStatsSetPhase(IO_PHASE_INGEST);
+    int convert_result = ingest_frame(fs, frame->jpeg, frame->jpeg_size, INPUT_JPEG, &width, &height);
+    IcerCompressionResult result;
+    memset(&result, 0, sizeof(result));
+    if (convert_result == 0) {
+        result = compressYuvWithIcerFlash(fs, Y_FILE, U_FILE, V_FILE, width, height,
+                                          stages, filter_type, segments, target_size, RESULT_FILE, false);
+    }
+
+    double wall = now_ms() - wall_start;
+    double cpu = cpu_ms() - cpu_start;
+    const SimulatedSdStats* sd = simulatedSdSnapshot();
+
+    fs->remove(Y_FILE);
+    fs->remove(U_FILE);
+    fs->remove(V_FILE);
+    fs->remove(RESULT_FILE);
+
+    if (convert_result != 0) {
+        fprintf(stderr, "%s: channel conversion failed: %d\n", frame->name, convert_result);
+        return false;
+    }
+    if (!result.success) {
+        fprintf(stderr, "%s: ICER compression failed: %d\n", frame->name, result.error_code);
+        return false;
+    }
+
+    out->name = frame->name;
+    out->width = width;
+    out->height = height;
+    out->compressed_size = result.compressed_size;
+    out->wall_ms = wall;
+    out->cpu_ms = cpu;
+    out->sd = *sd;
+    out->host_io_ms = sd->host_us / 1000.0;
+    double compute_ms = (wall > out->host_io_ms) ? wall - out->host_io_ms : 0;
+    out->estimate_ms = compute_ms * cpu_scale + sd->simulated_us / 1000.0;
+    return true;
+}
+
+static bool write_json(const char* path, const RunResult* runs, size_t count, const SimulatedSdParams* card,
+                       double cpu_scale) {
+    FILE* fp = (strcmp(path, "-") == 0) ? stdout : fopen(path, "w");
+    if (!fp) {
+        return false;
+    }
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"sd\": {\"command_us\": %u, \"sector_size\": %u, \"read_kbps\": %u, \"write_kbps\": %u, "
+                "\"random_ratio\": %u, \"lookup_us\": %u, \"create_us\": %u, \"sync_us\": %u, "
+                "\"program_stall_us\": %u, \"program_stall_bytes\": %u},\n",
+            (unsigned)card->command_us, (unsigned)card->sector_size, (unsigned)card->read_kbps,
+            (unsigned)card->write_kbps, (unsigned)card->random_ratio, (unsigned)card->lookup_us,
+            (unsigned)card->create_us, (unsigned)card->sync_us, (unsigned)card->program_stall_us,
+            (unsigned)card->program_stall_bytes);
+    fprintf(fp, "  \"cpu_scale\": %.3f,\n", cpu_scale);
+    fprintf(fp, "  \"results\": [\n");
+    for (size_t i = 0; i < count; i++) {
+        const RunResult* r = &runs[i];
+        fprintf(fp, "    {\"name\": \"%s\", \"width\": %zu, \"height\": %zu, \"compressed_bytes\": %zu, "
+                    "\"wall_ms\": %.2f, \"cpu_ms\": %.2f, \"host_io_ms\": %.2f, \"sd_ms\": %.2f, "
+                    "\"sd_command_ms\": %.2f, \"sd_transfer_ms\": %.2f, \"sd_directory_ms\": %.2f, "
+                    "\"sd_stall_ms\": %.2f, \"sd_commands\": %u, \"sd_random_commands\": %u, "
+                    "\"estimate_ms\": %.2f}%s\n",
+                r->name, r->width, r->height, r->compressed_size, r->wall_ms, r->cpu_ms, r->host_io_ms,
+                r->sd.simulated_us / 1000.0, r->sd.command_us / 1000.0, r->sd.transfer_us / 1000.0,
+                r->sd.lookup_us / 1000.0, r->sd.stall_us / 1000.0, (unsigned)r->sd.commands,
+                (unsigned)r->sd.random_commands, r->estimate_ms, (i + 1 < count) ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+    bool ok = !ferror(fp);
+    if (fp != stdout) {
+        ok = (fclose(fp) == 0) && ok;
+    }
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    const char* image_paths[MAX_FRAMES];
+    size_t image_count = 0;
+    int stages = 4;
+    int filter_type = 0;
+    int segments = 6;
+    size_t target_size = 400 * 1024;
+    const char* backend = "posix";
+    const char* workdir = ".";
+    size_t ram_budget = 0;
+    bool async_io = false;
+    int handle_cache = 4;
+    int threads = 1;
+    int repeat = 1;
+    double cpu_scale = 1.0;
+    const char* json_path = NULL;
+    bool verbose = false;
+    SimulatedSdParams card;
+    simulatedSdDefaultParams(&card);
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool has_value = (i + 1 < argc);
+        if (strcmp(arg, "--image") == 0 && has_value) {
+            if (image_count == MAX_FRAMES) {
+                fprintf(stderr, "At most %d images\n", MAX_FRAMES);
+                return 2;
+            }
+            image_paths[image_count++] = argv[++i];
+        } else if (strcmp(arg, "--stages") == 0 && has_value) {
+            stages = atoi(argv[++i]);
+        } else if (strcmp(arg, "--filter") == 0 && has_value) {
+            filter_type = atoi(argv[++i]);
+        } else if (strcmp(arg, "--segments") == 0 && has_value) {
+            segments = atoi(argv[++i]);
+        } else if (strcmp(arg, "--target") == 0 && has_value) {
+            target_size = (size_t)strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--backend") == 0 && has_value) {
+            backend = argv[++i];
+        } else if (strcmp(arg, "--workdir") == 0 && has_value) {
+            workdir = argv[++i];
+        } else if (strcmp(arg, "--ram-budget") == 0 && has_value) {
+            ram_budget = (size_t)strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--handle-cache") == 0 && has_value) {
+            handle_cache = atoi(argv[++i]);
+        } else if (strcmp(arg, "--threads") == 0 && has_value) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(arg, "--async") == 0) {
+            async_io = true;
+        } else if (strcmp(arg, "--repeat") == 0 && has_value) {
+            repeat = atoi(argv[++i]);
+        } else if (strcmp(arg, "--cpu-scale") == 0 && has_value) {
+            cpu_scale = atof(argv[++i]);
+        } else if (strcmp(arg, "--sd-command-us") == 0 && has_value) {
+            card.command_us = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--sd-sector") == 0 && has_value) {
+            card.sector_size = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--sd-read-kbps") == 0 && has_value) {
+            card.read_kbps = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--sd-write-kbps") == 0 && has_value) {
+            card.write_kbps = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--sd-random-ratio") == 0 && has_value) {
+            card.random_ratio = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--sd-lookup-us") == 0 && has_value) {
+            card.lookup_us = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--sd-create-us") == 0 && has_value) {
+            card.create_us = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--sd-sync-us") == 0 && has_value) {
+            card.sync_us = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--sd-stall-us") == 0 && has_value) {
+            card.program_stall_us = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--sd-stall-bytes") == 0 && has_value) {
+            card.program_stall_bytes = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--json") == 0 && has_value) {
+            json_path = argv[++i];
+        } else if (strcmp(arg, "--verbose") == 0) {
+            verbose = true;
+        } else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            fprintf(stderr, "Unknown or incomplete option: %s\n", arg);
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (stages < 1 || stages > ICER_MAX_DECOMP_STAGES || segments < 1 || segments > ICER_MAX_SEGMENTS ||
+        filter_type < 0 || filter_type > 6) {
+        fprintf(stderr, "Invalid stages/segments/filter\n");
+        return 2;
+    }
+    if (threads < 1 || repeat < 1 || cpu_scale <= 0) {
+        fprintf(stderr, "Invalid --threads/--repeat/--cpu-scale\n");
+        return 2;
+    }
+    if (card.sector_size == 0 || card.read_kbps == 0 || card.write_kbps == 0) {
+        fprintf(stderr, "Invalid card model\n");
+        return 2;
+    }
+    Serial.setEnabled(verbose);
+
+    // Input frames
+    Frame frames[MAX_FRAMES];
+    size_t frame_count = 0;
+    if (image_count > 0) {
+        for (size_t i = 0; i < image_count; i++) {
+            Frame* frame = &frames[frame_count];
+            frame->jpeg = read_whole_file(image_paths[i], &frame->jpeg_size);
+            if (!frame->jpeg) {
+                fprintf(stderr, "Failed to read %s\n", image_paths[i]);
+                return 1;
+            }
+            snprintf(frame->name, sizeof(frame->name), "%s", base_name(image_paths[i]));
+            frame_count++;
+        }
+    } else {
+        static const struct { const char* name; int width; int height; } sizes[] = {
+            {"qvga", 320, 240}, {"vga", 640, 480}, {"quadvga", 1280, 960}
+        };
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+            if (!make_synthetic_frame(&frames[frame_count], sizes[i].name, sizes[i].width, sizes[i].height)) {
+                fprintf(stderr, "Failed to generate the %s frame\n", sizes[i].name);
+                return 1;
+            }
+            frame_count++;
+        }
+    }
+
+    initMemoryPools(false);
+
+    // The simulated card sits directly over the backend, below the layers that
+    // change what reaches the card
+    IFileSystem* fs = NULL;
+    if (strcmp(backend, "posix") == 0) {
+        fs = createPosixFileSystem(workdir);
+    } else if (strcmp(backend, "mmap") == 0) {
+        fs = createMmapFileSystem(workdir);
+    } else {
+        fprintf(stderr, "Unknown backend: %s\n", backend);
+        return 2;
+    }
+    if (fs) {
+        fs = createSimulatedSDFileSystem(fs, &card, true);
+    }
+    if (fs && async_io) {
+        fs = createAsyncFileSystem(fs, 16384, 3, true);
+    }
+    if (fs && ram_budget > 0) {
+        fs = createTieredFileSystem(fs, ram_budget, NULL, NULL, true);
+    }
+    if (fs && handle_cache > 0) {
+        fs = createHandleCacheFileSystem(fs, (uint8_t)handle_cache, true);
+    }
+    if (!fs || !fs->begin()) {
+        fprintf(stderr, "Failed to initialize %s file system in %s\n", backend, workdir);
+        delete fs;
+        return 1;
+    }
+
+    ITaskPool* segment_pool = NULL;
+    if (threads > 1) {
+        segment_pool = createThreadTaskPool(threads);
+        setSegmentTaskPool(segment_pool);
+    }
+
+    // With --json - the table goes to stderr so stdout stays valid JSON
+    FILE* report = (json_path && strcmp(json_path, "-") == 0) ? stderr : stdout;
+    fprintf(report, "%-12s %10s %10s %9s %9s %9s %9s %11s\n",
+            "frame", "size", "bytes", "wall ms", "cpu ms", "host io", "sd ms", "estimate ms");
+
+    RunResult runs[MAX_FRAMES];
+    int status = 0;
+    for (size_t f = 0; f < frame_count; f++) {
+        RunResult best;
+        bool have_best = false;
+        for (int rep = 0; rep < repeat; rep++) {
+            RunResult run;
+            if (!run_frame(fs, &frames[f], (uint8_t)stages, (uint8_t)filter_type, (uint8_t)segments,
+                           target_size, cpu_scale, &run)) {
+                status = 1;
+                break;
+            }
+            if (!have_best || run.wall_ms < best.wall_ms) {
+                best = run;
+                have_best = true;
+            }
+        }
+        if (!have_best) {
+            break;
+        }
+        runs[f] = best;
+        char size[24];
+        snprintf(size, sizeof(size), "%zux%zu", best.width, best.height);
+        fprintf(report, "%-12s %10s %10zu %9.1f %9.1f %9.1f %9.1f %11.1f\n",
+                best.name, size, best.compressed_size, best.wall_ms, best.cpu_ms, best.host_io_ms,
+                best.sd.simulated_us / 1000.0, best.estimate_ms);
+        if (verbose) {
+            printSimulatedSdStats(&best.sd);
+        }
+    }
+
+    setSegmentTaskPool(NULL);
+    delete segment_pool;
+    delete fs;
+    for (size_t f = 0; f < frame_count; f++) {
+        free(frames[f].jpeg);
+    }
+
+    if (status == 0 && json_path && !write_json(json_path, runs, frame_count, &card, cpu_scale)) {
+        fprintf(stderr, "Cannot write %s\n", json_path);
+        return 1;
+    }
+    return status;
+}
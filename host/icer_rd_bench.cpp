@@ -0,0 +1,617 @@
+// Rate-distortion-time sweep of the ICER parameters over a corpus of captures
+//
+// For every frame and every combination of stages, filter and segment count
+// the frame is compressed once, losslessly, with the flash pipeline. Each byte
+// budget is then cut out of that single encode instead of compressing again:
+// ICER encodes packets in priority order, each segment independently, and with
+// a byte quota stops at the first segment that does not fit. Replaying that
+// rule over the segments of the lossless stream (in the packet order of
+// icer_compress_image_yuv_uint16) gives exactly the stream a compression with
+// that quota would write. --reencode compresses every budget as well, checks
+// that the two streams are identical and reports the real encode time.
+//
+// Every stream is decoded with the flash decoder and compared with the input.
+// One CSV row per frame, parameter set and budget:
+//   image, width, height, stages, filter, segments, target_bytes,
+//   bytes, bpp, encode_ms, decode_ms, encode_peak_bytes, decode_peak_bytes,
+//   psnr_y, psnr_u, psnr_v, psnr, ssim_y, ssim_u, ssim_v
+// encode_ms is the time of the shared lossless encode unless --reencode is
+// given; the peaks are the high-water marks of the memory pools
+// (memory_arena.h), which hold every buffer of both paths. PSNR is "inf" for
+// lossless rows, SSIM uses 8x8 windows with a step of 4.
+//
+// Usage:
+//   icer_rd_bench [options] <frame> [<frame> ...]
+//   icer_rd_bench --workdir /tmp --csv rd.csv captures/*.jpg
+//   icer_rd_bench --format yuv422 --width 640 --height 480 --targets 100000,409600 frame.yuv
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "filesystem_interface.h"
+#include "posix_filesystem.h"
+#include "mmap_filesystem.h"
+#include "memory_arena.h"
+#include "flash_icer_compression.h"
+#include "flash_icer_decompression.h"
+#include "host_util.h"
+
+extern "C" {
+#include "icer.h"
+}
+
+// Stream cut out of the lossless encode for one budget
+static const char* TRUNCATED_FILE = "_icer_truncated.tmp";
+
+// One segment of an ICER stream
+struct SegmentRef {
+    size_t offset;      // Header position in the stream
+    size_t size;        // Header and data
+    uint8_t chan;
+    uint8_t stage;
+    uint8_t subband;
+    uint8_t lsb;
+    uint8_t segment;
+};
+
+// Quality of one decoded frame
+struct Quality {
+    double mse[3];
+    double psnr[3];
+    double psnr_all;
+    double ssim[3];
+};
+
+static void print_usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s [options] <frame> [<frame> ...]\n"
+            "\n"
+            "Frames are JPEG files, or raw frames of --format with --width/--height.\n"
+            "\n"
+            "Options:\n"
+            "  --format yuv422|yuv16       Format of raw frames (default: by extension, .jpg/.jpeg = JPEG)\n"
+            "  --width N, --height N       Size of raw frames\n"
+            "  --stages LIST               Wavelet decomposition stages (default 2,3,4)\n"
+            "  --filters LIST              ICER filter types (default 0,1,2,3,4,5 = A-F)\n"
+            "  --segments LIST             Error containment segments (default 1,6,16)\n"
+            "  --bpp LIST                  Byte budgets in bits per pixel, 0 = lossless (default 0.5,1,2,4,0)\n"
+            "  --targets LIST              Byte budgets in bytes (replace --bpp, 0 = lossless)\n"
+            "  --backend posix|mmap        File system backend (default posix)\n"
+            "  --workdir DIR               Directory for intermediate files (default .)\n"
+            "  --reencode                  Also compress every budget on its own: real encode time,\n"
+            "                              and a check that it matches the truncated lossless stream\n"
+            "  --csv FILE                  Write the CSV to FILE instead of stdout\n"
+            "  --verbose                   Pipeline progress on stdout (use with --csv)\n",
+            prog);
+}
+
+// Read the Y, U, V channel files into planes
+static bool read_planes(IFileSystem* fs, const char* y_file, const char* u_file, const char* v_file,
+                        size_t width, size_t height, Planes* planes) {
+    const char* names[3] = {y_file, u_file, v_file};
+    planes->width = width;
+    planes->height = height;
+    bool ok = true;
+    for (int c = 0; c < 3; c++) {
+        planes->chan[c] = (uint16_t*)read_fs_file(fs, names[c], width * height * sizeof(uint16_t));
+        ok = ok && planes->chan[c] != NULL;
+    }
+    if (!ok) {
+        free_planes(planes);
+    }
+    return ok;
+}
+
+// Convert one corpus frame to planes, through the same converters the board uses
+static bool load_frame(IFileSystem* fs, const char* path, InputFormat format, size_t width, size_t height,
+                       Planes* planes) {
+    size_t input_size = 0;
+    uint8_t* input = read_whole_file(path, &input_size);
+    if (!input) {
+        fprintf(stderr, "Failed to read %s\n", path);
+        return false;
+    }
+    if (format == INPUT_AUTO) {
+        format = (has_suffix(path, ".jpg") || has_suffix(path, ".jpeg")) ? INPUT_JPEG : INPUT_AUTO;
+    }
+    int result = -1;
+    if (format != INPUT_JPEG && (format == INPUT_AUTO || width == 0 || height == 0)) {
+        fprintf(stderr, "%s: raw frames need --format, --width and --height\n", path);
+    } else {
+        result = ingest_frame(fs, input, input_size, format, &width, &height);
+    }
+    free(input);
+    bool ok = (result == 0) && read_planes(fs, Y_FILE, U_FILE, V_FILE, width, height, planes);
+    if (!ok) {
+        fprintf(stderr, "%s: conversion failed (%d)\n", path, result);
+    }
+    fs->remove(Y_FILE);
+    fs->remove(U_FILE);
+    fs->remove(V_FILE);
+    return ok;
+}
+
+// Split an ICER stream into its segments; false if it does not parse
+static bool index_segments(const uint8_t* stream, size_t size, SegmentRef* segments, size_t capacity,
+                           size_t* count) {
+    size_t offset = 0;
+    size_t n = 0;
+    while (offset < size) {
+        if (size - offset < sizeof(icer_image_segment_typedef) || n >= capacity) {
+            return false;
+        }
+        icer_image_segment_typedef header;
+        memcpy(&header, stream + offset, sizeof(header));
+        if (header.preamble != ICER_PACKET_PREAMBLE) {
+            return false;
+        }
+        size_t seg_size = sizeof(header) + (header.data_length + 7) / 8;
+        if (seg_size > size - offset) {
+            return false;
+        }
+        SegmentRef* seg = &segments[n++];
+        seg->offset = offset;
+        seg->size = seg_size;
+        seg->chan = (uint8_t)ICER_GET_CHANNEL_MACRO(header.lsb_chan);
+        seg->stage = header.decomp_level;
+        seg->subband = header.subband_type;
+        seg->lsb = (uint8_t)ICER_GET_LSB_MACRO(header.lsb_chan);
+        seg->segment = header.segment_number;
+        offset += seg_size;
+    }
+    *count = n;
+    return true;
+}
+
+// Cut the stream a compression with byte_quota would write out of a lossless stream
+// Replays the quota rule of icer_allocate_data_packet / icer_popbuf_while_avail:
+// a segment needs room for its header, and its data must end before the room
+// left after the header is used up. Encoding stops at the first segment that
+// does not fit; the segments that did are kept in stream (rearrange) order.
+// Returns the truncated size, the stream is written to out (at least size bytes).
+static size_t truncate_to_quota(const uint8_t* stream, const SegmentRef* segments, size_t segment_count,
+                                const icer_packet_context* packets, size_t packet_count, size_t byte_quota,
+                                bool* included, uint8_t* out) {
+    memset(included, 0, segment_count * sizeof(bool));
+    size_t used = 0;
+    bool full = false;
+    for (size_t p = 0; p < packet_count && !full; p++) {
+        const icer_packet_context* pkt = &packets[p];
+        for (int seg_num = 0; seg_num <= ICER_MAX_SEGMENTS && !full; seg_num++) {
+            for (size_t s = 0; s < segment_count; s++) {
+                const SegmentRef* seg = &segments[s];
+                if (seg->segment != seg_num || seg->chan != pkt->channel || seg->stage != pkt->decomp_level ||
+                    seg->subband != pkt->subband_type || seg->lsb != pkt->lsb) {
+                    continue;
+                }
+                size_t room = byte_quota - used;
+                size_t data_bytes = seg->size - sizeof(icer_image_segment_typedef);
+                icer_image_segment_typedef header;
+                memcpy(&header, stream + seg->offset, sizeof(header));
+                if (room < sizeof(icer_image_segment_typedef) ||
+                    header.data_length / 8 >= room - sizeof(icer_image_segment_typedef)) {
+                    full = true;
+                    break;
+                }
+                used += sizeof(icer_image_segment_typedef) + data_bytes;
+                included[s] = true;
+                break;
+            }
+        }
+    }
+    size_t size = 0;
+    for (size_t s = 0; s < segment_count; s++) {
+        if (included[s]) {
+            memcpy(out + size, stream + segments[s].offset, segments[s].size);
+            size += segments[s].size;
+        }
+    }
+    return size;
+}
+
+// Mean SSIM of one channel, 8x8 windows every 4 pixels
+static double channel_ssim(const uint16_t* a, const uint16_t* b, size_t width, size_t height, double peak) {
+    const double c1 = (0.01 * peak) * (0.01 * peak);
+    const double c2 = (0.03 * peak) * (0.03 * peak);
+    size_t win = 8;
+    if (width < win || height < win) {
+        win = (width < height) ? width : height;
+    }
+    double total = 0;
+    size_t windows = 0;
+    for (size_t y0 = 0; y0 + win <= height; y0 += 4) {
+        for (size_t x0 = 0; x0 + win <= width; x0 += 4) {
+            double sa = 0, sb = 0, saa = 0, sbb = 0, sab = 0;
+            for (size_t y = y0; y < y0 + win; y++) {
+                for (size_t x = x0; x < x0 + win; x++) {
+                    double va = a[y * width + x];
+                    double vb = b[y * width + x];
+                    sa += va;
+                    sb += vb;
+                    saa += va * va;
+                    sbb += vb * vb;
+                    sab += va * vb;
+                }
+            }
+            double n = (double)(win * win);
+            double ma = sa / n, mb = sb / n;
+            double va = saa / n - ma * ma;
+            double vb = sbb / n - mb * mb;
+            double cov = sab / n - ma * mb;
+            total += ((2 * ma * mb + c1) * (2 * cov + c2)) / ((ma * ma + mb * mb + c1) * (va + vb + c2));
+            windows++;
+        }
+    }
+    return (windows > 0) ? total / windows : 1.0;
+}
+
+static double psnr_of(double mse, double peak) {
+    return (mse > 0) ? 10.0 * log10(peak * peak / mse) : INFINITY;
+}
+
+static void measure_quality(const Planes* original, const Planes* decoded, Quality* q) {
+    size_t pixels = original->width * original->height;
+    uint16_t max_value = 0;
+    for (int c = 0; c < 3; c++) {
+        for (size_t i = 0; i < pixels; i++) {
+            if (original->chan[c][i] > max_value) {
+                max_value = original->chan[c][i];
+            }
+        }
+    }
+    // 8-bit camera data unless the frame uses more
+    double peak = 255;
+    while (peak < max_value) {
+        peak = peak * 2 + 1;
+    }
+    double mse_sum = 0;
+    for (int c = 0; c < 3; c++) {
+        double squared = 0;
+        for (size_t i = 0; i < pixels; i++) {
+            double d = (double)original->chan[c][i] - (double)decoded->chan[c][i];
+            squared += d * d;
+        }
+        q->mse[c] = squared / pixels;
+        q->psnr[c] = psnr_of(q->mse[c], peak);
+        q->ssim[c] = channel_ssim(original->chan[c], decoded->chan[c], original->width, original->height, peak);
+        mse_sum += q->mse[c];
+    }
+    q->psnr_all = psnr_of(mse_sum / 3, peak);
+}
+
+static void print_db(FILE* out, double value) {
+    if (isinf(value)) {
+        fprintf(out, ",inf");
+    } else {
+        fprintf(out, ",%.3f", value);
+    }
+}
+
+// Write the planes as channel files and compress them; the result stays in RESULT_FILE
+static IcerCompressionResult encode(IFileSystem* fs, const Planes* planes, uint8_t stages, uint8_t filter_type,
+                                    uint8_t segments, size_t target_size, double* ms, size_t* peak) {
+    IcerCompressionResult result;
+    memset(&result, 0, sizeof(result));
+    size_t plane_size = planes->width * planes->height * sizeof(uint16_t);
+    if (!write_fs_file(fs, Y_FILE, (const uint8_t*)planes->chan[0], plane_size) ||
+        !write_fs_file(fs, U_FILE, (const uint8_t*)planes->chan[1], plane_size) ||
+        !write_fs_file(fs, V_FILE, (const uint8_t*)planes->chan[2], plane_size)) {
+        result.error_code = -1000;
+        return result;
+    }
+    poolResetPeaks();
+    double start = now_ms();
+    result = compressYuvWithIcerFlash(fs, Y_FILE, U_FILE, V_FILE, planes->width, planes->height,
+                                      stages, filter_type, segments, target_size, RESULT_FILE, false);
+    *ms = now_ms() - start;
+    *peak = poolTotalPeak();
+    fs->remove(Y_FILE);
+    fs->remove(U_FILE);
+    fs->remove(V_FILE);
+    return result;
+}
+
+// Decode stream_file and measure it against the original planes
+static int decode(IFileSystem* fs, const char* stream_file, const Planes* original, uint8_t stages,
+                  uint8_t filter_type, uint8_t segments, double* ms, size_t* peak, Quality* quality) {
+    size_t width = 0;
+    size_t height = 0;
+    poolResetPeaks();
+    double start = now_ms();
+    int res = decompressYuvWithIcerFlash(fs, stream_file, Y_DECODED_FILE, U_DECODED_FILE, V_DECODED_FILE,
+                                         stages, filter_type, segments, &width, &height);
+    *ms = now_ms() - start;
+    *peak = poolTotalPeak();
+    if (res == 0 && (width != original->width || height != original->height)) {
+        res = -1000;
+    }
+    Planes decoded;
+    memset(&decoded, 0, sizeof(decoded));
+    if (res == 0 && !read_planes(fs, Y_DECODED_FILE, U_DECODED_FILE, V_DECODED_FILE, width, height, &decoded)) {
+        res = -1001;
+    }
+    if (res == 0) {
+        measure_quality(original, &decoded, quality);
+        free_planes(&decoded);
+    }
+    fs->remove(Y_DECODED_FILE);
+    fs->remove(U_DECODED_FILE);
+    fs->remove(V_DECODED_FILE);
+    return res;
+}
+
+// All budgets of one frame and parameter set; returns the number of failures
+static int run_parameters(IFileSystem* fs, FILE* csv, const char* name, const Planes* planes, uint8_t stages,
+                          uint8_t filter_type, uint8_t segments, const size_t* budgets, int budget_count,
+                          bool reencode) {
+    double lossless_ms = 0;
+    size_t lossless_peak = 0;
+    IcerCompressionResult lossless = encode(fs, planes, stages, filter_type, segments, 0, &lossless_ms,
+                                            &lossless_peak);
+    if (!lossless.success) {
+        fprintf(stderr, "%s stages %d filter %c segments %d: compression failed (%d)\n", name, stages,
+                'A' + filter_type, segments, lossless.error_code);
+        fs->remove(RESULT_FILE);
+        return 1;
+    }
+    uint8_t* stream = read_fs_file(fs, RESULT_FILE, lossless.compressed_size);
+    fs->remove(RESULT_FILE);
+    size_t capacity = lossless.compressed_size / sizeof(icer_image_segment_typedef) + 1;
+    SegmentRef* segment_refs = (SegmentRef*)malloc(capacity * sizeof(SegmentRef));
+    bool* included = (bool*)malloc(capacity * sizeof(bool));
+    uint8_t* truncated = (uint8_t*)malloc(lossless.compressed_size + 1);
+    icer_packet_context* packets = (icer_packet_context*)malloc(ICER_MAX_PACKETS_16 * sizeof(icer_packet_context));
+    size_t segment_count = 0;
+    if (!stream || !segment_refs || !included || !truncated || !packets ||
+        !index_segments(stream, lossless.compressed_size, segment_refs, capacity, &segment_count)) {
+        fprintf(stderr, "%s: unreadable ICER stream\n", name);
+        free(stream);
+        free(segment_refs);
+        free(included);
+        free(truncated);
+        free(packets);
+        return 1;
+    }
+    // Encode order of icer_compress_image_yuv_uint16 and compressYuvWithIcerFlash (the LL means do not
+    // change the order)
+    const uint16_t ll_mean[ICER_CHANNEL_MAX + 1] = {0};
+    size_t packet_count = 0;
+    if (icer_build_packet_list_uint16(packets, ICER_MAX_PACKETS_16, planes->width, planes->height, (uint8_t)stages,
+                                      ll_mean, &packet_count) != ICER_RESULT_OK) {
+        fprintf(stderr, "%s: too many packets for %d stages\n", name, stages);
+        free(stream);
+        free(segment_refs);
+        free(included);
+        free(truncated);
+        free(packets);
+        return 1;
+    }
+
+    int failures = 0;
+    for (int b = 0; b < budget_count; b++) {
+        size_t target = budgets[b];
+        size_t size = lossless.compressed_size;
+        const uint8_t* data = stream;
+        if (target > 0) {
+            size = truncate_to_quota(stream, segment_refs, segment_count, packets, packet_count, target, included,
+                                     truncated);
+            data = truncated;
+        }
+        double encode_ms = lossless_ms;
+        size_t encode_peak = lossless_peak;
+        if (reencode && target > 0) {
+            IcerCompressionResult direct = encode(fs, planes, stages, filter_type, segments, target, &encode_ms,
+                                                  &encode_peak);
+            uint8_t* direct_stream = direct.success ? read_fs_file(fs, RESULT_FILE, direct.compressed_size) : NULL;
+            fs->remove(RESULT_FILE);
+            if (!direct_stream || direct.compressed_size != size || memcmp(direct_stream, data, size) != 0) {
+                fprintf(stderr, "%s stages %d filter %c segments %d target %zu: direct encode (%zu bytes, %d) "
+                        "differs from the truncated stream (%zu bytes)\n", name, stages, 'A' + filter_type,
+                        segments, target, direct.compressed_size, direct.error_code, size);
+                failures++;
+            }
+            free(direct_stream);
+        }
+        if (!write_fs_file(fs, TRUNCATED_FILE, data, size)) {
+            failures++;
+            continue;
+        }
+        double decode_ms = 0;
+        size_t decode_peak = 0;
+        Quality quality = {};
+        int res = decode(fs, TRUNCATED_FILE, planes, stages, filter_type, segments, &decode_ms, &decode_peak,
+                         &quality);
+        fs->remove(TRUNCATED_FILE);
+        if (res != 0) {
+            fprintf(stderr, "%s stages %d filter %c segments %d target %zu: decode failed (%d)\n", name, stages,
+                    'A' + filter_type, segments, target, res);
+            failures++;
+            continue;
+        }
+        fprintf(csv, "%s,%zu,%zu,%d,%c,%d,%zu,%zu,%.4f,%.2f,%.2f,%zu,%zu", name, planes->width, planes->height,
+                stages, 'A' + filter_type, segments, target, size,
+                size * 8.0 / (planes->width * planes->height), encode_ms, decode_ms, encode_peak, decode_peak);
+        for (int c = 0; c < 3; c++) {
+            print_db(csv, quality.psnr[c]);
+        }
+        print_db(csv, quality.psnr_all);
+        fprintf(csv, ",%.5f,%.5f,%.5f\n", quality.ssim[0], quality.ssim[1], quality.ssim[2]);
+        fflush(csv);
+    }
+    free(stream);
+    free(segment_refs);
+    free(included);
+    free(truncated);
+    free(packets);
+    return failures;
+}
+
+int main(int argc, char** argv) {
+    NumberList stage_list;
+    NumberList filter_list;
+    NumberList segment_list;
+    NumberList bpp_list;
+    NumberList target_list;
+    parse_list("2,3,4", &stage_list);
+    parse_list("0,1,2,3,4,5", &filter_list);
+    parse_list("1,6,16", &segment_list);
+    parse_list("0.5,1,2,4,0", &bpp_list);
+    target_list.count = 0;
+    InputFormat format = INPUT_AUTO;
+    size_t width = 0;
+    size_t height = 0;
+    const char* backend = "posix";
+    const char* workdir = ".";
+    const char* csv_path = NULL;
+    bool reencode = false;
+    bool verbose = false;
+    const char* frames[64];
+    int frame_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool has_value = (i + 1 < argc);
+        bool ok = true;
+        if (strcmp(arg, "--format") == 0 && has_value) {
+            const char* value = argv[++i];
+            if (strcmp(value, "yuv422") == 0) {
+                format = INPUT_YUV422;
+            } else if (strcmp(value, "yuv16") == 0) {
+                format = INPUT_YUV16;
+            } else if (strcmp(value, "jpeg") == 0) {
+                format = INPUT_JPEG;
+            } else {
+                ok = false;
+            }
+        } else if (strcmp(arg, "--width") == 0 && has_value) {
+            width = (size_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--height") == 0 && has_value) {
+            height = (size_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--stages") == 0 && has_value) {
+            ok = parse_list(argv[++i], &stage_list);
+        } else if (strcmp(arg, "--filters") == 0 && has_value) {
+            ok = parse_list(argv[++i], &filter_list);
+        } else if (strcmp(arg, "--segments") == 0 && has_value) {
+            ok = parse_list(argv[++i], &segment_list);
+        } else if (strcmp(arg, "--bpp") == 0 && has_value) {
+            ok = parse_list(argv[++i], &bpp_list);
+        } else if (strcmp(arg, "--targets") == 0 && has_value) {
+            ok = parse_list(argv[++i], &target_list);
+        } else if (strcmp(arg, "--backend") == 0 && has_value) {
+            backend = argv[++i];
+        } else if (strcmp(arg, "--workdir") == 0 && has_value) {
+            workdir = argv[++i];
+        } else if (strcmp(arg, "--csv") == 0 && has_value) {
+            csv_path = argv[++i];
+        } else if (strcmp(arg, "--reencode") == 0) {
+            reencode = true;
+        } else if (strcmp(arg, "--verbose") == 0) {
+            verbose = true;
+        } else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (arg[0] != '-' && frame_count < 64) {
+            frames[frame_count++] = arg;
+        } else {
+            print_usage(argv[0]);
+            return 2;
+        }
+        if (!ok) {
+            fprintf(stderr, "Invalid value for %s\n", arg);
+            return 2;
+        }
+    }
+    if (frame_count == 0) {
+        print_usage(argv[0]);
+        return 2;
+    }
+    for (int i = 0; i < stage_list.count; i++) {
+        if (stage_list.values[i] < 1 || stage_list.values[i] > ICER_MAX_DECOMP_STAGES) {
+            fprintf(stderr, "Stages must be 1-%d\n", ICER_MAX_DECOMP_STAGES);
+            return 2;
+        }
+    }
+    for (int i = 0; i < filter_list.count; i++) {
+        if (filter_list.values[i] > 6) {
+            fprintf(stderr, "Filters must be 0-6\n");
+            return 2;
+        }
+    }
+    for (int i = 0; i < segment_list.count; i++) {
+        if (segment_list.values[i] < 1 || segment_list.values[i] > ICER_MAX_SEGMENTS) {
+            fprintf(stderr, "Segments must be 1-%d\n", ICER_MAX_SEGMENTS);
+            return 2;
+        }
+    }
+
+    FILE* csv = stdout;
+    if (csv_path) {
+        csv = fopen(csv_path, "w");
+        if (!csv) {
+            fprintf(stderr, "Failed to create %s\n", csv_path);
+            return 1;
+        }
+    } else {
+        verbose = false;  // stdout carries the CSV
+    }
+    Serial.setEnabled(verbose);
+    initMemoryPools(false);
+
+    IFileSystem* fs = NULL;
+    if (strcmp(backend, "posix") == 0) {
+        fs = createPosixFileSystem(workdir);
+    } else if (strcmp(backend, "mmap") == 0) {
+        fs = createMmapFileSystem(workdir);
+    } else {
+        fprintf(stderr, "Unknown backend: %s\n", backend);
+        return 2;
+    }
+    if (!fs || !fs->begin()) {
+        fprintf(stderr, "Failed to initialize %s file system in %s\n", backend, workdir);
+        delete fs;
+        return 1;
+    }
+
+    fprintf(csv, "image,width,height,stages,filter,segments,target_bytes,bytes,bpp,encode_ms,decode_ms,"
+                 "encode_peak_bytes,decode_peak_bytes,psnr_y,psnr_u,psnr_v,psnr,ssim_y,ssim_u,ssim_v\n");
+    int failures = 0;
+    for (int f = 0; f < frame_count; f++) {
+        Planes planes;
+        memset(&planes, 0, sizeof(planes));
+        if (!load_frame(fs, frames[f], format, width, height, &planes)) {
+            failures++;
+            continue;
+        }
+        // Budgets of this frame in bytes, 0 = lossless
+        size_t budgets[MAX_LIST];
+        int budget_count = 0;
+        const NumberList* list = (target_list.count > 0) ? &target_list : &bpp_list;
+        for (int b = 0; b < list->count; b++) {
+            double value = list->values[b];
+            budgets[budget_count++] = (list == &bpp_list) ? (size_t)(value * planes.width * planes.height / 8)
+                                                          : (size_t)value;
+        }
+        for (int s = 0; s < stage_list.count; s++) {
+            for (int k = 0; k < filter_list.count; k++) {
+                for (int g = 0; g < segment_list.count; g++) {
+                    failures += run_parameters(fs, csv, base_name(frames[f]), &planes, (uint8_t)stage_list.values[s],
+                                               (uint8_t)filter_list.values[k], (uint8_t)segment_list.values[g],
+                                               budgets, budget_count, reencode);
+                }
+            }
+        }
+        free_planes(&planes);
+    }
+    delete fs;
+    if (csv != stdout) {
+        fclose(csv);
+    }
+    if (failures > 0) {
+        fprintf(stderr, "%d failures\n", failures);
+    }
+    return (failures > 0) ? 1 : 0;
+}
@@ -0,0 +1,59 @@
+#ifndef HOST_SHIM_ARDUINO_H
+#define HOST_SHIM_ARDUINO_H
+
+// Minimal Arduino core shim for host (Linux/x86) builds
+// Provides just enough of Serial/millis/delay for the flash pipeline sources
+// to compile unchanged. Progress output goes to stderr so that host tools can
+// keep stdout for machine-readable results.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEC 10
+#define HEX 16
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+
+class HostSerial {
+private:
+    bool enabled;
+
+public:
+    HostSerial() : enabled(true) {}
+
+    // Baud rate is ignored on host, begin()/end() only toggle output
+    void begin(unsigned long baud) { (void)baud; enabled = true; }
+    void end() { enabled = false; }
+
+    // Host tools use this to silence pipeline progress output (e.g. --quiet)
+    void setEnabled(bool on) { enabled = on; }
+
+    size_t print(const char* str);
+    size_t print(char c);
+    size_t print(int value, int base = DEC);
+    size_t print(unsigned int value, int base = DEC);
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+    size_t print(long long value, int base = DEC);
+    size_t print(unsigned long long value, int base = DEC);
+    size_t print(double value, int digits = 2);
+
+    size_t println();
+    template <typename T>
+    size_t println(T value) { size_t n = print(value); return n + println(); }
+    template <typename T>
+    size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+
+    void flush();
+
+    // Always "connected" on host
+    operator bool() const { return true; }
+};
+
+extern HostSerial Serial;
+
+#endif // HOST_SHIM_ARDUINO_H
@@ -0,0 +1,33 @@
+#ifndef HOST_SHIM_CAMERA_H
+#define HOST_SHIM_CAMERA_H
+
+// Minimal Camera shim for host builds
+// CamImage only carries a caller-owned JPEG/YUV buffer so that
+// convertJpegToSeparateChannels() can be fed from a file on disk.
+
+#include <stdint.h>
+#include <stddef.h>
+
+class CamImage {
+private:
+    uint8_t* buff;
+    size_t img_size;
+    int width;
+    int height;
+
+public:
+    CamImage() : buff(NULL), img_size(0), width(0), height(0) {}
+    CamImage(uint8_t* data, size_t size, int w = 0, int h = 0)
+        : buff(data), img_size(size), width(w), height(h) {}
+
+    bool isAvailable() { return buff != NULL && img_size > 0; }
+    uint8_t* getImgBuff() { return buff; }
+    size_t getImgSize() { return img_size; }
+    size_t getImgBuffSize() { return img_size; }
+    int getWidth() { return width; }
+    int getHeight() { return height; }
+};
+
+class CameraClass;
+
+#endif // HOST_SHIM_CAMERA_H
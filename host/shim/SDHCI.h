@@ -0,0 +1,65 @@
+#ifndef HOST_SHIM_SDHCI_H
+#define HOST_SHIM_SDHCI_H
+
+// Minimal SDHCI shim for host builds
+// Maps the Spresense File/SDClass API onto stdio in the current working
+// directory so that the SDClass* compatibility overloads and the
+// SpresenceSDFileSystem wrapper still compile and behave sensibly on Linux.
+// New host code should use createPosixFileSystem()/createMmapFileSystem()
+// instead of going through this shim.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <unistd.h>
+#include "filesystem_interface.h"  // FILE_READ / FILE_WRITE
+
+class File {
+private:
+    FILE* fp;
+
+public:
+    File() : fp(NULL) {}
+    explicit File(FILE* f) : fp(f) {}
+
+    size_t read(uint8_t* buffer, size_t size) { return fp ? fread(buffer, 1, size, fp) : 0; }
+    int read() { return fp ? fgetc(fp) : -1; }
+    size_t write(const uint8_t* data, size_t size) { return fp ? fwrite(data, 1, size, fp) : 0; }
+    size_t write(uint8_t b) { return write(&b, 1); }
+    bool seek(uint32_t pos) { return fp && fseek(fp, (long)pos, SEEK_SET) == 0; }
+    uint32_t position() { return fp ? (uint32_t)ftell(fp) : 0; }
+    uint32_t size() {
+        if (!fp) return 0;
+        long cur = ftell(fp);
+        fseek(fp, 0, SEEK_END);
+        long end = ftell(fp);
+        fseek(fp, cur, SEEK_SET);
+        return (uint32_t)end;
+    }
+    int available() { return (int)(size() - position()); }
+    void flush() { if (fp) fflush(fp); }
+    void close() { if (fp) { fclose(fp); fp = NULL; } }
+    operator bool() const { return fp != NULL; }
+};
+
+class SDClass {
+public:
+    bool begin() { return true; }
+
+    // FILE_WRITE follows the Arduino semantics: create if missing,
+    // keep existing contents, start positioned at the end of the file
+    File open(const char* filename, int mode = FILE_READ) {
+        if (mode == FILE_READ) {
+            return File(fopen(filename, "rb"));
+        }
+        FILE* fp = fopen(filename, "r+b");
+        if (!fp) fp = fopen(filename, "w+b");
+        if (fp) fseek(fp, 0, SEEK_END);
+        return File(fp);
+    }
+
+    bool exists(const char* filename) { return access(filename, F_OK) == 0; }
+    bool remove(const char* filename) { return ::remove(filename) == 0; }
+};
+
+#endif // HOST_SHIM_SDHCI_H
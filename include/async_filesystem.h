@@ -0,0 +1,44 @@
+#ifndef ASYNC_FILESYSTEM_H
+#define ASYNC_FILESYSTEM_H
+
+#include "filesystem_interface.h"
+
+// Factory function to create an asynchronous I/O layer over another file system
+// One background I/O thread (pthreads on NuttX and on the host) performs the
+// actual reads and writes on the backing files, so the pipeline keeps computing
+// while the SD card is busy:
+//
+// - Write handles (FILE_WRITE) copy data into one of write_buffer_count buffers
+//   and return immediately; full buffers are written by the I/O thread while the
+//   caller fills the next one. Consecutive writes are coalesced, seek() to a
+//   non-contiguous position starts a new buffer. flush() and close() wait until
+//   every pending write has reached the backing file (completion barrier).
+//   A failed background write is reported by the next write()/flush()/close().
+//
+// - Read handles (FILE_READ) detect the access pattern (sequential or fixed
+//   stride, e.g. one row per image row) and prefetch the next expected block
+//   while the caller processes the current one. Reads larger than
+//   read_ahead_limit are passed through without prefetching.
+//
+// Data written through one handle is visible to other handles on the same file
+// after the writer's flush() or close(), which is how the pipeline already uses
+// files (it always closes a file before reopening it for reading).
+//
+// If the I/O thread cannot be started (or on platforms without pthreads) every
+// request is executed synchronously, so the layer is always safe to use.
+//
+// Parameters:
+//   backing:            File system that performs the actual I/O
+//   write_buffer_size:  Size of each write buffer in bytes
+//   write_buffer_count: Buffers per write handle (2 = double, 3 = triple buffering)
+//   take_ownership:     If true, backing is deleted when this file system is destroyed
+//   read_ahead_limit:   Largest read that is prefetched (the prefetch buffer grows to it)
+//
+// Returns:
+//   Pointer to IFileSystem implementation, or NULL on failure
+//   Caller is responsible for deleting the returned pointer (after all files are closed)
+IFileSystem* createAsyncFileSystem(IFileSystem* backing, size_t write_buffer_size = 4096,
+                                   uint8_t write_buffer_count = 2, bool take_ownership = false,
+                                   size_t read_ahead_limit = 32768);
+
+#endif // ASYNC_FILESYSTEM_H
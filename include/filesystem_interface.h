@@ -38,6 +38,24 @@ public:
     // Check if file exists
     // Returns true if file exists, false otherwise
     virtual bool exists(const char* filename) = 0;
+
+    // Announce the expected final size of a file that is about to be created
+    // The hint applies to the next open(filename, FILE_WRITE) that creates the file
+    // Backends may use it to choose where to place the file; the default ignores it
+    virtual void setSizeHint(const char* filename, size_t expected_size) {
+        (void)filename;
+        (void)expected_size;
+    }
+
+    // Create a file of exactly size bytes whose contents read as zeros
+    // Any existing file with that name is replaced. The returned handle is opened
+    // for writing and positioned at 0, so the caller can seek() anywhere inside the
+    // file and write in any order without the file growing under it.
+    // The default implementation uses IFile::reserve() and falls back to writing
+    // zeros when the backend cannot reserve space (defined in filesystem_interface.cpp)
+    // Returns a pointer to IFile object, or NULL on failure
+    // Caller is responsible for deleting the IFile object when done
+    virtual IFile* createPreallocated(const char* filename, size_t size);
 };
 
 // Abstract file interface
@@ -73,6 +91,16 @@ public:
     // Close the file
     // Returns true on success, false on failure
     virtual bool close() = 0;
+
+    // Extend the file to at least size bytes without writing data
+    // New bytes read as zeros, the file position is not changed. Only backends
+    // that can allocate space natively implement this (fallocate, RAM buffers);
+    // the default returns false and callers simply carry on without reservation.
+    // Returns true if the space was reserved, false if not supported or on failure
+    virtual bool reserve(size_t size) {
+        (void)size;
+        return false;
+    }
     
     // Check if file is open and valid
     // Returns true if file is open, false otherwise
@@ -0,0 +1,34 @@
+#ifndef HANDLE_CACHE_FILESYSTEM_H
+#define HANDLE_CACHE_FILESYSTEM_H
+
+#include "filesystem_interface.h"
+
+// Factory function to create a read-handle cache over another file system
+// The flash pipeline reopens the same few files over and over (the packet loop
+// opens a channel file once per packet, ~400 times per frame). On the SD card
+// every open is a FAT directory lookup plus a heap allocation.
+//
+// This layer keeps up to max_handles backing read handles open, one per file
+// name, and evicts the least recently used idle one when the table is full.
+// open(name, FILE_READ) returns a lightweight view on the cached handle with its
+// own file position; views come from a fixed pool, so opening and deleting them
+// in a hot loop does not touch the heap. Several views on the same file may be
+// open at once.
+//
+// Coherence follows the pipeline's close-before-reopen pattern: opening a file
+// for writing, closing a writer, creating a preallocated file or removing the
+// file drops its cached handle, so later reads always see the written data.
+// Write handles themselves are passed through (wrapped only to observe close()).
+//
+// Parameters:
+//   backing:        File system that performs the actual I/O
+//   max_handles:    Number of backing read handles kept open (e.g. 3 channel files + 1)
+//   take_ownership: If true, backing is deleted when this file system is destroyed
+//
+// Returns:
+//   Pointer to IFileSystem implementation, or NULL on failure
+//   Caller is responsible for deleting the returned pointer (after all files are closed)
+IFileSystem* createHandleCacheFileSystem(IFileSystem* backing, uint8_t max_handles = 4,
+                                         bool take_ownership = false);
+
+#endif // HANDLE_CACHE_FILESYSTEM_H
@@ -40,6 +40,11 @@ uint32_t updateCRC32(unsigned char ch, uint32_t crc);
 bool crc32file(char *name, uint32_t *crc, long *charcnt);
 uint32_t crc32buf(char *buf, size_t len);
 
+/* continue a CRC-32: crc32_update(crc32_update(0, a, n), b, m) is the  */
+/* CRC-32 of a followed by b, and crc32_update(0, buf, len) equals      */
+/* crc32buf(buf, len)                                                   */
+uint32_t crc32_update(uint32_t crc, const void *buf, size_t len);
+
 /*
 **  File: CHECKSUM.C
 */
@@ -24,7 +24,7 @@ uint32_t __inline __clz( uint32_t value ) {
 }
 #endif
 
-#define ICER_CIRC_BUF_SIZE 2048
+#define ICER_CIRC_BUF_SIZE 2048  /* must be a power of two, the encoder wraps its indices with a mask */
 #define MAX_K 12
 #ifndef ICER_MAX_SEGMENTS
 #define ICER_MAX_SEGMENTS 32
@@ -38,6 +38,10 @@ uint32_t __inline __clz( uint32_t value ) {
 #ifndef ICER_MAX_PACKETS_16
 #define ICER_MAX_PACKETS_16 800
 #endif
+#ifndef ICER_SIG_MAP_MAX_WIDTH
+#define ICER_SIG_MAP_MAX_WIDTH 1024  /* widest segment coded with packed significance rows (kept on the stack) */
+#endif
+#define ICER_SIG_MAP_WORDS ((ICER_SIG_MAP_MAX_WIDTH + 2 + 31) / 32)
 #ifndef ICER_BITPLANES_TO_COMPRESS_8
 #define ICER_BITPLANES_TO_COMPRESS_8 7
 #endif
@@ -79,6 +83,15 @@ uint32_t __inline __clz( uint32_t value ) {
  * override function with a custom defined function
  */
 
+#ifndef CRC32BUF_FUNCTION
+/*
+ * with the built in crc32 the encoder updates the data crc while it writes the output (see
+ * icer_finish_segment_crc32), so finished segments are not read a second time
+ * a custom function only sees whole buffers, so it is used on the finished segment instead
+ */
+#define ICER_INCREMENTAL_DATA_CRC
+#endif
+
 #if !defined(USE_UINT8_FUNCTIONS) && !defined(USE_UINT16_FUNCTIONS)
 #define USE_UINT8_FUNCTIONS
 #define USE_UINT16_FUNCTIONS
@@ -248,18 +261,18 @@ typedef struct {
 #define CUSTOM_CODING_MAX_LOOKUP 32
 #endif
 #ifdef USE_ENCODE_FUNCTIONS
-extern icer_custom_code_typedef icer_custom_coding_scheme[ICER_ENCODER_BIN_MAX + 1][CUSTOM_CODING_MAX_LOOKUP];
+extern const icer_custom_code_typedef icer_custom_coding_scheme[ICER_ENCODER_BIN_MAX + 1][CUSTOM_CODING_MAX_LOOKUP];
 #endif
 
 #ifdef USE_DECODE_FUNCTIONS
-extern icer_custom_code_typedef icer_custom_decode_scheme[ICER_ENCODER_BIN_MAX + 1][CUSTOM_CODING_MAX_LOOKUP];
+extern const icer_custom_code_typedef icer_custom_decode_scheme[ICER_ENCODER_BIN_MAX + 1][CUSTOM_CODING_MAX_LOOKUP];
 #endif
 
 #ifndef CUSTOM_CODE_FLUSH_MAX_LOOKUP
 #define CUSTOM_CODE_FLUSH_MAX_LOOKUP 8
 #endif
 #define MAX_NUM_BITS_BEFORE_FLUSH    5
-extern icer_custom_flush_typedef icer_custom_code_flush_bits[ICER_ENCODER_BIN_MAX + 1][CUSTOM_CODE_FLUSH_MAX_LOOKUP + 1][MAX_NUM_BITS_BEFORE_FLUSH + 1];
+extern const icer_custom_flush_typedef icer_custom_code_flush_bits[ICER_ENCODER_BIN_MAX + 1][CUSTOM_CODE_FLUSH_MAX_LOOKUP + 1][MAX_NUM_BITS_BEFORE_FLUSH + 1];
 
 typedef struct {
     uint16_t m;
@@ -267,7 +280,7 @@ typedef struct {
     uint16_t i;
 } icer_golomb_code_typedef;
 
-extern icer_golomb_code_typedef icer_golomb_coders[ICER_ENCODER_BIN_MAX + 1];
+extern const icer_golomb_code_typedef icer_golomb_coders[ICER_ENCODER_BIN_MAX + 1];
 
 typedef struct {
     uint8_t decomp_level;
@@ -321,6 +334,18 @@ typedef struct {
 // Returns number of bytes written, or 0 on error
 typedef size_t (*icer_flash_write_callback)(void* context, const void* data, size_t size);
 
+// Encoder phases reported through the phase callback of icer_compress_image_yuv_uint16
+enum icer_encode_phase {
+    ICER_ENCODE_PHASE_LL_MEAN = 0,  // Wavelet done, LL mean next (value: 0)
+    ICER_ENCODE_PHASE_SIGN_MAG,     // Mean subtraction and sign-magnitude conversion (value: 0)
+    ICER_ENCODE_PHASE_PARTITION,    // Packet encode (value: number of packets)
+    ICER_ENCODE_PHASE_REARRANGE,    // Segment rearrange (value: packets encoded in full)
+    ICER_ENCODE_PHASE_DONE          // Output complete (value: output bytes)
+};
+
+// Phase callback: called as the encoder enters each phase (phase is an icer_encode_phase)
+typedef void (*icer_phase_callback)(void* context, int phase, size_t value);
+
 typedef struct {
     size_t size_used;
     size_t size_allocated;
@@ -334,6 +359,10 @@ typedef struct {
     // STRATEGY DD - Phase 4: Flag to skip wavelet transform if channels are pre-transformed
     // This avoids using rearrange_flash_context as a sentinel (which conflicts with flash rearrange)
     uint8_t channels_pre_transformed;  // Non-zero if channels are already wavelet-transformed
+    // Optional phase callback (timing/telemetry), NULL to disable
+    // Reset by icer_init_output_struct, so set it afterwards
+    icer_phase_callback phase_callback;
+    void* phase_context;  // Context passed to phase_callback
 } icer_output_data_buf_typedef;
 
 typedef struct {
@@ -348,10 +377,10 @@ typedef struct {
     uint8_t *output_buffer;
     int16_t bin_current_buf[ICER_ENCODER_BIN_MAX+1];
     int16_t bin_current_buf_bits[ICER_ENCODER_BIN_MAX+1];
+    uint32_t data_crc32;   /* crc32 of output_buffer[0, data_crc_ind) */
+    size_t data_crc_ind;
 } icer_encoder_context_typedef;
 
-#define ICER_DECODER_BIT_BIN_MAX 30
-
 typedef struct {
     size_t decoded_words;
     size_t encode_ind;
@@ -359,7 +388,12 @@ typedef struct {
     uint32_t encoded_bits_total;
     uint32_t decoded_bits_total;
     uint8_t *encoded_words;
-    uint32_t bin_buf[ICER_ENCODER_BIN_MAX+1][ICER_DECODER_BIT_BIN_MAX];
+    /*
+     * bits left in each bin, read from bit bin_bits - 1 down to bit 0
+     * a bin is only refilled when empty, and only a run of zeros can reach past bit 63
+     * (golomb bins hold up to m = 512 bits), so those bits are not stored and read as zero
+     */
+    uint64_t bin_buf[ICER_ENCODER_BIN_MAX+1];
     int32_t bin_bits[ICER_ENCODER_BIN_MAX+1];
     size_t bin_decode_index[ICER_ENCODER_BIN_MAX+1];
 } icer_decoder_context_typedef;
@@ -385,7 +419,8 @@ extern icer_image_segment_typedef *icer_rearrange_segments_8[ICER_CHANNEL_MAX +
 #ifdef USE_UINT16_FUNCTIONS
 #ifdef USE_DECODE_FUNCTIONS
 #ifdef USER_PROVIDED_BUFFERS
-extern const icer_image_segment_typedef *****icer_reconstruct_data_16;
+/* pointer to the [ICER_CHANNEL_MAX + 1] array below, so it indexes exactly like the static buffer */
+extern const icer_image_segment_typedef *(*icer_reconstruct_data_16)[ICER_MAX_DECOMP_STAGES + 1][ICER_SUBBAND_MAX + 1][ICER_MAX_SEGMENTS + 1][15];
 #else
 extern const icer_image_segment_typedef *icer_reconstruct_data_16[ICER_CHANNEL_MAX + 1][ICER_MAX_DECOMP_STAGES + 1][ICER_SUBBAND_MAX + 1][ICER_MAX_SEGMENTS + 1][15];
 #endif
@@ -405,20 +440,13 @@ extern icer_image_segment_typedef *icer_rearrange_segments_16[ICER_CHANNEL_MAX +
 #endif
 #endif
 
+/* the entropy coder tables are const (src/icer_tables.c), nothing is left to initialise; kept for compatibility */
 int icer_init(void);
 
 #ifdef USE_DECODE_FUNCTIONS
-void icer_init_decodescheme(void);
 int icer_get_image_dimensions(const uint8_t *datastream, size_t data_length, size_t *image_w, size_t *image_h);
 #endif
 
-#ifdef USE_ENCODE_FUNCTIONS
-void icer_init_codingscheme(void);
-#endif
-
-void icer_init_flushbits(void);
-void icer_init_golombcoder(void);
-
 #ifdef USE_UINT8_FUNCTIONS
 #ifdef USE_ENCODE_FUNCTIONS
 int icer_compress_image_uint8(uint8_t *image, size_t image_w, size_t image_h, uint8_t stages, enum icer_filter_types filt,
@@ -480,6 +508,13 @@ int icer_compress_image_uint16(uint16_t *image, size_t image_w, size_t image_h,
 int icer_compress_image_yuv_uint16(uint16_t *y_channel, uint16_t *u_channel, uint16_t *v_channel, size_t image_w,
                                    size_t image_h, uint8_t stages, enum icer_filter_types filt,
                                    uint8_t segments, icer_output_data_buf_typedef *output_data);
+/*
+ * fills packets with the packet list of a colour image in encode order (priority, then subband type), as
+ * icer_compress_image_yuv_uint16 encodes it; ll_mean holds one LL mean per channel
+ * returns ICER_PACKET_COUNT_EXCEEDED if the list does not fit in max_packets - 1 entries
+ */
+int icer_build_packet_list_uint16(icer_packet_context *packets, size_t max_packets, size_t image_w, size_t image_h,
+                                  uint8_t stages, const uint16_t *ll_mean, size_t *packet_count);
 
 int icer_wavelet_transform_stages_uint16(uint16_t *image, size_t image_w, size_t image_h, uint8_t stages, enum icer_filter_types filt);
 
@@ -503,6 +538,17 @@ int icer_decompress_image_yuv_uint16(uint16_t * y_channel, uint16_t * u_channel,
                                      size_t data_length, uint8_t stages, enum icer_filter_types filt,
                                      uint8_t segments);
 
+/*
+ * icer_decompress_image_yuv_uint16 in two steps, so the channels can be decoded separately (e.g. one per thread):
+ * icer_index_yuv_packets_uint16 finds the packets in the datastream (image size and per channel LL mean from the
+ * packet headers, image_w / image_h are left as they are if there is none), then icer_decompress_channel_uint16
+ * decodes one channel from the indexed packets; the datastream must stay valid until the channels are decoded
+ */
+int icer_index_yuv_packets_uint16(const uint8_t *datastream, size_t data_length, size_t *image_w, size_t *image_h,
+                                  uint16_t ll_mean[ICER_CHANNEL_MAX + 1]);
+int icer_decompress_channel_uint16(uint16_t *channel, enum icer_color_channels chan, size_t image_w, size_t image_h,
+                                   uint8_t stages, enum icer_filter_types filt, uint8_t segments, uint16_t ll_mean);
+
 int icer_inverse_wavelet_transform_stages_uint16(uint16_t *image, size_t image_w, size_t image_h, uint8_t stages, enum icer_filter_types filt);
 
 int icer_inverse_wavelet_transform_2d_uint16(uint16_t *image, size_t image_w, size_t image_h, size_t rowstride, enum icer_filter_types filt);
@@ -562,9 +608,10 @@ int icer_generate_partition_parameters(partition_param_typdef *params, size_t ll
 
 uint32_t icer_calculate_packet_crc32(const icer_image_segment_typedef *pkt);
 uint32_t icer_calculate_segment_crc32(const icer_image_segment_typedef *pkt);
+uint32_t icer_finish_segment_crc32(const icer_encoder_context_typedef *encoder_context, const icer_image_segment_typedef *pkt);
 
 int icer_init_output_struct(icer_output_data_buf_typedef *out, uint8_t *data, size_t buf_len, size_t byte_quota);
-int icer_compute_bin(uint32_t zero_cnt, uint32_t total_cnt);
+static inline int icer_compute_bin(uint32_t zero_cnt, uint32_t total_cnt);
 
 static inline unsigned icer_pow_uint(unsigned base, unsigned exp);
 
@@ -641,6 +688,24 @@ static inline int icer_min_int(int a, int b) {
     return (a < b) ? a : b;
 }
 
+/*
+ * compute which bin of the interleaved entropy coder to place a bit to be encoded based of the probability cutoffs of each bin
+ * the bin is the number of cutoffs the zero probability reaches (the cutoffs are increasing), found with a
+ * fixed 4 step binary search plus one step for the last cutoff instead of a linear scan from the top bin
+ * zero_cnt and total_cnt stay below ICER_CONTEXT_RESCALING_CAP, so the products cannot overflow
+ */
+static inline int icer_compute_bin(uint32_t zero_cnt, uint32_t total_cnt) {
+    const uint32_t comp = zero_cnt * ICER_BIN_PROBABILITY_DENOMINATOR;
+    const uint32_t *cutoffs = icer_bin_probability_cutoffs + ICER_ENC_BIN_1;
+    unsigned n = 0;
+    if (comp >= total_cnt * cutoffs[n + 7]) n += 8;
+    if (comp >= total_cnt * cutoffs[n + 3]) n += 4;
+    if (comp >= total_cnt * cutoffs[n + 1]) n += 2;
+    if (comp >= total_cnt * cutoffs[n]) n += 1;
+    if (n == ICER_ENCODER_BIN_MAX - ICER_ENC_BIN_1 - 1 && comp >= total_cnt * cutoffs[n]) n += 1;
+    return ICER_ENC_BIN_1 + (int)n;
+}
+
 static inline void icer_reverse_bits(uint16_t *bits, uint8_t num) {
     uint16_t reversed = 0;
     for (int b = 0; b < num;b++) {
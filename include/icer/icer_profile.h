@@ -0,0 +1,149 @@
+#ifndef ICER_PROFILE_H
+#define ICER_PROFILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Scoped-zone profiler for the hot paths (wavelet, partition, bitplane coder,
+ * CRC, file I/O)
+ *
+ * A zone reads a cycle counter when it is entered and left and adds the
+ * difference to a static per-zone table (count, total, min, max), which the
+ * caller prints and resets once per frame. The counter is the DWT cycle counter
+ * (CYCCNT) on the board, rdtsc on x86 hosts and clock_gettime() elsewhere. On
+ * the host every zone can also be recorded as an event and written as a Chrome
+ * trace (chrome://tracing, Perfetto).
+ *
+ * Build with ICER_PROFILE=1 to enable it; otherwise the zone macros compile to
+ * nothing and the report functions do nothing.
+ */
+
+#ifndef ICER_PROFILE
+#define ICER_PROFILE 0
+#endif
+
+/* Zones, in report order */
+enum icer_profile_zone {
+    ICER_ZONE_WAVELET_ROWS = 0,  /* Row pass of one stage of one channel (flash wavelet) */
+    ICER_ZONE_WAVELET_COLS,      /* Column pass of one stage of one channel (flash wavelet) */
+    ICER_ZONE_WAVELET_1D,        /* icer_wavelet_transform_1d_uint16, one row or column batch */
+    ICER_ZONE_SEGMENT_LOAD,      /* Read one segment of a channel file (flash partition) */
+    ICER_ZONE_SEGMENT_ENCODE,    /* Encode one segment into a packet (flash partition) */
+    ICER_ZONE_BITPLANE,          /* icer_compress_bitplane_uint16 */
+    ICER_ZONE_CRC,               /* crc32_update */
+    ICER_ZONE_IO_READ,           /* Backend file read */
+    ICER_ZONE_IO_WRITE,          /* Backend file write */
+    ICER_ZONE_COUNT
+};
+
+#if ICER_PROFILE
+
+#if defined(__NuttX__) && defined(__arm__)
+/* Cortex-M4 on the board: DWT cycle counter (wraps every ~27 s at 156 MHz, so
+ * a single zone must be shorter than that) */
+typedef uint32_t icer_profile_ticks_t;
+#define ICER_PROFILE_DWT_CYCCNT (*(volatile uint32_t *)0xE0001004u)
+static inline icer_profile_ticks_t icer_profile_now(void) {
+    return ICER_PROFILE_DWT_CYCCNT;
+}
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+typedef uint64_t icer_profile_ticks_t;
+static inline icer_profile_ticks_t icer_profile_now(void) {
+    return __rdtsc();
+}
+#else
+#include <time.h>
+typedef uint64_t icer_profile_ticks_t;
+static inline icer_profile_ticks_t icer_profile_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Add one pass through zone (start and end from icer_profile_now()); thread safe */
+void icer_profile_record(enum icer_profile_zone zone, icer_profile_ticks_t start, icer_profile_ticks_t end);
+
+#ifdef __cplusplus
+}
+#endif
+
+/* C: ICER_PROFILE_BEGIN(name); ... ICER_PROFILE_END(name, zone); in one block */
+#define ICER_PROFILE_BEGIN(name) const icer_profile_ticks_t icer_profile_start_##name = icer_profile_now()
+#define ICER_PROFILE_END(name, zone) icer_profile_record((zone), icer_profile_start_##name, icer_profile_now())
+
+#else
+
+#define ICER_PROFILE_BEGIN(name) do {} while (0)
+#define ICER_PROFILE_END(name, zone) do {} while (0)
+
+#endif /* ICER_PROFILE */
+
+#ifdef __cplusplus
+
+#if ICER_PROFILE
+/* C++: the zone ends when the scope is left */
+class IcerProfileScope {
+private:
+    enum icer_profile_zone zone;
+    icer_profile_ticks_t start;
+
+public:
+    explicit IcerProfileScope(enum icer_profile_zone profile_zone)
+        : zone(profile_zone), start(icer_profile_now()) {}
+    ~IcerProfileScope() { icer_profile_record(zone, start, icer_profile_now()); }
+};
+#define ICER_PROFILE_CONCAT2(a, b) a##b
+#define ICER_PROFILE_CONCAT(a, b) ICER_PROFILE_CONCAT2(a, b)
+#define ICER_PROFILE_SCOPE(zone) IcerProfileScope ICER_PROFILE_CONCAT(icer_profile_scope_, __LINE__)(zone)
+#else
+#define ICER_PROFILE_SCOPE(zone) do {} while (0)
+#endif
+
+// Aggregate of one zone since the last icerProfileReset() (times in ticks)
+typedef struct {
+    uint32_t count;
+    uint64_t total;
+    uint64_t min;
+    uint64_t max;
+} IcerProfileZoneStats;
+
+// Clear the zone table (call at the start of a frame); the first call also
+// starts the cycle counter on the board
+void icerProfileReset(void);
+
+// Aggregate of one zone (all zeros when profiling is compiled out)
+IcerProfileZoneStats icerProfileZoneStats(enum icer_profile_zone zone);
+
+// Name of a zone for reports ("wavelet-rows", "bitplane", ...)
+const char* icerProfileZoneName(enum icer_profile_zone zone);
+
+// Counter ticks per microsecond (CPU clock on the board, calibrated TSC rate on x86)
+double icerProfileTicksPerUs(void);
+
+// Print the zone table to Serial (call at the end of a frame; prints nothing
+// when profiling is compiled out)
+void printIcerProfile(void);
+
+// Host only: also record every zone pass as a trace event, up to max_events
+// (later events are counted and dropped), until icerProfileTraceStop()
+// Returns 0 on success, -1 if tracing is not available (profiler compiled out,
+// board build), -2 if out of memory
+int icerProfileTraceStart(size_t max_events);
+
+// Write the recorded events as Chrome trace JSON
+// Returns 0 on success, -1 if no trace was started, -2 if path cannot be written
+int icerProfileWriteChromeTrace(const char* path);
+
+// Stop recording and free the events
+void icerProfileTraceStop(void);
+
+#endif /* __cplusplus */
+
+#endif /* ICER_PROFILE_H */
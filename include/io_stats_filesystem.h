@@ -0,0 +1,92 @@
+#ifndef IO_STATS_FILESYSTEM_H
+#define IO_STATS_FILESYSTEM_H
+
+#include "filesystem_interface.h"
+
+// Pipeline phases the I/O is attributed to
+// The pipeline sets the current phase with ioStatsSetPhase() as it moves along;
+// every operation recorded by an I/O statistics file system is counted against it.
+enum IoPhase {
+    IO_PHASE_OTHER = 0,      // Anything outside the tagged phases (setup, result copy, ...)
+    IO_PHASE_INGEST,         // Camera/JPEG data to Y/U/V channel files
+    IO_PHASE_WAVELET_ROW,    // Wavelet transform, row pass
+    IO_PHASE_WAVELET_COL,    // Wavelet transform, column pass and stage copies
+    IO_PHASE_SIGN_MAG,       // LL mean, mean subtraction and sign-magnitude conversion
+    IO_PHASE_PARTITION,      // Per-packet partition compression (channel reads)
+    IO_PHASE_REARRANGE,      // Segment rearrange and output write
+    IO_PHASE_COUNT
+};
+
+// Operations that are counted separately
+enum IoOp {
+    IO_OP_READ = 0,
+    IO_OP_WRITE,
+    IO_OP_SEEK,
+    IO_OP_OPEN,
+    IO_OP_CLOSE,
+    IO_OP_FLUSH,
+    IO_OP_COUNT
+};
+
+// Latency histogram: bucket b counts operations that took [2^b, 2^(b+1)) us
+// (bucket 0 also holds 0 us, the last bucket everything above 2^(N-1) us ~ 32 ms)
+#define IO_LATENCY_BUCKETS 16
+
+// Counters for one operation type in one phase
+typedef struct {
+    uint32_t count;
+    uint64_t bytes;                           // Bytes transferred (read/write only)
+    uint64_t total_us;                        // Sum of latencies
+    uint32_t max_us;                          // Slowest single operation
+    uint32_t histogram[IO_LATENCY_BUCKETS];
+} IoOpStats;
+
+// Counters for one phase
+typedef struct {
+    IoOpStats ops[IO_OP_COUNT];
+    uint64_t seek_distance;                   // Sum of |new position - old position| over all seeks
+} IoPhaseStats;
+
+// Everything recorded by one I/O statistics file system
+typedef struct IoStats {
+    IoPhaseStats phases[IO_PHASE_COUNT];
+} IoStats;
+
+// Factory function to create an I/O accounting layer over another file system
+// Every call on the returned file system and its files is forwarded to backing,
+// timed with micros() and counted against the current phase. Put it directly
+// over the SD card file system to see real card traffic, or on top of the whole
+// stack to see what the pipeline asks for.
+//
+// Only one accounting layer is active at a time: ioStatsSnapshot() reads the
+// most recently created one that still exists.
+//
+// Parameters:
+//   backing:        File system that performs the actual I/O
+//   take_ownership: If true, backing is deleted when this file system is destroyed
+//
+// Returns:
+//   Pointer to IFileSystem implementation, or NULL on failure (out of memory)
+//   Caller is responsible for deleting the returned pointer (after all files are closed)
+IFileSystem* createIoStatsFileSystem(IFileSystem* backing, bool take_ownership = false);
+
+// Set / get the phase subsequent I/O is attributed to (cheap, no accounting layer needed)
+void ioStatsSetPhase(IoPhase phase);
+IoPhase ioStatsGetPhase(void);
+
+// Reset the counters of the active accounting layer (no-op if there is none)
+void ioStatsReset(void);
+
+// Copy the counters of the active accounting layer into its snapshot buffer
+// Returns a pointer to the snapshot (valid until the next snapshot or until the
+// layer is deleted), or NULL if no accounting layer exists
+const IoStats* ioStatsSnapshot(void);
+
+// Name of a phase / operation for reports ("ingest", "wavelet-row", "read", ...)
+const char* ioStatsPhaseName(IoPhase phase);
+const char* ioStatsOpName(IoOp op);
+
+// Print a per-phase summary of stats to Serial (NULL is ignored)
+void printIoStats(const IoStats* stats);
+
+#endif // IO_STATS_FILESYSTEM_H
@@ -0,0 +1,24 @@
+#ifndef MMAP_FILESYSTEM_H
+#define MMAP_FILESYSTEM_H
+
+#include "filesystem_interface.h"
+
+// Factory function to create an mmap file system backend (host builds)
+// Every IFile maps its file with MAP_SHARED, so read()/write() are plain
+// memcpy()s into the page cache and handles on the same file stay coherent
+// with each other (and with the POSIX backend). The mapping reserves address
+// space ahead of the file size and is only re-established when a write goes
+// past the reservation, while the file itself is grown to the exact number of
+// bytes written so other handles always see the correct size().
+//
+// File names and FILE_WRITE semantics are the same as createPosixFileSystem().
+//
+// Parameters:
+//   root_dir: Directory used for all files (NULL or "" for current directory)
+//
+// Returns:
+//   Pointer to IFileSystem implementation, or NULL on failure
+//   Caller is responsible for deleting the returned pointer
+IFileSystem* createMmapFileSystem(const char* root_dir);
+
+#endif // MMAP_FILESYSTEM_H
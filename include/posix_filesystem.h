@@ -0,0 +1,24 @@
+#ifndef POSIX_FILESYSTEM_H
+#define POSIX_FILESYSTEM_H
+
+#include "filesystem_interface.h"
+
+// Factory function to create a POSIX file system backend (host builds)
+// Every IFile keeps its own position and uses pread()/pwrite() on a plain
+// file descriptor, so there is no stdio buffering and no shared seek pointer
+// between handles that refer to the same file.
+//
+// File names are resolved relative to root_dir, mirroring how the Spresense SD
+// library resolves names relative to the card mount point. FILE_WRITE follows
+// the Arduino semantics the pipeline relies on: create if missing, keep
+// existing contents, start positioned at the end of the file, allow seek().
+//
+// Parameters:
+//   root_dir: Directory used for all files (NULL or "" for current directory)
+//
+// Returns:
+//   Pointer to IFileSystem implementation, or NULL on failure
+//   Caller is responsible for deleting the returned pointer
+IFileSystem* createPosixFileSystem(const char* root_dir);
+
+#endif // POSIX_FILESYSTEM_H
@@ -0,0 +1,92 @@
+#ifndef SIMULATED_SD_FILESYSTEM_H
+#define SIMULATED_SD_FILESYSTEM_H
+
+#include "filesystem_interface.h"
+
+// Cost model of an SD card behind the Spresense FAT driver
+// All times are charged to a simulated clock, nothing actually sleeps.
+typedef struct {
+    uint32_t command_us;           // Fixed cost of every read/write command (command, response, busy polling)
+    uint32_t sector_size;          // Transfers are rounded out to whole sectors
+    uint32_t read_kbps;            // Sequential read throughput, KB/s
+    uint32_t write_kbps;           // Sequential write throughput, KB/s
+    uint32_t random_ratio;         // Sequential / random throughput ratio (1 = no penalty)
+    uint32_t lookup_us;            // FAT directory lookup on open(), exists() and remove()
+    uint32_t create_us;            // Extra cost of creating or truncating a file (directory entry, FAT chain)
+    uint32_t sync_us;              // Directory entry and FAT update on flush()/close() of a written file
+    uint32_t program_stall_us;     // Write-program stall (erase / garbage collection inside the card)
+    uint32_t program_stall_bytes;  // Bytes written between program stalls (0 = no stalls)
+} SimulatedSdParams;
+
+// Simulated card time, split by what it was spent on
+typedef struct {
+    uint64_t simulated_us;         // Sum of the four parts below
+    uint64_t command_us;
+    uint64_t transfer_us;
+    uint64_t lookup_us;            // Lookups, creates and syncs
+    uint64_t stall_us;
+    uint64_t host_us;              // Real time spent in the backing file system
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+    uint32_t commands;             // Read and write commands sent to the card
+    uint32_t random_commands;      // Commands that did not continue the file's previous transfer
+    uint32_t cached_accesses;      // Reads/writes served from the driver's sector buffer
+    uint32_t opens;
+    uint32_t syncs;
+    uint32_t stalls;
+} SimulatedSdStats;
+
+// Defaults: a class 10 card on the Spresense SDHCI (4-bit, 25 MHz) as seen
+// through the Arduino SD library. They are rough; calibrate them against
+// printIoStats() output of the same frame on the board.
+void simulatedSdDefaultParams(SimulatedSdParams* params);
+
+// Factory function to create a simulated SD card layer over another file system
+// Every call is forwarded to backing (normally the POSIX or mmap backend), and
+// the time the call would take on the card is added to a simulated clock:
+//
+// - read()/write(): command_us per call, plus the sectors touched at the
+//   sequential throughput, divided by random_ratio when the transfer does not
+//   continue the previous transfer of the same file (the last 4 files
+//   transferred are tracked, like the card's open allocation units). Accesses inside the last transferred sector of
+//   the same file are served from the driver's sector buffer for free.
+// - Every program_stall_bytes written cost a program stall.
+// - open(), exists(), remove(): a directory lookup; creating a file (FILE_WRITE
+//   on a new file, createPreallocated) also costs create_us.
+// - flush()/close() after writes: a directory entry / FAT update (sync_us).
+// - seek(): free, but the next transfer is usually not sequential.
+//
+// The real time spent in the backing file system is recorded too, so the
+// on-device time of a run can be estimated as
+//   real wall time - host_us + simulated_us
+// Put the layer directly over the backend (below async, tiered and handle
+// cache layers) so it sees the traffic the card would see. With the async
+// layer the estimate is an upper bound, the overlap of compute and card
+// time is not modelled.
+//
+// Only one simulated card is active at a time: simulatedSdSnapshot() reads
+// the most recently created one that still exists.
+//
+// Parameters:
+//   backing:        File system that performs the actual I/O
+//   params:         Card model (NULL = simulatedSdDefaultParams)
+//   take_ownership: If true, backing is deleted when this file system is destroyed
+//
+// Returns:
+//   Pointer to IFileSystem implementation, or NULL on failure
+//   Caller is responsible for deleting the returned pointer (after all files are closed)
+IFileSystem* createSimulatedSDFileSystem(IFileSystem* backing, const SimulatedSdParams* params = NULL,
+                                         bool take_ownership = false);
+
+// Reset the clock and counters of the active simulated card (no-op if there is none)
+void simulatedSdReset(void);
+
+// Copy the counters of the active simulated card into its snapshot buffer
+// Returns a pointer to the snapshot (valid until the next snapshot or until the
+// layer is deleted), or NULL if no simulated card exists
+const SimulatedSdStats* simulatedSdSnapshot(void);
+
+// Print stats to Serial (NULL is ignored)
+void printSimulatedSdStats(const SimulatedSdStats* stats);
+
+#endif // SIMULATED_SD_FILESYSTEM_H
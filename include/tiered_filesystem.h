@@ -0,0 +1,38 @@
+#ifndef TIERED_FILESYSTEM_H
+#define TIERED_FILESYSTEM_H
+
+#include "filesystem_interface.h"
+
+// RAM allocator used for the RAM tier (e.g. up_gnssram_malloc/up_gnssram_free)
+typedef void* (*TieredRamAlloc)(size_t size);
+typedef void (*TieredRamFree)(void* ptr);
+
+// Factory function to create a tiered file system
+// Short-lived intermediates are kept in a RAM-backed store when they fit, and
+// everything else goes to the backing file system (normally the SD card).
+//
+// Placement is decided when a file is created: open(name, FILE_WRITE) on a file
+// that does not exist yet goes to RAM only if setSizeHint(name, size) was called
+// first and size fits in the remaining RAM budget. Files without a hint always go
+// to the backing file system. If a RAM file later outgrows its allocation and the
+// budget (or the allocator) cannot grow it, its contents are spilled to the
+// backing file system and all open handles continue there transparently.
+//
+// RAM files live until remove() (or until the tiered file system is deleted),
+// so callers must remove their intermediates as they already do on SD.
+//
+// Parameters:
+//   backing:        File system used for files that do not fit in RAM
+//   ram_budget:     Maximum number of bytes held in RAM files at any time
+//   ram_alloc:      Allocator for RAM file buffers (NULL = malloc)
+//   ram_free:       Matching free function (NULL = free)
+//   take_ownership: If true, backing is deleted when the tiered file system is destroyed
+//
+// Returns:
+//   Pointer to IFileSystem implementation, or NULL on failure
+//   Caller is responsible for deleting the returned pointer
+IFileSystem* createTieredFileSystem(IFileSystem* backing, size_t ram_budget,
+                                    TieredRamAlloc ram_alloc = NULL, TieredRamFree ram_free = NULL,
+                                    bool take_ownership = false);
+
+#endif // TIERED_FILESYSTEM_H
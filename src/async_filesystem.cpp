@@ -0,0 +1,572 @@
+#include "async_filesystem.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// Asynchronous I/O layer: background writer and prefetching reader
+//
+// All backing-file I/O of a handle with requests in flight is done by the I/O
+// thread; the caller only touches the backing file itself after waiting for its
+// own requests to complete, so no backing IFile is ever used by two threads at once.
+
+#if defined(__NuttX__) || defined(__unix__) || defined(__APPLE__)
+#define ASYNC_IO_HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+// Stack for the I/O thread on the board (FAT driver + SD stack need some room)
+#define ASYNC_IO_STACK_SIZE 4096
+
+// One read or write request on a backing file
+struct AsyncJob {
+    IFile* file;
+    bool is_read;
+    size_t offset;
+    uint8_t* buffer;
+    size_t length;
+    size_t result;       // Bytes actually transferred
+    volatile bool done;
+    AsyncJob* next;
+};
+
+// Single background thread executing AsyncJobs in submission order
+class AsyncIoWorker {
+private:
+#ifdef ASYNC_IO_HAVE_PTHREADS
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+#endif
+    AsyncJob* head;
+    AsyncJob* tail;
+    bool running;    // I/O thread was started
+    bool stopping;
+
+    static void execute(AsyncJob* job) {
+        if (!job->file->seek(job->offset)) {
+            job->result = 0;
+        } else if (job->is_read) {
+            job->result = job->file->read(job->buffer, job->length);
+        } else {
+            job->result = job->file->write(job->buffer, job->length);
+        }
+    }
+
+#ifdef ASYNC_IO_HAVE_PTHREADS
+    static void* threadMain(void* arg) {
+        AsyncIoWorker* self = static_cast<AsyncIoWorker*>(arg);
+        pthread_mutex_lock(&self->lock);
+        for (;;) {
+            while (!self->head && !self->stopping) {
+                pthread_cond_wait(&self->cond, &self->lock);
+            }
+            if (!self->head) {
+                break;  // Stopping and queue drained
+            }
+            AsyncJob* job = self->head;
+            pthread_mutex_unlock(&self->lock);
+
+            execute(job);
+
+            pthread_mutex_lock(&self->lock);
+            self->head = job->next;
+            if (!self->head) {
+                self->tail = NULL;
+            }
+            job->done = true;
+            pthread_cond_broadcast(&self->cond);
+        }
+        pthread_mutex_unlock(&self->lock);
+        return NULL;
+    }
+#endif
+
+public:
+    AsyncIoWorker() : head(NULL), tail(NULL), running(false), stopping(false) {
+#ifdef ASYNC_IO_HAVE_PTHREADS
+        pthread_mutex_init(&lock, NULL);
+        pthread_cond_init(&cond, NULL);
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+#ifdef __NuttX__
+        pthread_attr_setstacksize(&attr, ASYNC_IO_STACK_SIZE);
+#endif
+        running = (pthread_create(&thread, &attr, threadMain, this) == 0);
+        pthread_attr_destroy(&attr);
+#endif
+    }
+
+    ~AsyncIoWorker() {
+#ifdef ASYNC_IO_HAVE_PTHREADS
+        if (running) {
+            pthread_mutex_lock(&lock);
+            stopping = true;
+            pthread_cond_broadcast(&cond);
+            pthread_mutex_unlock(&lock);
+            pthread_join(thread, NULL);
+        }
+        pthread_cond_destroy(&cond);
+        pthread_mutex_destroy(&lock);
+#endif
+    }
+
+    // Queue a job (executed inline if there is no I/O thread)
+    void submit(AsyncJob* job) {
+        job->done = false;
+        job->next = NULL;
+        job->result = 0;
+#ifdef ASYNC_IO_HAVE_PTHREADS
+        if (running) {
+            pthread_mutex_lock(&lock);
+            if (tail) {
+                tail->next = job;
+            } else {
+                head = job;
+            }
+            tail = job;
+            pthread_cond_broadcast(&cond);
+            pthread_mutex_unlock(&lock);
+            return;
+        }
+#endif
+        execute(job);
+        job->done = true;
+    }
+
+    // Block until job has completed
+    void wait(AsyncJob* job) {
+#ifdef ASYNC_IO_HAVE_PTHREADS
+        if (running) {
+            pthread_mutex_lock(&lock);
+            while (!job->done) {
+                pthread_cond_wait(&cond, &lock);
+            }
+            pthread_mutex_unlock(&lock);
+        }
+#endif
+        (void)job;
+    }
+};
+
+// Write buffer of an AsyncWriteFile
+struct AsyncWriteBuffer {
+    uint8_t* data;
+    size_t used;
+    size_t offset;     // File offset of data[0]
+    bool in_flight;
+    AsyncJob job;
+};
+
+// Write handle: coalesces writes into buffers drained by the I/O thread
+class AsyncWriteFile : public IFile {
+private:
+    IFile* inner;
+    AsyncIoWorker* worker;
+    AsyncWriteBuffer* buffers;
+    uint8_t buffer_count;
+    size_t buffer_size;
+    uint8_t current;
+    size_t pos;
+    bool failed;       // A background write came up short
+
+    // Wait for one buffer's write and record its outcome
+    void complete(AsyncWriteBuffer* buf) {
+        if (!buf->in_flight) {
+            return;
+        }
+        worker->wait(&buf->job);
+        if (buf->job.result != buf->used) {
+            failed = true;
+        }
+        buf->in_flight = false;
+        buf->used = 0;
+    }
+
+    // Hand the current buffer to the I/O thread and move on to the next one
+    void submitCurrent() {
+        AsyncWriteBuffer* buf = &buffers[current];
+        if (buf->used == 0 || !buf->data) {
+            return;
+        }
+        buf->job.file = inner;
+        buf->job.is_read = false;
+        buf->job.offset = buf->offset;
+        buf->job.buffer = buf->data;
+        buf->job.length = buf->used;
+        buf->in_flight = true;
+        worker->submit(&buf->job);
+        current = (uint8_t)((current + 1) % buffer_count);
+        complete(&buffers[current]);  // Reuse the oldest buffer once its write is done
+    }
+
+    // Completion barrier: every queued write has reached the backing file
+    void drain() {
+        if (!buffers) {
+            return;
+        }
+        submitCurrent();
+        for (uint8_t i = 0; i < buffer_count; i++) {
+            complete(&buffers[i]);
+        }
+    }
+
+public:
+    AsyncWriteFile(IFile* file, AsyncIoWorker* io, size_t buf_size, uint8_t buf_count)
+        : inner(file), worker(io), buffers(NULL), buffer_count(buf_count), buffer_size(buf_size),
+          current(0), pos(0), failed(false) {
+        pos = inner->position();  // FILE_WRITE starts at the end of the file
+        buffers = (AsyncWriteBuffer*)calloc(buffer_count, sizeof(AsyncWriteBuffer));
+        if (buffers) {
+            for (uint8_t i = 0; i < buffer_count; i++) {
+                buffers[i].data = (uint8_t*)malloc(buffer_size);
+                if (!buffers[i].data) {
+                    failed = true;
+                }
+            }
+        } else {
+            failed = true;
+        }
+    }
+
+    // True if all buffers could be allocated
+    bool isValid() const {
+        return !failed;
+    }
+
+    ~AsyncWriteFile() override {
+        if (inner) {
+            close();
+        }
+        if (buffers) {
+            for (uint8_t i = 0; i < buffer_count; i++) {
+                free(buffers[i].data);
+            }
+            free(buffers);
+        }
+    }
+
+    size_t read(uint8_t* buffer, size_t size) override {
+        if (!inner) {
+            return 0;
+        }
+        drain();
+        if (!inner->seek(pos)) {
+            return 0;
+        }
+        size_t n = inner->read(buffer, size);
+        pos += n;
+        return n;
+    }
+
+    size_t write(const uint8_t* data, size_t size) override {
+        if (!inner || failed || !data) {
+            return 0;
+        }
+        size_t written = 0;
+        while (written < size) {
+            AsyncWriteBuffer* buf = &buffers[current];
+            if (buf->used > 0 && (buf->offset + buf->used != pos || buf->used == buffer_size)) {
+                submitCurrent();
+                buf = &buffers[current];
+            }
+            if (buf->used == 0) {
+                buf->offset = pos;
+            }
+            size_t n = buffer_size - buf->used;
+            if (n > size - written) {
+                n = size - written;
+            }
+            memcpy(buf->data + buf->used, data + written, n);
+            buf->used += n;
+            written += n;
+            pos += n;
+        }
+        return failed ? 0 : written;
+    }
+
+    bool seek(size_t position) override {
+        if (!inner) {
+            return false;
+        }
+        pos = position;  // The next write starts a new buffer if it is not contiguous
+        return true;
+    }
+
+    size_t position() override {
+        return inner ? pos : 0;
+    }
+
+    size_t size() override {
+        if (!inner) {
+            return 0;
+        }
+        drain();
+        return inner->size();
+    }
+
+    bool flush() override {
+        if (!inner) {
+            return false;
+        }
+        drain();
+        return inner->flush() && !failed;
+    }
+
+    bool reserve(size_t size) override {
+        if (!inner) {
+            return false;
+        }
+        drain();
+        return inner->reserve(size);
+    }
+
+    bool close() override {
+        if (!inner) {
+            return true;  // Already closed
+        }
+        drain();
+        bool ok = inner->close() && !failed;
+        delete inner;
+        inner = NULL;
+        return ok;
+    }
+
+    bool isOpen() const override {
+        return inner != NULL;
+    }
+
+    operator bool() const override {
+        return inner != NULL;
+    }
+};
+
+// Read handle: prefetches the next expected block in the background
+class AsyncReadFile : public IFile {
+private:
+    IFile* inner;
+    AsyncIoWorker* worker;
+    uint8_t* prefetch_buf;
+    size_t prefetch_cap;
+    bool prefetch_pending;   // Job submitted (possibly completed) and not consumed
+    AsyncJob job;
+    size_t pos;
+    size_t last_offset;      // Offset of the previous read, for stride detection
+    bool have_last;
+    size_t file_size;
+    size_t max_prefetch;     // Reads larger than this are never prefetched
+
+    void waitPrefetch() {
+        if (prefetch_pending) {
+            worker->wait(&job);
+        }
+    }
+
+    // Start reading [offset, offset + length) in the background
+    void startPrefetch(size_t offset, size_t length) {
+        if (length == 0 || length > max_prefetch || offset >= file_size) {
+            return;
+        }
+        if (length > prefetch_cap) {
+            uint8_t* new_buf = (uint8_t*)realloc(prefetch_buf, length);
+            if (!new_buf) {
+                return;  // No prefetching, reads stay synchronous
+            }
+            prefetch_buf = new_buf;
+            prefetch_cap = length;
+        }
+        job.file = inner;
+        job.is_read = true;
+        job.offset = offset;
+        job.buffer = prefetch_buf;
+        job.length = length;
+        prefetch_pending = true;
+        worker->submit(&job);
+    }
+
+public:
+    AsyncReadFile(IFile* file, AsyncIoWorker* io, size_t read_ahead_limit)
+        : inner(file), worker(io), prefetch_buf(NULL), prefetch_cap(0), prefetch_pending(false),
+          pos(0), last_offset(0), have_last(false), file_size(0), max_prefetch(read_ahead_limit) {
+        memset(&job, 0, sizeof(job));
+        file_size = inner->size();
+    }
+
+    ~AsyncReadFile() override {
+        if (inner) {
+            close();
+        }
+        free(prefetch_buf);
+    }
+
+    size_t read(uint8_t* buffer, size_t size) override {
+        if (!inner || !buffer) {
+            return 0;
+        }
+        size_t n = 0;
+        bool hit = false;
+        if (prefetch_pending) {
+            waitPrefetch();
+            prefetch_pending = false;
+            // Hit if the request starts at the prefetched block and is covered by it.
+            // A short prefetch result only satisfies the request when it ends at
+            // EOF; a short read anywhere else is retried synchronously below
+            bool at_eof = job.offset + job.result >= file_size;
+            if (job.offset == pos && (size <= job.result || (job.result < job.length && at_eof))) {
+                n = (size < job.result) ? size : job.result;
+                memcpy(buffer, prefetch_buf, n);
+                hit = true;
+            }
+        }
+        if (!hit) {
+            if (!inner->seek(pos)) {
+                return 0;
+            }
+            n = inner->read(buffer, size);
+        }
+
+        // Predict the next read: same stride as the last two reads, else sequential
+        size_t next = pos + n;
+        if (have_last && pos > last_offset && pos - last_offset >= size) {
+            next = pos + (pos - last_offset);
+        }
+        last_offset = pos;
+        have_last = true;
+        pos += n;
+        if (n == size) {
+            startPrefetch(next, size);
+        }
+        return n;
+    }
+
+    size_t write(const uint8_t* data, size_t size) override {
+        (void)data;
+        (void)size;
+        return 0;  // Read-only handle
+    }
+
+    bool seek(size_t position) override {
+        if (!inner) {
+            return false;
+        }
+        pos = position;  // A pending prefetch is simply not used if it does not match
+        return true;
+    }
+
+    size_t position() override {
+        return inner ? pos : 0;
+    }
+
+    size_t size() override {
+        if (!inner) {
+            return 0;
+        }
+        waitPrefetch();
+        file_size = inner->size();
+        return file_size;
+    }
+
+    bool flush() override {
+        return inner != NULL;
+    }
+
+    bool close() override {
+        if (!inner) {
+            return true;  // Already closed
+        }
+        waitPrefetch();
+        prefetch_pending = false;
+        bool ok = inner->close();
+        delete inner;
+        inner = NULL;
+        return ok;
+    }
+
+    bool isOpen() const override {
+        return inner != NULL;
+    }
+
+    operator bool() const override {
+        return inner != NULL;
+    }
+};
+
+// Asynchronous file system implementation
+class AsyncFileSystem : public IFileSystem {
+private:
+    IFileSystem* backing;
+    bool owns_backing;
+    size_t write_buffer_size;
+    uint8_t write_buffer_count;
+    size_t read_ahead_limit;
+    AsyncIoWorker worker;
+
+public:
+    AsyncFileSystem(IFileSystem* backing_fs, size_t buf_size, uint8_t buf_count, bool take_ownership,
+                    size_t read_ahead)
+        : backing(backing_fs), owns_backing(take_ownership), write_buffer_size(buf_size),
+          write_buffer_count(buf_count), read_ahead_limit(read_ahead) {}
+
+    ~AsyncFileSystem() override {
+        if (owns_backing && backing) {
+            delete backing;
+        }
+    }
+
+    bool begin() override {
+        return backing->begin();
+    }
+
+    // Wrap a backing write handle, NULL if the write buffers cannot be allocated
+    IFile* wrapWriter(IFile* file) {
+        AsyncWriteFile* async_file = new AsyncWriteFile(file, &worker, write_buffer_size, write_buffer_count);
+        if (!async_file->isValid()) {
+            delete async_file;  // Closes and deletes the backing file
+            return nullptr;
+        }
+        return async_file;
+    }
+
+    IFile* open(const char* filename, int mode) override {
+        IFile* file = backing->open(filename, mode);
+        if (!file) {
+            return nullptr;
+        }
+        if (mode == FILE_READ) {
+            return new AsyncReadFile(file, &worker, read_ahead_limit);
+        }
+        return wrapWriter(file);
+    }
+
+    // Preallocation itself runs synchronously: it must be complete before the
+    // caller starts seeking around in the file
+    IFile* createPreallocated(const char* filename, size_t size) override {
+        IFile* file = backing->createPreallocated(filename, size);
+        if (!file) {
+            return nullptr;
+        }
+        return wrapWriter(file);
+    }
+
+    bool remove(const char* filename) override {
+        return backing->remove(filename);
+    }
+
+    bool exists(const char* filename) override {
+        return backing->exists(filename);
+    }
+
+    void setSizeHint(const char* filename, size_t expected_size) override {
+        backing->setSizeHint(filename, expected_size);
+    }
+};
+
+// Factory function to create an asynchronous I/O layer
+IFileSystem* createAsyncFileSystem(IFileSystem* backing, size_t write_buffer_size,
+                                   uint8_t write_buffer_count, bool take_ownership,
+                                   size_t read_ahead_limit) {
+    if (!backing || write_buffer_size == 0 || write_buffer_count < 2) {
+        return NULL;
+    }
+    return new AsyncFileSystem(backing, write_buffer_size, write_buffer_count, take_ownership,
+                               read_ahead_limit);
+}
@@ -1,12 +1,16 @@
 #include "camera_yuv.h"
 #include "filesystem_interface.h"
 #include "spresence_sd_filesystem.h"
+#include "io_stats_filesystem.h"
+#include "memory_planner.h"
+#include "icer_telemetry.h"
+#include "icer_log.h"
 #include <Camera.h>
 #include <SDHCI.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
-#include <Arduino.h>  // For Serial progress reporting
+#include <Arduino.h>
 
 // Streaming JPEG decoder using Tiny JPEG Decompressor (tjpgd)
 // This decoder reads JPEG from flash and writes RGB directly to flash, row by row
@@ -20,9 +24,8 @@ static struct {
     int width;                 // Image width
     int height;                // Image height
     size_t row_size_bytes;     // Size of one RGB row (width * 3)
-    int mcu_blocks_processed;  // Counter for progress reporting
-    unsigned long last_progress_time;  // For periodic progress updates
-} stream_decode_ctx = {NULL, NULL, 0, 0, 0, 0, 0};
+    int mcu_blocks_processed;  // MCU blocks decoded so far
+} stream_decode_ctx = {NULL, NULL, 0, 0, 0, 0};
 
 // Input function for tjpgd - reads JPEG data from flash
 // This is called by tjpgd whenever it needs more data to fill its internal buffer
@@ -34,6 +37,15 @@ static size_t jpeg_input_func(JDEC* jd, uint8_t* buff, size_t nbyte) {
         return 0;  // Error: file not available
     }
     
+    // tjpgd passes buff == NULL to skip segments it does not use (APPn, COM, ...)
+    if (!buff) {
+        IFile* file = stream_decode_ctx.jpeg_file;
+        size_t pos = file->position();
+        size_t remaining = file->size() - pos;
+        size_t skip = (nbyte < remaining) ? nbyte : remaining;
+        return file->seek(pos + skip) ? skip : 0;
+    }
+
     // Read from current file position (tjpgd calls this sequentially)
     return stream_decode_ctx.jpeg_file->read(buff, nbyte);
 }
@@ -103,27 +115,8 @@ static int jpeg_output_func(JDEC* jd, void* bitmap, JRECT* rect) {
     // Update progress counter
     stream_decode_ctx.mcu_blocks_processed++;
     
-    // Report progress every 100 MCU blocks or every 2 seconds, whichever comes first
-    unsigned long current_time = millis();
-    if (stream_decode_ctx.mcu_blocks_processed % 100 == 0 || 
-        (current_time - stream_decode_ctx.last_progress_time) > 2000) {
-        // Estimate progress based on bottom row processed (MCU blocks are typically 8x8 or 16x16)
-        // Use rect->bottom as a proxy for progress
-        int progress_percent = 0;
-        if (stream_decode_ctx.height > 0) {
-            progress_percent = (int)((rect->bottom * 100) / stream_decode_ctx.height);
-            if (progress_percent > 100) progress_percent = 100;
-        }
-        // Use minimal Serial output to avoid stack issues
-        Serial.print("  JPEG decode: ~");
-        Serial.print(progress_percent);
-        Serial.print("% (");
-        Serial.print(rect->bottom);
-        Serial.print("/");
-        Serial.print(stream_decode_ctx.height);
-        Serial.println(")");
-        stream_decode_ctx.last_progress_time = current_time;
-    }
+    // Rows finished so far: MCU blocks arrive left to right, so rect->bottom is a close estimate
+    icerReportProgress(ICER_PHASE_INGEST, rect->bottom, stream_decode_ctx.height);
     
     // Flush periodically to reduce flash wear (every ~50 rows)
     // Use rect->bottom to determine when to flush
@@ -150,6 +143,7 @@ int convertYuv422ToSeparateChannels(
     if (!yuv422_data || !filesystem || width == 0 || height == 0) {
         return -1;
     }
+    ioStatsSetPhase(IO_PHASE_INGEST);
     
     // Remove existing files
     filesystem->remove(y_flash_file);
@@ -157,6 +151,10 @@ int convertYuv422ToSeparateChannels(
     filesystem->remove(v_flash_file);
     
     // Open flash files for Y, U, V channels
+    size_t channel_size = width * height * sizeof(uint16_t);
+    filesystem->setSizeHint(y_flash_file, channel_size);
+    filesystem->setSizeHint(u_flash_file, channel_size);
+    filesystem->setSizeHint(v_flash_file, channel_size);
     IFile* y_file = filesystem->open(y_flash_file, FILE_WRITE);
     IFile* u_file = filesystem->open(u_flash_file, FILE_WRITE);
     IFile* v_file = filesystem->open(v_flash_file, FILE_WRITE);
@@ -170,6 +168,10 @@ int convertYuv422ToSeparateChannels(
         filesystem->remove(v_flash_file);
         return -2;
     }
+    // Reserve the full channel size where the backend supports it (best effort)
+    y_file->reserve(channel_size);
+    u_file->reserve(channel_size);
+    v_file->reserve(channel_size);
     
     // Process scanline-by-scanline to minimize RAM
     // YUV422: 2 bytes per pixel (Y, U, Y, V pattern)
@@ -270,29 +272,6 @@ int convertYuv422ToSeparateChannels(
 }
 
 
-// Convert RGB to YUV using ITU-R BT.601 standard formulas
-// Y = 0.299*R + 0.587*G + 0.114*B
-// U (Cb) = -0.168736*R - 0.331264*G + 0.5*B + 128
-// V (Cr) = 0.5*R - 0.418688*G - 0.081312*B + 128
-// Using integer arithmetic: multiply coefficients by 1000000, then divide by 1000000 for maximum accuracy
-// Output: Y, U, V values in range [0, 255] stored as uint16_t (compatible with ICER)
-static inline void rgb_to_yuv(uint8_t r, uint8_t g, uint8_t b, uint16_t* y, uint16_t* u, uint16_t* v) {
-    // Y calculation: 0.299*R + 0.587*G + 0.114*B
-    // Exact: (299000*R + 587000*G + 114000*B) / 1000000
-    int32_t y_val = (299000L * (int32_t)r + 587000L * (int32_t)g + 114000L * (int32_t)b) / 1000000L;
-    *y = (uint16_t)(y_val < 0 ? 0 : (y_val > 255 ? 255 : y_val));
-    
-    // U (Cb) calculation: -0.168736*R - 0.331264*G + 0.5*B + 128
-    // Exact: (-168736*R - 331264*G + 500000*B) / 1000000 + 128
-    int32_t u_val = (-168736L * (int32_t)r - 331264L * (int32_t)g + 500000L * (int32_t)b) / 1000000L + 128;
-    *u = (uint16_t)(u_val < 0 ? 0 : (u_val > 255 ? 255 : u_val));
-    
-    // V (Cr) calculation: 0.5*R - 0.418688*G - 0.081312*B + 128
-    // Exact: (500000*R - 418688*G - 81312*B) / 1000000 + 128
-    int32_t v_val = (500000L * (int32_t)r - 418688L * (int32_t)g - 81312L * (int32_t)b) / 1000000L + 128;
-    *v = (uint16_t)(v_val < 0 ? 0 : (v_val > 255 ? 255 : v_val));
-}
-
 // Convert JPEG image to separate Y, U, V channel files in flash
 // This function uses streaming JPEG decoding (tjpgd) to minimize RAM usage
 // 
@@ -303,7 +282,7 @@ static inline void rgb_to_yuv(uint8_t r, uint8_t g, uint8_t b, uint16_t* y, uint
 //   - Format matches flash_icer_compression.cpp expectations exactly
 //
 // Peak memory utilization (for 720p = 1280x720):
-//   - Step 2 (JPEG decode): ~3.7 KB (WORK_BUF_SIZE + JDEC struct)
+//   - Step 2 (JPEG decode): ~3.7-8.4 KB (WORK_BUF_SIZE from the buffer plan + JDEC struct)
 //   - Step 4 (RGB to YUV): ~11.5 KB (scanline buffers)
 //   - Overall peak: ~11.5 KB (during Step 4)
 //
@@ -322,6 +301,7 @@ int convertJpegToSeparateChannels(
     if (!jpeg_img.isAvailable() || !filesystem) {
         return -1;
     }
+    ioStatsSetPhase(IO_PHASE_INGEST);
 
     // Get JPEG data from CamImage
     // CRITICAL: After Step 1, we no longer need the CamImage object or camera
@@ -334,16 +314,17 @@ int convertJpegToSeparateChannels(
     }
 
     // Step 1: Save JPEG to flash first (compressed, so small)
-    Serial.println("  Step 1: Saving JPEG to flash...");
+    ICER_LOG_INFO("  Step 1: Saving JPEG to flash...");
     // After this step, the JPEG data is in flash and we no longer need:
     // - The CamImage object (can be freed by caller)
     // - The camera (can be ended by caller to free memory)
     // All subsequent operations read from flash files only
     const char* temp_jpeg_file = "_temp_jpeg.tmp";
     filesystem->remove(temp_jpeg_file);
+    filesystem->setSizeHint(temp_jpeg_file, jpeg_size);
     IFile* jpeg_flash_file = filesystem->open(temp_jpeg_file, FILE_WRITE);
     if (!jpeg_flash_file) {
-        Serial.println("  ERROR: Failed to open JPEG temp file for writing");
+        ICER_LOG_ERROR("  ERROR: Failed to open JPEG temp file for writing");
         return -3;
     }
     
@@ -352,17 +333,11 @@ int convertJpegToSeparateChannels(
     delete jpeg_flash_file;
     
     if (jpeg_written != jpeg_size) {
-        Serial.print("  ERROR: Failed to write JPEG data (");
-        Serial.print(jpeg_written);
-        Serial.print(" of ");
-        Serial.print(jpeg_size);
-        Serial.println(" bytes)");
+        ICER_LOG_ERROR("  ERROR: Failed to write JPEG data (%zu of %zu bytes)", jpeg_written, jpeg_size);
         filesystem->remove(temp_jpeg_file);
         return -4;
     }
-    Serial.print("  Step 1 complete: Saved ");
-    Serial.print(jpeg_size);
-    Serial.println(" bytes to flash");
+    ICER_LOG_INFO("  Step 1 complete: Saved %zu bytes to flash", jpeg_size);
     
     // JPEG data is now safely in flash - caller can free CamImage and end camera here
 
@@ -393,15 +368,14 @@ int convertJpegToSeparateChannels(
     stream_decode_ctx.height = 0;
     stream_decode_ctx.row_size_bytes = 0;
     stream_decode_ctx.mcu_blocks_processed = 0;
-    stream_decode_ctx.last_progress_time = millis();
     
     // Allocate working buffer for tjpgd
     // This is the ONLY significant RAM allocation during JPEG decode - much smaller than full image buffer
     // tjpgd needs: input buffer (512 bytes) + huffman tables + quantization tables + MCU buffer + IDCT work buffer
     // For baseline JPEG (8-bit, 3 components): minimum ~3100 bytes, recommended ~3500 bytes for safety
-    // Using 3500 bytes to ensure we have enough headroom for various JPEG configurations
-    // Peak memory during Step 2: 3500 bytes (WORK_BUF_SIZE) + ~200 bytes (JDEC struct on stack) ≈ 3.7 KB
-    const size_t WORK_BUF_SIZE = 3500;  // Safe size for baseline JPEG with 3 components
+    // Peak memory during Step 2: WORK_BUF_SIZE + ~200 bytes (JDEC struct on stack)
+    // The buffer plan uses 3500 bytes when memory is tight, more when there is room
+    const size_t WORK_BUF_SIZE = currentBufferPlan()->jpeg_work_bytes;
     void* work_buf = malloc(WORK_BUF_SIZE);
     if (!work_buf) {
         jpeg_file->close();
@@ -416,12 +390,11 @@ int convertJpegToSeparateChannels(
     }
     
     // Prepare JPEG decoder
-    Serial.println("  Step 2: Preparing JPEG decoder...");
+    ICER_LOG_INFO("  Step 2: Preparing JPEG decoder...");
     JDEC jdec;
     JRESULT jres = jd_prepare(&jdec, jpeg_input_func, work_buf, WORK_BUF_SIZE, NULL);
     if (jres != JDR_OK) {
-        Serial.print("  ERROR: JPEG prepare failed with code ");
-        Serial.println((int)jres);
+        ICER_LOG_ERROR("  ERROR: JPEG prepare failed with code %d", (int)jres);
         free(work_buf);
         jpeg_file->close();
         delete jpeg_file;
@@ -437,10 +410,7 @@ int convertJpegToSeparateChannels(
     // Get image dimensions
     int width = (int)jdec.width;
     int height = (int)jdec.height;
-    Serial.print("  Image dimensions: ");
-    Serial.print(width);
-    Serial.print("x");
-    Serial.println(height);
+    ICER_LOG_INFO("  Image dimensions: %dx%d", width, height);
     
     if (width <= 0 || height <= 0) {
         free(work_buf);
@@ -468,13 +438,13 @@ int convertJpegToSeparateChannels(
     stream_decode_ctx.height = height;
     stream_decode_ctx.row_size_bytes = (size_t)width * 3;  // RGB888 = 3 bytes per pixel
     
-    // CRITICAL FIX: Skip pre-allocation for RGB file
+    // CRITICAL FIX: Skip zero-filling the RGB file
     // Pre-allocating 2.76 MB by writing zeros is extremely slow (2,705 write operations)
-    // Instead, we'll let the file grow naturally as MCU blocks are written
-    // The file system will handle extending the file automatically
-    // This is much faster and more reliable
+    // Instead, we reserve the space where the backend can do it without writing data
+    // (fallocate, RAM tier) and otherwise let the file grow naturally as MCU blocks are written
     // Note: tjpgd writes MCU blocks in decode order (top-to-bottom, left-to-right),
     // so the file will grow sequentially, making this approach safe
+    rgb_flash_file->reserve((size_t)width * height * 3);
     
     // CRITICAL: After jd_prepare, the file position is at the start of image data (after SOS marker)
     // jd_decomp will continue reading from this position via the input function
@@ -483,11 +453,10 @@ int convertJpegToSeparateChannels(
     
     // Decompress JPEG - this will call jpeg_output_func for each MCU block
     // RGB data is written directly to flash, no full buffer in RAM!
-    Serial.println("  Step 2: Decompressing JPEG to RGB (this may take a while)...");
+    ICER_LOG_INFO("  Step 2: Decompressing JPEG to RGB (this may take a while)...");
     jres = jd_decomp(&jdec, jpeg_output_func, 0);  // scale = 0 means no scaling
     if (jres != JDR_OK) {
-        Serial.print("  ERROR: JPEG decompress failed with code ");
-        Serial.println((int)jres);
+        ICER_LOG_ERROR("  ERROR: JPEG decompress failed with code %d", (int)jres);
         free(work_buf);
         jpeg_file->close();
         delete jpeg_file;
@@ -499,9 +468,7 @@ int convertJpegToSeparateChannels(
         filesystem->remove(temp_rgb_file);
         return -11;  // JPEG decompress failed
     }
-    Serial.print("  Step 2 complete: Processed ");
-    Serial.print(stream_decode_ctx.mcu_blocks_processed);
-    Serial.println(" MCU blocks");
+    ICER_LOG_DEBUG("  Step 2 complete: Processed %d MCU blocks", stream_decode_ctx.mcu_blocks_processed);
     
     // Flush any remaining data
     rgb_flash_file->flush();
@@ -529,13 +496,13 @@ int convertJpegToSeparateChannels(
     // RGB data is now in temp_rgb_file in flash
 
     // Step 3: Open flash files for Y, U, V channels
-    Serial.println("  Step 3: Opening Y, U, V channel files...");
+    ICER_LOG_DEBUG("  Step 3: Opening Y, U, V channel files...");
     filesystem->remove(y_flash_file);
     filesystem->remove(u_flash_file);
     filesystem->remove(v_flash_file);
 
     // Step 4: Read RGB from flash and convert to YUV scanline-by-scanline
-    Serial.println("  Step 4: Converting RGB to YUV (this may take a while)...");
+    ICER_LOG_INFO("  Step 4: Converting RGB to YUV (this may take a while)...");
     // All operations now use flash - minimal RAM usage
     // Memory: RGB scanline (width * 3) + Y scanline (width * 2) + U scanline (width * 2) + V scanline (width * 2)
     // For 720p: (1280 * 3) + (1280 * 2) + (1280 * 2) + (1280 * 2) = 3,840 + 2,560 + 2,560 + 2,560 = 11,520 bytes ≈ 11.25 KB
@@ -544,6 +511,10 @@ int convertJpegToSeparateChannels(
     // CRITICAL REWRITE: Open all files at function scope, then destroy them one at a time
     // in separate scopes. The hard fault occurs when File destructors run during function return,
     // so we need to ensure they run one at a time in isolated scopes BEFORE the function returns.
+    size_t channel_size = (size_t)width * height * sizeof(uint16_t);
+    filesystem->setSizeHint(y_flash_file, channel_size);
+    filesystem->setSizeHint(u_flash_file, channel_size);
+    filesystem->setSizeHint(v_flash_file, channel_size);
     IFile* y_file = filesystem->open(y_flash_file, FILE_WRITE);
     IFile* u_file = filesystem->open(u_flash_file, FILE_WRITE);
     IFile* v_file = filesystem->open(v_flash_file, FILE_WRITE);
@@ -562,6 +533,10 @@ int convertJpegToSeparateChannels(
             return -12;
         }
     }  // End of check scope
+    // Reserve the full channel size where the backend supports it (best effort)
+    y_file->reserve(channel_size);
+    u_file->reserve(channel_size);
+    v_file->reserve(channel_size);
     
     // Open RGB read file in its own scope
     IFile* rgb_read_file = nullptr;
@@ -604,20 +579,8 @@ int convertJpegToSeparateChannels(
 
         // Process RGB from flash, convert to YUV, write to flash
         // All operations use flash - peak RAM is only scanline buffers
-        unsigned long rgb_convert_start_time = millis();
         for (int row = 0; row < height; row++) {
-            // Report progress every 50 rows or every 2 seconds
-            if (row % 50 == 0 || (millis() - rgb_convert_start_time) > 2000) {
-                int progress_percent = (int)((row * 100) / height);
-                Serial.print("  RGB->YUV progress: ");
-                Serial.print(progress_percent);
-                Serial.print("% (row ");
-                Serial.print(row);
-                Serial.print(" of ");
-                Serial.print(height);
-                Serial.println(")");
-                rgb_convert_start_time = millis();  // Reset timer
-            }
+            icerReportProgress(ICER_PHASE_INGEST, (size_t)row, (size_t)height);
             // Read RGB scanline from flash
             size_t rgb_scanline_bytes = (size_t)width * 3;
             size_t rgb_read = rgb_read_file->read(rgb_scanline, rgb_scanline_bytes);
@@ -712,19 +675,88 @@ int convertJpegToSeparateChannels(
     // This gives the file system time to finish all pending operations
     delay(500);
     
-    Serial.println("  Step 4 complete: RGB to YUV conversion finished");
+    ICER_LOG_INFO("  Step 4 complete: RGB to YUV conversion finished");
     
     // CRITICAL: Final delay before return to ensure all File destructors
     // can run safely. The destructors will be called when the function returns,
     // but since files are already closed, they should be no-ops.
     delay(300);
     
-    // All IFile objects are now deleted
-    // Do NOT remove temp_rgb_file here - it will be removed by the caller
+    // All IFile objects are now closed and deleted, so the RGB file can go
+    filesystem->remove(temp_rgb_file);
 
     return 0;
 }
 
+// Convert separate Y, U, V channel files to one RGB888 file
+// One row of each channel and one RGB row in RAM
+int convertSeparateChannelsToRgb888(
+    const char* y_flash_file,
+    const char* u_flash_file,
+    const char* v_flash_file,
+    size_t width,
+    size_t height,
+    const char* rgb_flash_file,
+    IFileSystem* filesystem) {
+
+    if (!filesystem || !y_flash_file || !u_flash_file || !v_flash_file || !rgb_flash_file ||
+        width == 0 || height == 0) {
+        return -1;
+    }
+
+    IFile* y_file = filesystem->open(y_flash_file, FILE_READ);
+    IFile* u_file = filesystem->open(u_flash_file, FILE_READ);
+    IFile* v_file = filesystem->open(v_flash_file, FILE_READ);
+    filesystem->remove(rgb_flash_file);
+    filesystem->setSizeHint(rgb_flash_file, width * height * 3);
+    IFile* rgb_file = filesystem->open(rgb_flash_file, FILE_WRITE);
+    if (!y_file || !u_file || !v_file || !rgb_file) {
+        if (y_file) { y_file->close(); delete y_file; }
+        if (u_file) { u_file->close(); delete u_file; }
+        if (v_file) { v_file->close(); delete v_file; }
+        if (rgb_file) { rgb_file->close(); delete rgb_file; }
+        filesystem->remove(rgb_flash_file);
+        return -2;
+    }
+    rgb_file->reserve(width * height * 3);  // Best effort, see IFile::reserve()
+
+    size_t scanline_bytes = width * sizeof(uint16_t);
+    uint16_t* y_scanline = (uint16_t*)malloc(scanline_bytes);
+    uint16_t* u_scanline = (uint16_t*)malloc(scanline_bytes);
+    uint16_t* v_scanline = (uint16_t*)malloc(scanline_bytes);
+    uint8_t* rgb_scanline = (uint8_t*)malloc(width * 3);
+
+    int result = 0;
+    if (!y_scanline || !u_scanline || !v_scanline || !rgb_scanline) {
+        result = -3;
+    }
+    for (size_t row = 0; row < height && result == 0; row++) {
+        if (y_file->read((uint8_t*)y_scanline, scanline_bytes) != scanline_bytes ||
+            u_file->read((uint8_t*)u_scanline, scanline_bytes) != scanline_bytes ||
+            v_file->read((uint8_t*)v_scanline, scanline_bytes) != scanline_bytes) {
+            result = -4;
+            break;
+        }
+        yuvToRgb888(y_scanline, u_scanline, v_scanline, width, rgb_scanline);
+        if (rgb_file->write(rgb_scanline, width * 3) != width * 3) {
+            result = -5;
+        }
+    }
+
+    free(y_scanline);
+    free(u_scanline);
+    free(v_scanline);
+    free(rgb_scanline);
+    y_file->close(); delete y_file;
+    u_file->close(); delete u_file;
+    v_file->close(); delete v_file;
+    rgb_file->close(); delete rgb_file;
+    if (result != 0) {
+        filesystem->remove(rgb_flash_file);
+    }
+    return result;
+}
+
 // Backward compatibility wrappers that accept SDClass*
 // These create a temporary IFileSystem wrapper and call the interface-based functions
 int convertYuv422ToSeparateChannels(
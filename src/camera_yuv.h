@@ -35,6 +35,59 @@ int convertJpegToSeparateChannels(
     IFileSystem* filesystem
 );
 
+// Convert RGB to YUV using ITU-R BT.601 standard formulas
+// Y = 0.299*R + 0.587*G + 0.114*B
+// U (Cb) = -0.168736*R - 0.331264*G + 0.5*B + 128
+// V (Cr) = 0.5*R - 0.418688*G - 0.081312*B + 128
+// Using integer arithmetic: multiply coefficients by 1000000, then divide by 1000000 for maximum accuracy
+// Output: Y, U, V values in range [0, 255] stored as uint16_t (compatible with ICER)
+static inline void rgb_to_yuv(uint8_t r, uint8_t g, uint8_t b, uint16_t* y, uint16_t* u, uint16_t* v) {
+    // Y calculation: 0.299*R + 0.587*G + 0.114*B
+    // Exact: (299000*R + 587000*G + 114000*B) / 1000000
+    int32_t y_val = (299000L * (int32_t)r + 587000L * (int32_t)g + 114000L * (int32_t)b) / 1000000L;
+    *y = (uint16_t)(y_val < 0 ? 0 : (y_val > 255 ? 255 : y_val));
+    
+    // U (Cb) calculation: -0.168736*R - 0.331264*G + 0.5*B + 128
+    // Exact: (-168736*R - 331264*G + 500000*B) / 1000000 + 128
+    int32_t u_val = (-168736L * (int32_t)r - 331264L * (int32_t)g + 500000L * (int32_t)b) / 1000000L + 128;
+    *u = (uint16_t)(u_val < 0 ? 0 : (u_val > 255 ? 255 : u_val));
+    
+    // V (Cr) calculation: 0.5*R - 0.418688*G - 0.081312*B + 128
+    // Exact: (500000*R - 418688*G - 81312*B) / 1000000 + 128
+    int32_t v_val = (500000L * (int32_t)r - 418688L * (int32_t)g - 81312L * (int32_t)b) / 1000000L + 128;
+    *v = (uint16_t)(v_val < 0 ? 0 : (v_val > 255 ? 255 : v_val));
+}
+
+// BT.601 full range YUV -> RGB888, the inverse of the conversion in
+// convertJpegToSeparateChannels (fixed point, 16 fractional bits)
+static inline uint8_t clampToUint8(int32_t value) {
+    return (value < 0) ? 0 : (value > 255) ? 255 : (uint8_t)value;
+}
+
+static inline void yuvToRgb888(const uint16_t* y, const uint16_t* u, const uint16_t* v, size_t pixels, uint8_t* rgb) {
+    for (size_t i = 0; i < pixels; i++) {
+        int32_t luma = (int32_t)y[i] << 16;
+        int32_t cb = (int32_t)u[i] - 128;
+        int32_t cr = (int32_t)v[i] - 128;
+        rgb[3 * i + 0] = clampToUint8((luma + 91881 * cr + 32768) >> 16);              // 1.402
+        rgb[3 * i + 1] = clampToUint8((luma - 22554 * cb - 46802 * cr + 32768) >> 16);  // 0.344136, 0.714136
+        rgb[3 * i + 2] = clampToUint8((luma + 116130 * cb + 32768) >> 16);              // 1.772
+    }
+}
+
+// Convert separate Y, U, V channel files (e.g. from decompressYuvWithIcerFlash)
+// to one RGB888 file, row by row
+// Uses IFileSystem interface for file operations
+int convertSeparateChannelsToRgb888(
+    const char* y_flash_file,
+    const char* u_flash_file,
+    const char* v_flash_file,
+    size_t width,
+    size_t height,
+    const char* rgb_flash_file,
+    IFileSystem* filesystem
+);
+
 // Backward compatibility: Wrapper functions that accept SDClass*
 // These create a temporary IFileSystem wrapper and call the main functions
 // For new code, prefer using IFileSystem* directly
@@ -0,0 +1,56 @@
+#include "filesystem_interface.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Default implementation of IFileSystem::createPreallocated()
+// Backends that can allocate space natively implement IFile::reserve() (or
+// override this method); everything else gets the file zero-filled here.
+IFile* IFileSystem::createPreallocated(const char* filename, size_t size) {
+    if (!filename) {
+        return NULL;
+    }
+    remove(filename);
+    IFile* file = open(filename, FILE_WRITE);
+    if (!file) {
+        return NULL;
+    }
+
+    if (size > 0 && !file->reserve(size)) {
+        // No native reservation: write zeros in chunks
+        size_t written = 0;
+        size_t chunk_size = 4096;  // 4 KB chunks
+        uint8_t* zero_chunk = (uint8_t*)malloc(chunk_size);
+        uint8_t small_chunk[64];
+        if (!zero_chunk) {
+            // Fallback: small stack buffer (slower, but needs no heap)
+            zero_chunk = small_chunk;
+            chunk_size = sizeof(small_chunk);
+        }
+        memset(zero_chunk, 0, chunk_size);
+        while (written < size) {
+            size_t to_write = (size - written > chunk_size) ? chunk_size : size - written;
+            size_t n = file->write(zero_chunk, to_write);
+            if (n != to_write) {
+                break;
+            }
+            written += n;
+        }
+        if (zero_chunk != small_chunk) {
+            free(zero_chunk);
+        }
+        if (written != size) {
+            file->close();
+            delete file;
+            remove(filename);
+            return NULL;
+        }
+    }
+
+    if (!file->seek(0)) {
+        file->close();
+        delete file;
+        remove(filename);
+        return NULL;
+    }
+    return file;
+}
@@ -3,30 +3,25 @@
 #include "flash_partition.h"
 #include "icer_compression.h"
 #include "memory_monitor.h"
+#include "memory_arena.h"
+#include "memory_planner.h"
 #include "filesystem_interface.h"
 #include "spresence_sd_filesystem.h"
+#include "io_stats_filesystem.h"
+#include "icer_telemetry.h"
+#include "icer_log.h"
 #include <SDHCI.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
 #include <limits.h>
 #include <stdio.h>
-#include <Arduino.h>  // For Serial progress reporting
+#include <Arduino.h>
 
 extern "C" {
 #include "icer.h"
 }
 
-// Packet comparison function (same as in icer_color.c)
-static inline int comp_packet(const void *a, const void *b) {
-    if (((icer_packet_context *)a)->priority == ((icer_packet_context *)b)->priority) {
-        // prioritize based on subband type given same priority
-        return (((icer_packet_context *)a)->subband_type > ((icer_packet_context *)b)->subband_type) ? 1 :
-               (((icer_packet_context *)a)->subband_type < ((icer_packet_context *)b)->subband_type) ? -1 : 0;
-    }
-    return (((icer_packet_context *)a)->priority > ((icer_packet_context *)b)->priority) ? -1 : 1;
-}
-
 // Flash write callback implementation (same as in icer_compression.cpp)
 static size_t icer_flash_write_callback_impl(void* context, const void* data, size_t size) {
     IFile* flash_file = static_cast<IFile*>(context);
@@ -37,46 +32,9 @@ static size_t icer_flash_write_callback_impl(void* context, const void* data, si
     return written;
 }
 
-// GNSS RAM allocation wrappers (consistent with icer_compression.cpp)
-#ifdef __arm__
-#include <arch/chip/gnssram.h>
-static bool gnss_ram_available = false;
-
-// Set GNSS RAM availability (called from main.cpp after initialization)
-// This must be called separately for flash_icer_compression.cpp
-// Note: This is separate from icer_compression.cpp's setGnssRamAvailable
-// because they are in different compilation units with separate static variables
-void setGnssRamAvailable_flash(bool available) {
-    gnss_ram_available = available;
-}
-
-static void* gnss_malloc(size_t size) {
-    if (gnss_ram_available) {
-        void* ptr = up_gnssram_malloc(size);
-        if (ptr) return ptr;
-        // Fallback to main RAM if GNSS RAM allocation fails
-    }
-    return malloc(size);
-}
-
-static void gnss_free(void* ptr) {
-    if (ptr) {
-        if (gnss_ram_available) {
-            up_gnssram_free(ptr);
-        } else {
-            free(ptr);
-        }
-    }
-}
-#else
-#define gnss_malloc malloc
-#define gnss_free free
-void setGnssRamAvailable_flash(bool available) { (void)available; } // No-op for non-ARM
-#endif
-
 // Flash-based ICER compression for large images (e.g., 720p)
 // Complete pipeline with minimal RAM usage, maintaining 100% ICER compatibility
-IcerCompressionResult compressYuvWithIcerFlash(
+static IcerCompressionResult compressYuvWithIcerFlashImpl(
     IFileSystem* filesystem,
     const char* y_flash_file,
     const char* u_flash_file,
@@ -90,39 +48,42 @@ IcerCompressionResult compressYuvWithIcerFlash(
     const char* output_flash_file,
     bool channels_pre_transformed) {
     
-    IcerCompressionResult result = {NULL, 0, false, 0, NULL};
+    IcerCompressionResult result = {NULL, 0, false, 0, NULL, NULL, NULL};
     
-    Serial.println("  ICER Flash Compression: Starting...");
+    ICER_LOG_INFO("  ICER Flash Compression: Starting...");
     
     if (!filesystem || !y_flash_file || !u_flash_file || !v_flash_file || !output_flash_file) {
-        Serial.println("  ICER Flash Compression: ERROR - Invalid parameters");
+        ICER_LOG_ERROR("  ICER Flash Compression: ERROR - Invalid parameters");
         result.error_code = -200;
         return result;
     }
-    
+
+    // Same limit as icer_wavelet_transform_stages_uint16: the smallest LL subband
+    // must be at least 3x3
+    if (!channels_pre_transformed &&
+        (icer_get_dim_n_low_stages(width, stages) < 3 || icer_get_dim_n_low_stages(height, stages) < 3)) {
+        ICER_LOG_ERROR("  ICER Flash Compression: ERROR - Too many stages for the image size");
+        result.error_code = ICER_TOO_MANY_STAGES;
+        return result;
+    }
+
     // Allocate ICER buffers (in GNSS RAM if available)
-    Serial.println("  ICER Flash Compression: Allocating buffers...");
+    ICER_LOG_INFO("  ICER Flash Compression: Allocating buffers...");
     int alloc_result = allocateIcerBuffers();
     if (alloc_result != 0) {
-        Serial.print("  ICER Flash Compression: ERROR - Buffer allocation failed: ");
-        Serial.println(alloc_result);
+        ICER_LOG_ERROR("  ICER Flash Compression: ERROR - Buffer allocation failed: %d", alloc_result);
         result.error_code = -120 - alloc_result;
         return result;
     }
     
-    // Initialize ICER
-    Serial.println("  ICER Flash Compression: Initializing ICER...");
-    static bool icer_initialized = false;
-    if (!icer_initialized) {
-        int init_result = icer_init();
-        if (init_result != 0) {
-            Serial.print("  ICER Flash Compression: ERROR - ICER init failed: ");
-            Serial.println(init_result);
-            freeIcerBuffers();
-            result.error_code = init_result;
-            return result;
-        }
-        icer_initialized = true;
+    // Size the remaining buffers from the memory left after the ICER buffers
+    MemoryBudget budget;
+    getMemoryBudget(&budget);
+    BufferPlan plan;
+    if (planBuffers(width, height, segments, target_size, &budget, &plan) == 0) {
+        setBufferPlan(&plan);
+        icerLogFlush();  // Keep the log in order with the report
+        printBufferPlan(&plan);
     }
     
     // Temporary files for transformed channels
@@ -132,30 +93,29 @@ IcerCompressionResult compressYuvWithIcerFlash(
     
     // Step 1: Apply wavelet transform to each channel (if not pre-transformed)
     if (!channels_pre_transformed) {
-        Serial.println("  ICER Flash Compression: Step 1 - Wavelet transform...");
+        ICER_LOG_INFO("  ICER Flash Compression: Step 1 - Wavelet transform...");
+        icerTelemetryPhase(ICER_PHASE_WAVELET);
         // Transform Y channel
-        Serial.println("    Transforming Y channel...");
+        ICER_LOG_DEBUG("    Transforming Y channel...");
         int transform_result = streamingWaveletTransform(
             filesystem, y_flash_file, y_transformed_file,
             width, height, stages, filter_type
         );
         if (transform_result != 0) {
-            Serial.print("    ERROR: Y channel transform failed: ");
-            Serial.println(transform_result);
+            ICER_LOG_ERROR("    ERROR: Y channel transform failed: %d", transform_result);
             freeIcerBuffers();
             result.error_code = -201 - transform_result;
             return result;
         }
         
         // Transform U channel
-        Serial.println("    Transforming U channel...");
+        ICER_LOG_DEBUG("    Transforming U channel...");
         transform_result = streamingWaveletTransform(
             filesystem, u_flash_file, u_transformed_file,
             width, height, stages, filter_type
         );
         if (transform_result != 0) {
-            Serial.print("    ERROR: U channel transform failed: ");
-            Serial.println(transform_result);
+            ICER_LOG_ERROR("    ERROR: U channel transform failed: %d", transform_result);
             freeIcerBuffers();
             filesystem->remove(y_transformed_file);
             result.error_code = -201 - transform_result;
@@ -163,38 +123,39 @@ IcerCompressionResult compressYuvWithIcerFlash(
         }
         
         // Transform V channel
-        Serial.println("    Transforming V channel...");
+        ICER_LOG_DEBUG("    Transforming V channel...");
         transform_result = streamingWaveletTransform(
             filesystem, v_flash_file, v_transformed_file,
             width, height, stages, filter_type
         );
         if (transform_result != 0) {
-            Serial.print("    ERROR: V channel transform failed: ");
-            Serial.println(transform_result);
+            ICER_LOG_ERROR("    ERROR: V channel transform failed: %d", transform_result);
             freeIcerBuffers();
             filesystem->remove(y_transformed_file);
             filesystem->remove(u_transformed_file);
             result.error_code = -201 - transform_result;
             return result;
         }
-        Serial.println("  Step 1 complete: Wavelet transform finished");
+        ICER_LOG_INFO("  Step 1 complete: Wavelet transform finished");
     } else {
         // Channels are already transformed, use input files directly
-        Serial.println("  ICER Flash Compression: Channels pre-transformed, skipping Step 1");
+        ICER_LOG_INFO("  ICER Flash Compression: Channels pre-transformed, skipping Step 1");
         y_transformed_file = y_flash_file;
         u_transformed_file = u_flash_file;
         v_transformed_file = v_flash_file;
     }
     
     // Step 2: Calculate LL mean values (needed for ICER)
-    Serial.println("  ICER Flash Compression: Step 2 - Calculating LL mean values...");
+    ICER_LOG_INFO("  ICER Flash Compression: Step 2 - Calculating LL mean values...");
+    icerTelemetryPhase(ICER_PHASE_LL_MEAN);
+    ioStatsSetPhase(IO_PHASE_SIGN_MAG);
     // We need to read the LL subband from the transformed image
     size_t ll_w = icer_get_dim_n_low_stages(width, stages);
     size_t ll_h = icer_get_dim_n_low_stages(height, stages);
     
     // Allocate buffer for LL subband (small, fits in RAM)
     size_t ll_size = ll_w * ll_h * sizeof(uint16_t);
-    uint16_t* ll_buffer = (uint16_t*)malloc(ll_size);
+    uint16_t* ll_buffer = (uint16_t*)poolAlloc(ll_size, MEM_POOL_MAIN);
     if (!ll_buffer) {
             freeIcerBuffers();
             if (!channels_pre_transformed) {
@@ -210,17 +171,17 @@ IcerCompressionResult compressYuvWithIcerFlash(
     
     // Read LL subband and calculate mean for each channel
     for (int chan = ICER_CHANNEL_MIN; chan <= ICER_CHANNEL_MAX; chan++) {
+#if ICER_LOG_LEVEL >= ICER_LOG_LEVEL_DEBUG
         const char* channel_name = (chan == ICER_CHANNEL_Y) ? "Y" : (chan == ICER_CHANNEL_U) ? "U" : "V";
-        Serial.print("    Calculating LL mean for channel ");
-        Serial.print(channel_name);
-        Serial.println("...");
+#endif
+        ICER_LOG_DEBUG("    Calculating LL mean for channel %s...", channel_name);
         
         const char* channel_file = (chan == ICER_CHANNEL_Y) ? y_transformed_file :
                                    (chan == ICER_CHANNEL_U) ? u_transformed_file : v_transformed_file;
         
         IFile* chan_file = filesystem->open(channel_file, FILE_READ);
         if (!chan_file) {
-            free(ll_buffer);
+            poolFree(ll_buffer);
             freeIcerBuffers();
             if (!channels_pre_transformed) {
                 filesystem->remove(y_transformed_file);
@@ -242,7 +203,7 @@ IcerCompressionResult compressYuvWithIcerFlash(
             if (bytes_read != ll_w * sizeof(uint16_t)) {
                 chan_file->close();
                 delete chan_file;
-                free(ll_buffer);
+                poolFree(ll_buffer);
                 freeIcerBuffers();
                 if (!channels_pre_transformed) {
                     filesystem->remove(y_transformed_file);
@@ -261,13 +222,10 @@ IcerCompressionResult compressYuvWithIcerFlash(
             sum += ll_buffer[i];
         }
         ll_mean[chan] = sum / (ll_w * ll_h);
-        Serial.print("      Channel ");
-        Serial.print(channel_name);
-        Serial.print(" LL mean: ");
-        Serial.println(ll_mean[chan]);
+        ICER_LOG_DEBUG("      Channel %s LL mean: %u", channel_name, ll_mean[chan]);
         
         if (ll_mean[chan] > INT16_MAX) {
-            free(ll_buffer);
+            poolFree(ll_buffer);
             freeIcerBuffers();
             if (!channels_pre_transformed) {
                 filesystem->remove(y_transformed_file);
@@ -279,11 +237,12 @@ IcerCompressionResult compressYuvWithIcerFlash(
         }
     }
     
-    free(ll_buffer);
-    Serial.println("  Step 2 complete: LL mean values calculated");
+    poolFree(ll_buffer);
+    ICER_LOG_INFO("  Step 2 complete: LL mean values calculated");
     
     // Step 2.5: Subtract LL mean from LL subband and convert to sign-magnitude
-    Serial.println("  ICER Flash Compression: Step 2.5 - Subtracting LL mean and converting to sign-magnitude...");
+    ICER_LOG_INFO("  ICER Flash Compression: Step 2.5 - Subtracting LL mean and converting to sign-magnitude...");
+    icerTelemetryPhase(ICER_PHASE_SIGN_MAG);
     // This must be done before compression
     // We need to:
     // 1. Subtract mean from LL subband (in-place in flash)
@@ -291,10 +250,10 @@ IcerCompressionResult compressYuvWithIcerFlash(
     
     // Process each channel
     for (int chan = ICER_CHANNEL_MIN; chan <= ICER_CHANNEL_MAX; chan++) {
+#if ICER_LOG_LEVEL >= ICER_LOG_LEVEL_DEBUG
         const char* channel_name = (chan == ICER_CHANNEL_Y) ? "Y" : (chan == ICER_CHANNEL_U) ? "U" : "V";
-        Serial.print("    Processing channel ");
-        Serial.print(channel_name);
-        Serial.println("...");
+#endif
+        ICER_LOG_DEBUG("    Processing channel %s...", channel_name);
         
         const char* channel_file = (chan == ICER_CHANNEL_Y) ? y_transformed_file :
                                    (chan == ICER_CHANNEL_U) ? u_transformed_file : v_transformed_file;
@@ -321,7 +280,7 @@ IcerCompressionResult compressYuvWithIcerFlash(
         
         // Subtract mean from LL subband (read, modify, write back)
         size_t ll_buffer_size = ll_w * ll_h * sizeof(uint16_t);
-        uint16_t* ll_buffer = (uint16_t*)malloc(ll_buffer_size);
+        uint16_t* ll_buffer = (uint16_t*)poolAlloc(ll_buffer_size, MEM_POOL_MAIN);
         if (!ll_buffer) {
             chan_file->close();
             delete chan_file;
@@ -342,7 +301,7 @@ IcerCompressionResult compressYuvWithIcerFlash(
             size_t bytes_read = chan_file->read((uint8_t*)ll_buffer + row * ll_w * sizeof(uint16_t),
                                                ll_w * sizeof(uint16_t));
             if (bytes_read != ll_w * sizeof(uint16_t)) {
-                free(ll_buffer);
+                poolFree(ll_buffer);
                 chan_file->close();
                 delete chan_file;
                 freeIcerBuffers();
@@ -367,7 +326,7 @@ IcerCompressionResult compressYuvWithIcerFlash(
         // Write LL subband back
         IFile* chan_file_write_ll = filesystem->open(channel_file, FILE_WRITE);
         if (!chan_file_write_ll) {
-            free(ll_buffer);
+            poolFree(ll_buffer);
             freeIcerBuffers();
             if (!channels_pre_transformed) {
                 filesystem->remove(y_transformed_file);
@@ -386,7 +345,7 @@ IcerCompressionResult compressYuvWithIcerFlash(
                 ll_w * sizeof(uint16_t)
             );
             if (bytes_written != ll_w * sizeof(uint16_t)) {
-                free(ll_buffer);
+                poolFree(ll_buffer);
                 chan_file_write_ll->close();
                 delete chan_file_write_ll;
                 freeIcerBuffers();
@@ -401,7 +360,7 @@ IcerCompressionResult compressYuvWithIcerFlash(
         }
         chan_file_write_ll->close();
         delete chan_file_write_ll;
-        free(ll_buffer);
+        poolFree(ll_buffer);
         
         // Convert entire image to sign-magnitude format
         // We need to do this in-place in flash
@@ -409,6 +368,7 @@ IcerCompressionResult compressYuvWithIcerFlash(
         // Use a temporary file approach: read from original, convert, write to temp, then replace
         const char* temp_convert_file = "_temp_convert.tmp";
         filesystem->remove(temp_convert_file);
+        filesystem->setSizeHint(temp_convert_file, width * height * sizeof(uint16_t));
         
         IFile* chan_file_read = filesystem->open(channel_file, FILE_READ);
         IFile* chan_file_write = filesystem->open(temp_convert_file, FILE_WRITE);
@@ -426,9 +386,10 @@ IcerCompressionResult compressYuvWithIcerFlash(
             result.error_code = -207;
             return result;
         }
+        chan_file_write->reserve(width * height * sizeof(uint16_t));  // Best effort, see IFile::reserve()
         
         size_t row_size = width * sizeof(uint16_t);
-        uint16_t* row_buffer = (uint16_t*)malloc(row_size);
+        uint16_t* row_buffer = (uint16_t*)poolAlloc(row_size, MEM_POOL_MAIN);
         if (!row_buffer) {
             chan_file_read->close();
             delete chan_file_read;
@@ -446,24 +407,12 @@ IcerCompressionResult compressYuvWithIcerFlash(
         }
         
         // Read, convert, write row-by-row
-        unsigned long convert_start_time = millis();
         for (size_t row = 0; row < height; row++) {
-            // Report progress every 50 rows or every 2 seconds
-            if (row % 50 == 0 || (millis() - convert_start_time) > 2000) {
-                int progress_percent = (int)((row * 100) / height);
-                Serial.print("      Sign-magnitude conversion: ");
-                Serial.print(progress_percent);
-                Serial.print("% (row ");
-                Serial.print(row);
-                Serial.print(" of ");
-                Serial.print(height);
-                Serial.println(")");
-                convert_start_time = millis();
-            }
+            icerReportProgress(ICER_PHASE_SIGN_MAG, row, height);
             
             size_t bytes_read = chan_file_read->read((uint8_t*)row_buffer, row_size);
             if (bytes_read != row_size) {
-                free(row_buffer);
+                poolFree(row_buffer);
                 chan_file_read->close();
                 delete chan_file_read;
                 chan_file_write->close();
@@ -485,7 +434,7 @@ IcerCompressionResult compressYuvWithIcerFlash(
             // Write converted row to temp file
             size_t bytes_written = chan_file_write->write((uint8_t*)row_buffer, row_size);
             if (bytes_written != row_size) {
-                free(row_buffer);
+                poolFree(row_buffer);
                 chan_file_read->close();
                 delete chan_file_read;
                 chan_file_write->close();
@@ -502,7 +451,7 @@ IcerCompressionResult compressYuvWithIcerFlash(
             }
         }
         
-        free(row_buffer);
+        poolFree(row_buffer);
         chan_file_read->close();
         delete chan_file_read;
         chan_file_write->close();
@@ -511,6 +460,7 @@ IcerCompressionResult compressYuvWithIcerFlash(
         // Replace original file with converted file
         // Copy temp file back to original location (SD card doesn't support rename)
         filesystem->remove(channel_file);
+        filesystem->setSizeHint(channel_file, width * height * sizeof(uint16_t));
         IFile* temp_read = filesystem->open(temp_convert_file, FILE_READ);
         IFile* orig_write = filesystem->open(channel_file, FILE_WRITE);
         if (!temp_read || !orig_write) {
@@ -526,11 +476,12 @@ IcerCompressionResult compressYuvWithIcerFlash(
             result.error_code = -211;
             return result;
         }
+        orig_write->reserve(width * height * sizeof(uint16_t));  // Best effort, see IFile::reserve()
         
         // Copy temp file back to original
         size_t total_size = width * height * sizeof(uint16_t);
-        size_t copy_buffer_size = 4096;  // 4 KB chunks
-        uint8_t* copy_buffer = (uint8_t*)malloc(copy_buffer_size);
+        size_t copy_buffer_size = currentBufferPlan()->copy_buffer_bytes;
+        uint8_t* copy_buffer = (uint8_t*)poolAlloc(copy_buffer_size, MEM_POOL_MAIN);
         if (!copy_buffer) {
             temp_read->close();
             delete temp_read;
@@ -552,7 +503,7 @@ IcerCompressionResult compressYuvWithIcerFlash(
             size_t to_read = (remaining > copy_buffer_size) ? copy_buffer_size : remaining;
             size_t bytes_read = temp_read->read(copy_buffer, to_read);
             if (bytes_read != to_read) {
-                free(copy_buffer);
+                poolFree(copy_buffer);
                 temp_read->close();
                 delete temp_read;
                 orig_write->close();
@@ -569,7 +520,7 @@ IcerCompressionResult compressYuvWithIcerFlash(
             }
             size_t bytes_written = orig_write->write(copy_buffer, bytes_read);
             if (bytes_written != bytes_read) {
-                free(copy_buffer);
+                poolFree(copy_buffer);
                 temp_read->close();
                 delete temp_read;
                 orig_write->close();
@@ -587,17 +538,18 @@ IcerCompressionResult compressYuvWithIcerFlash(
             remaining -= bytes_read;
         }
         
-        free(copy_buffer);
+        poolFree(copy_buffer);
         temp_read->close();
         delete temp_read;
         orig_write->close();
         delete orig_write;
         filesystem->remove(temp_convert_file);
     }
-    Serial.println("  Step 2.5 complete: LL mean subtraction and sign-magnitude conversion finished");
+    ICER_LOG_INFO("  Step 2.5 complete: LL mean subtraction and sign-magnitude conversion finished");
     
     // Step 3: Prepare ICER output structure
-    Serial.println("  ICER Flash Compression: Step 3 - Preparing ICER output structure...");
+    ICER_LOG_INFO("  ICER Flash Compression: Step 3 - Preparing ICER output structure...");
+    icerTelemetryPhase(ICER_PHASE_PARTITION);
     size_t pixel_count = width * height;
     size_t byte_quota = target_size;
     if (byte_quota == 0) {
@@ -632,30 +584,28 @@ IcerCompressionResult compressYuvWithIcerFlash(
     // but within memory constraints.
     //
     // SOLUTION: Use a large buffer (512 KB - 1 MB) and hope it's sufficient.
-    // If not, compression will fail with BYTE_QUOTA_EXCEEDED, which is better than
-    // allocation failure. For very large images, lossless compression may not be feasible.
+    // If not, the packets that do not fit are dropped (lowest priority first), which is
+    // better than allocation failure. For very large images, lossless compression may not be feasible.
     //
     // CRITICAL: icer_init_output_struct requires byte_quota <= buf_len for flash streaming.
     // We use effective_byte_quota = min(byte_quota, buffer_size) to pass this check.
     // size_allocated is set to effective_byte_quota, which limits how much can be stored.
-    const size_t MAX_DATASTREAM_BUFFER_SIZE = 400 * 1024;  // 400 KB - increased to handle full compression (matches target_size)
-    size_t buffer_size = MAX_DATASTREAM_BUFFER_SIZE;
-    
-    // If byte_quota is smaller than our buffer, use byte_quota + safety margin
-    // Otherwise, cap at MAX_DATASTREAM_BUFFER_SIZE
-    if (byte_quota < MAX_DATASTREAM_BUFFER_SIZE - 512) {
+    //
+    // The buffer plan sizes the datastream as byte_quota + 512 when memory allows,
+    // otherwise as large as the free memory next to the segment buffer
+    size_t buffer_size = currentBufferPlan()->datastream_bytes;
+    if (byte_quota <= SIZE_MAX - 512 && byte_quota + 512 < buffer_size) {
         buffer_size = byte_quota + 512;
     }
     
     // CRITICAL: For flash streaming with large byte_quota, we need to ensure
     // byte_quota <= buffer_size for icer_init_output_struct check to pass.
     // However, size_allocated limits how much can be stored in the buffer.
-    // If the total compressed size exceeds size_allocated, compression will fail.
-    // This is a fundamental limitation: we cannot compress images that require
-    // more buffer space than available.
+    // If the total compressed size exceeds size_allocated, the output is cut short
+    // there: we cannot store images that require more buffer space than available.
     size_t effective_byte_quota = (byte_quota > buffer_size) ? buffer_size : byte_quota;
     
-    uint8_t* datastream = (uint8_t*)gnss_malloc(buffer_size);
+    uint8_t* datastream = (uint8_t*)poolAlloc(buffer_size, MEM_POOL_GNSS);
     if (!datastream) {
             freeIcerBuffers();
             if (!channels_pre_transformed) {
@@ -675,9 +625,11 @@ IcerCompressionResult compressYuvWithIcerFlash(
     
     // Open output file for rearrange phase (flash streaming)
     filesystem->remove(output_flash_file);
+    // The compressed stream can never exceed the quota, so this is an upper bound
+    filesystem->setSizeHint(output_flash_file, effective_byte_quota);
     IFile* output_file = filesystem->open(output_flash_file, FILE_WRITE);
     if (!output_file) {
-        gnss_free(datastream);
+        poolFree(datastream);
             freeIcerBuffers();
             if (!channels_pre_transformed) {
                 filesystem->remove(y_transformed_file);
@@ -702,7 +654,7 @@ IcerCompressionResult compressYuvWithIcerFlash(
     if (init_result != ICER_RESULT_OK) {
         output_file->close();
         delete output_file;
-        gnss_free(datastream);
+        poolFree(datastream);
             freeIcerBuffers();
             if (!channels_pre_transformed) {
                 filesystem->remove(y_transformed_file);
@@ -717,129 +669,27 @@ IcerCompressionResult compressYuvWithIcerFlash(
     // This replicates the logic from icer_compress_image_yuv_uint16 but uses flash-based partition
     // Note: Sign-magnitude conversion was already done in Step 2.5
     
-    // Create packet list (same as standard ICER)
-    uint32_t priority = 0;
-    uint32_t ind = 0;
-    for (uint8_t curr_stage = 1; curr_stage <= stages; curr_stage++) {
-        priority = icer_pow_uint(2, curr_stage);
-        for (uint8_t lsb = 0; lsb < ICER_BITPLANES_TO_COMPRESS_16; lsb++) {
-            for (int chan = ICER_CHANNEL_MIN; chan <= ICER_CHANNEL_MAX; chan++) {
-                if (chan == ICER_CHANNEL_Y) priority *= 2;
-                
-                // HL subband
-                icer_packets_16[ind].subband_type = ICER_SUBBAND_HL;
-                icer_packets_16[ind].decomp_level = curr_stage;
-                icer_packets_16[ind].ll_mean_val = ll_mean[chan];
-                icer_packets_16[ind].lsb = lsb;
-                icer_packets_16[ind].priority = priority << lsb;
-                icer_packets_16[ind].image_w = width;
-                icer_packets_16[ind].image_h = height;
-                icer_packets_16[ind].channel = chan;
-                ind++;
-                if (ind >= ICER_MAX_PACKETS_16) {
-                    output_file->close();
-                    delete output_file;
-                    gnss_free(datastream);
-            freeIcerBuffers();
-            if (!channels_pre_transformed) {
-                filesystem->remove(y_transformed_file);
-                filesystem->remove(u_transformed_file);
-                filesystem->remove(v_transformed_file);
-            }
-                    result.error_code = ICER_PACKET_COUNT_EXCEEDED;
-                    return result;
-                }
-                
-                // LH subband
-                icer_packets_16[ind].subband_type = ICER_SUBBAND_LH;
-                icer_packets_16[ind].decomp_level = curr_stage;
-                icer_packets_16[ind].ll_mean_val = ll_mean[chan];
-                icer_packets_16[ind].lsb = lsb;
-                icer_packets_16[ind].priority = priority << lsb;
-                icer_packets_16[ind].image_w = width;
-                icer_packets_16[ind].image_h = height;
-                icer_packets_16[ind].channel = chan;
-                ind++;
-                if (ind >= ICER_MAX_PACKETS_16) {
-                    output_file->close();
-                    delete output_file;
-                    gnss_free(datastream);
-            freeIcerBuffers();
-            if (!channels_pre_transformed) {
-                filesystem->remove(y_transformed_file);
-                filesystem->remove(u_transformed_file);
-                filesystem->remove(v_transformed_file);
-            }
-                    result.error_code = ICER_PACKET_COUNT_EXCEEDED;
-                    return result;
-                }
-                
-                // HH subband
-                icer_packets_16[ind].subband_type = ICER_SUBBAND_HH;
-                icer_packets_16[ind].decomp_level = curr_stage;
-                icer_packets_16[ind].ll_mean_val = ll_mean[chan];
-                icer_packets_16[ind].lsb = lsb;
-                icer_packets_16[ind].priority = ((priority / 2) << lsb) + 1;
-                icer_packets_16[ind].image_w = width;
-                icer_packets_16[ind].image_h = height;
-            icer_packets_16[ind].channel = chan;
-            ind++;
-            if (ind >= ICER_MAX_PACKETS_16) {
-                    output_file->close();
-                    delete output_file;
-                    gnss_free(datastream);
-            freeIcerBuffers();
-            if (!channels_pre_transformed) {
-                filesystem->remove(y_transformed_file);
-                filesystem->remove(u_transformed_file);
-                filesystem->remove(v_transformed_file);
-            }
-                    result.error_code = ICER_PACKET_COUNT_EXCEEDED;
-                    return result;
-                }
-            }
+    // Create the packet list, sorted by priority (same as standard ICER)
+    size_t ind = 0;
+    int packet_res = icer_build_packet_list_uint16(icer_packets_16, ICER_MAX_PACKETS_16, width, height, stages,
+                                                   ll_mean, &ind);
+    if (packet_res != ICER_RESULT_OK) {
+        output_file->close();
+        delete output_file;
+        poolFree(datastream);
+        freeIcerBuffers();
+        if (!channels_pre_transformed) {
+            filesystem->remove(y_transformed_file);
+            filesystem->remove(u_transformed_file);
+            filesystem->remove(v_transformed_file);
         }
+        result.error_code = packet_res;
+        return result;
     }
-    
-    // LL subband (final stage)
-    priority = icer_pow_uint(2, stages);
-    for (uint8_t lsb = 0; lsb < ICER_BITPLANES_TO_COMPRESS_16; lsb++) {
-        for (int chan = ICER_CHANNEL_MIN; chan <= ICER_CHANNEL_MAX; chan++) {
-            if (chan == ICER_CHANNEL_Y) priority *= 2;
-            
-            icer_packets_16[ind].subband_type = ICER_SUBBAND_LL;
-            icer_packets_16[ind].decomp_level = stages;
-            icer_packets_16[ind].ll_mean_val = ll_mean[chan];
-            icer_packets_16[ind].lsb = lsb;
-            icer_packets_16[ind].priority = (2 * priority) << lsb;
-            icer_packets_16[ind].image_w = width;
-            icer_packets_16[ind].image_h = height;
-            icer_packets_16[ind].channel = chan;
-            ind++;
-            if (ind >= ICER_MAX_PACKETS_16) {
-                    output_file->close();
-                    delete output_file;
-                    gnss_free(datastream);
-            freeIcerBuffers();
-            if (!channels_pre_transformed) {
-                filesystem->remove(y_transformed_file);
-                filesystem->remove(u_transformed_file);
-                filesystem->remove(v_transformed_file);
-            }
-                    result.error_code = ICER_PACKET_COUNT_EXCEEDED;
-                    return result;
-                }
-            }
-        }
-    
-    // Sort packets by priority (same as standard ICER)
-    Serial.print("    Sorting ");
-    Serial.print(ind);
-    Serial.println(" packets by priority...");
-    qsort(icer_packets_16, ind, sizeof(icer_packet_context), comp_packet);
+    ICER_LOG_DEBUG("    %zu packets sorted by priority", ind);
     
     // Initialize rearrange segments array
-    Serial.println("    Initializing rearrange segments array...");
+    ICER_LOG_DEBUG("    Initializing rearrange segments array...");
     for (int i = 0; i <= ICER_MAX_DECOMP_STAGES; i++) {
         for (int j = 0; j <= ICER_SUBBAND_MAX; j++) {
             for (int k = 0; k <= ICER_MAX_SEGMENTS; k++) {
@@ -853,25 +703,16 @@ IcerCompressionResult compressYuvWithIcerFlash(
     }
     
     // Process each packet using flash-based partition
-    Serial.println("  ICER Flash Compression: Step 4 - Processing partitions...");
+    ICER_LOG_INFO("  ICER Flash Compression: Step 4 - Processing partitions...");
+    ioStatsSetPhase(IO_PHASE_PARTITION);
     partition_param_typdef partition_params;
     size_t ll_w_sub, ll_h_sub;
     size_t file_offset;
     
-    unsigned long partition_start_time = millis();
-    for (size_t it = 0; it < ind; it++) {
-        // Report progress every 10 packets or every 2 seconds
-        if (it % 10 == 0 || (millis() - partition_start_time) > 2000) {
-            int progress_percent = (int)((it * 100) / ind);
-            Serial.print("    Partition progress: ");
-            Serial.print(progress_percent);
-            Serial.print("% (packet ");
-            Serial.print(it);
-            Serial.print(" of ");
-            Serial.print(ind);
-            Serial.println(")");
-            partition_start_time = millis();
-        }
+    icerTelemetryPackets(ind, 0);
+    size_t it = 0;
+    for (; it < ind; it++) {
+        icerReportProgress(ICER_PHASE_PARTITION, it, ind);
         // Calculate subband dimensions and file offset
         if (icer_packets_16[it].subband_type == ICER_SUBBAND_LL) {
             ll_w_sub = icer_get_dim_n_low_stages(width, icer_packets_16[it].decomp_level);
@@ -891,7 +732,7 @@ IcerCompressionResult compressYuvWithIcerFlash(
             file_offset = (icer_get_dim_n_low_stages(height, icer_packets_16[it].decomp_level) * width +
                           icer_get_dim_n_low_stages(width, icer_packets_16[it].decomp_level)) * sizeof(uint16_t);
         } else {
-            gnss_free(datastream);
+            poolFree(datastream);
             freeIcerBuffers();
             if (!channels_pre_transformed) {
                 filesystem->remove(y_transformed_file);
@@ -911,7 +752,7 @@ IcerCompressionResult compressYuvWithIcerFlash(
         if (!channel_file_handle) {
             output_file->close();
             delete output_file;
-            gnss_free(datastream);
+            poolFree(datastream);
             freeIcerBuffers();
             if (!channels_pre_transformed) {
                 filesystem->remove(y_transformed_file);
@@ -929,7 +770,7 @@ IcerCompressionResult compressYuvWithIcerFlash(
             delete channel_file_handle;
             output_file->close();
             delete output_file;
-            gnss_free(datastream);
+            poolFree(datastream);
             freeIcerBuffers();
             if (!channels_pre_transformed) {
                 filesystem->remove(y_transformed_file);
@@ -954,10 +795,16 @@ IcerCompressionResult compressYuvWithIcerFlash(
         channel_file_handle->close();
         delete channel_file_handle;
         
+        if (res == ICER_BYTE_QUOTA_EXCEEDED) {
+            // Byte quota reached: as in icer_compress_image_yuv_uint16, the packets
+            // encoded so far (highest priority first) are written out and the rest dropped
+            ICER_LOG_INFO("    Byte quota reached after %zu of %zu packets", it, ind);
+            break;
+        }
         if (res != ICER_RESULT_OK) {
             output_file->close();
             delete output_file;
-            gnss_free(datastream);
+            poolFree(datastream);
             freeIcerBuffers();
             if (!channels_pre_transformed) {
                 filesystem->remove(y_transformed_file);
@@ -968,10 +815,13 @@ IcerCompressionResult compressYuvWithIcerFlash(
             return result;
         }
     }
-    Serial.println("  Step 4 complete: All partitions processed");
+    icerTelemetryPackets(ind, it);
+    ICER_LOG_INFO("  Step 4 complete: All partitions processed");
     
     // Step 5: Rearrange segments (same as standard ICER)
-    Serial.println("  ICER Flash Compression: Step 5 - Rearranging segments...");
+    ICER_LOG_INFO("  ICER Flash Compression: Step 5 - Rearranging segments...");
+    icerTelemetryPhase(ICER_PHASE_REARRANGE);
+    ioStatsSetPhase(IO_PHASE_REARRANGE);
     // This must happen AFTER all partitions are processed
     // The rearrange phase writes all segments in the correct order to the output file
     // This is critical for correct ICER output format
@@ -990,21 +840,14 @@ IcerCompressionResult compressYuvWithIcerFlash(
     
     // The rearrange phase iterates through all segments and writes them in order
     size_t segments_written = 0;
-    unsigned long rearrange_start_time = millis();
     for (int k = 0; k <= ICER_MAX_SEGMENTS; k++) {
         for (int j = ICER_SUBBAND_MAX; j >= 0; j--) {
             for (int i = ICER_MAX_DECOMP_STAGES; i >= 0; i--) {
                 for (int lsb = ICER_BITPLANES_TO_COMPRESS_16 - 1; lsb >= 0; lsb--) {
                     for (int chan = ICER_CHANNEL_MIN; chan <= ICER_CHANNEL_MAX; chan++) {
                         if (icer_rearrange_segments_16[chan][i][j][lsb][k] != NULL) {
+                            icerReportProgress(ICER_PHASE_REARRANGE, segments_written, 0);
                             segments_written++;
-                            // Report progress every 50 segments or every 2 seconds
-                            if (segments_written % 50 == 0 || (millis() - rearrange_start_time) > 2000) {
-                                Serial.print("    Rearrange progress: ");
-                                Serial.print(segments_written);
-                                Serial.println(" segments written");
-                                rearrange_start_time = millis();
-                            }
                             len = icer_ceil_div_uint32(icer_rearrange_segments_16[chan][i][j][lsb][k]->data_length, 8) +
                                   sizeof(icer_image_segment_typedef);
                             icer_rearrange_segments_16[chan][i][j][lsb][k]->lsb_chan |= ICER_SET_CHANNEL_MACRO(chan);
@@ -1020,7 +863,7 @@ IcerCompressionResult compressYuvWithIcerFlash(
                                     // Flash write failed
                                     output_file->close();
                                     delete output_file;
-                                    gnss_free(datastream);
+                                    poolFree(datastream);
             freeIcerBuffers();
             if (!channels_pre_transformed) {
                 filesystem->remove(y_transformed_file);
@@ -1036,7 +879,7 @@ IcerCompressionResult compressYuvWithIcerFlash(
                                 // This is an error condition
                                 output_file->close();
                                 delete output_file;
-                                gnss_free(datastream);
+                                poolFree(datastream);
             freeIcerBuffers();
             if (!channels_pre_transformed) {
                 filesystem->remove(y_transformed_file);
@@ -1058,15 +901,13 @@ IcerCompressionResult compressYuvWithIcerFlash(
     if (use_flash) {
         output.rearrange_flash_offset = rearrange_offset;
     }
-    Serial.print("    Total segments written: ");
-    Serial.print(segments_written);
-    Serial.print(", Output size: ");
-    Serial.print(rearrange_offset);
-    Serial.println(" bytes");
-    Serial.println("  Step 5 complete: Rearrange finished");
+    ICER_LOG_INFO("    Total segments written: %zu, Output size: %zu bytes", segments_written, rearrange_offset);
+    ICER_LOG_INFO("  Step 5 complete: Rearrange finished");
+    icerTelemetryCountSegments();
     
     // Close output file
-    Serial.println("  ICER Flash Compression: Verifying output file...");
+    ICER_LOG_INFO("  ICER Flash Compression: Verifying output file...");
+    icerTelemetryPhase(ICER_PHASE_VERIFY);
     output_file->close();
     delete output_file;
     
@@ -1079,13 +920,9 @@ IcerCompressionResult compressYuvWithIcerFlash(
         
         if (file_size == output.size_used) {
             // Success
-            Serial.println("  ICER Flash Compression: SUCCESS - Output file verified");
-            Serial.print("    Compressed size: ");
-            Serial.print(output.size_used);
-            Serial.print(" bytes (");
-            Serial.print(output.size_used / 1024);
-            Serial.println(" KB)");
-            gnss_free(datastream);
+            ICER_LOG_INFO("  ICER Flash Compression: SUCCESS - Output file verified");
+            ICER_LOG_INFO("    Compressed size: %zu bytes (%zu KB)", output.size_used, output.size_used / 1024);
+            poolFree(datastream);
             freeIcerBuffers();
             if (!channels_pre_transformed) {
                 filesystem->remove(y_transformed_file);
@@ -1100,7 +937,7 @@ IcerCompressionResult compressYuvWithIcerFlash(
         } else {
             // File size mismatch
             filesystem->remove(output_flash_file);
-            gnss_free(datastream);
+            poolFree(datastream);
             freeIcerBuffers();
             if (!channels_pre_transformed) {
                 filesystem->remove(y_transformed_file);
@@ -1112,7 +949,7 @@ IcerCompressionResult compressYuvWithIcerFlash(
         }
     } else {
         // File not found
-        gnss_free(datastream);
+        poolFree(datastream);
             freeIcerBuffers();
             if (!channels_pre_transformed) {
                 filesystem->remove(y_transformed_file);
@@ -1124,6 +961,32 @@ IcerCompressionResult compressYuvWithIcerFlash(
     }
 }
 
+IcerCompressionResult compressYuvWithIcerFlash(
+    IFileSystem* filesystem,
+    const char* y_flash_file,
+    const char* u_flash_file,
+    const char* v_flash_file,
+    size_t width,
+    size_t height,
+    uint8_t stages,
+    uint8_t filter_type,
+    uint8_t segments,
+    size_t target_size,
+    const char* output_flash_file,
+    bool channels_pre_transformed) {
+    icerTelemetryBegin();
+    IcerCompressionResult result = compressYuvWithIcerFlashImpl(filesystem, y_flash_file, u_flash_file, v_flash_file,
+                                                                width, height, stages, filter_type, segments,
+                                                                target_size, output_flash_file, channels_pre_transformed);
+    // Attach the I/O counters and telemetry (success or failure) and stop attributing
+    // I/O to pipeline phases
+    ioStatsSetPhase(IO_PHASE_OTHER);
+    result.io_stats = ioStatsSnapshot();
+    icerTelemetryEnd(result.io_stats);
+    result.telemetry = icerTelemetry();
+    return result;
+}
+
 // Backward compatibility wrapper that accepts SDClass*
 IcerCompressionResult compressYuvWithIcerFlash(
     SDClass* sd_card,
@@ -1142,7 +1005,7 @@ IcerCompressionResult compressYuvWithIcerFlash(
     // Create temporary file system wrapper (doesn't take ownership)
     IFileSystem* fs = createSpresenceSDFileSystem(sd_card, false);
     if (!fs) {
-        IcerCompressionResult result = {NULL, 0, false, -200, NULL};
+        IcerCompressionResult result = {NULL, 0, false, -200, NULL, NULL, NULL};
         return result;
     }
     
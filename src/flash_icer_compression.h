@@ -37,11 +37,8 @@ class IFileSystem;
 // Returns: IcerCompressionResult with success status
 //
 // RAM Usage: ~50-100 KB (segment buffers + ICER buffers in GNSS RAM)
-//
-// Note: setGnssRamAvailable_flash() must be called before this function to enable GNSS RAM usage
-// This is separate from icer_compression.cpp's setGnssRamAvailable() due to separate compilation units
-void setGnssRamAvailable_flash(bool available);
-
+// Buffers come from the memory pools (memory_arena.h): GNSS RAM is used once
+// initMemoryPools(true) has been called, the main heap otherwise
 IcerCompressionResult compressYuvWithIcerFlash(
     IFileSystem* filesystem,
     const char* y_flash_file,
@@ -0,0 +1,333 @@
+#include "flash_icer_decompression.h"
+#include "flash_wavelet.h"
+#include "flash_partition.h"
+#include "filesystem_interface.h"
+#include "io_stats_filesystem.h"
+#include "memory_arena.h"
+#include "memory_planner.h"
+#include "icer_log.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <Arduino.h>
+
+extern "C" {
+#include "icer.h"
+#include "crc.h"
+}
+
+// Read window of the packet search; only packet headers and CRC chunks go through it
+#define SCAN_BUFFER_BYTES 1024
+
+// Window over the compressed file, so the packet search can test every byte
+// offset (resynchronisation after damaged data) without a read per offset
+struct ScanWindow {
+    IFile* file;
+    size_t file_size;
+    uint8_t* buffer;    // SCAN_BUFFER_BYTES
+    size_t start;       // File offset of buffer[0]
+    size_t length;      // Valid bytes in buffer
+};
+
+// Packets of the three channels, found by indexPackets()
+struct PacketIndex {
+    uint32_t* offsets;          // Packet header offsets [chan][stage - 1][subband][segment][lsb]
+    uint8_t stages;
+    uint8_t segments;
+    size_t max_packet_bytes[ICER_CHANNEL_MAX + 1];  // Largest header + data of an indexed packet
+    size_t packet_count[ICER_CHANNEL_MAX + 1];
+    uint16_t ll_mean[ICER_CHANNEL_MAX + 1];
+    size_t image_w;             // Image size of the last valid packet (any channel)
+    size_t image_h;
+};
+
+// Index entries of one channel
+static inline size_t packetIndexEntries(uint8_t stages, uint8_t segments) {
+    return (size_t)stages * (ICER_SUBBAND_MAX + 1) * segments * ICER_BITPLANES_TO_COMPRESS_16;
+}
+
+// Offsets of the packets of one subband of channel chan, [segment][lsb]
+static inline uint32_t* subbandOffsets(const PacketIndex* index, int chan, uint8_t stage, uint8_t subband) {
+    return index->offsets + (size_t)chan * packetIndexEntries(index->stages, index->segments) +
+           ((size_t)(stage - 1) * (ICER_SUBBAND_MAX + 1) + subband) * index->segments * ICER_BITPLANES_TO_COMPRESS_16;
+}
+
+// Make bytes (at most SCAN_BUFFER_BYTES) at offset available
+// Returns a pointer into the window, or NULL if they cannot be read
+static const uint8_t* windowAt(ScanWindow* window, size_t offset, size_t bytes) {
+    if (offset >= window->start && offset + bytes <= window->start + window->length) {
+        return window->buffer + (offset - window->start);
+    }
+    size_t want = window->file_size - offset;
+    if (want > SCAN_BUFFER_BYTES) {
+        want = SCAN_BUFFER_BYTES;
+    }
+    if (want < bytes || !window->file->seek(offset) || window->file->read(window->buffer, want) != want) {
+        return NULL;
+    }
+    window->start = offset;
+    window->length = want;
+    return window->buffer;
+}
+
+// CRC32 of the data bytes of a packet, streamed through the window
+// Same value as icer_calculate_segment_crc32 on the packet in RAM
+static bool packetDataCrc(ScanWindow* window, size_t data_offset, size_t data_bytes, uint32_t* crc) {
+    uint32_t value = 0;
+    while (data_bytes > 0) {
+        size_t chunk = (data_bytes > SCAN_BUFFER_BYTES) ? SCAN_BUFFER_BYTES : data_bytes;
+        const uint8_t* data = windowAt(window, data_offset, chunk);
+        if (!data) {
+            return false;
+        }
+        value = crc32_update(value, data, chunk);
+        data_offset += chunk;
+        data_bytes -= chunk;
+    }
+    *crc = value;
+    return true;
+}
+
+// Index the packets of all channels in one pass over the file
+// Walks the file like icer_index_yuv_packets_uint16 walks the datastream: a
+// packet counts if its preamble, header CRC, length and data CRC check out,
+// otherwise the search moves on by one byte. A later packet for the same
+// channel, segment and bitplane replaces an earlier one, as in the RAM decoder.
+// Returns 0 on success, -1 on a read error
+static int indexPackets(ScanWindow* window, PacketIndex* index) {
+    size_t entries = (ICER_CHANNEL_MAX + 1) * packetIndexEntries(index->stages, index->segments);
+    for (size_t i = 0; i < entries; i++) {
+        index->offsets[i] = FLASH_PARTITION_NO_PACKET;
+    }
+    for (int chan = ICER_CHANNEL_MIN; chan <= ICER_CHANNEL_MAX; chan++) {
+        index->max_packet_bytes[chan] = 0;
+        index->packet_count[chan] = 0;
+        index->ll_mean[chan] = 0;
+    }
+    index->image_w = 0;
+    index->image_h = 0;
+
+    size_t offset = 0;
+    while (window->file_size - offset >= sizeof(icer_image_segment_typedef)) {
+        const uint8_t* header = windowAt(window, offset, sizeof(icer_image_segment_typedef));
+        if (!header) {
+            return -1;
+        }
+        icer_image_segment_typedef seg;
+        memcpy(&seg, header, sizeof(seg));  // The stream has no alignment guarantees
+
+        size_t data_bytes = icer_ceil_div_uint32(seg.data_length, 8);
+        bool valid = false;
+        if (seg.preamble == ICER_PACKET_PREAMBLE && seg.crc32 == icer_calculate_packet_crc32(&seg) &&
+            data_bytes <= window->file_size - offset - sizeof(seg)) {
+            uint32_t data_crc;
+            if (!packetDataCrc(window, offset + sizeof(seg), data_bytes, &data_crc)) {
+                return -1;
+            }
+            valid = (data_crc == seg.data_crc32);
+        }
+        if (!valid) {
+            offset++;
+            continue;
+        }
+
+        index->image_w = seg.image_w;
+        index->image_h = seg.image_h;
+        int chan = ICER_GET_CHANNEL_MACRO(seg.lsb_chan);
+        if (chan >= ICER_CHANNEL_MIN && chan <= ICER_CHANNEL_MAX) {
+            index->ll_mean[chan] = seg.ll_mean_val;
+            // Packets outside the expected layout are never read by the RAM decoder either
+            uint8_t lsb = ICER_GET_LSB_MACRO(seg.lsb_chan);
+            if (seg.decomp_level >= 1 && seg.decomp_level <= index->stages && seg.subband_type <= ICER_SUBBAND_MAX &&
+                seg.segment_number < index->segments && lsb < ICER_BITPLANES_TO_COMPRESS_16) {
+                uint32_t* slot = subbandOffsets(index, chan, seg.decomp_level, seg.subband_type) +
+                                 (size_t)seg.segment_number * ICER_BITPLANES_TO_COMPRESS_16 + lsb;
+                *slot = (uint32_t)offset;
+                index->packet_count[chan]++;
+                if (sizeof(seg) + data_bytes > index->max_packet_bytes[chan]) {
+                    index->max_packet_bytes[chan] = sizeof(seg) + data_bytes;
+                }
+            }
+        }
+        offset += sizeof(seg) + data_bytes;
+    }
+    return 0;
+}
+
+// Size and byte offset (within the full image, rowstride width) of a subband
+static void subbandGeometry(uint8_t subband, uint8_t level, size_t width, size_t height,
+                            size_t* sub_w, size_t* sub_h, size_t* file_offset) {
+    size_t low_w = icer_get_dim_n_low_stages(width, level);
+    size_t low_h = icer_get_dim_n_low_stages(height, level);
+    bool high_x = (subband == ICER_SUBBAND_HL || subband == ICER_SUBBAND_HH);
+    bool high_y = (subband == ICER_SUBBAND_LH || subband == ICER_SUBBAND_HH);
+    *sub_w = high_x ? icer_get_dim_n_high_stages(width, level) : low_w;
+    *sub_h = high_y ? icer_get_dim_n_high_stages(height, level) : low_h;
+    *file_offset = ((high_y ? low_h * width : 0) + (high_x ? low_w : 0)) * sizeof(uint16_t);
+}
+
+// Decode every subband of channel chan into channel_file (transformed image, sign-magnitude undone)
+static int decodeChannelSubbands(IFileSystem* filesystem, IFile* packet_file, const PacketIndex* index, int chan,
+                                 const char* channel_file, size_t width, size_t height, uint8_t segments) {
+    uint8_t* packet_buffer = NULL;
+    if (index->max_packet_bytes[chan] > 0) {
+        packet_buffer = (uint8_t*)poolAlloc(index->max_packet_bytes[chan], MEM_POOL_MAIN);
+        if (!packet_buffer) {
+            return -302;
+        }
+    }
+    // Every pixel belongs to exactly one segment, so the whole file is written below
+    IFile* out = filesystem->createPreallocated(channel_file, width * height * sizeof(uint16_t));
+    if (!out) {
+        poolFree(packet_buffer);
+        return -305;
+    }
+
+    int res = ICER_RESULT_OK;
+    for (uint8_t stage = 1; stage <= index->stages && res == ICER_RESULT_OK; stage++) {
+        for (uint8_t subband = 0; subband <= ICER_SUBBAND_MAX && res == ICER_RESULT_OK; subband++) {
+            if (subband == ICER_SUBBAND_LL && stage != index->stages) {
+                continue;  // Only the last stage keeps its LL subband
+            }
+            size_t sub_w, sub_h, file_offset;
+            subbandGeometry(subband, stage, width, height, &sub_w, &sub_h, &file_offset);
+
+            partition_param_typdef partition_params;
+            res = icer_generate_partition_parameters(&partition_params, sub_w, sub_h, segments);
+            if (res != ICER_RESULT_OK) {
+                break;
+            }
+            icer_packet_context pkt_context;
+            memset(&pkt_context, 0, sizeof(pkt_context));
+            pkt_context.subband_type = subband;
+            pkt_context.decomp_level = stage;
+            res = icer_decompress_partition_uint16_flash(packet_file, subbandOffsets(index, chan, stage, subband),
+                                                         packet_buffer, index->max_packet_bytes[chan], out,
+                                                         file_offset, &partition_params, width, &pkt_context,
+                                                         index->ll_mean[chan]);
+        }
+    }
+
+    bool closed = out->close();
+    delete out;
+    poolFree(packet_buffer);
+    if (res != ICER_RESULT_OK) {
+        return res;
+    }
+    return closed ? 0 : -306;
+}
+
+// Flash-based ICER decompression
+// Index the packets of all channels, then one channel at a time: decode its
+// subbands, undo the wavelet transform
+int decompressYuvWithIcerFlash(
+    IFileSystem* filesystem,
+    const char* input_flash_file,
+    const char* y_flash_file,
+    const char* u_flash_file,
+    const char* v_flash_file,
+    uint8_t stages,
+    uint8_t filter_type,
+    uint8_t segments,
+    size_t* width,
+    size_t* height) {
+
+    if (!filesystem || !input_flash_file || !y_flash_file || !u_flash_file || !v_flash_file || !width || !height ||
+        stages < 1 || stages > ICER_MAX_DECOMP_STAGES || segments < 1 || segments > ICER_MAX_SEGMENTS) {
+        return -300;
+    }
+
+    ICER_LOG_INFO("  ICER Flash Decompression: Starting...");
+
+    IFile* packet_file = filesystem->open(input_flash_file, FILE_READ);
+    if (!packet_file) {
+        return -301;
+    }
+    ScanWindow window;
+    window.file = packet_file;
+    window.file_size = packet_file->size();
+    window.start = 0;
+    window.length = 0;
+    window.buffer = (uint8_t*)poolAlloc(SCAN_BUFFER_BYTES, MEM_POOL_MAIN);
+
+    PacketIndex index;
+    memset(&index, 0, sizeof(index));
+    index.stages = stages;
+    index.segments = segments;
+    size_t index_bytes = (ICER_CHANNEL_MAX + 1) * packetIndexEntries(stages, segments) * sizeof(uint32_t);
+    index.offsets = (uint32_t*)poolAlloc(index_bytes, MEM_POOL_MAIN);
+
+    int result = 0;
+    if (window.file_size >= FLASH_PARTITION_NO_PACKET) {
+        result = -300;  // Offsets would not fit the index
+    } else if (!window.buffer || !index.offsets) {
+        result = -302;
+    }
+
+    // The encoder's plan may buffer a whole channel per column batch; the
+    // decoder stays within its own cap unless the plan is smaller still
+    size_t column_batch_bytes = currentBufferPlan()->column_batch_bytes;
+    if (column_batch_bytes > FLASH_DECODE_COLUMN_BATCH_BYTES) {
+        column_batch_bytes = FLASH_DECODE_COLUMN_BATCH_BYTES;
+    }
+
+    if (result == 0) {
+        ICER_LOG_DEBUG("    Indexing packets...");
+        ioStatsSetPhase(IO_PHASE_OTHER);
+        if (indexPackets(&window, &index) != 0) {
+            result = -303;
+        } else if (index.image_w == 0 || index.image_h == 0) {
+            result = -304;  // No valid packet at all
+        } else if (index.image_w > SIZE_MAX / index.image_h ||
+                   index.image_w * index.image_h > SIZE_MAX / sizeof(uint16_t) ||
+                   icer_get_dim_n_low_stages(index.image_w, stages) < 3 ||
+                   icer_get_dim_n_low_stages(index.image_h, stages) < 3) {
+            result = ICER_TOO_MANY_STAGES;
+        } else {
+            *width = index.image_w;
+            *height = index.image_h;
+        }
+        // Decoding reads whole packets into its own buffer
+        poolFree(window.buffer);
+        window.buffer = NULL;
+    }
+
+    const char* channel_files[ICER_CHANNEL_MAX + 1] = { y_flash_file, u_flash_file, v_flash_file };
+    for (int chan = ICER_CHANNEL_MIN; chan <= ICER_CHANNEL_MAX && result == 0; chan++) {
+        ICER_LOG_DEBUG("    Channel %s: %lu packets, decoding subbands...",
+                       (chan == ICER_CHANNEL_Y) ? "Y" : (chan == ICER_CHANNEL_U) ? "U" : "V",
+                       (unsigned long)index.packet_count[chan]);
+
+        ioStatsSetPhase(IO_PHASE_PARTITION);
+        result = decodeChannelSubbands(filesystem, packet_file, &index, chan, channel_files[chan], *width, *height,
+                                       segments);
+        if (result != 0) {
+            break;
+        }
+
+        int transform_result = streamingInverseWaveletTransform(filesystem, channel_files[chan], *width, *height,
+                                                                stages, filter_type, column_batch_bytes);
+        if (transform_result != 0) {
+            result = -320 + transform_result;
+        }
+    }
+    ioStatsSetPhase(IO_PHASE_OTHER);
+
+    poolFree(index.offsets);
+    poolFree(window.buffer);
+    packet_file->close();
+    delete packet_file;
+
+    if (result != 0) {
+        ICER_LOG_ERROR("  ICER Flash Decompression: ERROR %d", result);
+        for (int chan = ICER_CHANNEL_MIN; chan <= ICER_CHANNEL_MAX; chan++) {
+            filesystem->remove(channel_files[chan]);
+        }
+        icerLogFlush();
+        return result;
+    }
+    ICER_LOG_INFO("  ICER Flash Decompression: Complete");
+    icerLogFlush();
+    return 0;
+}
@@ -0,0 +1,66 @@
+#ifndef FLASH_ICER_DECOMPRESSION_H
+#define FLASH_ICER_DECOMPRESSION_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Forward declarations
+class IFileSystem;
+
+// Largest wavelet column batch of the decoder; the buffer plan's
+// column_batch_bytes is sized for the encoder and may hold a whole channel
+#ifndef FLASH_DECODE_COLUMN_BATCH_BYTES
+#define FLASH_DECODE_COLUMN_BATCH_BYTES (32 * 1024)
+#endif
+
+// Flash-based ICER decompression, the mirror of compressYuvWithIcerFlash
+// Decodes an ICER file into Y, U, V channel files without holding the
+// compressed stream or a channel in RAM:
+// 1. Index the packets of all three channels in one scan of the compressed file
+//    (same packet search and CRC checks as icer_find_packet_in_bytestream)
+// Then for each channel:
+// 2. Decode the subbands one segment at a time into the channel file
+//    (icer_decompress_partition_uint16_flash)
+// 3. Inverse streaming wavelet transform of the channel file, in place
+//    (streamingInverseWaveletTransform)
+//
+// Output: Flash files for Y, U, V (uint16_t, row-major), the same format
+// compressYuvWithIcerFlash takes as input. The pixels are identical to those
+// of icer_decompress_image_yuv_uint16 on the same stream, including truncated
+// streams (missing bitplanes and segments decode as in the RAM decoder).
+//
+// Parameters:
+// - filesystem: File system interface instance
+// - input_flash_file: Compressed ICER file (e.g. the output of compressYuvWithIcerFlash)
+// - y_flash_file, u_flash_file, v_flash_file: Output channel files (replaced)
+// - stages, filter_type, segments: ICER parameters the image was compressed with
+// - width, height: Set to the image size found in the packet headers
+//
+// Returns: 0 on success, negative error code on failure
+//
+// RAM Usage: a packet index of 3 * stages * 4 * segments * ICER_BITPLANES_TO_COMPRESS_16
+// * 4 bytes (~10 KB for 4 stages and 6 segments, ~27 KB with 16), a 1 KB scan
+// buffer while indexing, plus
+// - while decoding subbands: one padded segment buffer (as in the encoder, ~27 KB
+//   at 640x480 and ~100 KB at 1280x960 with 6 segments) and the largest packet
+// - while inverse transforming: one image row and one column batch of at most
+//   FLASH_DECODE_COLUMN_BATCH_BYTES (less if the buffer plan's column_batch_bytes
+//   is smaller)
+// Measured peaks (icer_rd_bench, 3-4 stages): ~40-43 KB at 320x240 and 640x480
+// with 6 segments, ~53-60 KB with 16; ~120-123 KB at 1280x960 with 6 segments,
+// ~71-78 KB with 16. With one segment the segment buffer holds a whole stage 1
+// subband (~169 KB at 640x480, ~667 KB at 1280x960).
+int decompressYuvWithIcerFlash(
+    IFileSystem* filesystem,
+    const char* input_flash_file,
+    const char* y_flash_file,
+    const char* u_flash_file,
+    const char* v_flash_file,
+    uint8_t stages,
+    uint8_t filter_type,
+    uint8_t segments,
+    size_t* width,
+    size_t* height
+);
+
+#endif // FLASH_ICER_DECOMPRESSION_H
@@ -1,68 +1,54 @@
 #include "flash_partition.h"
 #include "filesystem_interface.h"
+#include "memory_arena.h"
+#include "task_pool.h"
+#include "icer_profile.h"
 #include <SDHCI.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
 #include <limits.h>
 
-// Flash-based partition compression - reads segments from flash on-demand
-// Maintains 100% compatibility with standard ICER output
-int icer_compress_partition_uint16_flash(
-    IFile* flash_file,
-    size_t file_offset,
-    const partition_param_typdef *params,
-    size_t rowstride,
-    icer_packet_context *pkt_context,
-    icer_output_data_buf_typedef *output_data,
-    const icer_image_segment_typedef *segments_encoded[]) {
-    
-    if (!flash_file || !params || !pkt_context || !output_data || !segments_encoded) {
-        return ICER_FATAL_ERROR;
-    }
-    
-    int res;
-    size_t segment_w, segment_h;
-    uint16_t segment_num = 0;
-    
-    size_t partition_col_ind;
+// Free space a speculatively encoded segment must leave in the real output
+// buffer to be committed as is. With this much room the serial encoder cannot
+// run into the byte quota either, so its output would be the same bytes.
+#define PARALLEL_QUOTA_MARGIN 8
+
+// Position and size of one segment within the subband
+struct SegmentGeometry {
+    size_t row_ind;
+    size_t col_ind;
+    size_t w;
+    size_t h;
+};
+
+// Per-worker buffers of the parallel encoder
+struct SegmentSlot {
+    uint16_t* buffer;              // Padded segment data
+    uint16_t* circ_buf;            // Entropy coder circular buffer (ICER_CIRC_BUF_SIZE entries)
+    uint8_t* packet;               // Private packet: header + encoded data
+    size_t packet_capacity;
+    const SegmentGeometry* geometry;
+    uint16_t segment_num;
+    int result;                    // icer_compress_bitplane_uint16 result
+    size_t packet_bytes;           // Header + data bytes written to packet
+};
+
+// Shared state of one parallel batch
+struct SegmentBatch {
+    SegmentSlot* slots;
+    const icer_packet_context* pkt_context;
+    size_t padded_w;
+};
+
+// List the segments of a partition in segment number order
+// Returns the number of segments, or -1 if there are more than fit in segments
+static int listSegments(const partition_param_typdef* params, SegmentGeometry* segments, int max_segments) {
+    int count = 0;
     size_t partition_row_ind = 0;
-    
-    icer_context_model_typedef context_model;
-    icer_encoder_context_typedef context;
-    icer_image_segment_typedef *seg;
-    
-    uint32_t data_in_bytes;
-    
-           // Calculate maximum segment size for buffer allocation
-           // Segments can vary in size, so we allocate for the largest possible segment
-           size_t max_segment_w = (size_t)(params->x_t + 1);  // Largest width (x_t or x_t+1)
-           size_t max_segment_h = (size_t)(params->y_t + 1);  // Largest height (y_t or y_t+1)
-           if (params->x_b > 0 && (size_t)(params->x_b + 1) > max_segment_w) {
-               max_segment_w = (size_t)(params->x_b + 1);
-           }
-           if (params->y_b > 0 && (size_t)(params->y_b + 1) > max_segment_h) {
-               max_segment_h = (size_t)(params->y_b + 1);
-           }
-    
-    // CRITICAL OPTIMIZATION: Allocate buffer with segment width + padding instead of full rowstride
-    // icer_compress_bitplane accesses neighbors: pos-1, pos+1 (horizontal) and pos-rowstride, pos+rowstride (vertical)
-    // We need 1 pixel padding on each side for boundary access
-    // This reduces buffer from max_segment_h * rowstride to (max_segment_h + 2) * (max_segment_w + 2)
-    // For 1280x960 image: old = 161 * 1280 * 2 = 402 KB, new = 163 * 216 * 2 = 69 KB (83% reduction!)
-    size_t padded_w = max_segment_w + 2;  // Left + right padding
-    size_t padded_h = max_segment_h + 2;  // Top + bottom padding
-    size_t segment_buffer_size = padded_h * padded_w * sizeof(uint16_t);
-    uint16_t* segment_buffer = (uint16_t*)malloc(segment_buffer_size);
-    if (!segment_buffer) {
-        return ICER_FATAL_ERROR;
-    }
-    
-    // Clear buffer to ensure clean state (padding will be zeros)
-    memset(segment_buffer, 0, segment_buffer_size);
-    
+
     /*
-     * Process top region which consists of c columns
+     * Top region which consists of c columns
      * height of top region is h_t and it contains r_t rows
      */
     for (uint16_t row = 0; row < params->r_t; row++) {
@@ -70,122 +56,26 @@ int icer_compress_partition_uint16_flash(
          * the first r_t0 rows have height y_t
          * the remainder have height y_t + 1
          */
-        segment_h = params->y_t + ((row >= params->r_t0) ? 1 : 0);
-        partition_col_ind = 0;
-        
+        size_t segment_h = params->y_t + ((row >= params->r_t0) ? 1 : 0);
+        size_t partition_col_ind = 0;
         for (uint16_t col = 0; col < params->c; col++) {
             /* the first c_t0 columns have width x_t
              * the remainder have width x_t + 1
              */
-            segment_w = params->x_t + ((col >= params->c_t0) ? 1 : 0);
-            
-            // Calculate segment position in flash file
-            // Segment starts at: file_offset + (partition_row_ind * rowstride + partition_col_ind) * sizeof(uint16_t)
-            size_t segment_start_offset = file_offset + 
-                (partition_row_ind * rowstride + partition_col_ind) * sizeof(uint16_t);
-            
-            // Read segment from flash into padded buffer
-            // Buffer layout: [padding row][data row with left/right padding][padding row]
-            // Segment data starts at buffer[1 * padded_w + 1] (skip top padding row and left padding)
-            // This allows icer_compress_bitplane to access neighbors safely
-            flash_file->seek(segment_start_offset);
-            for (size_t seg_row = 0; seg_row < segment_h; seg_row++) {
-                // Calculate position in flash file for this row
-                size_t row_offset = segment_start_offset + seg_row * rowstride * sizeof(uint16_t);
-                flash_file->seek(row_offset);
-                
-                // Read one row of the segment into buffer with padding
-                // Write to buffer[(seg_row + 1) * padded_w + 1] (skip top padding and left padding)
-                size_t row_bytes = segment_w * sizeof(uint16_t);
-                size_t buffer_offset = (seg_row + 1) * padded_w + 1;  // +1 for top padding, +1 for left padding
-                size_t bytes_read = flash_file->read(
-                    (uint8_t*)(segment_buffer + buffer_offset),
-                    row_bytes
-                );
-                
-                if (bytes_read != row_bytes) {
-                    free(segment_buffer);
-                    return ICER_FATAL_ERROR;
-                }
-                
-                // Pad left and right edges with edge pixel value (replication)
-                // Left padding: copy first pixel
-                if (buffer_offset > 0) {
-                    segment_buffer[buffer_offset - 1] = segment_buffer[buffer_offset];
-                }
-                // Right padding: copy last pixel
-                if (buffer_offset + segment_w < padded_w * padded_h) {
-                    segment_buffer[buffer_offset + segment_w] = segment_buffer[buffer_offset + segment_w - 1];
-                }
-            }
-            
-            // Pad top and bottom rows by replicating first/last data row
-            // Top padding row: replicate first data row (including left/right padding)
-            if (segment_h > 0) {
-                // Copy entire first data row (including its left/right padding) to top padding row
-                for (size_t col = 0; col < padded_w; col++) {
-                    segment_buffer[col] = segment_buffer[padded_w + col];  // Copy row 1 to row 0
-                }
-            }
-            // Bottom padding row: replicate last data row (including left/right padding)
-            if (segment_h > 0) {
-                size_t last_data_row_start = segment_h * padded_w;
-                size_t bottom_padding_row_start = (segment_h + 1) * padded_w;
-                for (size_t col = 0; col < padded_w; col++) {
-                    segment_buffer[bottom_padding_row_start + col] = segment_buffer[last_data_row_start + col];
-                }
+            size_t segment_w = params->x_t + ((col >= params->c_t0) ? 1 : 0);
+            if (count >= max_segments) {
+                return -1;
             }
-            
-            // Calculate segment_start pointer: skip top padding row and left padding column
-            // This points to the actual segment data in the padded buffer
-            const uint16_t* segment_start = segment_buffer + padded_w + 1;  // Skip top row (padded_w) and left column (+1)
-            
-            // Use padded_w as rowstride for icer_compress_bitplane
-            // This allows it to access neighbors correctly within the padded buffer
-            size_t segment_rowstride = padded_w;
-            
+            segments[count].row_ind = partition_row_ind;
+            segments[count].col_ind = partition_col_ind;
+            segments[count].w = segment_w;
+            segments[count].h = segment_h;
+            count++;
             partition_col_ind += segment_w;
-            
-            // Initialize context model (same as standard ICER)
-            icer_init_context_model_vals(&context_model, (enum icer_subband_types)pkt_context->subband_type);
-            
-            // Allocate data packet (same as standard ICER)
-            res = icer_allocate_data_packet(&seg, output_data, segment_num, pkt_context);
-            if (res != ICER_RESULT_OK) {
-                free(segment_buffer);
-                return res;
-            }
-            
-            // Initialize entropy coder context (same as standard ICER)
-            icer_init_entropy_coder_context(&context, icer_encode_circ_buf, ICER_CIRC_BUF_SIZE,
-                                            (uint8_t *) seg + sizeof(icer_image_segment_typedef), seg->data_length);
-            
-            // Call standard ICER bitplane compression (NO ALGORITHM CHANGES)
-            // This ensures 100% output compatibility
-            // Use segment_rowstride (padded_w) instead of full image rowstride
-            // The padded buffer provides boundary pixels for neighbor access
-            res = icer_compress_bitplane_uint16(segment_start, segment_w, segment_h, segment_rowstride, &context_model, &context,
-                                               pkt_context);
-            if (res != ICER_RESULT_OK) {
-                output_data->size_used -= sizeof(icer_image_segment_typedef);
-                free(segment_buffer);
-                return res;
-            }
-            
-            // Calculate output size and update segment (same as standard ICER)
-            data_in_bytes = context.output_ind + (context.output_bit_offset > 0);
-            seg->data_length = context.output_ind * 8 + context.output_bit_offset;
-            seg->data_crc32 = icer_calculate_segment_crc32(seg);
-            seg->crc32 = icer_calculate_packet_crc32(seg);
-            output_data->size_used += data_in_bytes;
-            
-            segments_encoded[segment_num] = seg;
-            
-            segment_num++;
         }
         partition_row_ind += segment_h;
     }
-    
+
     /*
      * if the bottom region exists, process bottom region
      * which consists of c+1 columns
@@ -195,103 +85,452 @@ int icer_compress_partition_uint16_flash(
          * the first r_b0 rows have height y_b
          * the remainder have height y_b + 1
          */
-        segment_h = params->y_b + ((row >= params->r_b0) ? 1 : 0);
-        partition_col_ind = 0;
-        
+        size_t segment_h = params->y_b + ((row >= params->r_b0) ? 1 : 0);
+        size_t partition_col_ind = 0;
         for (uint16_t col = 0; col < (params->c + 1); col++) {
             /* the first c_b0 columns have width x_b
              * the remainder have width x_b + 1
              */
-            segment_w = params->x_b + ((col >= params->c_b0) ? 1 : 0);
-            
-            // Calculate segment position in flash file
-            size_t segment_start_offset = file_offset + 
-                (partition_row_ind * rowstride + partition_col_ind) * sizeof(uint16_t);
-            
-            // Read segment from flash into padded buffer (same as top region)
-            flash_file->seek(segment_start_offset);
-            for (size_t seg_row = 0; seg_row < segment_h; seg_row++) {
-                size_t row_offset = segment_start_offset + seg_row * rowstride * sizeof(uint16_t);
-                flash_file->seek(row_offset);
-                
-                size_t row_bytes = segment_w * sizeof(uint16_t);
-                size_t buffer_offset = (seg_row + 1) * padded_w + 1;  // +1 for top padding, +1 for left padding
-                size_t bytes_read = flash_file->read(
-                    (uint8_t*)(segment_buffer + buffer_offset),
-                    row_bytes
-                );
-                
-                if (bytes_read != row_bytes) {
-                    free(segment_buffer);
-                    return ICER_FATAL_ERROR;
-                }
-                
-                // Pad left and right edges
-                if (buffer_offset > 0) {
-                    segment_buffer[buffer_offset - 1] = segment_buffer[buffer_offset];
-                }
-                if (buffer_offset + segment_w < padded_w * padded_h) {
-                    segment_buffer[buffer_offset + segment_w] = segment_buffer[buffer_offset + segment_w - 1];
-                }
+            size_t segment_w = params->x_b + ((col >= params->c_b0) ? 1 : 0);
+            if (count >= max_segments) {
+                return -1;
             }
-            
-            // Pad top and bottom rows (including left/right padding)
-            if (segment_h > 0) {
-                // Copy entire first data row (including its left/right padding) to top padding row
-                for (size_t col = 0; col < padded_w; col++) {
-                    segment_buffer[col] = segment_buffer[padded_w + col];  // Copy row 1 to row 0
-                }
-                // Copy entire last data row (including its left/right padding) to bottom padding row
-                size_t last_data_row_start = segment_h * padded_w;
-                size_t bottom_padding_row_start = (segment_h + 1) * padded_w;
-                for (size_t col = 0; col < padded_w; col++) {
-                    segment_buffer[bottom_padding_row_start + col] = segment_buffer[last_data_row_start + col];
+            segments[count].row_ind = partition_row_ind;
+            segments[count].col_ind = partition_col_ind;
+            segments[count].w = segment_w;
+            segments[count].h = segment_h;
+            count++;
+            partition_col_ind += segment_w;
+        }
+        partition_row_ind += segment_h;
+    }
+    return count;
+}
+
+// Read one segment from flash into a padded buffer
+// Buffer layout: [padding row][data rows with left/right padding][padding row]
+// Segment data starts at buffer[1 * padded_w + 1] (skip top padding row and left padding).
+// Padding replicates the edge pixels; the bitplane coder never reads it, it
+// only keeps every neighbour pointer inside the buffer.
+static bool loadSegment(IFile* flash_file, size_t file_offset, size_t rowstride, const SegmentGeometry* geometry,
+                        uint16_t* segment_buffer, size_t padded_w, size_t padded_h) {
+    ICER_PROFILE_SCOPE(ICER_ZONE_SEGMENT_LOAD);
+    size_t segment_w = geometry->w;
+    size_t segment_h = geometry->h;
+
+    // Segment starts at: file_offset + (row_ind * rowstride + col_ind) * sizeof(uint16_t)
+    size_t segment_start_offset = file_offset +
+        (geometry->row_ind * rowstride + geometry->col_ind) * sizeof(uint16_t);
+
+    flash_file->seek(segment_start_offset);
+    for (size_t seg_row = 0; seg_row < segment_h; seg_row++) {
+        // Calculate position in flash file for this row
+        size_t row_offset = segment_start_offset + seg_row * rowstride * sizeof(uint16_t);
+        flash_file->seek(row_offset);
+
+        // Read one row of the segment into buffer with padding
+        size_t row_bytes = segment_w * sizeof(uint16_t);
+        size_t buffer_offset = (seg_row + 1) * padded_w + 1;  // +1 for top padding, +1 for left padding
+        size_t bytes_read = flash_file->read(
+            (uint8_t*)(segment_buffer + buffer_offset),
+            row_bytes
+        );
+
+        if (bytes_read != row_bytes) {
+            return false;
+        }
+
+        // Pad left and right edges with edge pixel value (replication)
+        if (buffer_offset > 0) {
+            segment_buffer[buffer_offset - 1] = segment_buffer[buffer_offset];
+        }
+        if (buffer_offset + segment_w < padded_w * padded_h) {
+            segment_buffer[buffer_offset + segment_w] = segment_buffer[buffer_offset + segment_w - 1];
+        }
+    }
+
+    // Pad top and bottom rows by replicating first/last data row (including left/right padding)
+    if (segment_h > 0) {
+        for (size_t col = 0; col < padded_w; col++) {
+            segment_buffer[col] = segment_buffer[padded_w + col];  // Copy row 1 to row 0
+        }
+        size_t last_data_row_start = segment_h * padded_w;
+        size_t bottom_padding_row_start = (segment_h + 1) * padded_w;
+        for (size_t col = 0; col < padded_w; col++) {
+            segment_buffer[bottom_padding_row_start + col] = segment_buffer[last_data_row_start + col];
+        }
+    }
+    return true;
+}
+
+// Encode one loaded segment into the next packet of output_data (same steps as standard ICER)
+// On failure the packet header is taken back out of output_data, like icer_compress_partition_uint16.
+static int encodeSegment(const uint16_t* segment_buffer, size_t padded_w, const SegmentGeometry* geometry,
+                         const icer_packet_context* pkt_context, icer_output_data_buf_typedef* output_data,
+                         uint16_t segment_num, uint16_t* circ_buf, icer_image_segment_typedef** seg_out) {
+    ICER_PROFILE_SCOPE(ICER_ZONE_SEGMENT_ENCODE);
+    icer_context_model_typedef context_model;
+    icer_encoder_context_typedef context;
+    icer_image_segment_typedef* seg;
+
+    // Segment data starts after the top padding row and the left padding column;
+    // padded_w is the rowstride within the buffer
+    const uint16_t* segment_start = segment_buffer + padded_w + 1;
+
+    icer_init_context_model_vals(&context_model, (enum icer_subband_types)pkt_context->subband_type);
+
+    int res = icer_allocate_data_packet(&seg, output_data, segment_num, pkt_context);
+    if (res != ICER_RESULT_OK) {
+        return res;
+    }
+
+    icer_init_entropy_coder_context(&context, circ_buf, ICER_CIRC_BUF_SIZE,
+                                    (uint8_t *) seg + sizeof(icer_image_segment_typedef), seg->data_length);
+
+    // Standard ICER bitplane compression (NO ALGORITHM CHANGES)
+    res = icer_compress_bitplane_uint16(segment_start, geometry->w, geometry->h, padded_w, &context_model, &context,
+                                        pkt_context);
+    if (res != ICER_RESULT_OK) {
+        output_data->size_used -= sizeof(icer_image_segment_typedef);
+        return res;
+    }
+
+    // Calculate output size and update segment
+    uint32_t data_in_bytes = context.output_ind + (context.output_bit_offset > 0);
+    seg->data_length = context.output_ind * 8 + context.output_bit_offset;
+    seg->data_crc32 = icer_finish_segment_crc32(&context, seg);
+    seg->crc32 = icer_calculate_packet_crc32(seg);
+    output_data->size_used += data_in_bytes;
+
+    *seg_out = seg;
+    return ICER_RESULT_OK;
+}
+
+// Task body: encode one slot's segment into its private packet buffer
+static void encodeSlotTask(void* context, size_t index, int worker) {
+    (void)worker;
+    SegmentBatch* batch = static_cast<SegmentBatch*>(context);
+    SegmentSlot* slot = &batch->slots[index];
+
+    icer_output_data_buf_typedef private_output;
+    memset(&private_output, 0, sizeof(private_output));
+    private_output.data_start = slot->packet;
+    private_output.size_allocated = slot->packet_capacity;
+
+    icer_image_segment_typedef* seg;
+    slot->result = encodeSegment(slot->buffer, batch->padded_w, slot->geometry, batch->pkt_context, &private_output,
+                                 slot->segment_num, slot->circ_buf, &seg);
+    slot->packet_bytes = private_output.size_used;
+}
+
+static void freeSlots(SegmentSlot* slots, int slot_count) {
+    for (int i = 0; i < slot_count; i++) {
+        poolFree(slots[i].buffer);
+        poolFree(slots[i].circ_buf);
+        poolFree(slots[i].packet);
+    }
+}
+
+// Segment-parallel encoder
+// Segments are loaded in batches of one per slot (file reads stay on the
+// calling thread), encoded by the pool into private packet buffers, then
+// committed to output_data in segment number order. A segment whose private
+// result cannot be proven identical to the serial encoder's - it came close to
+// the real byte quota, or overflowed its private buffer - is encoded again in
+// place with the real quota, so the stream and the error behaviour stay
+// exactly those of the serial encoder.
+//
+// Returns ICER_RESULT_OK / an ICER error, or 1 if the slots could not be
+// allocated (the caller then encodes serially)
+static int compressSegmentsParallel(ITaskPool* pool, IFile* flash_file, size_t file_offset, size_t rowstride,
+                                    const SegmentGeometry* segments, int segment_count,
+                                    size_t padded_w, size_t padded_h, size_t max_segment_w, size_t max_segment_h,
+                                    const icer_packet_context* pkt_context, icer_output_data_buf_typedef* output_data,
+                                    const icer_image_segment_typedef* segments_encoded[]) {
+    SegmentSlot slots[ICER_MAX_SEGMENTS + 1];
+    int slot_count = pool->workerCount();
+    if (slot_count > segment_count) {
+        slot_count = segment_count;
+    }
+    if (slot_count > ICER_MAX_SEGMENTS + 1) {
+        slot_count = ICER_MAX_SEGMENTS + 1;
+    }
+
+    // A bitplane costs about one bit per pixel plus sign bits; 4 bits per pixel
+    // leaves room for poorly compressible planes, anything larger takes the fallback
+    size_t segment_buffer_size = padded_h * padded_w * sizeof(uint16_t);
+    size_t packet_capacity = sizeof(icer_image_segment_typedef) + max_segment_w * max_segment_h / 2 + 256;
+
+    memset(slots, 0, sizeof(slots));
+    for (int i = 0; i < slot_count; i++) {
+        slots[i].buffer = (uint16_t*)poolAlloc(segment_buffer_size, MEM_POOL_MAIN);
+        slots[i].circ_buf = (uint16_t*)poolAlloc(sizeof(uint16_t) * ICER_CIRC_BUF_SIZE, MEM_POOL_MAIN);
+        slots[i].packet = (uint8_t*)poolAlloc(packet_capacity, MEM_POOL_MAIN);
+        slots[i].packet_capacity = packet_capacity;
+        if (!slots[i].buffer || !slots[i].circ_buf || !slots[i].packet) {
+            freeSlots(slots, i + 1);
+            return 1;
+        }
+        memset(slots[i].buffer, 0, segment_buffer_size);
+    }
+
+    SegmentBatch batch;
+    batch.slots = slots;
+    batch.pkt_context = pkt_context;
+    batch.padded_w = padded_w;
+
+    for (int first = 0; first < segment_count; first += slot_count) {
+        int batch_count = segment_count - first;
+        if (batch_count > slot_count) {
+            batch_count = slot_count;
+        }
+
+        for (int i = 0; i < batch_count; i++) {
+            slots[i].geometry = &segments[first + i];
+            slots[i].segment_num = (uint16_t)(first + i);
+            if (!loadSegment(flash_file, file_offset, rowstride, slots[i].geometry, slots[i].buffer, padded_w, padded_h)) {
+                freeSlots(slots, slot_count);
+                return ICER_FATAL_ERROR;
+            }
+        }
+
+        pool->run((size_t)batch_count, encodeSlotTask, &batch);
+
+        // Commit in segment number order
+        for (int i = 0; i < batch_count; i++) {
+            SegmentSlot* slot = &slots[i];
+            size_t room = output_data->size_allocated - output_data->size_used;
+            if (slot->result == ICER_RESULT_OK && slot->packet_bytes + PARALLEL_QUOTA_MARGIN <= room) {
+                uint8_t* dst = output_data->data_start + output_data->size_used;
+                memcpy(dst, slot->packet, slot->packet_bytes);
+                output_data->size_used += slot->packet_bytes;
+                segments_encoded[slot->segment_num] = (const icer_image_segment_typedef*)dst;
+            } else {
+                icer_image_segment_typedef* seg;
+                int res = encodeSegment(slot->buffer, padded_w, slot->geometry, pkt_context, output_data,
+                                        slot->segment_num, slot->circ_buf, &seg);
+                if (res != ICER_RESULT_OK) {
+                    freeSlots(slots, slot_count);
+                    return res;
                 }
+                segments_encoded[slot->segment_num] = seg;
             }
-            
-            const uint16_t* segment_start = segment_buffer + padded_w + 1;
-            size_t segment_rowstride = padded_w;
-            
-            partition_col_ind += segment_w;
-            
-            // Initialize context model
-            icer_init_context_model_vals(&context_model, (enum icer_subband_types)pkt_context->subband_type);
-            
-            // Allocate data packet
-            res = icer_allocate_data_packet(&seg, output_data, segment_num, pkt_context);
-            if (res != ICER_RESULT_OK) {
-                free(segment_buffer);
-                return res;
+        }
+    }
+
+    freeSlots(slots, slot_count);
+    return ICER_RESULT_OK;
+}
+
+// Flash-based partition compression - reads segments from flash on-demand
+// Maintains 100% compatibility with standard ICER output
+int icer_compress_partition_uint16_flash(
+    IFile* flash_file,
+    size_t file_offset,
+    const partition_param_typdef *params,
+    size_t rowstride,
+    icer_packet_context *pkt_context,
+    icer_output_data_buf_typedef *output_data,
+    const icer_image_segment_typedef *segments_encoded[]) {
+
+    if (!flash_file || !params || !pkt_context || !output_data || !segments_encoded) {
+        return ICER_FATAL_ERROR;
+    }
+
+    int res;
+    icer_image_segment_typedef *seg;
+
+    SegmentGeometry segments[ICER_MAX_SEGMENTS + 1];
+    int segment_count = listSegments(params, segments, ICER_MAX_SEGMENTS + 1);
+    if (segment_count < 0) {
+        return ICER_FATAL_ERROR;
+    }
+
+    // Calculate maximum segment size for buffer allocation
+    // Segments can vary in size, so we allocate for the largest possible segment
+    size_t max_segment_w = (size_t)(params->x_t + 1);  // Largest width (x_t or x_t+1)
+    size_t max_segment_h = (size_t)(params->y_t + 1);  // Largest height (y_t or y_t+1)
+    if (params->x_b > 0 && (size_t)(params->x_b + 1) > max_segment_w) {
+        max_segment_w = (size_t)(params->x_b + 1);
+    }
+    if (params->y_b > 0 && (size_t)(params->y_b + 1) > max_segment_h) {
+        max_segment_h = (size_t)(params->y_b + 1);
+    }
+
+    // CRITICAL OPTIMIZATION: Allocate buffer with segment width + padding instead of full rowstride
+    // icer_compress_bitplane accesses neighbors: pos-1, pos+1 (horizontal) and pos-rowstride, pos+rowstride (vertical)
+    // We need 1 pixel padding on each side for boundary access
+    // This reduces buffer from max_segment_h * rowstride to (max_segment_h + 2) * (max_segment_w + 2)
+    // For 1280x960 image: old = 161 * 1280 * 2 = 402 KB, new = 163 * 216 * 2 = 69 KB (83% reduction!)
+    size_t padded_w = max_segment_w + 2;  // Left + right padding
+    size_t padded_h = max_segment_h + 2;  // Top + bottom padding
+
+    // Spread the segments over the segment task pool if one is set
+    ITaskPool* pool = getSegmentTaskPool();
+    if (pool && pool->workerCount() > 1 && segment_count > 1) {
+        res = compressSegmentsParallel(pool, flash_file, file_offset, rowstride, segments, segment_count,
+                                       padded_w, padded_h, max_segment_w, max_segment_h,
+                                       pkt_context, output_data, segments_encoded);
+        if (res <= 0) {
+            return res;
+        }
+        // Not enough memory for the worker buffers: encode serially below
+    }
+
+    size_t segment_buffer_size = padded_h * padded_w * sizeof(uint16_t);
+    uint16_t* segment_buffer = (uint16_t*)poolAlloc(segment_buffer_size, MEM_POOL_MAIN);
+    if (!segment_buffer) {
+        return ICER_FATAL_ERROR;
+    }
+
+    // Clear buffer to ensure clean state (padding will be zeros)
+    memset(segment_buffer, 0, segment_buffer_size);
+
+    for (int segment_num = 0; segment_num < segment_count; segment_num++) {
+        if (!loadSegment(flash_file, file_offset, rowstride, &segments[segment_num], segment_buffer, padded_w, padded_h)) {
+            poolFree(segment_buffer);
+            return ICER_FATAL_ERROR;
+        }
+
+        res = encodeSegment(segment_buffer, padded_w, &segments[segment_num], pkt_context, output_data,
+                            (uint16_t)segment_num, icer_encode_circ_buf, &seg);
+        if (res != ICER_RESULT_OK) {
+            poolFree(segment_buffer);
+            return res;
+        }
+
+        segments_encoded[segment_num] = seg;
+    }
+
+    poolFree(segment_buffer);
+    return ICER_RESULT_OK;
+}
+
+// Read one packet (header + data) into packet_buffer
+static bool loadPacket(IFile* packet_file, uint32_t offset, uint8_t* packet_buffer, size_t packet_buffer_size) {
+    if (!packet_buffer || packet_buffer_size < sizeof(icer_image_segment_typedef) || !packet_file->seek(offset)) {
+        return false;
+    }
+    if (packet_file->read(packet_buffer, sizeof(icer_image_segment_typedef)) != sizeof(icer_image_segment_typedef)) {
+        return false;
+    }
+    const icer_image_segment_typedef* seg = (const icer_image_segment_typedef*)packet_buffer;
+    size_t data_bytes = icer_ceil_div_uint32(seg->data_length, 8);
+    if (data_bytes > packet_buffer_size - sizeof(icer_image_segment_typedef)) {
+        return false;
+    }
+    return packet_file->read(packet_buffer + sizeof(icer_image_segment_typedef), data_bytes) == data_bytes;
+}
+
+// Write the decoded segment rows (segment data starts at segment_buffer[padded_w + 1]) into the subband
+static bool storeSegment(IFile* out_file, size_t file_offset, size_t rowstride, const SegmentGeometry* geometry,
+                         const uint16_t* segment_buffer, size_t padded_w) {
+    size_t row_bytes = geometry->w * sizeof(uint16_t);
+    for (size_t seg_row = 0; seg_row < geometry->h; seg_row++) {
+        size_t row_offset = file_offset + ((geometry->row_ind + seg_row) * rowstride + geometry->col_ind) * sizeof(uint16_t);
+        if (!out_file->seek(row_offset)) {
+            return false;
+        }
+        const uint16_t* row = segment_buffer + (seg_row + 1) * padded_w + 1;
+        if (out_file->write((const uint8_t*)row, row_bytes) != row_bytes) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Flash-based partition decompression - decodes one segment at a time into the channel file
+// Writes the same pixels as icer_decompress_partition_uint16 followed by the sign-magnitude
+// conversion and LL mean of icer_decompress_channel_uint16
+int icer_decompress_partition_uint16_flash(
+    IFile* packet_file,
+    const uint32_t *packet_offsets,
+    uint8_t *packet_buffer,
+    size_t packet_buffer_size,
+    IFile* out_file,
+    size_t file_offset,
+    const partition_param_typdef *params,
+    size_t rowstride,
+    const icer_packet_context *pkt_context,
+    uint16_t ll_mean) {
+
+    // packet_buffer may be NULL when the channel has no packets at all (every
+    // offset missing); loadPacket() then never runs
+    if (!packet_file || !packet_offsets || !out_file || !params || !pkt_context) {
+        return ICER_FATAL_ERROR;
+    }
+
+    SegmentGeometry segments[ICER_MAX_SEGMENTS + 1];
+    int segment_count = listSegments(params, segments, ICER_MAX_SEGMENTS + 1);
+    if (segment_count < 0) {
+        return ICER_FATAL_ERROR;
+    }
+
+    size_t max_segment_w = 0;
+    size_t max_segment_h = 0;
+    for (int i = 0; i < segment_count; i++) {
+        if (segments[i].w > max_segment_w) max_segment_w = segments[i].w;
+        if (segments[i].h > max_segment_h) max_segment_h = segments[i].h;
+    }
+
+    // Same padded layout as the encoder: every neighbour the context model looks
+    // at stays inside the buffer, the padding itself is never decoded into
+    size_t padded_w = max_segment_w + 2;
+    size_t padded_h = max_segment_h + 2;
+    size_t segment_buffer_size = padded_h * padded_w * sizeof(uint16_t);
+    uint16_t* segment_buffer = (uint16_t*)poolAlloc(segment_buffer_size, MEM_POOL_MAIN);
+    if (!segment_buffer) {
+        return ICER_FATAL_ERROR;
+    }
+
+    icer_context_model_typedef context_model;
+    icer_decoder_context_typedef context;
+    icer_packet_context plane_context = *pkt_context;
+
+    for (int segment_num = 0; segment_num < segment_count; segment_num++) {
+        const SegmentGeometry* geometry = &segments[segment_num];
+        const uint32_t* offsets = packet_offsets + (size_t)segment_num * ICER_BITPLANES_TO_COMPRESS_16;
+        uint16_t* segment_start = segment_buffer + padded_w + 1;
+
+        // Missing segments decode as zeros, like the memset image of the RAM decoder
+        memset(segment_buffer, 0, segment_buffer_size);
+
+        /* decompress starting from the msb, and stop whenever there is a missing bitplane; the context
+         * modeller relies on the previously decoded bitplanes to determine a bit's context */
+        for (int lsb = ICER_BITPLANES_TO_COMPRESS_16 - 1; lsb >= 0 && offsets[lsb] != FLASH_PARTITION_NO_PACKET; lsb--) {
+            if (!loadPacket(packet_file, offsets[lsb], packet_buffer, packet_buffer_size)) {
+                poolFree(segment_buffer);
+                return ICER_FATAL_ERROR;
             }
-            
-            // Initialize entropy coder context
-            icer_init_entropy_coder_context(&context, icer_encode_circ_buf, ICER_CIRC_BUF_SIZE,
-                                            (uint8_t *) seg + sizeof(icer_image_segment_typedef), seg->data_length);
-            
-            // Call standard ICER bitplane compression (NO ALGORITHM CHANGES)
-            res = icer_compress_bitplane_uint16(segment_start, segment_w, segment_h, segment_rowstride, &context_model, &context,
-                                               pkt_context);
+            const icer_image_segment_typedef* seg = (const icer_image_segment_typedef*)packet_buffer;
+            plane_context.lsb = (uint8_t)lsb;
+            icer_init_context_model_vals(&context_model, (enum icer_subband_types)plane_context.subband_type);
+            icer_init_entropy_decoder_context(&context, packet_buffer + sizeof(icer_image_segment_typedef),
+                                              seg->data_length);
+            int res = icer_decompress_bitplane_uint16(segment_start, geometry->w, geometry->h, padded_w,
+                                                      &context_model, &context, &plane_context);
             if (res != ICER_RESULT_OK) {
-                output_data->size_used -= sizeof(icer_image_segment_typedef);
-                free(segment_buffer);
-                return res;
+                break;
             }
-            
-            // Calculate output size and update segment
-            data_in_bytes = context.output_ind + (context.output_bit_offset > 0);
-            seg->data_length = context.output_ind * 8 + context.output_bit_offset;
-            seg->data_crc32 = icer_calculate_segment_crc32(seg);
-            seg->crc32 = icer_calculate_packet_crc32(seg);
-            output_data->size_used += data_in_bytes;
-            
-            segments_encoded[segment_num] = seg;
-            
-            segment_num++;
         }
-        partition_row_ind += segment_h;
+
+        for (size_t seg_row = 0; seg_row < geometry->h; seg_row++) {
+            uint16_t* row = segment_start + seg_row * padded_w;
+            icer_from_sign_magnitude_int16(row, geometry->w);
+            if (pkt_context->subband_type == ICER_SUBBAND_LL) {
+                int16_t* signed_pixel = (int16_t*)row;
+                for (size_t col = 0; col < geometry->w; col++) {
+                    signed_pixel[col] = (int16_t)(signed_pixel[col] + (int16_t)ll_mean);
+                }
+            }
+        }
+
+        if (!storeSegment(out_file, file_offset, rowstride, geometry, segment_buffer, padded_w)) {
+            poolFree(segment_buffer);
+            return ICER_FATAL_ERROR;
+        }
     }
-    
-    free(segment_buffer);
+
+    poolFree(segment_buffer);
     return ICER_RESULT_OK;
 }
-
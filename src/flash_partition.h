@@ -34,8 +34,14 @@ extern "C" {
 //    d. Process output normally
 // 2. Output is identical to standard ICER partition function
 //
+// If a segment task pool with more than one worker is set (setSegmentTaskPool()
+// in task_pool.h), segments are encoded in parallel into per-worker buffers and
+// committed in segment order; the output is byte-identical to the serial encoder.
+//
 // RAM Usage: ~segment_w * segment_h * sizeof(uint16_t) per segment
 // For typical segments: ~10-50 KB
+// Parallel: per worker the segment buffer, a private packet buffer of
+// ~segment_w * segment_h / 2 bytes and a 4 KB entropy coder buffer
 int icer_compress_partition_uint16_flash(
     IFile* flash_file,
     size_t file_offset,
@@ -46,5 +52,45 @@ int icer_compress_partition_uint16_flash(
     const icer_image_segment_typedef *segments_encoded[]
 );
 
+// No packet for this segment / bitplane in a packet offset table
+#define FLASH_PARTITION_NO_PACKET 0xFFFFFFFFu
+
+// Flash-based partition decompression, the inverse of icer_compress_partition_uint16_flash
+// Each segment is decoded on its own into a padded segment buffer, converted
+// from sign-magnitude and written into the subband in out_file. Bitplanes are
+// decoded from the msb down and decoding stops at the first missing or
+// undecodable bitplane, exactly as icer_decompress_partition_uint16 does, so
+// the pixels written are those of icer_decompress_image_yuv_uint16.
+//
+// Parameters:
+// - packet_file: Compressed ICER file the packets are read from
+// - packet_offsets: File offset of the packet header of each segment and bitplane,
+//   indexed [segment_num * ICER_BITPLANES_TO_COMPRESS_16 + lsb]
+//   (FLASH_PARTITION_NO_PACKET if missing); packets must have passed both CRC checks
+// - packet_buffer, packet_buffer_size: Room for the largest packet (header + data);
+//   NULL and 0 if the channel has no packets (the segments then decode as zeros)
+// - out_file: Channel file opened for writing (full image, row-major uint16)
+// - file_offset: Byte offset in out_file where the subband starts
+// - params: Partition parameters of the subband
+// - rowstride: Full image width
+// - pkt_context: subband_type and decomp_level of the subband
+// - ll_mean: Added to the decoded pixels of an LL subband (ignored for the others)
+//
+// Returns: ICER_RESULT_OK on success, ICER_FATAL_ERROR on I/O or allocation failure
+//
+// RAM Usage: one padded segment buffer, (segment_w + 2) * (segment_h + 2) * sizeof(uint16_t)
+int icer_decompress_partition_uint16_flash(
+    IFile* packet_file,
+    const uint32_t *packet_offsets,
+    uint8_t *packet_buffer,
+    size_t packet_buffer_size,
+    IFile* out_file,
+    size_t file_offset,
+    const partition_param_typdef *params,
+    size_t rowstride,
+    const icer_packet_context *pkt_context,
+    uint16_t ll_mean
+);
+
 #endif // FLASH_PARTITION_H
 
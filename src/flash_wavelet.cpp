@@ -1,52 +1,23 @@
 #include "flash_wavelet.h"
 #include "filesystem_interface.h"
+#include "memory_arena.h"
+#include "memory_planner.h"
 #include "spresence_sd_filesystem.h"
+#include "io_stats_filesystem.h"
+#include "icer_telemetry.h"
+#include "icer_log.h"
+#include "icer_profile.h"
 #include <SDHCI.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
 #include <limits.h>
-#include <Arduino.h>  // For Serial progress reporting
+#include <Arduino.h>
 
 extern "C" {
 #include "icer.h"
 }
 
-// GNSS RAM allocation wrappers (consistent with flash_icer_compression.cpp)
-#ifdef __arm__
-#include <arch/chip/gnssram.h>
-static bool gnss_ram_available = false;
-
-// Set GNSS RAM availability (called from main.cpp after initialization)
-// This must be called separately for flash_wavelet.cpp
-void setGnssRamAvailable_wavelet(bool available) {
-    gnss_ram_available = available;
-}
-
-static void* gnss_malloc(size_t size) {
-    if (gnss_ram_available) {
-        void* ptr = up_gnssram_malloc(size);
-        if (ptr) return ptr;
-        // Fallback to main RAM if GNSS RAM allocation fails
-    }
-    return malloc(size);
-}
-
-static void gnss_free(void* ptr) {
-    if (ptr) {
-        if (gnss_ram_available) {
-            up_gnssram_free(ptr);
-        } else {
-            free(ptr);
-        }
-    }
-}
-#else
-#define gnss_malloc malloc
-#define gnss_free free
-void setGnssRamAvailable_wavelet(bool available) { (void)available; } // No-op for non-ARM
-#endif
-
 // Apply wavelet transform to image in flash using standard ICER algorithms
 // This streams data to minimize RAM usage while maintaining 100% ICER compatibility
 int streamingWaveletTransform(
@@ -85,20 +56,10 @@ int streamingWaveletTransform(
     const char* temp_file = "_wavelet_temp.tmp";
     
     // Process each stage
-    Serial.print("    Wavelet transform: Processing ");
-    Serial.print(stages);
-    Serial.println(" stages...");
+    ICER_LOG_INFO("    Wavelet transform: Processing %u stages...", stages);
     
     for (uint8_t stage = 0; stage < stages; stage++) {
-        Serial.print("      Stage ");
-        Serial.print(stage + 1);
-        Serial.print(" of ");
-        Serial.print(stages);
-        Serial.print(" (dimensions: ");
-        Serial.print(current_w);
-        Serial.print("x");
-        Serial.print(current_h);
-        Serial.println(")...");
+        ICER_LOG_DEBUG("      Stage %u of %u (dimensions: %zux%zu)...", stage + 1, stages, current_w, current_h);
         
         // Stage 0: read from input_file, write to output_file
         // Subsequent stages: read LL subband from output_file (previous stage), write LL subband back
@@ -112,6 +73,7 @@ int streamingWaveletTransform(
         }
         
         filesystem->remove(temp_file);
+        filesystem->setSizeHint(temp_file, current_w * current_h * sizeof(uint16_t));
         IFile* temp_out = filesystem->open(temp_file, FILE_WRITE);
         if (!temp_out) {
             stage_in->close();
@@ -120,12 +82,16 @@ int streamingWaveletTransform(
             delete input_file;
             return -4;
         }
+        temp_out->reserve(current_w * current_h * sizeof(uint16_t));  // Best effort, see IFile::reserve()
         
         // PHASE 1: Row-wise transform (streaming)
         // Read rows from LL subband region, transform, write to temp file
-        Serial.println("        Phase 1: Row-wise transform...");
+        ICER_LOG_DEBUG("        Phase 1: Row-wise transform...");
+        ioStatsSetPhase(IO_PHASE_WAVELET_ROW);
+        unsigned long pass_start_us = micros();
+        ICER_PROFILE_BEGIN(row_pass);
         size_t row_size = current_w * sizeof(uint16_t);
-        uint16_t* row_buffer = (uint16_t*)malloc(row_size);
+        uint16_t* row_buffer = (uint16_t*)poolAlloc(row_size, MEM_POOL_MAIN);
         if (!row_buffer) {
             temp_out->close();
             delete temp_out;
@@ -136,20 +102,8 @@ int streamingWaveletTransform(
             return -5;
         }
         
-        unsigned long row_start_time = millis();
         for (size_t row = 0; row < current_h; row++) {
-            // Report progress every 50 rows or every 2 seconds
-            if (row % 50 == 0 || (millis() - row_start_time) > 2000) {
-                int progress_percent = (int)((row * 100) / current_h);
-                Serial.print("          Row transform: ");
-                Serial.print(progress_percent);
-                Serial.print("% (row ");
-                Serial.print(row);
-                Serial.print(" of ");
-                Serial.print(current_h);
-                Serial.println(")");
-                row_start_time = millis();
-            }
+            icerReportProgress(ICER_PHASE_WAVELET, row, current_h);
             // Calculate file position: LL subband region starts at (ll_offset_x, ll_offset_y)
             // Row position: (ll_offset_y + row) * width + ll_offset_x
             size_t file_pos = (ll_offset_y + row) * width * sizeof(uint16_t) + ll_offset_x * sizeof(uint16_t);
@@ -158,7 +112,7 @@ int streamingWaveletTransform(
             // Read row from LL subband region
             size_t bytes_read = stage_in->read((uint8_t*)row_buffer, row_size);
             if (bytes_read != row_size) {
-                free(row_buffer);
+                poolFree(row_buffer);
                 temp_out->close();
                 delete temp_out;
                 stage_in->close();
@@ -172,7 +126,7 @@ int streamingWaveletTransform(
             // Apply row-wise transform using exact ICER function
             int res = icer_wavelet_transform_1d_uint16(row_buffer, current_w, 1, filt);
             if (res != ICER_RESULT_OK) {
-                free(row_buffer);
+                poolFree(row_buffer);
                 temp_out->close();
                 delete temp_out;
                 stage_in->close();
@@ -186,7 +140,7 @@ int streamingWaveletTransform(
             // Write transformed row to temp file (compact, no rowstride)
             size_t bytes_written = temp_out->write((uint8_t*)row_buffer, row_size);
             if (bytes_written != row_size) {
-                free(row_buffer);
+                poolFree(row_buffer);
                 temp_out->close();
                 delete temp_out;
                 stage_in->close();
@@ -198,15 +152,20 @@ int streamingWaveletTransform(
             }
         }
         
-        free(row_buffer);
+        poolFree(row_buffer);
         temp_out->close();
         delete temp_out;
         stage_in->close();
         delete stage_in;
-        Serial.println("        Phase 1 complete: Row-wise transform finished");
+        ICER_LOG_DEBUG("        Phase 1 complete: Row-wise transform finished");
         
         // PHASE 2: Column-wise transform (streaming)
-        Serial.println("        Phase 2: Column-wise transform...");
+        ICER_LOG_DEBUG("        Phase 2: Column-wise transform...");
+        ioStatsSetPhase(IO_PHASE_WAVELET_COL);
+        icerTelemetryWaveletPass(stage, false, (uint32_t)(micros() - pass_start_us));
+        ICER_PROFILE_END(row_pass, ICER_ZONE_WAVELET_ROWS);
+        pass_start_us = micros();
+        ICER_PROFILE_BEGIN(col_pass);
         // Read columns from temp file, transform, write to output file
         IFile* temp_in = filesystem->open(temp_file, FILE_READ);
         if (!temp_in) {
@@ -219,12 +178,31 @@ int streamingWaveletTransform(
         // For stage 0, create new output file
         // For subsequent stages, we need to read existing output, update LL subband, write back
         const char* stage_output_file = (stage == 0) ? output_flash_file : "_wavelet_stage_temp.tmp";
+        IFile* stage_out;
         if (stage == 0) {
-            filesystem->remove(output_flash_file);
+            // EDGE CASE: Check for integer overflow in total_size calculation
+            if (width > SIZE_MAX / height || (width * height) > SIZE_MAX / sizeof(uint16_t)) {
+                temp_in->close();
+                delete temp_in;
+                input_file->close();
+                delete input_file;
+                filesystem->remove(temp_file);
+                return -23;  // Integer overflow in total_size calculation
+            }
+            // Output file spans the full image from the start, so the column pass can
+            // seek anywhere in it. The file system reserves the space (fallocate, one
+            // FAT cluster chain, RAM) instead of us writing the zeros chunk by chunk.
+            ICER_LOG_DEBUG("        Initializing output file...");
+            stage_out = filesystem->createPreallocated(output_flash_file, width * height * sizeof(uint16_t));
         } else {
             filesystem->remove(stage_output_file);
+            // The stage copy holds the full image
+            filesystem->setSizeHint(stage_output_file, width * height * sizeof(uint16_t));
+            stage_out = filesystem->open(stage_output_file, FILE_WRITE);
+            if (stage_out) {
+                stage_out->reserve(width * height * sizeof(uint16_t));  // Best effort, see IFile::reserve()
+            }
         }
-        IFile* stage_out = filesystem->open(stage_output_file, FILE_WRITE);
         if (!stage_out) {
             temp_in->close();
             delete temp_in;
@@ -234,47 +212,10 @@ int streamingWaveletTransform(
             return -9;
         }
         
-        // For stage 0, initialize output file with full image size
+        // For stage 0, the output file is already initialized with the full image size
         // For subsequent stages, copy existing output file first, then update LL subband
         if (stage == 0) {
-            // Initialize output file with zeros (full image size)
-            Serial.println("        Initializing output file...");
-            // EDGE CASE: Check for integer overflow in total_size calculation
-            if (width > SIZE_MAX / height || (width * height) > SIZE_MAX / sizeof(uint16_t)) {
-                temp_in->close();
-                delete temp_in;
-                stage_out->close();
-                delete stage_out;
-                input_file->close();
-                delete input_file;
-                filesystem->remove(temp_file);
-                if (stage > 0) {
-                    filesystem->remove(stage_output_file);
-                }
-                return -23;  // Integer overflow in total_size calculation
-            }
-            size_t total_size = width * height * sizeof(uint16_t);
-            uint16_t zero = 0;
-            // Use chunked writes for better performance
-            size_t chunk_size = 4096;  // 4 KB chunks
-            uint8_t* zero_chunk = (uint8_t*)malloc(chunk_size);
-            if (zero_chunk) {
-                memset(zero_chunk, 0, chunk_size);
-                size_t remaining = total_size;
-                while (remaining > 0) {
-                    size_t to_write = (remaining > chunk_size) ? chunk_size : remaining;
-                    stage_out->write(zero_chunk, to_write);
-                    remaining -= to_write;
-                }
-                free(zero_chunk);
-            } else {
-                // Fallback: write zeros one at a time (slower)
-                for (size_t i = 0; i < total_size; i += sizeof(uint16_t)) {
-                    stage_out->write((uint8_t*)&zero, sizeof(uint16_t));
-                }
-            }
-            stage_out->seek(0);  // Reset to beginning
-            Serial.println("        Output file initialized");
+            ICER_LOG_DEBUG("        Output file initialized");
         } else {
             // Copy existing output file to temp, then we'll update LL subband region
             IFile* existing_out = filesystem->open(output_flash_file, FILE_READ);
@@ -304,8 +245,8 @@ int streamingWaveletTransform(
                 return -24;  // Integer overflow in total_size calculation
             }
             size_t total_size = width * height * sizeof(uint16_t);
-            size_t copy_buffer_size = 4096;
-            uint8_t* copy_buffer = (uint8_t*)malloc(copy_buffer_size);
+            size_t copy_buffer_size = currentBufferPlan()->copy_buffer_bytes;
+            uint8_t* copy_buffer = (uint8_t*)poolAlloc(copy_buffer_size, MEM_POOL_MAIN);
             if (!copy_buffer) {
                 existing_out->close();
                 delete existing_out;
@@ -324,7 +265,7 @@ int streamingWaveletTransform(
                 size_t to_read = (remaining > copy_buffer_size) ? copy_buffer_size : remaining;
                 size_t bytes_read = existing_out->read(copy_buffer, to_read);
                 if (bytes_read != to_read) {
-                    free(copy_buffer);
+                    poolFree(copy_buffer);
                     existing_out->close();
                     delete existing_out;
                     temp_in->close();
@@ -339,7 +280,7 @@ int streamingWaveletTransform(
                 }
                 size_t bytes_written = stage_out->write(copy_buffer, bytes_read);
                 if (bytes_written != bytes_read) {
-                    free(copy_buffer);
+                    poolFree(copy_buffer);
                     existing_out->close();
                     delete existing_out;
                     temp_in->close();
@@ -354,21 +295,19 @@ int streamingWaveletTransform(
                 }
                 remaining -= bytes_read;
             }
-            free(copy_buffer);
+            poolFree(copy_buffer);
             existing_out->close();
             delete existing_out;
             stage_out->seek(0);  // Reset to beginning
         }
         
         // CRITICAL OPTIMIZATION: Buffer multiple columns at once to reduce random seeks
-        // Target: Use up to 300 KB for column buffering to dramatically speed up column transform
         // Strategy: Process columns in batches, reading/writing sequentially instead of random access
         
-        // Calculate optimal batch size based on available memory
+        // Batch size comes from the buffer plan (memory_planner.h), which sizes it
+        // from the memory actually free for this frame
         // Each column requires: current_h * sizeof(uint16_t) bytes
-        // With 300 KB available, we can buffer: 300KB / (current_h * 2) columns
-        // But we need to leave some headroom, so target ~280 KB for buffering
-        const size_t MAX_BUFFER_SIZE = 150 * 1024;  // 150 KB max for column buffer (reduced for memory optimization)
+        const size_t MAX_BUFFER_SIZE = currentBufferPlan()->column_batch_bytes;
         
         // EDGE CASE: Check for integer overflow in col_size calculation
         // If current_h * sizeof(uint16_t) would overflow, we can't proceed
@@ -400,16 +339,11 @@ int streamingWaveletTransform(
             max_cols_per_batch = MAX_BUFFER_SIZE / col_size;
         }
         
-        // Ensure we buffer at least 1 column, but cap at reasonable maximum
-        // For very small images, we might buffer all columns at once
-        // For large images, we'll process in batches
+        // Ensure we buffer at least 1 column, and no more than the stage has
+        // With enough memory the whole stage is one batch (a single pass over the file)
         if (max_cols_per_batch < 1) max_cols_per_batch = 1;
         if (max_cols_per_batch > current_w) max_cols_per_batch = current_w;
         
-        // For very large batches, cap at 200 columns to avoid excessive memory usage
-        // This still gives us massive speedup while staying well under 300 KB
-        if (max_cols_per_batch > 200) max_cols_per_batch = 200;
-        
         size_t batch_size = max_cols_per_batch;
         
         // EDGE CASE: Check for integer overflow in buffer size calculation
@@ -424,14 +358,10 @@ int streamingWaveletTransform(
         
         size_t actual_buffer_size = batch_size * col_size;
         
-        Serial.print("        Buffering ");
-        Serial.print(batch_size);
-        Serial.print(" columns at once (");
-        Serial.print(actual_buffer_size / 1024);
-        Serial.println(" KB buffer)");
+        ICER_LOG_DEBUG("        Buffering %zu columns at once (%zu KB buffer)", batch_size, actual_buffer_size / 1024);
         
         // Allocate column buffer for batch processing (in GNSS RAM if available)
-        uint16_t* col_buffer_batch = (uint16_t*)gnss_malloc(actual_buffer_size);
+        uint16_t* col_buffer_batch = (uint16_t*)poolAlloc(actual_buffer_size, MEM_POOL_GNSS);
         if (!col_buffer_batch) {
                 temp_in->close();
                 delete temp_in;
@@ -447,24 +377,9 @@ int streamingWaveletTransform(
         }
         
         // Process columns in batches
-        unsigned long col_start_time = millis();
         for (size_t col_start = 0; col_start < current_w; col_start += batch_size) {
             size_t cols_in_batch = (col_start + batch_size > current_w) ? (current_w - col_start) : batch_size;
-            
-            // Report progress
-            if (col_start % (batch_size * 4) == 0 || (millis() - col_start_time) > 2000) {
-                int progress_percent = (int)((col_start * 100) / current_w);
-                Serial.print("          Column transform: ");
-                Serial.print(progress_percent);
-                Serial.print("% (column ");
-                Serial.print(col_start);
-                Serial.print(" of ");
-                Serial.print(current_w);
-                Serial.print(", batch of ");
-                Serial.print(cols_in_batch);
-                Serial.println(")");
-                col_start_time = millis();
-            }
+            icerReportProgress(ICER_PHASE_WAVELET, col_start, current_w);
             
             // PHASE 2A: Read all columns in batch sequentially (row by row)
             // This is much faster than random seeks - we read entire rows from temp file
@@ -474,7 +389,7 @@ int streamingWaveletTransform(
                 // EDGE CASE: Check for integer overflow in file position calculation
                 // Must check multiplication overflow BEFORE computing row_offset
                 if (current_w > 0 && row > SIZE_MAX / current_w) {
-                    gnss_free(col_buffer_batch);
+                    poolFree(col_buffer_batch);
                 temp_in->close();
                 delete temp_in;
                 stage_out->close();
@@ -492,7 +407,7 @@ int streamingWaveletTransform(
                 if (row_offset > SIZE_MAX / sizeof(uint16_t) || 
                     col_offset > SIZE_MAX / sizeof(uint16_t) ||
                     (row_offset * sizeof(uint16_t)) > SIZE_MAX - (col_offset * sizeof(uint16_t))) {
-                    gnss_free(col_buffer_batch);
+                    poolFree(col_buffer_batch);
                 temp_in->close();
                 delete temp_in;
                 stage_out->close();
@@ -516,7 +431,7 @@ int streamingWaveletTransform(
                 // But check for integer overflow in pointer offset calculation
                 // Note: batch_size is guaranteed to be >= 1 from earlier checks
                 if (batch_size == 0 || row > SIZE_MAX / batch_size || (row * batch_size) > SIZE_MAX - cols_in_batch) {
-                    gnss_free(col_buffer_batch);
+                    poolFree(col_buffer_batch);
                 temp_in->close();
                 delete temp_in;
                 stage_out->close();
@@ -533,7 +448,7 @@ int streamingWaveletTransform(
                 size_t buffer_offset = row * batch_size;
                 size_t bytes_read = temp_in->read((uint8_t*)(col_buffer_batch + buffer_offset), bytes_to_read);
                 if (bytes_read != bytes_to_read) {
-                    gnss_free(col_buffer_batch);
+                    poolFree(col_buffer_batch);
                 temp_in->close();
                 delete temp_in;
                 stage_out->close();
@@ -564,7 +479,7 @@ int streamingWaveletTransform(
                 // This is correct: ICER will access col_ptr[0], col_ptr[batch_size], col_ptr[2*batch_size], etc.
                 int res = icer_wavelet_transform_1d_uint16(col_ptr, current_h, batch_size, filt);
                 if (res != ICER_RESULT_OK) {
-                    gnss_free(col_buffer_batch);
+                    poolFree(col_buffer_batch);
                 temp_in->close();
                 delete temp_in;
                 stage_out->close();
@@ -586,7 +501,7 @@ int streamingWaveletTransform(
                 // EDGE CASE: Check for integer overflow in file position calculation
                 // Check addition overflow first
                 if (ll_offset_y > SIZE_MAX - row) {
-                    gnss_free(col_buffer_batch);
+                    poolFree(col_buffer_batch);
                 temp_in->close();
                 delete temp_in;
                 stage_out->close();
@@ -603,7 +518,7 @@ int streamingWaveletTransform(
                 size_t col_offset = ll_offset_x + col_start;
                 // Check multiplication overflow before computing file position
                 if (width > 0 && row_offset > SIZE_MAX / width) {
-                    gnss_free(col_buffer_batch);
+                    poolFree(col_buffer_batch);
                 temp_in->close();
                 delete temp_in;
                 stage_out->close();
@@ -619,7 +534,7 @@ int streamingWaveletTransform(
                 if ((row_offset * width) > SIZE_MAX / sizeof(uint16_t) ||
                     col_offset > SIZE_MAX / sizeof(uint16_t) ||
                     (row_offset * width * sizeof(uint16_t)) > SIZE_MAX - (col_offset * sizeof(uint16_t))) {
-                    gnss_free(col_buffer_batch);
+                    poolFree(col_buffer_batch);
                 temp_in->close();
                 delete temp_in;
                 stage_out->close();
@@ -640,7 +555,7 @@ int streamingWaveletTransform(
                 // Same bounds check as read operation
                 // Note: batch_size is guaranteed to be >= 1 from earlier checks
                 if (batch_size == 0 || row > SIZE_MAX / batch_size || (row * batch_size) > SIZE_MAX - cols_in_batch) {
-                    gnss_free(col_buffer_batch);
+                    poolFree(col_buffer_batch);
                 temp_in->close();
                 delete temp_in;
                 stage_out->close();
@@ -657,7 +572,7 @@ int streamingWaveletTransform(
                 size_t buffer_offset = row * batch_size;
                 size_t bytes_written = stage_out->write((uint8_t*)(col_buffer_batch + buffer_offset), bytes_to_write);
                 if (bytes_written != bytes_to_write) {
-                    gnss_free(col_buffer_batch);
+                    poolFree(col_buffer_batch);
                 temp_in->close();
                 delete temp_in;
                 stage_out->close();
@@ -673,17 +588,18 @@ int streamingWaveletTransform(
             }
         }
         
-        gnss_free(col_buffer_batch);
+        poolFree(col_buffer_batch);
         temp_in->close();
         delete temp_in;
         stage_out->close();
         delete stage_out;
-        Serial.println("        Phase 2 complete: Column-wise transform finished");
+        ICER_LOG_DEBUG("        Phase 2 complete: Column-wise transform finished");
         
         // For subsequent stages, replace output file with updated version
         if (stage > 0) {
-            Serial.println("        Copying updated output file...");
+            ICER_LOG_DEBUG("        Copying updated output file...");
             filesystem->remove(output_flash_file);
+            filesystem->setSizeHint(output_flash_file, width * height * sizeof(uint16_t));
             // Copy stage_output_file to output_flash_file
             IFile* temp_read = filesystem->open(stage_output_file, FILE_READ);
             IFile* final_write = filesystem->open(output_flash_file, FILE_WRITE);
@@ -709,8 +625,8 @@ int streamingWaveletTransform(
                 return -25;  // Integer overflow in total_size calculation
             }
             size_t total_size = width * height * sizeof(uint16_t);
-            size_t copy_buffer_size = 4096;
-            uint8_t* copy_buffer = (uint8_t*)malloc(copy_buffer_size);
+            size_t copy_buffer_size = currentBufferPlan()->copy_buffer_bytes;
+            uint8_t* copy_buffer = (uint8_t*)poolAlloc(copy_buffer_size, MEM_POOL_MAIN);
             if (!copy_buffer) {
                 temp_read->close();
                 delete temp_read;
@@ -727,7 +643,7 @@ int streamingWaveletTransform(
                 size_t to_read = (remaining > copy_buffer_size) ? copy_buffer_size : remaining;
                 size_t bytes_read = temp_read->read(copy_buffer, to_read);
                 if (bytes_read != to_read) {
-                    free(copy_buffer);
+                    poolFree(copy_buffer);
                     temp_read->close();
                     delete temp_read;
                     final_write->close();
@@ -740,7 +656,7 @@ int streamingWaveletTransform(
                 }
                 size_t bytes_written = final_write->write(copy_buffer, bytes_read);
                 if (bytes_written != bytes_read) {
-                    free(copy_buffer);
+                    poolFree(copy_buffer);
                     temp_read->close();
                     delete temp_read;
                     final_write->close();
@@ -753,21 +669,21 @@ int streamingWaveletTransform(
                 }
                 remaining -= bytes_read;
             }
-            free(copy_buffer);
+            poolFree(copy_buffer);
             temp_read->close();
             delete temp_read;
             final_write->close();
             delete final_write;
             filesystem->remove(stage_output_file);
-            Serial.println("        Output file updated");
+            ICER_LOG_DEBUG("        Output file updated");
         }
         
         // Clean up temp file
         filesystem->remove(temp_file);
         
-        Serial.print("      Stage ");
-        Serial.print(stage + 1);
-        Serial.println(" complete");
+        ICER_LOG_DEBUG("      Stage %u complete", stage + 1);
+        icerTelemetryWaveletPass(stage, true, (uint32_t)(micros() - pass_start_us));
+        ICER_PROFILE_END(col_pass, ICER_ZONE_WAVELET_COLS);
         
         // Update dimensions and offset for next stage (LL subband is always at top-left, offset stays 0)
         // Dimensions halve for next stage's LL subband
@@ -778,11 +694,182 @@ int streamingWaveletTransform(
     
     input_file->close();
     delete input_file;
-    Serial.println("    Wavelet transform complete");
+    ICER_LOG_INFO("    Wavelet transform complete");
     
     return 0;
 }
 
+// Inverse column pass of one stage: the region_w x region_h LL region of
+// flash_file (rowstride width) into temp_file (compact, rowstride region_w)
+static int inverseColumnPass(IFileSystem* filesystem, const char* flash_file, const char* temp_file,
+                             size_t width, size_t region_w, size_t region_h, enum icer_filter_types filt,
+                             size_t column_batch_bytes) {
+    size_t col_size = region_h * sizeof(uint16_t);
+    size_t batch_size = column_batch_bytes / col_size;
+    if (batch_size < 1) batch_size = 1;  // One column at a time is the minimum
+    if (batch_size > region_w) batch_size = region_w;
+
+    IFile* in = filesystem->open(flash_file, FILE_READ);
+    if (!in) {
+        return -2;
+    }
+    IFile* out = filesystem->createPreallocated(temp_file, region_w * region_h * sizeof(uint16_t));
+    if (!out) {
+        in->close();
+        delete in;
+        return -3;
+    }
+    uint16_t* col_buffer_batch = (uint16_t*)poolAlloc(batch_size * col_size, MEM_POOL_GNSS);
+    if (!col_buffer_batch) {
+        out->close();
+        delete out;
+        in->close();
+        delete in;
+        return -4;
+    }
+
+    int result = 0;
+    for (size_t col_start = 0; col_start < region_w && result == 0; col_start += batch_size) {
+        size_t cols_in_batch = (col_start + batch_size > region_w) ? (region_w - col_start) : batch_size;
+        size_t batch_bytes = cols_in_batch * sizeof(uint16_t);
+
+        // Columns are interleaved in the buffer with stride batch_size, as in the forward pass
+        for (size_t row = 0; row < region_h; row++) {
+            in->seek((row * width + col_start) * sizeof(uint16_t));
+            if (in->read((uint8_t*)(col_buffer_batch + row * batch_size), batch_bytes) != batch_bytes) {
+                result = -5;
+                break;
+            }
+        }
+        if (result != 0) {
+            break;
+        }
+
+        // The overflow flag is ignored, as in icer_inverse_wavelet_transform_stages_uint16
+        // callers: lossy data can legitimately reconstruct outside the pixel range
+        for (size_t col_idx = 0; col_idx < cols_in_batch; col_idx++) {
+            icer_inverse_wavelet_transform_1d_uint16(col_buffer_batch + col_idx, region_h, batch_size, filt);
+        }
+
+        for (size_t row = 0; row < region_h; row++) {
+            out->seek((row * region_w + col_start) * sizeof(uint16_t));
+            if (out->write((uint8_t*)(col_buffer_batch + row * batch_size), batch_bytes) != batch_bytes) {
+                result = -6;
+                break;
+            }
+        }
+    }
+
+    poolFree(col_buffer_batch);
+    out->close();
+    delete out;
+    in->close();
+    delete in;
+    return result;
+}
+
+// Inverse row pass of one stage: the compact rows of temp_file back into the
+// LL region of flash_file, clamping negative pixels after the last stage
+static int inverseRowPass(IFileSystem* filesystem, const char* flash_file, const char* temp_file,
+                          size_t width, size_t region_w, size_t region_h, enum icer_filter_types filt,
+                          bool remove_negative) {
+    IFile* in = filesystem->open(temp_file, FILE_READ);
+    if (!in) {
+        return -7;
+    }
+    IFile* out = filesystem->open(flash_file, FILE_WRITE);
+    if (!out) {
+        in->close();
+        delete in;
+        return -8;
+    }
+    size_t row_size = region_w * sizeof(uint16_t);
+    uint16_t* row_buffer = (uint16_t*)poolAlloc(row_size, MEM_POOL_MAIN);
+    if (!row_buffer) {
+        out->close();
+        delete out;
+        in->close();
+        delete in;
+        return -9;
+    }
+
+    int result = 0;
+    for (size_t row = 0; row < region_h; row++) {
+        if (in->read((uint8_t*)row_buffer, row_size) != row_size) {
+            result = -10;
+            break;
+        }
+        icer_inverse_wavelet_transform_1d_uint16(row_buffer, region_w, 1, filt);
+        if (remove_negative) {
+            icer_remove_negative_uint16(row_buffer, region_w, 1);
+        }
+        out->seek(row * width * sizeof(uint16_t));
+        if (out->write((uint8_t*)row_buffer, row_size) != row_size) {
+            result = -11;
+            break;
+        }
+    }
+
+    poolFree(row_buffer);
+    out->close();
+    delete out;
+    in->close();
+    delete in;
+    return result;
+}
+
+// Inverse wavelet transform of an image in flash, in place
+// Mirrors streamingWaveletTransform: the forward transform goes rows then
+// columns per stage from the full image inwards, this goes columns then rows
+// per stage from the smallest LL subband outwards
+int streamingInverseWaveletTransform(
+    IFileSystem* filesystem,
+    const char* flash_file,
+    size_t width,
+    size_t height,
+    uint8_t stages,
+    uint8_t filter_type,
+    size_t column_batch_bytes) {
+
+    if (!filesystem || !flash_file || width == 0 || height == 0) {
+        return -1;
+    }
+    if (width > SIZE_MAX / height || width * height > SIZE_MAX / sizeof(uint16_t)) {
+        return -1;
+    }
+    // Same limit as icer_inverse_wavelet_transform_stages_uint16
+    if (icer_get_dim_n_low_stages(width, stages) < 3 || icer_get_dim_n_low_stages(height, stages) < 3) {
+        return -1;
+    }
+
+    enum icer_filter_types filt = (enum icer_filter_types)filter_type;
+    const char* temp_file = "_iwavelet_temp.tmp";
+
+    ICER_LOG_INFO("    Inverse wavelet transform: Processing %u stages...", stages);
+
+    for (int stage = stages - 1; stage >= 0; stage--) {
+        // LL region this stage reconstructs (the image itself for stage 0)
+        size_t region_w = icer_get_dim_n_low_stages(width, (uint8_t)stage);
+        size_t region_h = icer_get_dim_n_low_stages(height, (uint8_t)stage);
+
+        ioStatsSetPhase(IO_PHASE_WAVELET_COL);
+        filesystem->remove(temp_file);
+        int result = inverseColumnPass(filesystem, flash_file, temp_file, width, region_w, region_h, filt,
+                                       column_batch_bytes);
+        if (result == 0) {
+            ioStatsSetPhase(IO_PHASE_WAVELET_ROW);
+            result = inverseRowPass(filesystem, flash_file, temp_file, width, region_w, region_h, filt, stage == 0);
+        }
+        filesystem->remove(temp_file);
+        if (result != 0) {
+            return result;
+        }
+    }
+
+    ICER_LOG_INFO("    Inverse wavelet transform complete");
+    return 0;
+}
+
 // Backward compatibility wrapper that accepts SDClass*
 int streamingWaveletTransform(
     SDClass* sd_card,
@@ -34,12 +34,6 @@ int streamingWaveletTransform(
     uint8_t filter_type
 );
 
-// Set GNSS RAM availability for wavelet transform buffers
-// This allows column buffering to use GNSS RAM instead of main RAM
-// Must be called before streamingWaveletTransform if GNSS RAM is available
-// Note: This is separate from other setGnssRamAvailable functions due to separate compilation units
-void setGnssRamAvailable_wavelet(bool available);
-
 // Backward compatibility: Wrapper function that accepts SDClass*
 // This creates a temporary IFileSystem wrapper and calls the main function
 // For new code, prefer using IFileSystem* directly
@@ -53,4 +47,28 @@ int streamingWaveletTransform(
     uint8_t filter_type
 );
 
+// Inverse of streamingWaveletTransform, in place
+// flash_file holds a transformed image (as written by streamingWaveletTransform
+// or decoded by decompressYuvWithIcerFlash) and is replaced by the image. Stages
+// are undone from the smallest LL subband outwards; per stage the columns of the
+// LL region are inverse transformed into a compact temporary file and the rows
+// are then inverse transformed back into their place in flash_file.
+// Like icer_decompress_image_yuv_uint16, negative pixels of the reconstructed
+// image are clamped to 0 in the last row pass, so the output is identical to
+// icer_inverse_wavelet_transform_stages_uint16 followed by icer_remove_negative_uint16.
+//
+// RAM usage: one row of the image + one column batch of column_batch_bytes
+// (at least one column of height * sizeof(uint16_t), at most the whole channel)
+//
+// Returns: 0 on success, negative error code on failure
+int streamingInverseWaveletTransform(
+    IFileSystem* filesystem,
+    const char* flash_file,
+    size_t width,
+    size_t height,
+    uint8_t stages,
+    uint8_t filter_type,
+    size_t column_batch_bytes
+);
+
 #endif // FLASH_WAVELET_H
@@ -0,0 +1,388 @@
+#include "handle_cache_filesystem.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// Read-handle cache: a small fixed table of backing read handles shared by
+// lightweight views. Each view keeps its own position and only seeks the shared
+// handle when it is not already where the view wants to read.
+
+// Limits (the pipeline has at most a handful of files open for reading at once)
+#define HANDLE_CACHE_MAX_SLOTS 8
+#define HANDLE_CACHE_MAX_NAME 48
+#define HANDLE_CACHE_VIEW_POOL 8
+
+// One cached backing read handle
+struct HandleCacheSlot {
+    bool used;
+    bool stale;         // Invalidated while views were open, closed with the last view
+    char name[HANDLE_CACHE_MAX_NAME];
+    IFile* handle;
+    size_t handle_pos;  // Current position of handle (saves redundant seeks)
+    int refs;           // Open views on this slot
+    uint32_t last_use;  // For LRU eviction of idle slots
+};
+
+class HandleCacheFileSystem;
+
+// View on a cached read handle
+// Allocated from a static pool by the class operator new, so the open/delete
+// pairs in the packet loop never reach the heap (malloc only if the pool is exhausted).
+class HandleCacheView : public IFile {
+private:
+    HandleCacheFileSystem* fs;
+    HandleCacheSlot* slot;
+    size_t pos;
+
+public:
+    HandleCacheView(HandleCacheFileSystem* owner, HandleCacheSlot* cache_slot)
+        : fs(owner), slot(cache_slot), pos(0) {}
+
+    ~HandleCacheView() override {
+        if (slot) {
+            close();
+        }
+    }
+
+    static void* operator new(size_t size) throw();
+    static void operator delete(void* ptr);
+
+    size_t read(uint8_t* buffer, size_t size) override {
+        if (!slot || !buffer) {
+            return 0;
+        }
+        if (slot->handle_pos != pos) {
+            if (!slot->handle->seek(pos)) {
+                return 0;
+            }
+            slot->handle_pos = pos;
+        }
+        size_t n = slot->handle->read(buffer, size);
+        pos += n;
+        slot->handle_pos = pos;
+        return n;
+    }
+
+    size_t write(const uint8_t* data, size_t size) override {
+        (void)data;
+        (void)size;
+        return 0;  // Read-only
+    }
+
+    bool seek(size_t position) override {
+        if (!slot) {
+            return false;
+        }
+        pos = position;  // The shared handle is moved lazily by read()
+        return true;
+    }
+
+    size_t position() override {
+        return slot ? pos : 0;
+    }
+
+    size_t size() override {
+        return slot ? slot->handle->size() : 0;
+    }
+
+    bool flush() override {
+        return slot != NULL;
+    }
+
+    bool close() override;
+
+    bool isOpen() const override {
+        return slot != NULL;
+    }
+
+    operator bool() const override {
+        return slot != NULL;
+    }
+};
+
+// Static storage for views
+union HandleCacheViewStorage {
+    uint8_t bytes[sizeof(HandleCacheView)];
+    void* align_ptr;
+    uint64_t align_u64;
+};
+static HandleCacheViewStorage view_pool[HANDLE_CACHE_VIEW_POOL];
+static bool view_pool_used[HANDLE_CACHE_VIEW_POOL];
+
+void* HandleCacheView::operator new(size_t size) throw() {
+    if (size == sizeof(HandleCacheView)) {
+        for (int i = 0; i < HANDLE_CACHE_VIEW_POOL; i++) {
+            if (!view_pool_used[i]) {
+                view_pool_used[i] = true;
+                return &view_pool[i];
+            }
+        }
+    }
+    return malloc(size);
+}
+
+void HandleCacheView::operator delete(void* ptr) {
+    HandleCacheViewStorage* storage = (HandleCacheViewStorage*)ptr;
+    if (storage >= view_pool && storage < view_pool + HANDLE_CACHE_VIEW_POOL) {
+        view_pool_used[storage - view_pool] = false;
+        return;
+    }
+    free(ptr);
+}
+
+// Write handle wrapper: forwards everything, drops the cached read handle on close
+class HandleCacheWriteFile : public IFile {
+private:
+    HandleCacheFileSystem* fs;
+    IFile* inner;
+    char name[HANDLE_CACHE_MAX_NAME];
+
+public:
+    HandleCacheWriteFile(HandleCacheFileSystem* owner, IFile* file, const char* filename)
+        : fs(owner), inner(file) {
+        // Names that do not fit are never cached, so there is nothing to invalidate
+        if (strlen(filename) < HANDLE_CACHE_MAX_NAME) {
+            strcpy(name, filename);
+        } else {
+            name[0] = '\0';
+        }
+    }
+
+    ~HandleCacheWriteFile() override {
+        if (inner) {
+            close();
+        }
+    }
+
+    size_t read(uint8_t* buffer, size_t size) override {
+        return inner ? inner->read(buffer, size) : 0;
+    }
+
+    size_t write(const uint8_t* data, size_t size) override {
+        return inner ? inner->write(data, size) : 0;
+    }
+
+    bool seek(size_t position) override {
+        return inner ? inner->seek(position) : false;
+    }
+
+    size_t position() override {
+        return inner ? inner->position() : 0;
+    }
+
+    size_t size() override {
+        return inner ? inner->size() : 0;
+    }
+
+    bool flush() override {
+        return inner ? inner->flush() : false;
+    }
+
+    bool reserve(size_t size) override {
+        return inner ? inner->reserve(size) : false;
+    }
+
+    bool close() override;
+
+    bool isOpen() const override {
+        return inner != NULL;
+    }
+
+    operator bool() const override {
+        return inner != NULL;
+    }
+};
+
+// Handle cache file system implementation
+class HandleCacheFileSystem : public IFileSystem {
+private:
+    IFileSystem* backing;
+    bool owns_backing;
+    uint8_t max_handles;
+    uint32_t tick;
+    HandleCacheSlot slots[HANDLE_CACHE_MAX_SLOTS];
+
+    // Find the live (non-stale) slot for filename
+    HandleCacheSlot* findSlot(const char* filename) {
+        for (uint8_t i = 0; i < max_handles; i++) {
+            HandleCacheSlot* s = &slots[i];
+            if (s->used && !s->stale && strcmp(s->name, filename) == 0) {
+                return s;
+            }
+        }
+        return NULL;
+    }
+
+    // Get an empty slot, evicting the least recently used idle handle if needed
+    // Returns NULL if every slot has open views
+    HandleCacheSlot* claimSlot() {
+        HandleCacheSlot* victim = NULL;
+        for (uint8_t i = 0; i < max_handles; i++) {
+            HandleCacheSlot* s = &slots[i];
+            if (!s->used) {
+                return s;
+            }
+            if (s->refs <= 0 && (!victim || s->last_use < victim->last_use)) {
+                victim = s;
+            }
+        }
+        if (victim) {
+            closeSlot(victim);
+        }
+        return victim;
+    }
+
+    void closeSlot(HandleCacheSlot* slot) {
+        if (slot->handle) {
+            slot->handle->close();
+            delete slot->handle;
+        }
+        memset(slot, 0, sizeof(*slot));
+    }
+
+    // Wrap a backing write handle so its close() invalidates the cache
+    IFile* wrapWriter(IFile* file, const char* filename) {
+        if (!file) {
+            return nullptr;
+        }
+        return new HandleCacheWriteFile(this, file, filename);
+    }
+
+public:
+    HandleCacheFileSystem(IFileSystem* backing_fs, uint8_t handles, bool take_ownership)
+        : backing(backing_fs), owns_backing(take_ownership), max_handles(handles), tick(0) {
+        memset(slots, 0, sizeof(slots));
+    }
+
+    // Destructor: cached handles are closed (views must already be closed)
+    ~HandleCacheFileSystem() override {
+        for (uint8_t i = 0; i < max_handles; i++) {
+            if (slots[i].used) {
+                closeSlot(&slots[i]);
+            }
+        }
+        if (owns_backing && backing) {
+            delete backing;
+        }
+    }
+
+    // Drop the cached handle for filename (deferred until its last view closes)
+    void invalidate(const char* filename) {
+        HandleCacheSlot* slot = findSlot(filename);
+        if (!slot) {
+            return;
+        }
+        if (slot->refs <= 0) {
+            closeSlot(slot);
+        } else {
+            slot->stale = true;
+        }
+    }
+
+    // Called by a view on close()
+    void release(HandleCacheSlot* slot) {
+        slot->refs--;
+        slot->last_use = ++tick;
+        if (slot->refs <= 0 && slot->stale) {
+            closeSlot(slot);
+        }
+    }
+
+    bool begin() override {
+        return backing->begin();
+    }
+
+    IFile* open(const char* filename, int mode) override {
+        if (!filename) {
+            return nullptr;
+        }
+        if (mode != FILE_READ) {
+            invalidate(filename);
+            return wrapWriter(backing->open(filename, mode), filename);
+        }
+
+        HandleCacheSlot* slot = findSlot(filename);
+        if (!slot) {
+            slot = (strlen(filename) < HANDLE_CACHE_MAX_NAME) ? claimSlot() : NULL;
+            if (!slot) {
+                return backing->open(filename, mode);  // Every handle busy: open uncached
+            }
+            slot->handle = backing->open(filename, FILE_READ);
+            if (!slot->handle) {
+                return nullptr;  // Slot stays unused
+            }
+            slot->used = true;
+            strcpy(slot->name, filename);
+            slot->handle_pos = slot->handle->position();
+        }
+
+        HandleCacheView* view = new HandleCacheView(this, slot);
+        if (!view) {
+            return nullptr;
+        }
+        slot->refs++;
+        slot->last_use = ++tick;
+        return view;
+    }
+
+    bool remove(const char* filename) override {
+        if (!filename) {
+            return false;
+        }
+        invalidate(filename);
+        return backing->remove(filename);
+    }
+
+    bool exists(const char* filename) override {
+        if (!filename) {
+            return false;
+        }
+        // A cached handle proves the file exists without a directory lookup
+        return findSlot(filename) != NULL || backing->exists(filename);
+    }
+
+    void setSizeHint(const char* filename, size_t expected_size) override {
+        backing->setSizeHint(filename, expected_size);
+    }
+
+    IFile* createPreallocated(const char* filename, size_t size) override {
+        if (!filename) {
+            return nullptr;
+        }
+        invalidate(filename);
+        return wrapWriter(backing->createPreallocated(filename, size), filename);
+    }
+};
+
+bool HandleCacheView::close() {
+    if (!slot) {
+        return true;  // Already closed
+    }
+    fs->release(slot);
+    slot = NULL;
+    return true;
+}
+
+bool HandleCacheWriteFile::close() {
+    if (!inner) {
+        return true;  // Already closed
+    }
+    bool ok = inner->close();
+    delete inner;
+    inner = NULL;
+    if (name[0] != '\0') {
+        fs->invalidate(name);
+    }
+    return ok;
+}
+
+// Factory function to create a read-handle cache
+IFileSystem* createHandleCacheFileSystem(IFileSystem* backing, uint8_t max_handles, bool take_ownership) {
+    if (!backing || max_handles == 0) {
+        return NULL;
+    }
+    if (max_handles > HANDLE_CACHE_MAX_SLOTS) {
+        max_handles = HANDLE_CACHE_MAX_SLOTS;
+    }
+    return new HandleCacheFileSystem(backing, max_handles, take_ownership);
+}
@@ -0,0 +1,74 @@
+#include "host_path_filesystem.h"
+
+// Host builds only; the Spresense build uses SDHCI
+#ifndef ARDUINO
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+HostPathFileSystem::HostPathFileSystem(const char* root_dir) {
+    root = strdup(root_dir ? root_dir : "");
+    if (root) {
+        size_t len = strlen(root);
+        while (len > 1 && root[len - 1] == '/') {
+            root[--len] = '\0';
+        }
+    }
+}
+
+HostPathFileSystem::~HostPathFileSystem() {
+    free(root);
+}
+
+char* HostPathFileSystem::makePath(const char* filename) const {
+    if (!filename) {
+        return NULL;
+    }
+    size_t root_len = strlen(root);
+    size_t name_len = strlen(filename);
+    char* path = (char*)malloc(root_len + name_len + 2);
+    if (!path) {
+        return NULL;
+    }
+    if (root_len == 0 || filename[0] == '/') {
+        memcpy(path, filename, name_len + 1);
+    } else {
+        memcpy(path, root, root_len);
+        path[root_len] = '/';
+        memcpy(path + root_len + 1, filename, name_len + 1);
+    }
+    return path;
+}
+
+bool HostPathFileSystem::begin() {
+    if (root[0] == '\0') {
+        return true;
+    }
+    struct stat st;
+    return stat(root, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+bool HostPathFileSystem::remove(const char* filename) {
+    char* path = makePath(filename);
+    if (!path) {
+        return false;
+    }
+    bool ok = (unlink(path) == 0);
+    free(path);
+    return ok;
+}
+
+bool HostPathFileSystem::exists(const char* filename) {
+    char* path = makePath(filename);
+    if (!path) {
+        return false;
+    }
+    bool ok = (access(path, F_OK) == 0);
+    free(path);
+    return ok;
+}
+
+#endif // !ARDUINO
@@ -0,0 +1,45 @@
+#ifndef HOST_PATH_FILESYSTEM_H
+#define HOST_PATH_FILESYSTEM_H
+
+#include "filesystem_interface.h"
+
+// Host builds only; the Spresense build uses SDHCI
+#ifndef ARDUINO
+
+// Base of the host file system backends (posix_filesystem.cpp,
+// mmap_filesystem.cpp): resolves file names relative to a root directory, the
+// way the Spresense SD library resolves them relative to the card mount point,
+// and implements everything but open() on those paths.
+class HostPathFileSystem : public IFileSystem {
+private:
+    char* root;  // Directory prefix, without trailing slash ("" = current directory)
+
+protected:
+    // root_dir: Directory used for all files (NULL or "" for current directory)
+    explicit HostPathFileSystem(const char* root_dir);
+
+    // Build "<root>/<filename>" into a newly allocated string (caller frees);
+    // absolute names are taken as they are
+    char* makePath(const char* filename) const;
+
+public:
+    ~HostPathFileSystem() override;
+
+    // false if the root could not be copied; the factories check this
+    bool isValid() const {
+        return root != NULL;
+    }
+
+    // Initialize the file system: the root directory must exist
+    bool begin() override;
+
+    // Remove a file
+    bool remove(const char* filename) override;
+
+    // Check if file exists
+    bool exists(const char* filename) override;
+};
+
+#endif // !ARDUINO
+
+#endif // HOST_PATH_FILESYSTEM_H
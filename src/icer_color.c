@@ -11,6 +11,13 @@ static inline int comp_packet(const void *a, const void *b) {
   return (((icer_packet_context *)a)->priority > ((icer_packet_context *)b)->priority) ? -1 : 1;
 }
 
+static inline void icer_report_phase(icer_output_data_buf_typedef *const output_data, enum icer_encode_phase phase,
+                                     size_t value) {
+    if (output_data->phase_callback != NULL) {
+        output_data->phase_callback(output_data->phase_context, phase, value);
+    }
+}
+
 #ifdef USE_UINT8_FUNCTIONS
 int icer_compress_image_yuv_uint8(uint8_t *y_channel, uint8_t *u_channel, uint8_t *v_channel, size_t image_w,
                                   size_t image_h, uint8_t stages, enum icer_filter_types filt,
@@ -169,7 +176,10 @@ int icer_compress_image_yuv_uint8(uint8_t *y_channel, uint8_t *u_channel, uint8_
             return ICER_FATAL_ERROR;
         }
 
-        icer_generate_partition_parameters(&partition_params, ll_w, ll_h, segments);
+        res = icer_generate_partition_parameters(&partition_params, ll_w, ll_h, segments);
+        if (res != ICER_RESULT_OK) {
+            break;
+        }
         res = icer_compress_partition_uint8(data_start, &partition_params, image_w, &(icer_packets[it]), output_data,
                                             (const icer_image_segment_typedef **) icer_rearrange_segments_8[icer_packets[it].channel][icer_packets[it].decomp_level][icer_packets[it].subband_type][icer_packets[it].lsb]);
         if (res != ICER_RESULT_OK) {
@@ -362,6 +372,60 @@ int icer_decompress_image_yuv_uint8(uint8_t *y_channel, uint8_t *u_channel, uint
 
 #ifdef USE_UINT16_FUNCTIONS
 #ifdef USE_ENCODE_FUNCTIONS
+static inline void set_packet_uint16(icer_packet_context *pkt, uint8_t subband_type, uint8_t stage,
+                                     uint8_t lsb, int chan, uint32_t priority,
+                                     uint16_t ll_mean_val, size_t image_w, size_t image_h) {
+    pkt->subband_type = subband_type;
+    pkt->decomp_level = stage;
+    pkt->ll_mean_val = ll_mean_val;
+    pkt->lsb = lsb;
+    pkt->priority = priority;
+    pkt->image_w = image_w;
+    pkt->image_h = image_h;
+    pkt->channel = chan;
+}
+
+int icer_build_packet_list_uint16(icer_packet_context *packets, size_t max_packets, size_t image_w, size_t image_h,
+                                  uint8_t stages, const uint16_t *ll_mean, size_t *packet_count) {
+    uint32_t priority = 0;
+    size_t ind = 0;
+    for (uint8_t curr_stage = 1;curr_stage <= stages;curr_stage++) {
+        priority = icer_pow_uint(2, curr_stage);
+        for (uint8_t lsb = 0;lsb < ICER_BITPLANES_TO_COMPRESS_16;lsb++) {
+            for (int chan = ICER_CHANNEL_MIN;chan <= ICER_CHANNEL_MAX;chan++) {
+                if (chan == ICER_CHANNEL_Y) priority *= 2;
+
+                set_packet_uint16(&packets[ind], ICER_SUBBAND_HL, curr_stage, lsb, chan, priority << lsb,
+                                  ll_mean[chan], image_w, image_h);
+                ind++; if (ind >= max_packets) return ICER_PACKET_COUNT_EXCEEDED;
+
+                set_packet_uint16(&packets[ind], ICER_SUBBAND_LH, curr_stage, lsb, chan, priority << lsb,
+                                  ll_mean[chan], image_w, image_h);
+                ind++; if (ind >= max_packets) return ICER_PACKET_COUNT_EXCEEDED;
+
+                set_packet_uint16(&packets[ind], ICER_SUBBAND_HH, curr_stage, lsb, chan, ((priority / 2) << lsb) + 1,
+                                  ll_mean[chan], image_w, image_h);
+                ind++; if (ind >= max_packets) return ICER_PACKET_COUNT_EXCEEDED;
+            }
+        }
+    }
+
+    priority = icer_pow_uint(2, stages);
+    for (uint8_t lsb = 0;lsb < ICER_BITPLANES_TO_COMPRESS_16;lsb++) {
+        for (int chan = ICER_CHANNEL_MIN;chan <= ICER_CHANNEL_MAX;chan++) {
+            if (chan == ICER_CHANNEL_Y) priority *= 2;
+
+            set_packet_uint16(&packets[ind], ICER_SUBBAND_LL, stages, lsb, chan, (2 * priority) << lsb,
+                              ll_mean[chan], image_w, image_h);
+            ind++; if (ind >= max_packets) return ICER_PACKET_COUNT_EXCEEDED;
+        }
+    }
+
+    qsort(packets, ind, sizeof(icer_packet_context), comp_packet);
+    *packet_count = ind;
+    return ICER_RESULT_OK;
+}
+
 int icer_compress_image_yuv_uint16(uint16_t *y_channel, uint16_t *u_channel, uint16_t *v_channel, size_t image_w,
                                   size_t image_h, uint8_t stages, enum icer_filter_types filt,
                                   uint8_t segments, icer_output_data_buf_typedef *const output_data) {
@@ -382,6 +446,7 @@ int icer_compress_image_yuv_uint16(uint16_t *y_channel, uint16_t *u_channel, uin
     if (res != ICER_RESULT_OK) return res;
     }
 
+    icer_report_phase(output_data, ICER_ENCODE_PHASE_LL_MEAN, 0);
     size_t ll_w = icer_get_dim_n_low_stages(image_w, stages);
     size_t ll_h = icer_get_dim_n_low_stages(image_h, stages);
 
@@ -407,6 +472,7 @@ int icer_compress_image_yuv_uint16(uint16_t *y_channel, uint16_t *u_channel, uin
         }
     }
 
+    icer_report_phase(output_data, ICER_ENCODE_PHASE_SIGN_MAG, 0);
     int16_t *signed_pixel[ICER_CHANNEL_MAX+1];
     for (size_t row = 0;row < ll_h;row++) {
         signed_pixel[ICER_CHANNEL_Y] = (int16_t*)(y_channel + image_w * row);
@@ -424,67 +490,10 @@ int icer_compress_image_yuv_uint16(uint16_t *y_channel, uint16_t *u_channel, uin
     icer_to_sign_magnitude_int16(u_channel, image_w * image_h);
     icer_to_sign_magnitude_int16(v_channel, image_w * image_h);
 
-    uint32_t priority = 0;
-    uint32_t ind = 0;
-    for (uint8_t curr_stage = 1;curr_stage <= stages;curr_stage++) {
-        priority = icer_pow_uint(2, curr_stage);
-        for (uint8_t lsb = 0;lsb < ICER_BITPLANES_TO_COMPRESS_16;lsb++) {
-            for (int chan = ICER_CHANNEL_MIN;chan <= ICER_CHANNEL_MAX;chan++) {
-                if (chan == ICER_CHANNEL_Y) priority *= 2;
-
-                icer_packets_16[ind].subband_type = ICER_SUBBAND_HL;
-                icer_packets_16[ind].decomp_level = curr_stage;
-                icer_packets_16[ind].ll_mean_val = ll_mean[chan];
-                icer_packets_16[ind].lsb = lsb;
-                icer_packets_16[ind].priority = priority << lsb;
-                icer_packets_16[ind].image_w = image_w;
-                icer_packets_16[ind].image_h = image_h;
-                icer_packets_16[ind].channel = chan;
-                ind++; if (ind >= ICER_MAX_PACKETS_16) return ICER_PACKET_COUNT_EXCEEDED;
-
-                icer_packets_16[ind].subband_type = ICER_SUBBAND_LH;
-                icer_packets_16[ind].decomp_level = curr_stage;
-                icer_packets_16[ind].ll_mean_val = ll_mean[chan];
-                icer_packets_16[ind].lsb = lsb;
-                icer_packets_16[ind].priority = priority << lsb;
-                icer_packets_16[ind].image_w = image_w;
-                icer_packets_16[ind].image_h = image_h;
-                icer_packets_16[ind].channel = chan;
-                ind++; if (ind >= ICER_MAX_PACKETS_16) return ICER_PACKET_COUNT_EXCEEDED;
-
-                icer_packets_16[ind].subband_type = ICER_SUBBAND_HH;
-                icer_packets_16[ind].decomp_level = curr_stage;
-                icer_packets_16[ind].ll_mean_val = ll_mean[chan];
-                icer_packets_16[ind].lsb = lsb;
-                icer_packets_16[ind].priority = ((priority / 2) << lsb) + 1;
-                icer_packets_16[ind].image_w = image_w;
-                icer_packets_16[ind].image_h = image_h;
-                icer_packets_16[ind].channel = chan;
-                ind++; if (ind >= ICER_MAX_PACKETS_16) return ICER_PACKET_COUNT_EXCEEDED;
-            }
-        }
-    }
-
-    priority = icer_pow_uint(2, stages);
-    for (uint8_t lsb = 0;lsb < ICER_BITPLANES_TO_COMPRESS_16;lsb++) {
-        for (int chan = ICER_CHANNEL_MIN;chan <= ICER_CHANNEL_MAX;chan++) {
-            if (chan == ICER_CHANNEL_Y) priority *= 2;
-
-            icer_packets_16[ind].subband_type = ICER_SUBBAND_LL;
-            icer_packets_16[ind].decomp_level = stages;
-            icer_packets_16[ind].ll_mean_val = ll_mean[chan];
-            icer_packets_16[ind].lsb = lsb;
-            icer_packets_16[ind].priority = (2 * priority) << lsb;
-            icer_packets_16[ind].image_w = image_w;
-            icer_packets_16[ind].image_h = image_h;
-            icer_packets_16[ind].channel = chan;
-            ind++;
-            if (ind >= ICER_MAX_PACKETS_16) return ICER_PACKET_COUNT_EXCEEDED;
-        }
-
-    }
-
-    qsort(icer_packets_16, ind, sizeof(icer_packet_context), comp_packet);
+    size_t ind;
+    res = icer_build_packet_list_uint16(icer_packets_16, ICER_MAX_PACKETS_16, image_w, image_h, stages, ll_mean, &ind);
+    if (res != ICER_RESULT_OK) return res;
+    icer_report_phase(output_data, ICER_ENCODE_PHASE_PARTITION, ind);
 
     for (int i = 0;i <= ICER_MAX_DECOMP_STAGES;i++) {
         for (int j = 0;j <= ICER_SUBBAND_MAX;j++) {
@@ -504,6 +513,7 @@ int icer_compress_image_yuv_uint16(uint16_t *y_channel, uint16_t *u_channel, uin
     data_chan[ICER_CHANNEL_U] = u_channel;
     data_chan[ICER_CHANNEL_V] = v_channel;
     uint16_t *data_start;
+    size_t packets_encoded = 0;
     for (size_t it = 0;it < ind;it++) {
         if (icer_packets_16[it].subband_type == ICER_SUBBAND_LL) {
             ll_w = icer_get_dim_n_low_stages(image_w, icer_packets_16[it].decomp_level);
@@ -526,13 +536,18 @@ int icer_compress_image_yuv_uint16(uint16_t *y_channel, uint16_t *u_channel, uin
             return ICER_FATAL_ERROR;
         }
 
-        icer_generate_partition_parameters(&partition_params, ll_w, ll_h, segments);
+        res = icer_generate_partition_parameters(&partition_params, ll_w, ll_h, segments);
+        if (res != ICER_RESULT_OK) {
+            break;
+        }
         res = icer_compress_partition_uint16(data_start, &partition_params, image_w, &(icer_packets_16[it]), output_data,
                                              (const icer_image_segment_typedef **) icer_rearrange_segments_16[icer_packets_16[it].channel][icer_packets_16[it].decomp_level][icer_packets_16[it].subband_type][icer_packets_16[it].lsb]);
         if (res != ICER_RESULT_OK) {
             break;
         }
+        packets_encoded++;
     }
+    icer_report_phase(output_data, ICER_ENCODE_PHASE_REARRANGE, packets_encoded);
 
     size_t rearrange_offset = 0;
     size_t len;
@@ -580,16 +595,15 @@ int icer_compress_image_yuv_uint16(uint16_t *y_channel, uint16_t *u_channel, uin
     if (use_flash) {
         output_data->rearrange_flash_offset = rearrange_offset;
     }
+    icer_report_phase(output_data, ICER_ENCODE_PHASE_DONE, rearrange_offset);
 
     return res;
 }
 #endif
 
 #ifdef USE_DECODE_FUNCTIONS
-int icer_decompress_image_yuv_uint16(uint16_t * const y_channel, uint16_t * const u_channel, uint16_t * const v_channel, size_t *const image_w,
-                                    size_t *const image_h, const size_t image_bufsize, const uint8_t *datastream,
-                                    const size_t data_length, const uint8_t stages, const enum icer_filter_types filt,
-                                    const uint8_t segments) {
+int icer_index_yuv_packets_uint16(const uint8_t *datastream, size_t data_length, size_t *const image_w,
+                                  size_t *const image_h, uint16_t ll_mean[ICER_CHANNEL_MAX + 1]) {
     for (int i = 0;i <= ICER_MAX_DECOMP_STAGES;i++) {
         for (int j = 0;j <= ICER_SUBBAND_MAX;j++) {
             for (int k = 0;k <= ICER_MAX_SEGMENTS;k++) {
@@ -601,13 +615,15 @@ int icer_decompress_image_yuv_uint16(uint16_t * const y_channel, uint16_t * cons
             }
         }
     }
+    for (int chan = ICER_CHANNEL_MIN;chan <= ICER_CHANNEL_MAX;chan++) {
+        ll_mean[chan] = 0;
+    }
 
     const icer_image_segment_typedef *seg = NULL;
     const uint8_t *seg_start;
     size_t offset = 0;
     size_t pkt_offset;
     int res;
-    uint16_t ll_mean[ICER_CHANNEL_MAX + 1];
     while ((data_length - offset) > 0) {
         seg_start = datastream + offset;
         res = icer_find_packet_in_bytestream(&seg, seg_start, data_length - offset, &pkt_offset);
@@ -619,101 +635,107 @@ int icer_decompress_image_yuv_uint16(uint16_t * const y_channel, uint16_t * cons
         }
         offset += pkt_offset;
     }
+    return ICER_RESULT_OK;
+}
 
-    if (image_bufsize < (*image_w) * (*image_h)) {
-        return ICER_BYTE_QUOTA_EXCEEDED;
-    }
-
+int icer_decompress_channel_uint16(uint16_t * const channel, enum icer_color_channels chan, size_t im_w, size_t im_h,
+                                   uint8_t stages, enum icer_filter_types filt, uint8_t segments, uint16_t ll_mean) {
     uint16_t *data_start;
     size_t ll_w;
     size_t ll_h;
-    size_t im_w = *image_w;
-    size_t im_h = *image_h;
-    memset(y_channel, 0, im_w * im_h * sizeof(y_channel[0]));
-    memset(u_channel, 0, im_w * im_h * sizeof(u_channel[0]));
-    memset(v_channel, 0, im_w * im_h * sizeof(v_channel[0]));
-    uint16_t *data_chan[ICER_CHANNEL_MAX + 1];
-    data_chan[ICER_CHANNEL_Y] = y_channel;
-    data_chan[ICER_CHANNEL_U] = u_channel;
-    data_chan[ICER_CHANNEL_V] = v_channel;
+    int res;
+    memset(channel, 0, im_w * im_h * sizeof(channel[0]));
     partition_param_typdef partition_params;
     for (uint8_t curr_stage = 1;curr_stage <= stages;curr_stage++) {
-        for (int chan = ICER_CHANNEL_MIN;chan <= ICER_CHANNEL_MAX;chan++) {
-            if (curr_stage == stages) {
-                /* LL subband */
-                ll_w = icer_get_dim_n_low_stages(im_w, curr_stage);
-                ll_h = icer_get_dim_n_low_stages(im_h, curr_stage);
-                data_start = data_chan[chan];
-
-                res = icer_generate_partition_parameters(&partition_params, ll_w, ll_h, segments);
-                if (res != ICER_RESULT_OK) return res;
-                res = icer_decompress_partition_uint16(data_start, &partition_params, im_w,
-                                                      icer_reconstruct_data_16[chan][curr_stage][ICER_SUBBAND_LL]);
-                if (res != ICER_RESULT_OK) return res;
-            }
-
-            /* HL subband */
-            ll_w = icer_get_dim_n_high_stages(im_w, curr_stage);
-            ll_h = icer_get_dim_n_low_stages(im_h, curr_stage);
-            data_start = data_chan[chan] + icer_get_dim_n_low_stages(im_w, curr_stage);
-
-            res = icer_generate_partition_parameters(&partition_params, ll_w, ll_h, segments);
-            if (res != ICER_RESULT_OK) return res;
-            res = icer_decompress_partition_uint16(data_start, &partition_params, im_w,
-                                                  icer_reconstruct_data_16[chan][curr_stage][ICER_SUBBAND_HL]);
-            if (res != ICER_RESULT_OK) return res;
-
-            /* LH subband */
+        if (curr_stage == stages) {
+            /* LL subband */
             ll_w = icer_get_dim_n_low_stages(im_w, curr_stage);
-            ll_h = icer_get_dim_n_high_stages(im_h, curr_stage);
-            data_start = data_chan[chan] + icer_get_dim_n_low_stages(im_h, curr_stage) * im_w;
-
-            res = icer_generate_partition_parameters(&partition_params, ll_w, ll_h, segments);
-            if (res != ICER_RESULT_OK) return res;
-            res = icer_decompress_partition_uint16(data_start, &partition_params, im_w,
-                                                  icer_reconstruct_data_16[chan][curr_stage][ICER_SUBBAND_LH]);
-            if (res != ICER_RESULT_OK) return res;
-
-            /* HH subband */
-            ll_w = icer_get_dim_n_high_stages(im_w, curr_stage);
-            ll_h = icer_get_dim_n_high_stages(im_h, curr_stage);
-            data_start = data_chan[chan] + icer_get_dim_n_low_stages(im_h, curr_stage) * im_w +
-                         icer_get_dim_n_low_stages(im_w, curr_stage);
+            ll_h = icer_get_dim_n_low_stages(im_h, curr_stage);
+            data_start = channel;
 
             res = icer_generate_partition_parameters(&partition_params, ll_w, ll_h, segments);
             if (res != ICER_RESULT_OK) return res;
             res = icer_decompress_partition_uint16(data_start, &partition_params, im_w,
-                                                  icer_reconstruct_data_16[chan][curr_stage][ICER_SUBBAND_HH]);
+                                                  icer_reconstruct_data_16[chan][curr_stage][ICER_SUBBAND_LL]);
             if (res != ICER_RESULT_OK) return res;
         }
+
+        /* HL subband */
+        ll_w = icer_get_dim_n_high_stages(im_w, curr_stage);
+        ll_h = icer_get_dim_n_low_stages(im_h, curr_stage);
+        data_start = channel + icer_get_dim_n_low_stages(im_w, curr_stage);
+
+        res = icer_generate_partition_parameters(&partition_params, ll_w, ll_h, segments);
+        if (res != ICER_RESULT_OK) return res;
+        res = icer_decompress_partition_uint16(data_start, &partition_params, im_w,
+                                              icer_reconstruct_data_16[chan][curr_stage][ICER_SUBBAND_HL]);
+        if (res != ICER_RESULT_OK) return res;
+
+        /* LH subband */
+        ll_w = icer_get_dim_n_low_stages(im_w, curr_stage);
+        ll_h = icer_get_dim_n_high_stages(im_h, curr_stage);
+        data_start = channel + icer_get_dim_n_low_stages(im_h, curr_stage) * im_w;
+
+        res = icer_generate_partition_parameters(&partition_params, ll_w, ll_h, segments);
+        if (res != ICER_RESULT_OK) return res;
+        res = icer_decompress_partition_uint16(data_start, &partition_params, im_w,
+                                              icer_reconstruct_data_16[chan][curr_stage][ICER_SUBBAND_LH]);
+        if (res != ICER_RESULT_OK) return res;
+
+        /* HH subband */
+        ll_w = icer_get_dim_n_high_stages(im_w, curr_stage);
+        ll_h = icer_get_dim_n_high_stages(im_h, curr_stage);
+        data_start = channel + icer_get_dim_n_low_stages(im_h, curr_stage) * im_w +
+                     icer_get_dim_n_low_stages(im_w, curr_stage);
+
+        res = icer_generate_partition_parameters(&partition_params, ll_w, ll_h, segments);
+        if (res != ICER_RESULT_OK) return res;
+        res = icer_decompress_partition_uint16(data_start, &partition_params, im_w,
+                                              icer_reconstruct_data_16[chan][curr_stage][ICER_SUBBAND_HH]);
+        if (res != ICER_RESULT_OK) return res;
     }
 
-    icer_from_sign_magnitude_int16(y_channel, im_w * im_h);
-    icer_from_sign_magnitude_int16(u_channel, im_w * im_h);
-    icer_from_sign_magnitude_int16(v_channel, im_w * im_h);
+    icer_from_sign_magnitude_int16(channel, im_w * im_h);
 
     ll_w = icer_get_dim_n_low_stages(im_w, stages);
     ll_h = icer_get_dim_n_low_stages(im_h, stages);
-    int16_t *signed_pixel[ICER_CHANNEL_MAX + 1];
+    int16_t *signed_pixel;
     for (size_t row = 0;row < ll_h;row++) {
-        signed_pixel[ICER_CHANNEL_Y] = (int16_t*)(y_channel + im_w * row);
-        signed_pixel[ICER_CHANNEL_U] = (int16_t*)(u_channel + im_w * row);
-        signed_pixel[ICER_CHANNEL_V] = (int16_t*)(v_channel + im_w * row);
+        signed_pixel = (int16_t*)(channel + im_w * row);
         for (size_t col = 0;col < ll_w;col++) {
-            for (int chan = ICER_CHANNEL_MIN;chan <= ICER_CHANNEL_MAX;chan++) {
-                (*signed_pixel[chan]) = (int16_t)(*signed_pixel[chan] + (int16_t)ll_mean[chan]);
-                signed_pixel[chan]++;
-            }
+            (*signed_pixel) = (int16_t)(*signed_pixel + (int16_t)ll_mean);
+            signed_pixel++;
         }
     }
 
-    icer_inverse_wavelet_transform_stages_uint16(y_channel, im_w, im_h, stages, filt);
-    icer_inverse_wavelet_transform_stages_uint16(u_channel, im_w, im_h, stages, filt);
-    icer_inverse_wavelet_transform_stages_uint16(v_channel, im_w, im_h, stages, filt);
+    icer_inverse_wavelet_transform_stages_uint16(channel, im_w, im_h, stages, filt);
+
+    icer_remove_negative_uint16(channel, im_w, im_h);
+    return ICER_RESULT_OK;
+}
 
-    icer_remove_negative_uint16(y_channel, im_w, im_h);
-    icer_remove_negative_uint16(u_channel, im_w, im_h);
-    icer_remove_negative_uint16(v_channel, im_w, im_h);
+int icer_decompress_image_yuv_uint16(uint16_t * const y_channel, uint16_t * const u_channel, uint16_t * const v_channel, size_t *const image_w,
+                                    size_t *const image_h, const size_t image_bufsize, const uint8_t *datastream,
+                                    const size_t data_length, const uint8_t stages, const enum icer_filter_types filt,
+                                    const uint8_t segments) {
+    uint16_t ll_mean[ICER_CHANNEL_MAX + 1];
+    int res = icer_index_yuv_packets_uint16(datastream, data_length, image_w, image_h, ll_mean);
+    if (res != ICER_RESULT_OK) return res;
+
+    if (image_bufsize < (*image_w) * (*image_h)) {
+        return ICER_BYTE_QUOTA_EXCEEDED;
+    }
+
+    /* the channels are independent once the packets are indexed */
+    uint16_t *data_chan[ICER_CHANNEL_MAX + 1];
+    data_chan[ICER_CHANNEL_Y] = y_channel;
+    data_chan[ICER_CHANNEL_U] = u_channel;
+    data_chan[ICER_CHANNEL_V] = v_channel;
+    for (int chan = ICER_CHANNEL_MIN;chan <= ICER_CHANNEL_MAX;chan++) {
+        res = icer_decompress_channel_uint16(data_chan[chan], (enum icer_color_channels)chan, *image_w, *image_h,
+                                             stages, filt, segments, ll_mean[chan]);
+        if (res != ICER_RESULT_OK) return res;
+    }
     return ICER_RESULT_OK;
 }
 #endif
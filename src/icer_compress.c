@@ -134,7 +134,10 @@ int icer_compress_image_uint8(uint8_t * const image, size_t image_w, size_t imag
             return ICER_FATAL_ERROR;
         }
 
-        icer_generate_partition_parameters(&partition_params, ll_w, ll_h, segments);
+        res = icer_generate_partition_parameters(&partition_params, ll_w, ll_h, segments);
+        if (res != ICER_RESULT_OK) {
+            break;
+        }
         res = icer_compress_partition_uint8(data_start, &partition_params, image_w, &(icer_packets[it]), output_data,
                                             (const icer_image_segment_typedef **) icer_rearrange_segments_8[chan][icer_packets[it].decomp_level][icer_packets[it].subband_type][icer_packets[it].lsb]);
         if (res != ICER_RESULT_OK) {
@@ -396,7 +399,10 @@ int icer_compress_image_uint16(uint16_t * const image, size_t image_w, size_t im
             return ICER_FATAL_ERROR;
         }
 
-        icer_generate_partition_parameters(&partition_params, ll_w, ll_h, segments);
+        res = icer_generate_partition_parameters(&partition_params, ll_w, ll_h, segments);
+        if (res != ICER_RESULT_OK) {
+            break;
+        }
         res = icer_compress_partition_uint16(data_start, &partition_params, image_w, &(icer_packets_16[it]),
                                              output_data, (const icer_image_segment_typedef **) icer_rearrange_segments_16[chan][icer_packets_16[it].decomp_level][icer_packets_16[it].subband_type][icer_packets_16[it].lsb]);
         if (res != ICER_RESULT_OK) {
@@ -570,6 +576,11 @@ int icer_find_packet_in_bytestream(const icer_image_segment_typedef **seg, const
     (*offset) = 0;
     (*seg) = NULL;
     while ((*offset) < data_length) {
+        if (data_length - (*offset) < sizeof(icer_image_segment_typedef)) {
+            /* no room left for a packet header; do not read past the end of the datastream */
+            (*offset) = data_length;
+            break;
+        }
         (*seg) = (icer_image_segment_typedef*)(datastream + (*offset));
         if ((*seg)->preamble == ICER_PACKET_PREAMBLE) {
             if ((*seg)->crc32 == icer_calculate_packet_crc32((*seg))) {
@@ -1,6 +1,9 @@
 #include "icer_compression.h"
 #include "memory_monitor.h"
+#include "memory_arena.h"
+#include "icer_telemetry.h"
 #include <SDHCI.h>
+#include <Arduino.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
@@ -8,58 +11,10 @@
 #include <limits.h>
 #include <stdio.h>
 
-// GNSS RAM support - use for ICER buffers to free main RAM for camera
-#ifdef __arm__
-#include <arch/chip/gnssram.h>
-static bool gnss_ram_available = false;
-
-// Wrapper functions to use GNSS RAM if available, fallback to main RAM
-// Note: If GNSS RAM allocation fails, we fall back to main RAM.
-// This means we need to track which pool was used for proper cleanup.
-// For simplicity, we assume GNSS RAM allocations succeed when available.
-// If they don't, we'll use main RAM and free with free().
-static void* gnss_malloc(size_t size) {
-    if (gnss_ram_available) {
-        void* ptr = up_gnssram_malloc(size);
-        if (ptr) return ptr;
-        // Fallback to main RAM if GNSS RAM allocation fails
-        // This should be rare - if GNSS RAM is available, it should have space
-    }
-    return malloc(size);
-}
-
-static void gnss_free(void* ptr) {
-    if (ptr) {
-        if (gnss_ram_available) {
-            // Try GNSS RAM free first
-            // If the pointer was allocated in GNSS RAM, this will succeed
-            // If it was allocated in main RAM (fallback case), up_gnssram_free()
-            // should handle it gracefully (likely a no-op or safe failure)
-            // However, to be safe, we could check pointer ranges, but that's complex
-            // For now, assume GNSS RAM allocations succeed when available
-            up_gnssram_free(ptr);
-        } else {
-            free(ptr);
-        }
-    }
-}
-#else
-// Non-ARM: use standard malloc/free
-#define gnss_malloc malloc
-#define gnss_free free
-#endif
-
 extern "C" {
 #include "icer.h"
 }
 
-// Function to check if GNSS RAM is available (called from main.cpp after initialization)
-void setGnssRamAvailable(bool available) {
-#ifdef __arm__
-    gnss_ram_available = available;
-#endif
-}
-
 // Dynamic ICER buffers when USER_PROVIDED_BUFFERS is defined
 #ifdef USER_PROVIDED_BUFFERS
 #ifdef USE_UINT16_FUNCTIONS
@@ -67,6 +22,10 @@ void setGnssRamAvailable(bool available) {
 icer_packet_context *icer_packets_16 = NULL;
 icer_image_segment_typedef ******icer_rearrange_segments_16 = NULL;
 #endif
+#ifdef USE_DECODE_FUNCTIONS
+// Only the in-memory decoder uses it; the flash decoder keeps its own packet index
+const icer_image_segment_typedef *(*icer_reconstruct_data_16)[ICER_MAX_DECOMP_STAGES + 1][ICER_SUBBAND_MAX + 1][ICER_MAX_SEGMENTS + 1][15] = NULL;
+#endif
 #endif
 #ifdef USE_ENCODE_FUNCTIONS
 uint16_t *icer_encode_circ_buf = NULL;
@@ -100,7 +59,42 @@ static void safe_delete_file(File* file_ptr) {
     }
 }
 
-IcerCompressionResult compressYuvWithIcer(
+// Forward wavelet transform of one channel, as icer_wavelet_transform_stages_uint16()
+// but with the row and column passes of every stage timed for the telemetry
+static int timedWaveletTransform(uint16_t* image, size_t image_w, size_t image_h, uint8_t stages,
+                                 enum icer_filter_types filt) {
+    if (icer_get_dim_n_low_stages(image_w, stages) < 3 || icer_get_dim_n_low_stages(image_h, stages) < 3) {
+        return ICER_TOO_MANY_STAGES;
+    }
+
+    bool overflow = false;
+    size_t low_w = image_w;
+    size_t low_h = image_h;
+    for (uint8_t stage = 0; stage < stages; stage++) {
+        unsigned long pass_start_us = micros();
+        uint16_t* rowstart = image;
+        for (size_t r = 0; r < low_h; r++) {
+            overflow |= (icer_wavelet_transform_1d_uint16(rowstart, low_w, 1, filt) != ICER_RESULT_OK);
+            rowstart += image_w;
+        }
+        icerTelemetryWaveletPass(stage, false, (uint32_t)(micros() - pass_start_us));
+
+        pass_start_us = micros();
+        uint16_t* colstart = image;
+        for (size_t c = 0; c < low_w; c++) {
+            overflow |= (icer_wavelet_transform_1d_uint16(colstart, low_h, image_w, filt) != ICER_RESULT_OK);
+            colstart += 1;
+        }
+        icerTelemetryWaveletPass(stage, true, (uint32_t)(micros() - pass_start_us));
+
+        low_w = low_w / 2 + low_w % 2;
+        low_h = low_h / 2 + low_h % 2;
+    }
+
+    return overflow ? ICER_INTEGER_OVERFLOW : ICER_RESULT_OK;
+}
+
+static IcerCompressionResult compressYuvWithIcerImpl(
     uint16_t* y_channel,
     uint16_t* u_channel,
     uint16_t* v_channel,
@@ -114,7 +108,7 @@ IcerCompressionResult compressYuvWithIcer(
     const char* flash_filename,
     bool channels_pre_transformed) {
     
-    IcerCompressionResult result = {NULL, 0, false, 0, NULL};
+    IcerCompressionResult result = {NULL, 0, false, 0, NULL, NULL, NULL};
     
     if (!y_channel || !u_channel || !v_channel) {
         result.error_code = -100;
@@ -122,25 +116,11 @@ IcerCompressionResult compressYuvWithIcer(
     }
     
     // Initialize ICER buffers (when USER_PROVIDED_BUFFERS is defined)
-    // Allocate ICER buffers dynamically (only when needed)
-    static bool icer_buffers_allocated = false;
-    if (!icer_buffers_allocated) {
-        int alloc_result = allocateIcerBuffers();
-        if (alloc_result != 0) {
-            result.error_code = -120 - alloc_result;  // -121, -122, -123 for allocation failures
-            return result;
-        }
-        icer_buffers_allocated = true;
-    }
-    
-    static bool icer_initialized = false;
-    if (!icer_initialized) {
-        int init_result = icer_init();
-        if (init_result != 0) {
-            result.error_code = init_result;
-            return result;
-        }
-        icer_initialized = true;
+    // Allocated per call: they are freed again at the end of every compression
+    int alloc_result = allocateIcerBuffers();
+    if (alloc_result != 0) {
+        result.error_code = -120 - alloc_result;  // -121, -122, -123 for allocation failures
+        return result;
     }
     
     enum icer_filter_types filt = (enum icer_filter_types)filter_type;
@@ -194,7 +174,7 @@ IcerCompressionResult compressYuvWithIcer(
     
     // Allocate datastream buffer - prefer GNSS RAM to free main RAM for camera
     // Note: This buffer is used during compression, not for DMA, so GNSS RAM is safe
-    uint8_t* datastream = (uint8_t*)gnss_malloc(buffer_size);
+    uint8_t* datastream = (uint8_t*)poolAlloc(buffer_size, MEM_POOL_GNSS);
     if (!datastream) {
         result.error_code = -105;
         return result;
@@ -235,7 +215,7 @@ IcerCompressionResult compressYuvWithIcer(
     int init_result = icer_init_output_struct(&output, datastream, buffer_size, byte_quota);
     if (init_result != ICER_RESULT_OK) {
         safe_delete_file(rearrange_flash_file);
-        gnss_free(datastream);
+        poolFree(datastream);
         result.error_code = init_result;
         return result;
     }
@@ -245,24 +225,43 @@ IcerCompressionResult compressYuvWithIcer(
     if (channels_pre_transformed) {
         output.channels_pre_transformed = 1;  // Set flag to skip wavelet transform
     }
+    output.phase_callback = icerTelemetryPhaseCallback;
     
-    int icer_result = icer_compress_image_yuv_uint16(
-        y_channel, u_channel, v_channel,
-        width, height,
-        stages, filt, segments,
-        &output
-    );
+    // The wavelet transform runs here rather than in ICER so its stages can be timed
+    int icer_result = ICER_RESULT_OK;
+    if (!channels_pre_transformed) {
+        icerTelemetryPhase(ICER_PHASE_WAVELET);
+        icer_result = timedWaveletTransform(y_channel, width, height, stages, filt);
+        if (icer_result == ICER_RESULT_OK) {
+            icer_result = timedWaveletTransform(u_channel, width, height, stages, filt);
+        }
+        if (icer_result == ICER_RESULT_OK) {
+            icer_result = timedWaveletTransform(v_channel, width, height, stages, filt);
+        }
+        output.channels_pre_transformed = 1;
+    }
     
-    // Clear the flag after use (for cleanup)
-    if (channels_pre_transformed) {
-        output.channels_pre_transformed = 0;
+    if (icer_result == ICER_RESULT_OK) {
+        icer_result = icer_compress_image_yuv_uint16(
+            y_channel, u_channel, v_channel,
+            width, height,
+            stages, filt, segments,
+            &output
+        );
+    }
+    if (icer_result == ICER_RESULT_OK || icer_result == ICER_BYTE_QUOTA_EXCEEDED) {
+        icerTelemetryCountSegments();  // Segment data lives in datastream until it is freed below
     }
     
+    // Clear the flag after use (for cleanup)
+    output.channels_pre_transformed = 0;
+    
     // Close flash file if it was opened
     safe_delete_file(rearrange_flash_file);
     rearrange_flash_file = NULL;
     
-    if (icer_result == ICER_RESULT_OK) {
+    // ICER_BYTE_QUOTA_EXCEEDED: the quota was reached and the packets that fit were written
+    if (icer_result == ICER_RESULT_OK || icer_result == ICER_BYTE_QUOTA_EXCEEDED) {
         result.compressed_size = output.size_used;
         if (result.compressed_size > 0) {
             // Check if data was written to flash during rearrange
@@ -270,6 +269,7 @@ IcerCompressionResult compressYuvWithIcer(
             
             if (data_in_flash) {
                 // Data was written to flash during rearrange phase - verify file exists and size matches
+                icerTelemetryPhase(ICER_PHASE_VERIFY);
                 File verify_file = sd_card->open(flash_filename, FILE_READ);
                 if (verify_file) {
                     size_t file_size = verify_file.size();
@@ -277,7 +277,7 @@ IcerCompressionResult compressYuvWithIcer(
                     
                     if (file_size == result.compressed_size) {
                         // Success: data is in flash, not RAM
-                        gnss_free(datastream);  // Free datastream immediately (no longer needed)
+                        poolFree(datastream);  // Free datastream immediately (no longer needed)
                         result.compressed_data = NULL;
                         result.flash_filename = flash_filename;
                         result.success = true;
@@ -285,13 +285,13 @@ IcerCompressionResult compressYuvWithIcer(
                     } else {
                         // File size mismatch - error
                         sd_card->remove(flash_filename);
-                        gnss_free(datastream);
+                        poolFree(datastream);
                         result.compressed_size = 0;
                         result.error_code = -113;  // Flash file size mismatch
                     }
                 } else {
                     // File doesn't exist - error
-                    gnss_free(datastream);
+                    poolFree(datastream);
                     result.compressed_size = 0;
                     result.error_code = -114;  // Flash file not found
                 }
@@ -301,25 +301,25 @@ IcerCompressionResult compressYuvWithIcer(
                 if (compressed_copy) {
                     // Copy data while datastream is still valid
                     memcpy(compressed_copy, output.rearrange_start, result.compressed_size);
-                    gnss_free(datastream);
+                    poolFree(datastream);
                     
                     result.compressed_data = compressed_copy;
                     result.flash_filename = NULL;
                     result.success = true;
                     result.error_code = 0;
                 } else {
-                    gnss_free(datastream);
+                    poolFree(datastream);
                     result.compressed_size = 0;
                     result.error_code = -109;
                 }
             }
         } else {
-            gnss_free(datastream);
+            poolFree(datastream);
             result.success = false;
             result.error_code = -110;
         }
     } else {
-        gnss_free(datastream);
+        poolFree(datastream);
         result.error_code = icer_result;
     }
     
@@ -329,6 +329,29 @@ IcerCompressionResult compressYuvWithIcer(
     return result;
 }
 
+IcerCompressionResult compressYuvWithIcer(
+    uint16_t* y_channel,
+    uint16_t* u_channel,
+    uint16_t* v_channel,
+    size_t width,
+    size_t height,
+    uint8_t stages,
+    uint8_t filter_type,
+    uint8_t segments,
+    size_t target_size,
+    SDClass* sd_card,
+    const char* flash_filename,
+    bool channels_pre_transformed) {
+    icerTelemetryBegin();
+    IcerCompressionResult result = compressYuvWithIcerImpl(y_channel, u_channel, v_channel, width, height,
+                                                           stages, filter_type, segments, target_size,
+                                                           sd_card, flash_filename, channels_pre_transformed);
+    // Attach the telemetry (success or failure); this path does no file system I/O
+    icerTelemetryEnd(NULL);
+    result.telemetry = icerTelemetry();
+    return result;
+}
+
 void freeIcerCompression(IcerCompressionResult* result) {
     if (result) {
         if (result->compressed_data) {
@@ -341,183 +364,94 @@ void freeIcerCompression(IcerCompressionResult* result) {
     }
 }
 
-// Allocate ICER buffers dynamically on the heap (prefer GNSS RAM to free main RAM)
+#ifdef USER_PROVIDED_BUFFERS
+// All ICER buffers live in one bump arena block (see allocateIcerBuffers)
+static BumpArena icer_arena = { NULL, 0, 0 };
+
+// Number of lsb entries per subband in the rearrange structure
+#define ICER_REARRANGE_LSB_COUNT 15
+
+// Size of the arena holding every ICER buffer
+static size_t icerArenaSize(void) {
+    const size_t chans = ICER_CHANNEL_MAX + 1;
+    const size_t stages = ICER_MAX_DECOMP_STAGES + 1;
+    const size_t subbands = ICER_SUBBAND_MAX + 1;
+    size_t size = bumpAlignedSize(sizeof(icer_packet_context) * ICER_MAX_PACKETS_16);
+    size += bumpAlignedSize(chans * sizeof(icer_image_segment_typedef*****));
+    size += chans * bumpAlignedSize(stages * sizeof(icer_image_segment_typedef****));
+    size += chans * stages * bumpAlignedSize(subbands * sizeof(icer_image_segment_typedef***));
+    size += chans * stages * subbands *
+            bumpAlignedSize(ICER_REARRANGE_LSB_COUNT * sizeof(icer_image_segment_typedef**));
+    size += chans * stages * subbands * ICER_REARRANGE_LSB_COUNT *
+            bumpAlignedSize((ICER_MAX_SEGMENTS + 1) * sizeof(icer_image_segment_typedef*));
+    size += bumpAlignedSize(sizeof(uint16_t) * ICER_CIRC_BUF_SIZE);
+    return size;
+}
+#endif
+
+// Allocate ICER buffers (prefer GNSS RAM to free main RAM for camera)
+// The packets, the circular buffer and the nested rearrange structure
+// ([chan][stage][subband][lsb][seg] built from pointer arrays, as ICER expects)
+// are carved out of a single block, so allocation is one pool call instead of
+// ~1400 small ones and the buffers cannot fragment GNSS RAM between frames.
 int allocateIcerBuffers(void) {
 #ifdef USER_PROVIDED_BUFFERS
-    // Allocate packets buffer (1D array - simple)
-    // Use GNSS RAM if available to free main RAM for camera
-    if (!icer_packets_16) {
-        icer_packets_16 = (icer_packet_context*)gnss_malloc(sizeof(icer_packet_context) * ICER_MAX_PACKETS_16);
-        if (!icer_packets_16) return -1;
+    if (icer_arena.base) {
+        return 0;  // Already allocated
     }
-    
-    // Allocate rearrange_segments buffer (5D array: [chan][stage][subband][lsb][seg])
-    // We need to allocate it as a proper multi-dimensional structure with nested pointers
-    if (!icer_rearrange_segments_16) {
-        // Allocate the top-level array of pointers (channels)
-        // Use GNSS RAM if available to free main RAM for camera
-        icer_rearrange_segments_16 = (icer_image_segment_typedef******)gnss_malloc(
-            (ICER_CHANNEL_MAX + 1) * sizeof(icer_image_segment_typedef*****)
+    if (!bumpArenaInit(&icer_arena, icerArenaSize(), MEM_POOL_GNSS)) {
+        return -1;
+    }
+
+    // Packets buffer (1D array)
+    icer_packets_16 = (icer_packet_context*)bumpAlloc(&icer_arena, sizeof(icer_packet_context) * ICER_MAX_PACKETS_16);
+
+    // Rearrange segments buffer (5D array of nested pointers)
+    icer_rearrange_segments_16 = (icer_image_segment_typedef******)bumpAlloc(
+        &icer_arena, (ICER_CHANNEL_MAX + 1) * sizeof(icer_image_segment_typedef*****)
+    );
+    for (int chan = 0; chan <= ICER_CHANNEL_MAX; chan++) {
+        icer_rearrange_segments_16[chan] = (icer_image_segment_typedef*****)bumpAlloc(
+            &icer_arena, (ICER_MAX_DECOMP_STAGES + 1) * sizeof(icer_image_segment_typedef****)
         );
-        if (!icer_rearrange_segments_16) {
-            gnss_free(icer_packets_16);
-            icer_packets_16 = NULL;
-            return -2;
-        }
-        
-        // Allocate each channel level
-        for (int chan = 0; chan <= ICER_CHANNEL_MAX; chan++) {
-            icer_rearrange_segments_16[chan] = (icer_image_segment_typedef*****)gnss_malloc(
-                (ICER_MAX_DECOMP_STAGES + 1) * sizeof(icer_image_segment_typedef****)
+        for (int stage = 0; stage <= ICER_MAX_DECOMP_STAGES; stage++) {
+            icer_rearrange_segments_16[chan][stage] = (icer_image_segment_typedef****)bumpAlloc(
+                &icer_arena, (ICER_SUBBAND_MAX + 1) * sizeof(icer_image_segment_typedef***)
             );
-            if (!icer_rearrange_segments_16[chan]) {
-                // Cleanup on failure
-                for (int i = 0; i < chan; i++) {
-                    gnss_free(icer_rearrange_segments_16[i]);
-                }
-                gnss_free(icer_rearrange_segments_16);
-                icer_rearrange_segments_16 = NULL;
-                gnss_free(icer_packets_16);
-                icer_packets_16 = NULL;
-                return -2;
-            }
-            
-            // Allocate each stage level
-            for (int stage = 0; stage <= ICER_MAX_DECOMP_STAGES; stage++) {
-                icer_rearrange_segments_16[chan][stage] = (icer_image_segment_typedef****)gnss_malloc(
-                    (ICER_SUBBAND_MAX + 1) * sizeof(icer_image_segment_typedef***)
+            for (int subband = 0; subband <= ICER_SUBBAND_MAX; subband++) {
+                icer_rearrange_segments_16[chan][stage][subband] = (icer_image_segment_typedef***)bumpAlloc(
+                    &icer_arena, ICER_REARRANGE_LSB_COUNT * sizeof(icer_image_segment_typedef**)
                 );
-                if (!icer_rearrange_segments_16[chan][stage]) {
-                    // Cleanup on failure
-                    for (int i = 0; i < stage; i++) {
-                        gnss_free(icer_rearrange_segments_16[chan][i]);
-                    }
-                    gnss_free(icer_rearrange_segments_16[chan]);
-                    for (int i = 0; i < chan; i++) {
-                        gnss_free(icer_rearrange_segments_16[i]);
-                    }
-                    gnss_free(icer_rearrange_segments_16);
-                    icer_rearrange_segments_16 = NULL;
-                    gnss_free(icer_packets_16);
-                    icer_packets_16 = NULL;
-                    return -2;
-                }
-                
-                // Allocate each subband level
-                for (int subband = 0; subband <= ICER_SUBBAND_MAX; subband++) {
-                    icer_rearrange_segments_16[chan][stage][subband] = (icer_image_segment_typedef***)gnss_malloc(
-                        15 * sizeof(icer_image_segment_typedef**)
+                for (int lsb = 0; lsb < ICER_REARRANGE_LSB_COUNT; lsb++) {
+                    // Array of (ICER_MAX_SEGMENTS + 1) segment pointers, initially NULL
+                    icer_rearrange_segments_16[chan][stage][subband][lsb] = (icer_image_segment_typedef**)bumpAlloc(
+                        &icer_arena, (ICER_MAX_SEGMENTS + 1) * sizeof(icer_image_segment_typedef*)
                     );
-                    if (!icer_rearrange_segments_16[chan][stage][subband]) {
-                        // Cleanup on failure
-                        for (int s = 0; s < subband; s++) {
-                            gnss_free(icer_rearrange_segments_16[chan][stage][s]);
-                        }
-                        gnss_free(icer_rearrange_segments_16[chan][stage]);
-                        for (int i = 0; i < stage; i++) {
-                            gnss_free(icer_rearrange_segments_16[chan][i]);
-                        }
-                        gnss_free(icer_rearrange_segments_16[chan]);
-                        for (int i = 0; i < chan; i++) {
-                            gnss_free(icer_rearrange_segments_16[i]);
-                        }
-                        gnss_free(icer_rearrange_segments_16);
-                        icer_rearrange_segments_16 = NULL;
-                        gnss_free(icer_packets_16);
-                        icer_packets_16 = NULL;
-                        return -2;
-                    }
-                    
-                    // Allocate the final level (segments array) for each lsb
-                    // This is an array of pointers: icer_image_segment_typedef* [ICER_MAX_SEGMENTS + 1]
-                    for (int lsb = 0; lsb < 15; lsb++) {
-                        // Allocate array of (ICER_MAX_SEGMENTS + 1) pointers
-                        icer_rearrange_segments_16[chan][stage][subband][lsb] = (icer_image_segment_typedef**)gnss_malloc(
-                            (ICER_MAX_SEGMENTS + 1) * sizeof(icer_image_segment_typedef*)
-                        );
-                        if (!icer_rearrange_segments_16[chan][stage][subband][lsb]) {
-                            // Cleanup on failure
-                            for (int l = 0; l < lsb; l++) {
-                                gnss_free(icer_rearrange_segments_16[chan][stage][subband][l]);
-                            }
-                            gnss_free(icer_rearrange_segments_16[chan][stage][subband]);
-                            for (int s = 0; s < subband; s++) {
-                                gnss_free(icer_rearrange_segments_16[chan][stage][s]);
-                            }
-                            gnss_free(icer_rearrange_segments_16[chan][stage]);
-                            for (int i = 0; i < stage; i++) {
-                                gnss_free(icer_rearrange_segments_16[chan][i]);
-                            }
-                            gnss_free(icer_rearrange_segments_16[chan]);
-                            for (int i = 0; i < chan; i++) {
-                                gnss_free(icer_rearrange_segments_16[i]);
-                            }
-                            gnss_free(icer_rearrange_segments_16);
-                            icer_rearrange_segments_16 = NULL;
-                            gnss_free(icer_packets_16);
-                            icer_packets_16 = NULL;
-                            return -2;
-                        }
-                        // Initialize all pointers to NULL
-                        memset(icer_rearrange_segments_16[chan][stage][subband][lsb], 0, 
-                               (ICER_MAX_SEGMENTS + 1) * sizeof(icer_image_segment_typedef*));
-                    }
+                    memset(icer_rearrange_segments_16[chan][stage][subband][lsb], 0,
+                           (ICER_MAX_SEGMENTS + 1) * sizeof(icer_image_segment_typedef*));
                 }
             }
         }
     }
-    
-    // Allocate circular buffer (1D array - simple)
-    // Use GNSS RAM if available to free main RAM for camera
+
+    // Circular buffer (1D array)
+    icer_encode_circ_buf = (uint16_t*)bumpAlloc(&icer_arena, sizeof(uint16_t) * ICER_CIRC_BUF_SIZE);
     if (!icer_encode_circ_buf) {
-        icer_encode_circ_buf = (uint16_t*)gnss_malloc(sizeof(uint16_t) * ICER_CIRC_BUF_SIZE);
-        if (!icer_encode_circ_buf) {
-            freeIcerBuffers();  // Cleanup what we've allocated so far
-            return -3;
-        }
+        // Arena was sized by icerArenaSize(), so this means the two disagree
+        freeIcerBuffers();
+        return -3;
     }
 #endif
     return 0;
 }
 
-// Free ICER buffers (use gnss_free which handles both GNSS RAM and main RAM)
+// Free ICER buffers (returns the arena block to the pool it came from)
 void freeIcerBuffers(void) {
 #ifdef USER_PROVIDED_BUFFERS
-    if (icer_packets_16) {
-        gnss_free(icer_packets_16);
-        icer_packets_16 = NULL;
-    }
-    
-    if (icer_rearrange_segments_16) {
-        // Free the nested multi-dimensional structure
-        for (int chan = 0; chan <= ICER_CHANNEL_MAX; chan++) {
-            if (icer_rearrange_segments_16[chan]) {
-                for (int stage = 0; stage <= ICER_MAX_DECOMP_STAGES; stage++) {
-                    if (icer_rearrange_segments_16[chan][stage]) {
-                        for (int subband = 0; subband <= ICER_SUBBAND_MAX; subband++) {
-                            if (icer_rearrange_segments_16[chan][stage][subband]) {
-                                for (int lsb = 0; lsb < 15; lsb++) {
-                                    if (icer_rearrange_segments_16[chan][stage][subband][lsb]) {
-                                        gnss_free(icer_rearrange_segments_16[chan][stage][subband][lsb]);
-                                    }
-                                }
-                                gnss_free(icer_rearrange_segments_16[chan][stage][subband]);
-                            }
-                        }
-                        gnss_free(icer_rearrange_segments_16[chan][stage]);
-                    }
-                }
-                gnss_free(icer_rearrange_segments_16[chan]);
-            }
-        }
-        gnss_free(icer_rearrange_segments_16);
-        icer_rearrange_segments_16 = NULL;
-    }
-    
-    if (icer_encode_circ_buf) {
-        gnss_free(icer_encode_circ_buf);
-        icer_encode_circ_buf = NULL;
-    }
+    bumpArenaRelease(&icer_arena);
+    icer_packets_16 = NULL;
+    icer_rearrange_segments_16 = NULL;
+    icer_encode_circ_buf = NULL;
 #endif
 }
 
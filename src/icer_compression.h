@@ -8,6 +8,8 @@
 // Forward declarations
 class File;
 class SDClass;
+struct IoStats;
+struct IcerTelemetry;
 
 // ICER compression result
 // If flash_filename is non-NULL, compressed_data is NULL and data is in flash
@@ -18,6 +20,10 @@ typedef struct {
     bool success;
     int error_code;
     const char* flash_filename;    // Non-NULL if result is stored in flash
+    const IoStats* io_stats;       // I/O counters at the end of the run (flash path with an
+                                   // I/O statistics file system only, see io_stats_filesystem.h)
+    const IcerTelemetry* telemetry; // Phase times, packet/segment counts, peak RAM and output bytes
+                                   // of the run (valid until the next compression, see icer_telemetry.h)
 } IcerCompressionResult;
 
 // Compress YUV image using ICER
@@ -45,15 +51,12 @@ IcerCompressionResult compressYuvWithIcer(
 void freeIcerCompression(IcerCompressionResult* result);
 
 // Allocate ICER static buffers dynamically (only when needed)
+// All buffers share one block from the memory pools, GNSS RAM preferred
 // Returns 0 on success, negative error code on failure
 int allocateIcerBuffers(void);
 
 // Free ICER static buffers (call after compression is complete)
 void freeIcerBuffers(void);
 
-// Set GNSS RAM availability (call after up_gnssram_initialize() in main.cpp)
-// If true, ICER buffers will be allocated in GNSS RAM to free main RAM for camera
-void setGnssRamAvailable(bool available);
-
 #endif // ICER_COMPRESSION_H
 
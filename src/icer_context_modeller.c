@@ -1,4 +1,5 @@
 #include "icer.h"
+#include "icer_profile.h"
 
 #ifdef USE_UINT8_FUNCTIONS
 static inline uint8_t get_bit_category_uint8(const uint8_t* data, uint8_t lsb);
@@ -7,9 +8,65 @@ static inline int8_t get_sign_uint8(const uint8_t* data, uint8_t lsb);
 #endif
 
 #ifdef USE_UINT16_FUNCTIONS
+#if defined(__GNUC__)
+#define ICER_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define ICER_ALWAYS_INLINE inline
+#endif
+
+/*
+ * packed significance state of the three rows around the current pixel, one bit per pixel
+ * above_lsb: row above, significance at lsb (already coded in this plane)
+ * cur_lsb: current row, significance at lsb, filled in as the row is coded
+ * cur_prev, below_prev: current row and row below, significance at the previous plane
+ */
+typedef struct {
+    uint32_t buf[4][ICER_SIG_MAP_WORDS + 1];
+    uint32_t *above_lsb;
+    uint32_t *cur_lsb;
+    uint32_t *cur_prev;
+    uint32_t *below_prev;
+    size_t words;
+} icer_significance_rows_typedef;
+
 static inline uint8_t get_bit_category_uint16(const uint16_t* data, uint8_t lsb);
 static inline bool get_bit_significance_uint16(const uint16_t* data, uint8_t lsb);
 static inline int8_t get_sign_uint16(const uint16_t* data, uint8_t lsb);
+static inline void clear_significance_row(uint32_t *sig, size_t words);
+static inline void build_significance_row_uint16(uint32_t *sig, size_t words, const uint16_t *row, size_t plane_w, uint8_t plane);
+static inline uint32_t get_significance_bit(const uint32_t *sig, size_t bit_ind);
+static inline uint32_t get_significance_window(const uint32_t *sig, size_t col);
+static inline void init_significance_rows_uint16(icer_significance_rows_typedef *rows, const uint16_t *data, size_t plane_w,
+                                                 size_t plane_h, size_t rowstride, uint8_t prev_plane);
+static inline void advance_significance_rows_uint16(icer_significance_rows_typedef *rows, const uint16_t *rowstart, size_t row,
+                                                    size_t plane_w, size_t plane_h, size_t rowstride, uint8_t prev_plane);
+static ICER_ALWAYS_INLINE enum icer_pixel_contexts get_magnitude_context(const icer_significance_rows_typedef *rows, size_t col,
+                                                                         int category, enum icer_subband_types subband_type);
+static ICER_ALWAYS_INLINE enum icer_pixel_contexts get_sign_context_uint16(const icer_significance_rows_typedef *rows,
+                                                                           const uint16_t *pos, size_t col, size_t rowstride,
+                                                                           enum icer_subband_types subband_type,
+                                                                           uint8_t *pred_sign);
+static inline void update_context_model(icer_context_model_typedef *context_model, enum icer_pixel_contexts cntxt, bool bit);
+#ifdef USE_ENCODE_FUNCTIONS
+static ICER_ALWAYS_INLINE int compress_bitplane_kernel_uint16(const uint16_t *data, size_t plane_w, size_t plane_h, size_t rowstride,
+                                                              icer_context_model_typedef *context_model,
+                                                              icer_encoder_context_typedef *encoder_context,
+                                                              uint8_t lsb, enum icer_subband_types subband_type);
+static int compress_bitplane_unpacked_uint16(const uint16_t *data, size_t plane_w, size_t plane_h, size_t rowstride,
+                                             icer_context_model_typedef *context_model,
+                                             icer_encoder_context_typedef *encoder_context,
+                                             const icer_packet_context *pkt_context);
+#endif
+#ifdef USE_DECODE_FUNCTIONS
+static ICER_ALWAYS_INLINE int decompress_bitplane_kernel_uint16(uint16_t *data, size_t plane_w, size_t plane_h, size_t rowstride,
+                                                                icer_context_model_typedef *context_model,
+                                                                icer_decoder_context_typedef *decoder_context,
+                                                                uint8_t lsb, enum icer_subband_types subband_type);
+static int decompress_bitplane_unpacked_uint16(uint16_t * const data, size_t plane_w, size_t plane_h, size_t rowstride,
+                                               icer_context_model_typedef *context_model,
+                                               icer_decoder_context_typedef *decoder_context,
+                                               const icer_packet_context *pkt_context);
+#endif
 #endif
 
 #ifdef USE_UINT8_FUNCTIONS
@@ -309,6 +366,111 @@ int icer_compress_bitplane_uint16(const uint16_t *data, size_t plane_w, size_t p
                                   icer_context_model_typedef *context_model,
                                   icer_encoder_context_typedef *encoder_context,
                                   const icer_packet_context *pkt_context) {
+    uint8_t lsb = pkt_context->lsb;
+    uint8_t prev_plane = lsb+1;
+    if (prev_plane >= 16) return ICER_BITPLANE_OUT_OF_RANGE;
+
+    ICER_PROFILE_BEGIN(bitplane);
+    int res;
+    if (plane_w > ICER_SIG_MAP_MAX_WIDTH) {
+        res = compress_bitplane_unpacked_uint16(data, plane_w, plane_h, rowstride, context_model, encoder_context,
+                                                pkt_context);
+    } else {
+        /* one copy of the kernel per context table layout, so the subband type is not tested per pixel */
+        switch (context_model->subband_type) {
+            case ICER_SUBBAND_HL:
+                res = compress_bitplane_kernel_uint16(data, plane_w, plane_h, rowstride, context_model, encoder_context,
+                                                      lsb, ICER_SUBBAND_HL);
+                break;
+            case ICER_SUBBAND_HH:
+                res = compress_bitplane_kernel_uint16(data, plane_w, plane_h, rowstride, context_model, encoder_context,
+                                                      lsb, ICER_SUBBAND_HH);
+                break;
+            default:
+                /* LL and LH share the same tables */
+                res = compress_bitplane_kernel_uint16(data, plane_w, plane_h, rowstride, context_model, encoder_context,
+                                                      lsb, ICER_SUBBAND_LL);
+                break;
+        }
+    }
+    ICER_PROFILE_END(bitplane, ICER_ZONE_BITPLANE);
+    return res;
+}
+
+/*
+ * the packed significance rows have clear guard bits around the segment and the sign prediction only
+ * reads neighbours that are significant, so the pixel loop needs no boundary tests at all
+ */
+static ICER_ALWAYS_INLINE int compress_bitplane_kernel_uint16(const uint16_t *data, size_t plane_w, size_t plane_h, size_t rowstride,
+                                                              icer_context_model_typedef *context_model,
+                                                              icer_encoder_context_typedef *encoder_context,
+                                                              uint8_t lsb, enum icer_subband_types subband_type) {
+    int res;
+    const uint16_t *pos;
+    const uint16_t *rowstart = data;
+    int category;
+    bool bit;
+    uint16_t mask = 0b1 << lsb;
+    uint8_t prev_plane = lsb+1;
+
+    enum icer_pixel_contexts cntxt, sign_context;
+    uint8_t pred_sign, actual_sign, agreement_bit;
+    icer_significance_rows_typedef rows;
+
+    init_significance_rows_uint16(&rows, data, plane_w, plane_h, rowstride, prev_plane);
+
+    for (size_t row = 0; row < plane_h; row++) {
+        pos = rowstart;
+
+        for (size_t col = 0; col < plane_w; col++) {
+            category = get_bit_category_uint16(pos, lsb);
+            bit = ((*pos) & mask) != 0;
+
+            if (category == ICER_CATEGORY_3) {
+                /* pass to uncoded bin */
+                res = icer_encode_bit(encoder_context, bit, 1, 2);
+                if (res != ICER_RESULT_OK) return res;
+            } else {
+                cntxt = get_magnitude_context(&rows, col, category, subband_type);
+
+                res = icer_encode_bit(encoder_context, bit, context_model->zero_count[cntxt], context_model->total_count[cntxt]);
+                if (res != ICER_RESULT_OK) return res;
+                update_context_model(context_model, cntxt, bit);
+
+                if (category == ICER_CATEGORY_0 && bit) {
+                    /* bit is the first magnitude bit to be encoded, thus we will encode the sign bit */
+                    sign_context = get_sign_context_uint16(&rows, pos, col, rowstride, subband_type, &pred_sign);
+                    actual_sign = ((*pos) & 0x8000) != 0;
+
+                    agreement_bit = (pred_sign ^ actual_sign) & 1;
+
+                    res = icer_encode_bit(encoder_context, agreement_bit, context_model->zero_count[sign_context], context_model->total_count[sign_context]);
+                    if (res != ICER_RESULT_OK) return res;
+                    update_context_model(context_model, sign_context, agreement_bit);
+                }
+            }
+
+            /* a pixel is significant at lsb if it already was, or if this plane's bit is its first magnitude bit */
+            rows.cur_lsb[(col + 1) >> 5] |= (uint32_t)((category != ICER_CATEGORY_0) | bit) << ((col + 1) & 31);
+
+            pos++;
+        }
+
+        advance_significance_rows_uint16(&rows, rowstart, row, plane_w, plane_h, rowstride, prev_plane);
+        rowstart += rowstride;
+    }
+    while (encoder_context->used > 0) {
+        res = icer_flush_encode(encoder_context);
+        if (res != ICER_RESULT_OK) return res;
+    }
+    return ICER_RESULT_OK;
+}
+
+/* reference coder for segments wider than ICER_SIG_MAP_MAX_WIDTH, tests and reads every neighbour in the image */
+static int compress_bitplane_unpacked_uint16(const uint16_t *data, size_t plane_w, size_t plane_h, size_t rowstride,
+                                             icer_context_model_typedef *context_model,
+                                             icer_encoder_context_typedef *encoder_context,
+                                             const icer_packet_context *pkt_context) {
     int res;
     const uint16_t *pos;
     const uint16_t *rowstart = data;
@@ -458,6 +620,98 @@ int icer_decompress_bitplane_uint16(uint16_t * const data, size_t plane_w, size_
                                     icer_context_model_typedef *context_model,
                                     icer_decoder_context_typedef *decoder_context,
                                     const icer_packet_context *pkt_context) {
+    uint8_t lsb = pkt_context->lsb;
+    uint8_t prev_plane = lsb+1;
+    if (prev_plane >= 16) return ICER_BITPLANE_OUT_OF_RANGE;
+
+    if (plane_w > ICER_SIG_MAP_MAX_WIDTH) {
+        return decompress_bitplane_unpacked_uint16(data, plane_w, plane_h, rowstride, context_model, decoder_context,
+                                                   pkt_context);
+    }
+
+    switch (context_model->subband_type) {
+        case ICER_SUBBAND_HL:
+            return decompress_bitplane_kernel_uint16(data, plane_w, plane_h, rowstride, context_model, decoder_context,
+                                                     lsb, ICER_SUBBAND_HL);
+        case ICER_SUBBAND_HH:
+            return decompress_bitplane_kernel_uint16(data, plane_w, plane_h, rowstride, context_model, decoder_context,
+                                                     lsb, ICER_SUBBAND_HH);
+        default:
+            return decompress_bitplane_kernel_uint16(data, plane_w, plane_h, rowstride, context_model, decoder_context,
+                                                     lsb, ICER_SUBBAND_LL);
+    }
+}
+
+/*
+ * mirror of compress_bitplane_kernel_uint16
+ * rows below the current one still hold only the higher planes, so their packed state is
+ * built from the partially reconstructed data exactly as the encoder builds it from the image
+ */
+static ICER_ALWAYS_INLINE int decompress_bitplane_kernel_uint16(uint16_t *data, size_t plane_w, size_t plane_h, size_t rowstride,
+                                                                icer_context_model_typedef *context_model,
+                                                                icer_decoder_context_typedef *decoder_context,
+                                                                uint8_t lsb, enum icer_subband_types subband_type) {
+    int res;
+    uint16_t *pos;
+    uint16_t *rowstart = data;
+    int category;
+    uint8_t bit;
+    uint8_t prev_plane = lsb+1;
+
+    enum icer_pixel_contexts cntxt, sign_context;
+    uint8_t pred_sign, agreement_bit;
+    uint16_t actual_sign;
+    icer_significance_rows_typedef rows;
+
+    init_significance_rows_uint16(&rows, data, plane_w, plane_h, rowstride, prev_plane);
+
+    for (size_t row = 0; row < plane_h; row++) {
+        pos = rowstart;
+
+        for (size_t col = 0; col < plane_w; col++) {
+            category = get_bit_category_uint16(pos, lsb);
+
+            if (category == ICER_CATEGORY_3) {
+                /* pass to uncoded bin */
+                res = icer_decode_bit(decoder_context, &bit, 1, 2);
+                if (res != ICER_RESULT_OK) return res;
+                (*pos) |= (uint16_t)bit << lsb;
+            } else {
+                cntxt = get_magnitude_context(&rows, col, category, subband_type);
+
+                res = icer_decode_bit(decoder_context, &bit, context_model->zero_count[cntxt], context_model->total_count[cntxt]);
+                if (res != ICER_RESULT_OK) return res;
+                (*pos) |= (uint16_t)bit << lsb;
+                update_context_model(context_model, cntxt, bit);
+
+                if (category == ICER_CATEGORY_0 && bit) {
+                    /* bit is the first magnitude bit to be encoded, thus we will decode the sign bit */
+                    sign_context = get_sign_context_uint16(&rows, pos, col, rowstride, subband_type, &pred_sign);
+
+                    res = icer_decode_bit(decoder_context, &agreement_bit, context_model->zero_count[sign_context], context_model->total_count[sign_context]);
+                    if (res != ICER_RESULT_OK) return res;
+                    actual_sign = (agreement_bit ^ pred_sign) & 1;
+                    (*pos) |= actual_sign << 15;
+                    update_context_model(context_model, sign_context, agreement_bit);
+                }
+            }
+
+            rows.cur_lsb[(col + 1) >> 5] |= (uint32_t)((category != ICER_CATEGORY_0) | bit) << ((col + 1) & 31);
+
+            pos++;
+        }
+
+        advance_significance_rows_uint16(&rows, rowstart, row, plane_w, plane_h, rowstride, prev_plane);
+        rowstart += rowstride;
+    }
+    return ICER_RESULT_OK;
+}
+
+/* reference decoder for segments wider than ICER_SIG_MAP_MAX_WIDTH */
+static int decompress_bitplane_unpacked_uint16(uint16_t * const data, size_t plane_w, size_t plane_h, size_t rowstride,
+                                               icer_context_model_typedef *context_model,
+                                               icer_decoder_context_typedef *decoder_context,
+                                               const icer_packet_context *pkt_context) {
     int res;
     uint16_t *pos;
     uint16_t *rowstart = data;
@@ -636,4 +890,142 @@ static inline bool get_bit_significance_uint16(const uint16_t* data, uint8_t lsb
 static inline int8_t get_sign_uint16(const uint16_t* data, uint8_t lsb) {
     return (int8_t)(((int16_t)(*data) >> 15) * (int8_t)get_bit_significance_uint16(data, lsb));
 }
+
+/*
+ * packed significance rows hold one bit per pixel, the pixel in column col at bit col + 1
+ * bit 0 and the bits after the last column stay clear, so the missing neighbours of the
+ * first and last column read as insignificant
+ */
+static inline void clear_significance_row(uint32_t *sig, size_t words) {
+    for (size_t i = 0; i < words; i++) sig[i] = 0;
+}
+
+static inline void build_significance_row_uint16(uint32_t *sig, size_t words, const uint16_t *row, size_t plane_w, uint8_t plane) {
+    uint32_t word = 0;
+    uint8_t bit_ind = 1;
+    size_t word_ind = 0;
+    for (size_t col = 0; col < plane_w; col++) {
+        word |= (uint32_t)(((row[col] & 0x7fff) >> plane) != 0) << bit_ind;
+        if (++bit_ind == 32) {
+            sig[word_ind++] = word;
+            word = 0;
+            bit_ind = 0;
+        }
+    }
+    sig[word_ind++] = word;
+    while (word_ind < words) sig[word_ind++] = 0;
+}
+
+static inline uint32_t get_significance_bit(const uint32_t *sig, size_t bit_ind) {
+    return (sig[bit_ind >> 5] >> (bit_ind & 31)) & 1;
+}
+
+/* significance of columns col - 1, col and col + 1 in bits 0, 1 and 2 */
+static inline uint32_t get_significance_window(const uint32_t *sig, size_t col) {
+    uint32_t shift = col & 31;
+    uint32_t window = sig[col >> 5] >> shift;
+    /* only the last two columns of a word need bits from the next word */
+    if (shift > 29) window |= sig[(col >> 5) + 1] << (32 - shift);
+    return window & 0b111;
+}
+
+static inline void init_significance_rows_uint16(icer_significance_rows_typedef *rows, const uint16_t *data, size_t plane_w,
+                                                 size_t plane_h, size_t rowstride, uint8_t prev_plane) {
+    /* one spare word so that windows at the last column can always read two words */
+    rows->words = ((plane_w + 1) >> 5) + 2;
+    rows->above_lsb = rows->buf[0];
+    rows->cur_lsb = rows->buf[1];
+    rows->cur_prev = rows->buf[2];
+    rows->below_prev = rows->buf[3];
+
+    clear_significance_row(rows->above_lsb, rows->words);
+    clear_significance_row(rows->cur_lsb, rows->words);
+    build_significance_row_uint16(rows->cur_prev, rows->words, data, plane_w, prev_plane);
+    if (plane_h > 1) build_significance_row_uint16(rows->below_prev, rows->words, data + rowstride, plane_w, prev_plane);
+    else clear_significance_row(rows->below_prev, rows->words);
+}
+
+/* move the significance state down one row once row has been coded */
+static inline void advance_significance_rows_uint16(icer_significance_rows_typedef *rows, const uint16_t *rowstart, size_t row,
+                                                    size_t plane_w, size_t plane_h, size_t rowstride, uint8_t prev_plane) {
+    uint32_t *swap;
+
+    swap = rows->above_lsb; rows->above_lsb = rows->cur_lsb; rows->cur_lsb = swap;
+    clear_significance_row(rows->cur_lsb, rows->words);
+
+    swap = rows->cur_prev; rows->cur_prev = rows->below_prev; rows->below_prev = swap;
+    if (row + 2 < plane_h) build_significance_row_uint16(rows->below_prev, rows->words, rowstart + 2 * rowstride, plane_w, prev_plane);
+    else clear_significance_row(rows->below_prev, rows->words);
+}
+
+/* context of a category 0, 1 or 2 magnitude bit, subband_type is a constant in every kernel copy */
+static ICER_ALWAYS_INLINE enum icer_pixel_contexts get_magnitude_context(const icer_significance_rows_typedef *rows, size_t col,
+                                                                         int category, enum icer_subband_types subband_type) {
+    uint8_t h, v, d, tmp;
+    uint32_t up, down;
+
+    if (category == ICER_CATEGORY_2) return ICER_CONTEXT_11;
+
+    up = get_significance_window(rows->above_lsb, col);
+    down = get_significance_window(rows->below_prev, col);
+
+    h = get_significance_bit(rows->cur_lsb, col) + get_significance_bit(rows->cur_prev, col + 2);
+    v = ((up >> 1) & 1) + ((down >> 1) & 1);
+
+    if (category == ICER_CATEGORY_1) return (h + v == 0) ? ICER_CONTEXT_9 : ICER_CONTEXT_10;
+
+    d = (up & 1) + (up >> 2) + (down & 1) + (down >> 2);
+
+    if (subband_type == ICER_SUBBAND_HL) {
+        tmp = h;
+        h = v;
+        v = tmp;
+    }
+
+    if (subband_type != ICER_SUBBAND_HH) {
+        return icer_context_table_ll_lh_hl[h][v][d];
+    } else {
+        return icer_context_table_hh[h + v][d];
+    }
+}
+
+/*
+ * sign context and predicted sign of a pixel that just became significant
+ * a neighbour counts -1 if it is significant and negative, and only significant neighbours are
+ * read, so pixels outside the segment (clear guard bits) are never touched
+ */
+static ICER_ALWAYS_INLINE enum icer_pixel_contexts get_sign_context_uint16(const icer_significance_rows_typedef *rows,
+                                                                           const uint16_t *pos, size_t col, size_t rowstride,
+                                                                           enum icer_subband_types subband_type,
+                                                                           uint8_t *pred_sign) {
+    int8_t sh0 = 0, sh1 = 0, sv0 = 0, sv1 = 0;
+    uint8_t sh, sv, tmp;
+
+    if (get_significance_bit(rows->cur_lsb, col)) sh0 = (int8_t)((int16_t)pos[-1] >> 15);
+    if (get_significance_bit(rows->cur_prev, col + 2)) sh1 = (int8_t)((int16_t)pos[1] >> 15);
+    if (get_significance_bit(rows->above_lsb, col + 1)) sv0 = (int8_t)((int16_t)*(pos - rowstride) >> 15);
+    if (get_significance_bit(rows->below_prev, col + 1)) sv1 = (int8_t)((int16_t)pos[rowstride] >> 15);
+
+    sh = sh0 + sh1 + 2;
+    sv = sv0 + sv1 + 2;
+
+    if (subband_type == ICER_SUBBAND_HL) {
+        tmp = sh;
+        sh = sv;
+        sv = tmp;
+    }
+
+    *pred_sign = icer_sign_prediction_table[sh][sv];
+    return icer_sign_context_table[sh][sv];
+}
+
+static inline void update_context_model(icer_context_model_typedef *context_model, enum icer_pixel_contexts cntxt, bool bit) {
+    context_model->total_count[cntxt]++;
+    context_model->zero_count[cntxt] += (uint32_t)(!bit);
+    if (context_model->total_count[cntxt] >= ICER_CONTEXT_RESCALING_CAP) {
+        context_model->total_count[cntxt] >>= 1;
+        if (context_model->zero_count[cntxt] > context_model->total_count[cntxt]) context_model->zero_count[cntxt] >>= 1;
+        else icer_ceil_div_uint32(context_model->zero_count[cntxt], 2);
+    }
+}
 #endif
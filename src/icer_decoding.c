@@ -1,4 +1,3 @@
-#include <string.h>
 #include "icer.h"
 
 #ifdef USE_DECODE_FUNCTIONS
@@ -17,29 +16,52 @@ void icer_init_entropy_decoder_context(icer_decoder_context_typedef *decoder_con
     for (size_t it = 0;it < ICER_ENCODER_BIN_MAX+1;it++) {
         decoder_context->bin_bits[it] = 0;
         decoder_context->bin_decode_index[it] = 0;
-        for (size_t j = 0;j < ICER_DECODER_BIT_BIN_MAX;j++) decoder_context->bin_buf[it][j] = 0;
+        decoder_context->bin_buf[it] = 0;
     }
 }
 
+/* bits past bit 63 of the bin are dropped, they must be zero (see icer_decoder_context_typedef) */
 void icer_push_bin_bits(icer_decoder_context_typedef *decoder_context, uint8_t bin, uint16_t bits, uint16_t num_bits) {
-    int32_t bin_ind, bin_bit_offset;
-    bin_ind = decoder_context->bin_bits[bin] / 32;
-    bin_bit_offset = decoder_context->bin_bits[bin] % 32;
+    int32_t bin_bit_offset = decoder_context->bin_bits[bin];
     decoder_context->bin_bits[bin] += num_bits;
 
-    int bits_to_push;
-    while (num_bits) {
-        bits_to_push = icer_min_int(num_bits, 32-bin_bit_offset);
-        decoder_context->bin_buf[bin][bin_ind] |= ((bits & ICER_BITMASK_MACRO(bits_to_push)) << bin_bit_offset);
-        num_bits -= bits_to_push;
-
-        bin_bit_offset += bits_to_push;
-        bin_ind += bin_bit_offset / 32;
-        bin_bit_offset %= 32;
+    if (num_bits < 16) bits &= ICER_BITMASK_MACRO(num_bits);
+    if (bin_bit_offset < 64) {
+        decoder_context->bin_buf[bin] |= (uint64_t)bits << bin_bit_offset;
     }
 }
 
+/*
+ * codeword reads take the next 64 bits of the segment at once while at least 8 whole bytes of it are
+ * left; near the end of the segment (and for segments under 8 bits, where the length check below can
+ * fail) the byte wise reads are used, so nothing past the bytes they touched is read
+ */
+static inline int icer_codeword_word_available(const icer_decoder_context_typedef *decoder_context) {
+    return decoder_context->decoded_bits_total + 8 <= decoder_context->encoded_bits_total &&
+           decoder_context->encode_ind + 8 <= (decoder_context->encoded_bits_total + 7) / 8;
+}
+
+/* the 57 or more stream bits from the current position, first bit in bit 0 */
+static inline uint64_t icer_peek_codeword_word(const icer_decoder_context_typedef *decoder_context) {
+    const uint8_t *p = decoder_context->encoded_words + decoder_context->encode_ind;
+    uint64_t word = (uint64_t)p[0] | ((uint64_t)p[1] << 8) | ((uint64_t)p[2] << 16) | ((uint64_t)p[3] << 24) |
+                    ((uint64_t)p[4] << 32) | ((uint64_t)p[5] << 40) | ((uint64_t)p[6] << 48) | ((uint64_t)p[7] << 56);
+    return word >> decoder_context->encode_bit_offset;
+}
+
+static inline void icer_skip_codeword_bits(icer_decoder_context_typedef *decoder_context, uint8_t bits) {
+    unsigned bitoffset = decoder_context->encode_bit_offset + bits;
+    decoder_context->encode_ind += bitoffset / 8;
+    decoder_context->encode_bit_offset = bitoffset % 8;
+}
+
+static int icer_get_bits_from_codeword_bytewise(icer_decoder_context_typedef *decoder_context, uint8_t bits);
+static int icer_pop_bits_from_codeword_bytewise(icer_decoder_context_typedef *decoder_context, uint8_t bits);
+
 int icer_get_bit_from_codeword(icer_decoder_context_typedef *decoder_context, uint8_t bits) {
+    if (icer_codeword_word_available(decoder_context)) {
+        return (int)((icer_peek_codeword_word(decoder_context) >> (bits - 1)) & 1);
+    }
     uint8_t bitoffset = decoder_context->encode_bit_offset;
     size_t ind = decoder_context->encode_ind;
     uint16_t d, r;
@@ -53,6 +75,22 @@ int icer_get_bit_from_codeword(icer_decoder_context_typedef *decoder_context, ui
 }
 
 int icer_get_bits_from_codeword(icer_decoder_context_typedef *decoder_context, uint8_t bits) {
+    if (icer_codeword_word_available(decoder_context)) {
+        return (int)(icer_peek_codeword_word(decoder_context) & ICER_BITMASK_MACRO(bits));
+    }
+    return icer_get_bits_from_codeword_bytewise(decoder_context, bits);
+}
+
+int icer_pop_bits_from_codeword(icer_decoder_context_typedef *decoder_context, uint8_t bits) {
+    if (icer_codeword_word_available(decoder_context)) {
+        int num = (int)(icer_peek_codeword_word(decoder_context) & ICER_BITMASK_MACRO(bits));
+        icer_skip_codeword_bits(decoder_context, bits);
+        return num;
+    }
+    return icer_pop_bits_from_codeword_bytewise(decoder_context, bits);
+}
+
+static int icer_get_bits_from_codeword_bytewise(icer_decoder_context_typedef *decoder_context, uint8_t bits) {
     int num = 0;
     int bits_to_decode, decoded = 0;
     uint8_t bitoffset = decoder_context->encode_bit_offset;
@@ -77,7 +115,7 @@ int icer_get_bits_from_codeword(icer_decoder_context_typedef *decoder_context, u
     return num;
 }
 
-int icer_pop_bits_from_codeword(icer_decoder_context_typedef *decoder_context, uint8_t bits) {
+static int icer_pop_bits_from_codeword_bytewise(icer_decoder_context_typedef *decoder_context, uint8_t bits) {
     int num = 0;
     int bits_to_decode, decoded = 0;
     uint16_t d, r;
@@ -124,7 +162,7 @@ int icer_decode_bit(icer_decoder_context_typedef *decoder_context, uint8_t *bit,
     if (decoder_context->bin_bits[bin] <= 0 || decoder_context->decoded_words - decoder_context->bin_decode_index[bin] >= ICER_CIRC_BUF_SIZE) {
         /* ran out of bits in the bit, time to process a new codeword */
         decoder_context->bin_bits[bin] = 0;
-        memset(decoder_context->bin_buf[bin], 0, ICER_DECODER_BIT_BIN_MAX*sizeof(decoder_context->bin_buf[bin][0]));
+        decoder_context->bin_buf[bin] = 0;
         if (bin > ICER_ENC_BIN_8) {
             /* golomb code bins */
             code_bit = icer_get_bit_from_codeword(decoder_context, 1);
@@ -151,9 +189,13 @@ int icer_decode_bit(icer_decoder_context_typedef *decoder_context, uint8_t *bit,
             /* custom non prefix code bins */
             codeword = 0;
             num_bits = 0;
+            /* codewords are at most 10 bits, one word read covers all of them */
+            bool lookahead_valid = icer_codeword_word_available(decoder_context);
+            uint64_t lookahead = lookahead_valid ? icer_peek_codeword_word(decoder_context) : 0;
             do {
                 if (decoder_context->decoded_bits_total + num_bits + 1 >= decoder_context->encoded_bits_total) return ICER_DECODER_OUT_OF_DATA;
-                codeword |= icer_get_bit_from_codeword(decoder_context, num_bits+1) << num_bits;
+                code_bit = lookahead_valid ? (int)((lookahead >> num_bits) & 1) : icer_get_bit_from_codeword(decoder_context, num_bits+1);
+                codeword |= code_bit << num_bits;
                 num_bits++;
                 if (codeword < 32) {
                     if (icer_custom_decode_scheme[bin][codeword].input_code_bits == num_bits) {
@@ -179,11 +221,8 @@ int icer_decode_bit(icer_decoder_context_typedef *decoder_context, uint8_t *bit,
         decoder_context->decoded_words++;
         decoder_context->bin_decode_index[bin] = decoder_context->decoded_words;
     }
-    int32_t bin_ind = decoder_context->bin_bits[bin] / 32;
-    int32_t bit_offset = decoder_context->bin_bits[bin] % 32;
-    b = (decoder_context->bin_buf[bin][bin_ind] & (1 << (bit_offset-1))) != 0;
-    decoder_context->bin_buf[bin][bin_ind] &= ~(1 << (bit_offset-1));
-    decoder_context->bin_bits[bin]--;
+    int32_t bit_offset = --decoder_context->bin_bits[bin];
+    b = bit_offset >= 0 && bit_offset < 64 && ((decoder_context->bin_buf[bin] >> bit_offset) & 1);
     (*bit) = inv == !b;
 
     return ICER_RESULT_OK;
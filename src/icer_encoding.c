@@ -1,6 +1,11 @@
 #include "icer.h"
 
 #ifdef USE_ENCODE_FUNCTIONS
+#ifdef ICER_INCREMENTAL_DATA_CRC
+#include "crc.h"
+/* output bytes per data crc update: enough for the wide crc paths, few enough to still be in cache */
+#define ICER_DATA_CRC_BLOCK 256
+#endif
 #ifndef USER_PROVIDED_BUFFERS
 uint16_t icer_encode_circ_buf[ICER_CIRC_BUF_SIZE];
 #endif
@@ -12,6 +17,10 @@ void icer_init_entropy_coder_context(icer_encoder_context_typedef *encoder_conte
     encoder_context->max_output_length = enc_out_max;
     encoder_context->output_buffer = encoder_out;
 
+    /* the circular buffer indices wrap with a mask, so only a power of two length is used */
+    while (buffer_length & (buffer_length - 1)) {
+        buffer_length &= buffer_length - 1;
+    }
     encoder_context->buffer_length = buffer_length;
     encoder_context->encode_buffer = encode_buffer;
 
@@ -27,6 +36,9 @@ void icer_init_entropy_coder_context(icer_encoder_context_typedef *encoder_conte
     encoder_context->output_ind = 0;
     encoder_context->output_bit_offset = 0;
     encoder_context->output_buffer[encoder_context->output_ind] = 0;
+
+    encoder_context->data_crc32 = 0;
+    encoder_context->data_crc_ind = 0;
 }
 
 
@@ -107,26 +119,89 @@ int icer_encode_bit(icer_encoder_context_typedef *encoder_context, uint8_t bit,
     return ICER_RESULT_OK;
 }
 
+/* store the low 32 bits of a bit accumulator as 4 little endian output bytes (one word store on little endian targets) */
+static inline void store_word_le(uint8_t *dst, uint64_t acc) {
+    dst[0] = (uint8_t)acc;
+    dst[1] = (uint8_t)(acc >> 8);
+    dst[2] = (uint8_t)(acc >> 16);
+    dst[3] = (uint8_t)(acc >> 24);
+}
+
 int icer_popbuf_while_avail(icer_encoder_context_typedef *encoder_context) {
     uint16_t out, bits;
     uint16_t d, r;
     int bits_to_encode;
-    while (encoder_context->used > 0 && (encoder_context->encode_buffer[encoder_context->head] & ICER_ENC_BUF_DONE_MASK)) {
+    const uint16_t *encode_buffer = encoder_context->encode_buffer;
+    uint8_t *output_buffer = encoder_context->output_buffer;
+
+    if (encoder_context->used == 0 || !(encode_buffer[encoder_context->head] & ICER_ENC_BUF_DONE_MASK)) {
+        return ICER_RESULT_OK;
+    }
+
+    /*
+     * word level output: finished codewords are appended to a 64 bit accumulator that starts with the
+     * bits of the partially filled output byte, and whole 32 bit words are flushed to the output
+     * a codeword adds at most 31 bits, so the accumulator never holds more than 32 + 31 bits
+     * while at least 8 bytes of quota are left the quota cannot be reached before the next word flush,
+     * so it is only checked there; the last bytes before the quota go through the byte wise path below,
+     * which stops exactly at the quota as before
+     */
+    size_t ind = encoder_context->output_ind;
+    const size_t max_output_length = encoder_context->max_output_length;
+    if (ind + 8 <= max_output_length) {
+        uint64_t acc = output_buffer[ind];
+        unsigned acc_bits = encoder_context->output_bit_offset;
+        do {
+            out = pop_buf(encoder_context);
+            bits = out >> ICER_ENC_BUF_BITS_OFFSET;
+            acc |= (uint64_t)((uint32_t)out & ((1u << bits) - 1)) << acc_bits;
+            acc_bits += bits;
+            if (acc_bits >= 32) {
+                store_word_le(output_buffer + ind, acc);
+                ind += 4;
+                acc >>= 32;
+                acc_bits -= 32;
+                if (ind + 8 > max_output_length) break;
+            }
+        } while (encoder_context->used > 0 && (encode_buffer[encoder_context->head] & ICER_ENC_BUF_DONE_MASK));
+
+        /* spill the remaining complete bytes, then the partial byte (upper bits zero) */
+        while (acc_bits >= 8) {
+            output_buffer[ind++] = (uint8_t)acc;
+            acc >>= 8;
+            acc_bits -= 8;
+        }
+        output_buffer[ind] = (uint8_t)acc;
+        encoder_context->output_ind = ind;
+        encoder_context->output_bit_offset = (uint8_t)acc_bits;
+
+#ifdef ICER_INCREMENTAL_DATA_CRC
+        /* bytes below ind are final; fold them into the data crc in blocks while they are still in cache */
+        if (ind - encoder_context->data_crc_ind >= ICER_DATA_CRC_BLOCK) {
+            encoder_context->data_crc32 = crc32_update(encoder_context->data_crc32,
+                                                       output_buffer + encoder_context->data_crc_ind,
+                                                       ind - encoder_context->data_crc_ind);
+            encoder_context->data_crc_ind = ind;
+        }
+#endif
+    }
+
+    while (encoder_context->used > 0 && (encode_buffer[encoder_context->head] & ICER_ENC_BUF_DONE_MASK)) {
         out = pop_buf(encoder_context);
         bits = out >> ICER_ENC_BUF_BITS_OFFSET;
         while (bits) {
             bits_to_encode = icer_min_int(8-encoder_context->output_bit_offset, bits);
-            encoder_context->output_buffer[encoder_context->output_ind] |= (out & ((1 << bits_to_encode) - 1)) << (encoder_context->output_bit_offset);
+            output_buffer[encoder_context->output_ind] |= (out & ((1 << bits_to_encode) - 1)) << (encoder_context->output_bit_offset);
             out >>= bits_to_encode;
             bits -= bits_to_encode;
-            r = (encoder_context->output_bit_offset + bits_to_encode) / 8;
-            d = (encoder_context->output_bit_offset + bits_to_encode) % 8;
+            r = (encoder_context->output_bit_offset + bits_to_encode) >> 3;
+            d = (encoder_context->output_bit_offset + bits_to_encode) & 7;
             encoder_context->output_bit_offset = d;
             if (r) {
                 encoder_context->output_ind += r;
-                encoder_context->output_buffer[encoder_context->output_ind] = 0;
+                output_buffer[encoder_context->output_ind] = 0;
             }
-            if (encoder_context->output_ind == encoder_context->max_output_length) {
+            if (encoder_context->output_ind == max_output_length) {
                 return ICER_BYTE_QUOTA_EXCEEDED;
             }
         }
@@ -136,7 +211,7 @@ int icer_popbuf_while_avail(icer_encoder_context_typedef *encoder_context) {
 
 int icer_flush_encode(icer_encoder_context_typedef *encoder_context) {
     uint16_t *first = encoder_context->encode_buffer + encoder_context->head;
-    icer_custom_flush_typedef *flush;
+    const icer_custom_flush_typedef *flush;
     uint16_t prefix;
     if (((*first) & ICER_ENC_BUF_DONE_MASK) == 0) {
         uint8_t bin = (*first) >> ICER_ENC_BUF_BITS_OFFSET;
@@ -189,7 +264,7 @@ int icer_flush_encode(icer_encoder_context_typedef *encoder_context) {
 static inline uint16_t pop_buf(icer_encoder_context_typedef *cntxt) {
     if (cntxt->used > 0) cntxt->used--;
     uint16_t res = cntxt->encode_buffer[cntxt->head];
-    cntxt->head = (cntxt->head + 1) % cntxt->buffer_length;
+    cntxt->head = (cntxt->head + 1) & (cntxt->buffer_length - 1);
     return res;
 }
 
@@ -197,7 +272,7 @@ static inline int16_t alloc_buf(icer_encoder_context_typedef *cntxt) {
     if (cntxt->used >= cntxt->buffer_length) return -1;
     cntxt->used++;
     int16_t ind = (int16_t)cntxt->tail;
-    cntxt->tail = (cntxt->tail+1) % cntxt->buffer_length;
+    cntxt->tail = (cntxt->tail + 1) & (cntxt->buffer_length - 1);
     return ind;
 }
 
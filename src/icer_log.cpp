@@ -0,0 +1,208 @@
+#include "icer_log.h"
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__NuttX__) || defined(__unix__) || defined(__APPLE__)
+#define ICER_LOG_HAVE_PTHREADS 1
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+// One buffered message
+typedef struct {
+    uint32_t time_ms;
+    const char* format;
+    uint8_t level;
+    uint8_t arg_count;
+    intptr_t args[ICER_LOG_MAX_ARGS];
+} LogRecord;
+
+// Ring buffer: head and tail count records written / read since startup
+static LogRecord ring[ICER_LOG_RING_RECORDS];
+static uint32_t ring_head = 0;
+static uint32_t ring_tail = 0;
+static uint32_t dropped = 0;
+static uint32_t dropped_reported = 0;
+
+#ifdef ICER_LOG_HAVE_PTHREADS
+// Segment workers may log while the main thread flushes
+static pthread_mutex_t ring_lock = PTHREAD_MUTEX_INITIALIZER;
+// Keeps the lines of concurrent flushes (drain thread, phase boundary) in order
+static pthread_mutex_t flush_lock = PTHREAD_MUTEX_INITIALIZER;
+#define RING_LOCK() pthread_mutex_lock(&ring_lock)
+#define RING_UNLOCK() pthread_mutex_unlock(&ring_lock)
+#define FLUSH_LOCK() pthread_mutex_lock(&flush_lock)
+#define FLUSH_UNLOCK() pthread_mutex_unlock(&flush_lock)
+#else
+#define RING_LOCK() do {} while (0)
+#define RING_UNLOCK() do {} while (0)
+#define FLUSH_LOCK() do {} while (0)
+#define FLUSH_UNLOCK() do {} while (0)
+#endif
+
+void icerLogWrite(uint8_t level, const char* format, uint8_t arg_count, const intptr_t* args) {
+    uint32_t now = (uint32_t)millis();
+    RING_LOCK();
+    if (ring_head - ring_tail >= ICER_LOG_RING_RECORDS) {
+        dropped++;
+        RING_UNLOCK();
+        return;
+    }
+    LogRecord* record = &ring[ring_head % ICER_LOG_RING_RECORDS];
+    record->time_ms = now;
+    record->format = format;
+    record->level = level;
+    record->arg_count = arg_count;
+    memcpy(record->args, args, arg_count * sizeof(intptr_t));
+    ring_head++;
+    RING_UNLOCK();
+}
+
+// Format one record into line (always NUL-terminated)
+static void formatRecord(const LogRecord* record, char* line, size_t size) {
+    // "[<ms> <E|W|I|D>] message"
+    static const char level_letters[] = "-EWID";
+    char letter = (record->level <= ICER_LOG_LEVEL_DEBUG) ? level_letters[record->level] : '?';
+    size_t len = (size_t)snprintf(line, size, "[%lu %c] ", (unsigned long)record->time_ms, letter);
+    uint8_t next_arg = 0;
+    for (const char* f = record->format; *f && len + 1 < size; f++) {
+        if (*f != '%') {
+            line[len++] = *f;
+            continue;
+        }
+        f++;
+        while (*f == 'l' || *f == 'z') {
+            f++;
+        }
+        if (*f == '%') {
+            line[len++] = '%';
+            continue;
+        }
+        if (*f == '\0') {
+            break;
+        }
+        intptr_t value = (next_arg < record->arg_count) ? record->args[next_arg] : 0;
+        next_arg++;
+        int n = 0;
+        switch (*f) {
+            case 'd':
+            case 'i':
+                n = snprintf(line + len, size - len, "%ld", (long)value);
+                break;
+            case 'u':
+                n = snprintf(line + len, size - len, "%lu", (unsigned long)(uintptr_t)value);
+                break;
+            case 'x':
+                n = snprintf(line + len, size - len, "%lx", (unsigned long)(uintptr_t)value);
+                break;
+            case 'c':
+                n = snprintf(line + len, size - len, "%c", (char)value);
+                break;
+            case 's':
+                n = snprintf(line + len, size - len, "%s", value ? (const char*)value : "(null)");
+                break;
+            default:
+                n = snprintf(line + len, size - len, "%%%c", *f);
+                break;
+        }
+        if (n > 0) {
+            len += (size_t)n;
+        }
+        if (len >= size) {
+            len = size - 1;
+        }
+    }
+    line[len] = '\0';
+}
+
+void icerLogFlush(void) {
+    char line[160];
+    FLUSH_LOCK();
+    for (;;) {
+        LogRecord record;
+        uint32_t newly_dropped = 0;
+        RING_LOCK();
+        bool have = (ring_tail != ring_head);
+        if (have) {
+            record = ring[ring_tail % ICER_LOG_RING_RECORDS];
+            ring_tail++;
+        } else {
+            newly_dropped = dropped - dropped_reported;
+            dropped_reported = dropped;
+        }
+        RING_UNLOCK();
+
+        if (!have) {
+            if (newly_dropped > 0) {
+                Serial.print("WARNING: ");
+                Serial.print((unsigned long)newly_dropped);
+                Serial.println(" log records dropped (buffer full)");
+            }
+            FLUSH_UNLOCK();
+            return;
+        }
+        // Printed outside the lock, so a slow Serial never stalls the writers
+        formatRecord(&record, line, sizeof(line));
+        Serial.println(line);
+    }
+}
+
+uint32_t icerLogDropped(void) {
+    RING_LOCK();
+    uint32_t count = dropped;
+    RING_UNLOCK();
+    return count;
+}
+
+#ifdef ICER_LOG_HAVE_PTHREADS
+static pthread_t drain_thread;
+static bool drain_running = false;
+static volatile bool drain_stop = false;
+static uint32_t drain_period_ms = 0;
+
+static void* drainMain(void* arg) {
+    (void)arg;
+    while (!drain_stop) {
+        icerLogFlush();
+        usleep(drain_period_ms * 1000);
+    }
+    return NULL;
+}
+#endif
+
+int icerLogStartDrain(uint32_t period_ms) {
+#ifdef ICER_LOG_HAVE_PTHREADS
+    if (drain_running) {
+        return 0;
+    }
+    drain_stop = false;
+    drain_period_ms = (period_ms > 0) ? period_ms : 1;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+#ifdef __NuttX__
+    pthread_attr_setstacksize(&attr, 4096);
+#endif
+    int created = pthread_create(&drain_thread, &attr, drainMain, NULL);
+    pthread_attr_destroy(&attr);
+    if (created != 0) {
+        return -2;
+    }
+    drain_running = true;
+    return 0;
+#else
+    (void)period_ms;
+    return -1;
+#endif
+}
+
+void icerLogStopDrain(void) {
+#ifdef ICER_LOG_HAVE_PTHREADS
+    if (drain_running) {
+        drain_stop = true;
+        pthread_join(drain_thread, NULL);
+        drain_running = false;
+    }
+#endif
+    icerLogFlush();
+}
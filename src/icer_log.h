@@ -0,0 +1,89 @@
+#ifndef ICER_LOG_H
+#define ICER_LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Deferred logger for the pipeline
+// ICER_LOG_ERROR/WARN/INFO/DEBUG(format, args...) store a small binary record
+// (time, level, format pointer, up to ICER_LOG_MAX_ARGS integer arguments) in
+// a RAM ring buffer instead of printing. icerLogFlush() formats the records
+// and writes them to Serial; the compressors flush at their phase boundaries
+// (outside the timed phases, see icer_telemetry.h) and icerLogStartDrain()
+// can flush from a background thread instead.
+//
+// The format string and any %s argument are printed later, so both must stay
+// valid until then (string literals). Supported conversions: %d %i %u %x %c %s
+// %%, with an optional l/z length modifier; arguments are stored as intptr_t.
+
+#define ICER_LOG_LEVEL_NONE 0
+#define ICER_LOG_LEVEL_ERROR 1
+#define ICER_LOG_LEVEL_WARN 2
+#define ICER_LOG_LEVEL_INFO 3
+#define ICER_LOG_LEVEL_DEBUG 4
+
+// Most verbose level compiled in; the macros of higher levels compile to
+// nothing (their arguments are not evaluated)
+#ifndef ICER_LOG_LEVEL
+#define ICER_LOG_LEVEL ICER_LOG_LEVEL_INFO
+#endif
+
+// Records held between flushes (~28 bytes each on the board); records logged
+// while the buffer is full are dropped and counted. DEBUG builds log every
+// wavelet stage of every channel within one phase, so they get a larger buffer.
+#ifndef ICER_LOG_RING_RECORDS
+#if ICER_LOG_LEVEL >= ICER_LOG_LEVEL_DEBUG
+#define ICER_LOG_RING_RECORDS 256
+#else
+#define ICER_LOG_RING_RECORDS 64
+#endif
+#endif
+
+#define ICER_LOG_MAX_ARGS 4
+
+// Store one record (use the macros below)
+void icerLogWrite(uint8_t level, const char* format, uint8_t arg_count, const intptr_t* args);
+
+template <typename... Args>
+inline void icerLog(uint8_t level, const char* format, Args... args) {
+    static_assert(sizeof...(Args) <= ICER_LOG_MAX_ARGS, "too many log arguments");
+    const intptr_t values[sizeof...(Args) + 1] = { (intptr_t)args..., 0 };
+    icerLogWrite(level, format, (uint8_t)sizeof...(Args), values);
+}
+
+#if ICER_LOG_LEVEL >= ICER_LOG_LEVEL_ERROR
+#define ICER_LOG_ERROR(...) icerLog(ICER_LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define ICER_LOG_ERROR(...) do {} while (0)
+#endif
+#if ICER_LOG_LEVEL >= ICER_LOG_LEVEL_WARN
+#define ICER_LOG_WARN(...) icerLog(ICER_LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define ICER_LOG_WARN(...) do {} while (0)
+#endif
+#if ICER_LOG_LEVEL >= ICER_LOG_LEVEL_INFO
+#define ICER_LOG_INFO(...) icerLog(ICER_LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define ICER_LOG_INFO(...) do {} while (0)
+#endif
+#if ICER_LOG_LEVEL >= ICER_LOG_LEVEL_DEBUG
+#define ICER_LOG_DEBUG(...) icerLog(ICER_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define ICER_LOG_DEBUG(...) do {} while (0)
+#endif
+
+// Write the buffered records to Serial (oldest first) and report any dropped ones
+void icerLogFlush(void);
+
+// Records dropped because the buffer was full, since startup
+uint32_t icerLogDropped(void);
+
+// Flush every period_ms from a background thread (pthreads only; elsewhere
+// this returns -1 and flushing stays at the phase boundaries)
+// Returns 0 on success, negative error code on failure
+int icerLogStartDrain(uint32_t period_ms);
+
+// Stop the background thread and flush what is left
+void icerLogStopDrain(void);
+
+#endif // ICER_LOG_H
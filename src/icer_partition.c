@@ -102,7 +102,7 @@ int icer_compress_partition_uint8(const uint8_t *data, partition_param_typdef *p
 
             data_in_bytes = context.output_ind + (context.output_bit_offset > 0);
             seg->data_length = context.output_ind * 8 + context.output_bit_offset;
-            seg->data_crc32 = icer_calculate_segment_crc32(seg);
+            seg->data_crc32 = icer_finish_segment_crc32(&context, seg);
             seg->crc32 = icer_calculate_packet_crc32(seg);
             output_data->size_used += data_in_bytes;
 
@@ -148,7 +148,7 @@ int icer_compress_partition_uint8(const uint8_t *data, partition_param_typdef *p
 
             data_in_bytes = context.output_ind + (context.output_bit_offset > 0);
             seg->data_length = context.output_ind * 8 + context.output_bit_offset;
-            seg->data_crc32 = icer_calculate_segment_crc32(seg);
+            seg->data_crc32 = icer_finish_segment_crc32(&context, seg);
             seg->crc32 = icer_calculate_packet_crc32(seg);
             output_data->size_used += data_in_bytes;
 
@@ -323,7 +323,7 @@ int icer_compress_partition_uint16(const uint16_t *data, const partition_param_t
 
             data_in_bytes = context.output_ind + (context.output_bit_offset > 0);
             seg->data_length = context.output_ind * 8 + context.output_bit_offset;
-            seg->data_crc32 = icer_calculate_segment_crc32(seg);
+            seg->data_crc32 = icer_finish_segment_crc32(&context, seg);
             seg->crc32 = icer_calculate_packet_crc32(seg);
             output_data->size_used += data_in_bytes;
 
@@ -369,7 +369,7 @@ int icer_compress_partition_uint16(const uint16_t *data, const partition_param_t
 
             data_in_bytes = context.output_ind + (context.output_bit_offset > 0);
             seg->data_length = context.output_ind * 8 + context.output_bit_offset;
-            seg->data_crc32 = icer_calculate_segment_crc32(seg);
+            seg->data_crc32 = icer_finish_segment_crc32(&context, seg);
             seg->crc32 = icer_calculate_packet_crc32(seg);
             output_data->size_used += data_in_bytes;
 
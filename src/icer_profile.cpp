@@ -0,0 +1,321 @@
+#include "icer_profile.h"
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static const char* const zone_names[ICER_ZONE_COUNT] = {
+    "wavelet-rows", "wavelet-cols", "wavelet-1d", "segment-load", "segment-encode",
+    "bitplane", "crc32", "io-read", "io-write"
+};
+
+const char* icerProfileZoneName(enum icer_profile_zone zone) {
+    return ((int)zone >= 0 && zone < ICER_ZONE_COUNT) ? zone_names[zone] : "?";
+}
+
+#if ICER_PROFILE
+
+#if defined(__NuttX__) || defined(__unix__) || defined(__APPLE__)
+#define ICER_PROFILE_HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+// Trace events are recorded on host builds only (the board has no file to
+// write them to, and no RAM to spare for them)
+#if !defined(ARDUINO) && defined(ICER_PROFILE_HAVE_PTHREADS)
+#define ICER_PROFILE_HAVE_TRACE
+#endif
+
+#if defined(__NuttX__) && defined(__arm__)
+// Core clock of the board, override if the clock is changed
+#ifndef ICER_PROFILE_CPU_HZ
+#define ICER_PROFILE_CPU_HZ 156000000
+#endif
+#define DWT_CTRL (*(volatile uint32_t*)0xE0001000u)
+#define DEMCR (*(volatile uint32_t*)0xE000EDFCu)
+#define DEMCR_TRCENA (1u << 24)
+#define DWT_CTRL_CYCCNTENA 1u
+#endif
+
+#ifdef ICER_PROFILE_HAVE_TRACE
+// One pass through a zone
+typedef struct {
+    uint64_t start;
+    uint64_t ticks;
+    uint8_t zone;
+    uint8_t thread;   // Index into trace_threads
+} TraceEvent;
+
+#define TRACE_MAX_THREADS 32
+#endif
+
+// Zone table since the last icerProfileReset()
+static IcerProfileZoneStats zones[ICER_ZONE_COUNT];
+static bool counter_started = false;
+static double ticks_per_us = 0.0;
+
+#ifdef ICER_PROFILE_HAVE_TRACE
+static TraceEvent* trace_events = NULL;
+static size_t trace_capacity = 0;
+static size_t trace_count = 0;
+static size_t trace_dropped = 0;
+static uint64_t trace_origin = 0;
+static pthread_t trace_threads[TRACE_MAX_THREADS];
+static int trace_thread_count = 0;
+#endif
+
+#ifdef ICER_PROFILE_HAVE_PTHREADS
+// Segment workers and the async I/O thread record zones concurrently; the lock
+// is taken after the zone's end time is read, so only enclosing zones pay for it
+static pthread_mutex_t profile_lock = PTHREAD_MUTEX_INITIALIZER;
+#define PROFILE_LOCK() pthread_mutex_lock(&profile_lock)
+#define PROFILE_UNLOCK() pthread_mutex_unlock(&profile_lock)
+#else
+#define PROFILE_LOCK() do {} while (0)
+#define PROFILE_UNLOCK() do {} while (0)
+#endif
+
+#ifdef ICER_PROFILE_HAVE_TRACE
+// Small thread number for the trace (called with the lock held)
+static uint8_t traceThread(void) {
+    pthread_t self = pthread_self();
+    for (int i = 0; i < trace_thread_count; i++) {
+        if (pthread_equal(trace_threads[i], self)) {
+            return (uint8_t)i;
+        }
+    }
+    if (trace_thread_count < TRACE_MAX_THREADS) {
+        trace_threads[trace_thread_count] = self;
+        return (uint8_t)trace_thread_count++;
+    }
+    return TRACE_MAX_THREADS - 1;
+}
+#endif
+
+extern "C" void icer_profile_record(enum icer_profile_zone zone, icer_profile_ticks_t start,
+                                    icer_profile_ticks_t end) {
+    // Unsigned difference, so a wrap of the 32-bit board counter between the
+    // two reads still gives the right length
+    uint64_t ticks = (uint64_t)(icer_profile_ticks_t)(end - start);
+    PROFILE_LOCK();
+    IcerProfileZoneStats* stats = &zones[zone];
+    if (stats->count == 0 || ticks < stats->min) {
+        stats->min = ticks;
+    }
+    if (ticks > stats->max) {
+        stats->max = ticks;
+    }
+    stats->count++;
+    stats->total += ticks;
+#ifdef ICER_PROFILE_HAVE_TRACE
+    if (trace_events) {
+        if (trace_count < trace_capacity) {
+            TraceEvent* event = &trace_events[trace_count++];
+            event->start = (uint64_t)start;
+            event->ticks = ticks;
+            event->zone = (uint8_t)zone;
+            event->thread = traceThread();
+        } else {
+            trace_dropped++;
+        }
+    }
+#endif
+    PROFILE_UNLOCK();
+}
+
+// Counter rate; on x86 the TSC rate is measured against the monotonic clock
+static void calibrate(void) {
+#if defined(__NuttX__) && defined(__arm__)
+    ticks_per_us = ICER_PROFILE_CPU_HZ / 1e6;
+#elif defined(__x86_64__) || defined(__i386__)
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    uint64_t c0 = icer_profile_now();
+    uint64_t elapsed_ns;
+    do {
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        elapsed_ns = (uint64_t)(t1.tv_sec - t0.tv_sec) * 1000000000ULL + (uint64_t)t1.tv_nsec - (uint64_t)t0.tv_nsec;
+    } while (elapsed_ns < 20000000ULL);
+    uint64_t c1 = icer_profile_now();
+    ticks_per_us = (double)(c1 - c0) * 1000.0 / (double)elapsed_ns;
+#else
+    ticks_per_us = 1000.0;   // clock_gettime() nanoseconds
+#endif
+}
+
+void icerProfileReset(void) {
+    if (!counter_started) {
+#if defined(__NuttX__) && defined(__arm__)
+        DEMCR |= DEMCR_TRCENA;
+        DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+#endif
+        calibrate();
+        counter_started = true;
+    }
+    PROFILE_LOCK();
+    memset(zones, 0, sizeof(zones));
+    PROFILE_UNLOCK();
+}
+
+IcerProfileZoneStats icerProfileZoneStats(enum icer_profile_zone zone) {
+    IcerProfileZoneStats stats;
+    memset(&stats, 0, sizeof(stats));
+    if ((int)zone >= 0 && zone < ICER_ZONE_COUNT) {
+        PROFILE_LOCK();
+        stats = zones[zone];
+        PROFILE_UNLOCK();
+    }
+    return stats;
+}
+
+double icerProfileTicksPerUs(void) {
+    if (!counter_started) {
+        icerProfileReset();
+    }
+    return ticks_per_us;
+}
+
+void printIcerProfile(void) {
+    double rate = icerProfileTicksPerUs();
+    IcerProfileZoneStats table[ICER_ZONE_COUNT];
+    PROFILE_LOCK();
+    memcpy(table, zones, sizeof(table));
+    PROFILE_UNLOCK();
+
+    Serial.print("ICER profile (count / total ms / avg, min, max us), ");
+    Serial.print(rate, 1);
+    Serial.println(" ticks/us:");
+    for (int zone = 0; zone < ICER_ZONE_COUNT; zone++) {
+        const IcerProfileZoneStats* s = &table[zone];
+        if (s->count == 0) {
+            continue;
+        }
+        Serial.print("  ");
+        Serial.print(zone_names[zone]);
+        Serial.print(": ");
+        Serial.print((unsigned long)s->count);
+        Serial.print(" / ");
+        Serial.print((double)s->total / rate / 1000.0, 1);
+        Serial.print(" / ");
+        Serial.print((double)s->total / s->count / rate, 2);
+        Serial.print(", ");
+        Serial.print((double)s->min / rate, 2);
+        Serial.print(", ");
+        Serial.println((double)s->max / rate, 2);
+    }
+}
+
+#ifdef ICER_PROFILE_HAVE_TRACE
+int icerProfileTraceStart(size_t max_events) {
+    icerProfileTraceStop();
+    if (!counter_started) {
+        icerProfileReset();
+    }
+    TraceEvent* events = (TraceEvent*)malloc((max_events > 0 ? max_events : 1) * sizeof(TraceEvent));
+    if (!events) {
+        return -2;
+    }
+    PROFILE_LOCK();
+    trace_events = events;
+    trace_capacity = max_events;
+    trace_count = 0;
+    trace_dropped = 0;
+    trace_thread_count = 0;
+    trace_origin = icer_profile_now();
+    PROFILE_UNLOCK();
+    return 0;
+}
+
+int icerProfileWriteChromeTrace(const char* path) {
+    if (!trace_events) {
+        return -1;
+    }
+    FILE* out = fopen(path, "w");
+    if (!out) {
+        return -2;
+    }
+    PROFILE_LOCK();
+    // Complete events ("ph": "X") with microsecond timestamps from the trace start
+    fprintf(out, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+    for (int thread = 0; thread < trace_thread_count; thread++) {
+        fprintf(out, "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, "
+                     "\"args\": {\"name\": \"thread %d\"}},\n",
+                thread, thread);
+    }
+    for (size_t i = 0; i < trace_count; i++) {
+        const TraceEvent* event = &trace_events[i];
+        // Events from before the trace start (none in practice) are clamped to it
+        double ts = (event->start > trace_origin) ? (double)(event->start - trace_origin) / ticks_per_us : 0.0;
+        fprintf(out, "{\"name\": \"%s\", \"cat\": \"icer\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, "
+                     "\"ts\": %.3f, \"dur\": %.3f},\n",
+                zone_names[event->zone], (int)event->thread, ts, (double)event->ticks / ticks_per_us);
+    }
+    fprintf(out, "{\"name\": \"trace_info\", \"ph\": \"M\", \"pid\": 1, \"tid\": 0, "
+                 "\"args\": {\"events\": %lu, \"dropped\": %lu, \"ticks_per_us\": %.3f}}\n]}\n",
+            (unsigned long)trace_count, (unsigned long)trace_dropped, ticks_per_us);
+    PROFILE_UNLOCK();
+    bool ok = (ferror(out) == 0);
+    if (fclose(out) != 0) {
+        ok = false;
+    }
+    return ok ? 0 : -2;
+}
+
+void icerProfileTraceStop(void) {
+    PROFILE_LOCK();
+    TraceEvent* events = trace_events;
+    trace_events = NULL;
+    trace_capacity = 0;
+    trace_count = 0;
+    PROFILE_UNLOCK();
+    free(events);
+}
+#else
+int icerProfileTraceStart(size_t max_events) {
+    (void)max_events;
+    return -1;
+}
+
+int icerProfileWriteChromeTrace(const char* path) {
+    (void)path;
+    return -1;
+}
+
+void icerProfileTraceStop(void) {
+}
+#endif
+
+#else // !ICER_PROFILE
+
+void icerProfileReset(void) {
+}
+
+IcerProfileZoneStats icerProfileZoneStats(enum icer_profile_zone zone) {
+    (void)zone;
+    IcerProfileZoneStats stats;
+    memset(&stats, 0, sizeof(stats));
+    return stats;
+}
+
+double icerProfileTicksPerUs(void) {
+    return 0.0;
+}
+
+void printIcerProfile(void) {
+}
+
+int icerProfileTraceStart(size_t max_events) {
+    (void)max_events;
+    return -1;
+}
+
+int icerProfileWriteChromeTrace(const char* path) {
+    (void)path;
+    return -1;
+}
+
+void icerProfileTraceStop(void) {
+}
+
+#endif // ICER_PROFILE
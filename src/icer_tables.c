@@ -0,0 +1,198 @@
+/* Generated by host/icer_gen_tables.c - do not edit, rerun the generator instead */
+
+#include "icer.h"
+
+#ifdef USE_ENCODE_FUNCTIONS
+const icer_custom_code_typedef icer_custom_coding_scheme[ICER_ENCODER_BIN_MAX + 1][CUSTOM_CODING_MAX_LOOKUP] = {
+    [ICER_ENC_BIN_2] = {
+        [0x00] = { 5, 4, 0x07 },
+        [0x01] = { 2, 2, 0x02 },
+        [0x02] = { 2, 2, 0x01 },
+        [0x03] = { 3, 3, 0x03 },
+        [0x04] = { 3, 3, 0x04 },
+        [0x07] = { 4, 4, 0x0f },
+        [0x08] = { 4, 4, 0x08 },
+        [0x0f] = { 4, 5, 0x10 },
+        [0x10] = { 5, 5, 0x00 },
+    },
+    [ICER_ENC_BIN_3] = {
+        [0x00] = { 4, 3, 0x03 },
+        [0x01] = { 2, 3, 0x06 },
+        [0x02] = { 2, 2, 0x01 },
+        [0x03] = { 4, 4, 0x07 },
+        [0x04] = { 3, 2, 0x00 },
+        [0x07] = { 3, 4, 0x0a },
+        [0x08] = { 5, 4, 0x0f },
+        [0x0b] = { 4, 5, 0x02 },
+        [0x18] = { 5, 5, 0x12 },
+    },
+    [ICER_ENC_BIN_4] = {
+        [0x00] = { 3, 2, 0x00 },
+        [0x01] = { 2, 2, 0x01 },
+        [0x02] = { 2, 2, 0x02 },
+        [0x03] = { 2, 3, 0x07 },
+        [0x04] = { 3, 3, 0x03 },
+    },
+    [ICER_ENC_BIN_5] = {
+        [0x00] = { 2, 1, 0x01 },
+        [0x01] = { 5, 4, 0x04 },
+        [0x02] = { 3, 3, 0x00 },
+        [0x03] = { 3, 4, 0x0c },
+        [0x05] = { 3, 4, 0x02 },
+        [0x06] = { 3, 4, 0x0a },
+        [0x07] = { 3, 5, 0x16 },
+        [0x09] = { 4, 4, 0x0e },
+        [0x11] = { 5, 5, 0x06 },
+    },
+    [ICER_ENC_BIN_6] = {
+        [0x00] = { 5, 2, 0x00 },
+        [0x01] = { 1, 2, 0x02 },
+        [0x02] = { 3, 3, 0x03 },
+        [0x04] = { 3, 3, 0x05 },
+        [0x06] = { 3, 4, 0x0f },
+        [0x08] = { 4, 3, 0x01 },
+        [0x10] = { 5, 4, 0x07 },
+    },
+    [ICER_ENC_BIN_7] = {
+        [0x00] = { 3, 1, 0x00 },
+        [0x01] = { 3, 3, 0x03 },
+        [0x02] = { 3, 3, 0x05 },
+        [0x03] = { 2, 4, 0x07 },
+        [0x04] = { 3, 3, 0x01 },
+        [0x05] = { 3, 5, 0x1f },
+        [0x06] = { 3, 5, 0x0f },
+    },
+    [ICER_ENC_BIN_8] = {
+        [0x00] = { 4, 1, 0x00 },
+        [0x01] = { 2, 3, 0x03 },
+        [0x02] = { 2, 3, 0x05 },
+        [0x03] = { 2, 5, 0x1f },
+        [0x04] = { 3, 3, 0x01 },
+        [0x08] = { 5, 4, 0x07 },
+        [0x18] = { 5, 5, 0x0f },
+    },
+};
+#endif
+
+#ifdef USE_DECODE_FUNCTIONS
+const icer_custom_code_typedef icer_custom_decode_scheme[ICER_ENCODER_BIN_MAX + 1][CUSTOM_CODING_MAX_LOOKUP] = {
+    [ICER_ENC_BIN_2] = {
+        [0x00] = { 5, 5, 0x01 },
+        [0x01] = { 2, 2, 0x01 },
+        [0x02] = { 2, 2, 0x02 },
+        [0x03] = { 3, 3, 0x06 },
+        [0x04] = { 3, 3, 0x01 },
+        [0x07] = { 4, 5, 0x00 },
+        [0x08] = { 4, 4, 0x01 },
+        [0x0f] = { 4, 4, 0x0e },
+        [0x10] = { 5, 4, 0x0f },
+    },
+    [ICER_ENC_BIN_3] = {
+        [0x00] = { 2, 3, 0x01 },
+        [0x01] = { 2, 2, 0x01 },
+        [0x02] = { 5, 4, 0x0d },
+        [0x03] = { 3, 4, 0x00 },
+        [0x06] = { 3, 2, 0x02 },
+        [0x07] = { 4, 4, 0x0c },
+        [0x0a] = { 4, 3, 0x07 },
+        [0x0f] = { 4, 5, 0x02 },
+        [0x12] = { 5, 5, 0x03 },
+    },
+    [ICER_ENC_BIN_4] = {
+        [0x00] = { 2, 3, 0x00 },
+        [0x01] = { 2, 2, 0x02 },
+        [0x02] = { 2, 2, 0x01 },
+        [0x03] = { 3, 3, 0x01 },
+        [0x07] = { 3, 2, 0x03 },
+    },
+    [ICER_ENC_BIN_5] = {
+        [0x00] = { 3, 3, 0x02 },
+        [0x01] = { 1, 2, 0x00 },
+        [0x02] = { 4, 3, 0x05 },
+        [0x04] = { 4, 5, 0x10 },
+        [0x06] = { 5, 5, 0x11 },
+        [0x0a] = { 4, 3, 0x03 },
+        [0x0c] = { 4, 3, 0x06 },
+        [0x0e] = { 4, 4, 0x09 },
+        [0x16] = { 5, 3, 0x07 },
+    },
+    [ICER_ENC_BIN_6] = {
+        [0x00] = { 2, 5, 0x00 },
+        [0x01] = { 3, 4, 0x01 },
+        [0x02] = { 2, 1, 0x01 },
+        [0x03] = { 3, 3, 0x02 },
+        [0x05] = { 3, 3, 0x01 },
+        [0x07] = { 4, 5, 0x01 },
+        [0x0f] = { 4, 3, 0x03 },
+    },
+    [ICER_ENC_BIN_7] = {
+        [0x00] = { 1, 3, 0x00 },
+        [0x01] = { 3, 3, 0x01 },
+        [0x03] = { 3, 3, 0x04 },
+        [0x05] = { 3, 3, 0x02 },
+        [0x07] = { 4, 2, 0x03 },
+        [0x0f] = { 5, 3, 0x03 },
+        [0x1f] = { 5, 3, 0x05 },
+    },
+    [ICER_ENC_BIN_8] = {
+        [0x00] = { 1, 4, 0x00 },
+        [0x01] = { 3, 3, 0x01 },
+        [0x03] = { 3, 2, 0x02 },
+        [0x05] = { 3, 2, 0x01 },
+        [0x07] = { 4, 5, 0x02 },
+        [0x0f] = { 5, 5, 0x03 },
+        [0x1f] = { 5, 2, 0x03 },
+    },
+};
+#endif
+
+const icer_custom_flush_typedef icer_custom_code_flush_bits[ICER_ENCODER_BIN_MAX + 1][CUSTOM_CODE_FLUSH_MAX_LOOKUP + 1][MAX_NUM_BITS_BEFORE_FLUSH + 1] = {
+    [ICER_ENC_BIN_2] = {
+        [0x00] = { [1] = { 1, 1 }, [2] = { 1, 1 }, [3] = { 1, 1 }, [4] = { 0, 1 }, },
+        [0x01] = { [1] = { 0, 1 }, },
+        [0x03] = { [2] = { 0, 1 }, },
+        [0x07] = { [3] = { 0, 1 }, },
+    },
+    [ICER_ENC_BIN_3] = {
+        [0x00] = { [1] = { 1, 1 }, [2] = { 1, 1 }, [3] = { 0, 1 }, },
+        [0x01] = { [1] = { 0, 1 }, },
+        [0x03] = { [2] = { 1, 1 }, [3] = { 0, 1 }, },
+        [0x08] = { [4] = { 0, 1 }, },
+    },
+    [ICER_ENC_BIN_4] = {
+        [0x00] = { [1] = { 1, 1 }, [2] = { 0, 1 }, },
+        [0x01] = { [1] = { 0, 1 }, },
+    },
+    [ICER_ENC_BIN_5] = {
+        [0x00] = { [1] = { 0, 1 }, },
+        [0x01] = { [1] = { 1, 2 }, [2] = { 1, 1 }, [3] = { 1, 1 }, [4] = { 0, 1 }, },
+        [0x02] = { [2] = { 0, 1 }, },
+        [0x03] = { [2] = { 0, 1 }, },
+    },
+    [ICER_ENC_BIN_6] = {
+        [0x00] = { [1] = { 1, 2 }, [2] = { 1, 1 }, [3] = { 1, 1 }, [4] = { 0, 1 }, },
+        [0x01] = { [2] = { 0, 1 }, },
+    },
+    [ICER_ENC_BIN_7] = {
+        [0x00] = { [1] = { 0, 2 }, [2] = { 0, 1 }, },
+        [0x01] = { [1] = { 1, 1 }, [2] = { 0, 1 }, },
+        [0x02] = { [2] = { 0, 1 }, },
+    },
+    [ICER_ENC_BIN_8] = {
+        [0x00] = { [1] = { 1, 1 }, [2] = { 1, 1 }, [3] = { 0, 1 }, },
+        [0x01] = { [1] = { 0, 1 }, },
+        [0x08] = { [4] = { 0, 1 }, },
+    },
+};
+
+const icer_golomb_code_typedef icer_golomb_coders[ICER_ENCODER_BIN_MAX + 1] = {
+    [ICER_ENC_BIN_9] = { 5, 3, 3 },
+    [ICER_ENC_BIN_10] = { 6, 3, 2 },
+    [ICER_ENC_BIN_11] = { 7, 3, 1 },
+    [ICER_ENC_BIN_12] = { 11, 4, 5 },
+    [ICER_ENC_BIN_13] = { 17, 5, 15 },
+    [ICER_ENC_BIN_14] = { 31, 5, 1 },
+    [ICER_ENC_BIN_15] = { 70, 7, 58 },
+    [ICER_ENC_BIN_16] = { 200, 8, 56 },
+    [ICER_ENC_BIN_17] = { 512, 9, 0 },
+};
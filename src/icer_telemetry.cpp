@@ -0,0 +1,248 @@
+#include "icer_telemetry.h"
+#include "icer_log.h"
+#include <Arduino.h>
+#include <string.h>
+
+// Telemetry of the current / most recent compression
+static IcerTelemetry telemetry;
+
+// Running phase (ICER_PHASE_COUNT = none) and when it and the compression started
+static IcerPhase running_phase = ICER_PHASE_COUNT;
+static unsigned long phase_start_us = 0;
+static unsigned long begin_us = 0;
+
+// Progress callback (setIcerProgressCallback)
+static IcerProgressCallback progress_callback = NULL;
+static void* progress_context = NULL;
+
+static const char* const phase_names[ICER_PHASE_COUNT] = {
+    "ingest", "wavelet", "ll-mean", "sign-mag", "partition", "rearrange", "verify"
+};
+
+static const char* const subband_names[ICER_SUBBAND_MAX + 1] = {
+    "LL", "HL", "LH", "HH"
+};
+
+const IcerTelemetry* icerTelemetry(void) {
+    return &telemetry;
+}
+
+void icerTelemetryAddPhase(IcerPhase phase, uint32_t us) {
+    if (phase < ICER_PHASE_COUNT) {
+        telemetry.phase_us[phase] += us;
+    }
+}
+
+const char* icerTelemetryPhaseName(IcerPhase phase) {
+    return (phase < ICER_PHASE_COUNT) ? phase_names[phase] : "?";
+}
+
+void setIcerProgressCallback(IcerProgressCallback callback, void* context) {
+    progress_callback = callback;
+    progress_context = context;
+}
+
+void icerReportProgress(IcerPhase phase, size_t done, size_t total) {
+    if (progress_callback) {
+        progress_callback(progress_context, phase, (uint32_t)done, (uint32_t)total);
+    }
+}
+
+void icerTelemetryBegin(void) {
+    memset(&telemetry, 0, sizeof(telemetry));
+    poolResetPeaks();
+    running_phase = ICER_PHASE_COUNT;
+    begin_us = micros();
+}
+
+void icerTelemetryPhase(IcerPhase phase) {
+    unsigned long now = micros();
+    if (running_phase < ICER_PHASE_COUNT) {
+        telemetry.phase_us[running_phase] += (uint32_t)(now - phase_start_us);
+    }
+    // Drain the log between phases, outside the timed phases
+    icerLogFlush();
+    running_phase = phase;
+    phase_start_us = micros();
+}
+
+void icerTelemetryWaveletPass(uint8_t stage, bool columns, uint32_t us) {
+    if (stage >= ICER_MAX_DECOMP_STAGES) {
+        return;
+    }
+    if (columns) {
+        telemetry.wavelet_col_us[stage] += us;
+    } else {
+        telemetry.wavelet_row_us[stage] += us;
+    }
+}
+
+void icerTelemetryPackets(size_t total, size_t encoded) {
+    if (encoded > total) {
+        encoded = total;
+    }
+    telemetry.packets_total = (uint16_t)total;
+    telemetry.packets_encoded = (uint16_t)encoded;
+    telemetry.packets_dropped = (uint16_t)(total - encoded);
+}
+
+void icerTelemetryCountSegments(void) {
+    if (!icer_rearrange_segments_16) {
+        return;
+    }
+    for (int chan = ICER_CHANNEL_MIN; chan <= ICER_CHANNEL_MAX; chan++) {
+        for (int i = 0; i <= ICER_MAX_DECOMP_STAGES; i++) {
+            for (int j = 0; j <= ICER_SUBBAND_MAX; j++) {
+                for (int lsb = 0; lsb < ICER_BITPLANES_TO_COMPRESS_16; lsb++) {
+                    for (int k = 0; k <= ICER_MAX_SEGMENTS; k++) {
+                        const icer_image_segment_typedef* seg = icer_rearrange_segments_16[chan][i][j][lsb][k];
+                        if (seg == NULL) {
+                            continue;
+                        }
+                        uint32_t len = icer_ceil_div_uint32(seg->data_length, 8) +
+                                       sizeof(icer_image_segment_typedef);
+                        telemetry.segments++;
+                        telemetry.output_bytes += len;
+                        telemetry.subband_bytes[i][j] += len;
+                        telemetry.bitplane_bytes[lsb] += len;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void icerTelemetryEnd(const IoStats* io) {
+    icerTelemetryPhase(ICER_PHASE_COUNT);
+    telemetry.total_us = (uint32_t)(micros() - begin_us);
+
+    for (int pool = 0; pool < MEM_POOL_COUNT; pool++) {
+        telemetry.pool_peak[pool] = poolPeak((MemoryPool)pool);
+    }
+    telemetry.pool_peak_total = poolTotalPeak();
+
+    telemetry.io_counted = (io != NULL);
+    if (io) {
+        for (int phase = 0; phase < IO_PHASE_COUNT; phase++) {
+            telemetry.bytes_read[phase] = io->phases[phase].ops[IO_OP_READ].bytes;
+            telemetry.bytes_written[phase] = io->phases[phase].ops[IO_OP_WRITE].bytes;
+        }
+    }
+}
+
+void icerTelemetryPhaseCallback(void* context, int phase, size_t value) {
+    (void)context;
+    switch (phase) {
+        case ICER_ENCODE_PHASE_LL_MEAN:
+            icerTelemetryPhase(ICER_PHASE_LL_MEAN);
+            break;
+        case ICER_ENCODE_PHASE_SIGN_MAG:
+            icerTelemetryPhase(ICER_PHASE_SIGN_MAG);
+            break;
+        case ICER_ENCODE_PHASE_PARTITION:
+            icerTelemetryPhase(ICER_PHASE_PARTITION);
+            icerTelemetryPackets(value, 0);
+            break;
+        case ICER_ENCODE_PHASE_REARRANGE:
+            icerTelemetryPhase(ICER_PHASE_REARRANGE);
+            icerTelemetryPackets(telemetry.packets_total, value);
+            break;
+        default:
+            icerTelemetryPhase(ICER_PHASE_COUNT);
+            break;
+    }
+}
+
+void printIcerTelemetry(const IcerTelemetry* t) {
+    if (!t) {
+        return;
+    }
+    Serial.print("ICER telemetry: ");
+    Serial.print((unsigned long)(t->total_us / 1000));
+    Serial.println(" ms total");
+    for (int phase = 0; phase < ICER_PHASE_COUNT; phase++) {
+        if (t->phase_us[phase] == 0) {
+            continue;
+        }
+        Serial.print("  ");
+        Serial.print(phase_names[phase]);
+        Serial.print(": ");
+        Serial.print((unsigned long)(t->phase_us[phase] / 1000));
+        Serial.println(" ms");
+        if (phase == ICER_PHASE_WAVELET) {
+            for (int stage = 0; stage < ICER_MAX_DECOMP_STAGES; stage++) {
+                if (t->wavelet_row_us[stage] == 0 && t->wavelet_col_us[stage] == 0) {
+                    continue;
+                }
+                Serial.print("    stage ");
+                Serial.print(stage + 1);
+                Serial.print(": rows ");
+                Serial.print((unsigned long)(t->wavelet_row_us[stage] / 1000));
+                Serial.print(" ms, columns ");
+                Serial.print((unsigned long)(t->wavelet_col_us[stage] / 1000));
+                Serial.println(" ms");
+            }
+        }
+    }
+    if (t->io_counted) {
+        Serial.println("  I/O (KB read / written):");
+        for (int phase = 0; phase < IO_PHASE_COUNT; phase++) {
+            if (t->bytes_read[phase] == 0 && t->bytes_written[phase] == 0) {
+                continue;
+            }
+            Serial.print("    ");
+            Serial.print(ioStatsPhaseName((IoPhase)phase));
+            Serial.print(": ");
+            Serial.print((unsigned long)(t->bytes_read[phase] / 1024));
+            Serial.print(" / ");
+            Serial.println((unsigned long)(t->bytes_written[phase] / 1024));
+        }
+    }
+    Serial.print("  packets: ");
+    Serial.print((unsigned long)t->packets_encoded);
+    Serial.print(" of ");
+    Serial.print((unsigned long)t->packets_total);
+    Serial.print(" encoded, ");
+    Serial.print((unsigned long)t->packets_dropped);
+    Serial.print(" dropped, ");
+    Serial.print((unsigned long)t->segments);
+    Serial.println(" segments");
+    Serial.print("  peak RAM:");
+    for (int pool = 0; pool < MEM_POOL_COUNT; pool++) {
+        Serial.print(" ");
+        Serial.print(poolName((MemoryPool)pool));
+        Serial.print(" ");
+        Serial.print((unsigned long)(t->pool_peak[pool] / 1024));
+        Serial.print(" KB,");
+    }
+    Serial.print(" total ");
+    Serial.print((unsigned long)(t->pool_peak_total / 1024));
+    Serial.println(" KB");
+    Serial.print("  output: ");
+    Serial.print((unsigned long)t->output_bytes);
+    Serial.println(" bytes");
+    for (int i = ICER_MAX_DECOMP_STAGES; i >= 0; i--) {
+        for (int j = 0; j <= ICER_SUBBAND_MAX; j++) {
+            if (t->subband_bytes[i][j] == 0) {
+                continue;
+            }
+            Serial.print("    stage ");
+            Serial.print(i);
+            Serial.print(" ");
+            Serial.print(subband_names[j]);
+            Serial.print(": ");
+            Serial.print((unsigned long)t->subband_bytes[i][j]);
+            Serial.println(" bytes");
+        }
+    }
+    for (int lsb = ICER_BITPLANES_TO_COMPRESS_16 - 1; lsb >= 0; lsb--) {
+        if (t->bitplane_bytes[lsb] == 0) {
+            continue;
+        }
+        Serial.print("    bitplane ");
+        Serial.print(lsb);
+        Serial.print(": ");
+        Serial.print((unsigned long)t->bitplane_bytes[lsb]);
+        Serial.println(" bytes");
+    }
+}
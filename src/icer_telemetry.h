@@ -0,0 +1,101 @@
+#ifndef ICER_TELEMETRY_H
+#define ICER_TELEMETRY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "memory_arena.h"
+#include "io_stats_filesystem.h"
+
+extern "C" {
+#include "icer.h"
+}
+
+// Compression phases timed by the telemetry
+enum IcerPhase {
+    ICER_PHASE_INGEST = 0,   // Camera/JPEG data to Y/U/V channels (recorded by the caller)
+    ICER_PHASE_WAVELET,      // Wavelet transform, all stages and channels
+    ICER_PHASE_LL_MEAN,      // LL subband mean
+    ICER_PHASE_SIGN_MAG,     // Mean subtraction and sign-magnitude conversion
+    ICER_PHASE_PARTITION,    // Packet list and partition encode
+    ICER_PHASE_REARRANGE,    // Segment rearrange and output write
+    ICER_PHASE_VERIFY,       // Output check (flash path; callers may add their own)
+    ICER_PHASE_COUNT
+};
+
+// Everything recorded about one compression
+// Filled by compressYuvWithIcer() and compressYuvWithIcerFlash() and attached to
+// IcerCompressionResult::telemetry, on success and on failure (phases that did not
+// run stay zero).
+typedef struct IcerTelemetry {
+    uint32_t total_us;                                   // Compression call, start to end
+    uint32_t phase_us[ICER_PHASE_COUNT];
+    uint32_t wavelet_row_us[ICER_MAX_DECOMP_STAGES];     // Per stage, summed over the channels
+    uint32_t wavelet_col_us[ICER_MAX_DECOMP_STAGES];
+
+    // Bytes through the file system per I/O phase (io_stats_filesystem.h), valid
+    // only if io_counted is set (flash path with an I/O statistics layer)
+    bool io_counted;
+    uint64_t bytes_read[IO_PHASE_COUNT];
+    uint64_t bytes_written[IO_PHASE_COUNT];
+
+    uint16_t packets_total;      // Packets in the priority list
+    uint16_t packets_encoded;    // Packets encoded in full
+    uint16_t packets_dropped;    // Packets not (fully) encoded because the byte quota was reached
+    uint32_t segments;           // Segments in the output
+
+    size_t pool_peak[MEM_POOL_COUNT];   // High-water mark per pool during the compression
+    size_t pool_peak_total;             // High-water mark of the sum over the pools
+
+    // Output bytes (segment headers included), all channels together
+    uint32_t output_bytes;
+    uint32_t subband_bytes[ICER_MAX_DECOMP_STAGES + 1][ICER_SUBBAND_MAX + 1];
+    uint32_t bitplane_bytes[ICER_BITPLANES_TO_COMPRESS_16];
+} IcerTelemetry;
+
+// Telemetry of the most recent compression (zeros before the first one)
+// The block is static: it is valid until the next compression starts.
+const IcerTelemetry* icerTelemetry(void);
+
+// Add time to a phase of the most recent compression, for work done outside
+// the compressor (ingest before it, a decode check after it)
+void icerTelemetryAddPhase(IcerPhase phase, uint32_t us);
+
+// Name of a phase for reports ("ingest", "wavelet", ...)
+const char* icerTelemetryPhaseName(IcerPhase phase);
+
+// Print telemetry to Serial (NULL is ignored)
+void printIcerTelemetry(const IcerTelemetry* telemetry);
+
+// Progress callback: done of total units (rows, columns, packets, segments, ...)
+// of the current pass of phase are finished (total is 0 if not known up front). It is called from the inner loops
+// (once per row / batch / packet / segment), so keep it short, e.g. print only
+// when the percentage changes.
+typedef void (*IcerProgressCallback)(void* context, IcerPhase phase, uint32_t done, uint32_t total);
+
+// Set the progress callback of the pipeline (NULL, the default, disables progress reports)
+void setIcerProgressCallback(IcerProgressCallback callback, void* context);
+
+// Report progress to the callback, if one is set (used by the pipeline)
+void icerReportProgress(IcerPhase phase, size_t done, size_t total);
+
+// Used by the compressors
+// Begin clears the block and restarts the pool high-water marks; each
+// icerTelemetryPhase() call closes the running phase and starts the next one
+// (ICER_PHASE_COUNT: none);
+// End closes the running phase and records total time, pool peaks and the I/O
+// bytes of io (NULL: no I/O counted).
+void icerTelemetryBegin(void);
+void icerTelemetryPhase(IcerPhase phase);
+void icerTelemetryWaveletPass(uint8_t stage, bool columns, uint32_t us);
+void icerTelemetryPackets(size_t total, size_t encoded);
+// Count the segments left in icer_rearrange_segments_16 (call after the rearrange,
+// while the segment data is still allocated)
+void icerTelemetryCountSegments(void);
+void icerTelemetryEnd(const IoStats* io);
+
+// icer_output_data_buf_typedef::phase_callback for icer_compress_image_yuv_uint16()
+// (context unused)
+void icerTelemetryPhaseCallback(void* context, int phase, size_t value);
+
+#endif // ICER_TELEMETRY_H
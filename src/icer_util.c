@@ -64,29 +64,35 @@ int icer_init_output_struct(icer_output_data_buf_typedef *out, uint8_t *data, si
     // Always initialize pre-transformed flag
     // (This flag is independent of flash streaming, so initialize it unconditionally)
     out->channels_pre_transformed = 0;
+    out->phase_callback = NULL;
+    out->phase_context = NULL;
     
     return ICER_RESULT_OK;
 }
 
-/* compute which bin of the interleaved entropy coder to place a bit to be encoded based of the probability cutoffs of each bin */
-int icer_compute_bin(uint32_t zero_cnt, uint32_t total_cnt) {
-    uint32_t comp = zero_cnt * ICER_BIN_PROBABILITY_DENOMINATOR;
-    for (int16_t bin = ICER_ENCODER_BIN_MAX;bin > ICER_ENC_BIN_1;bin--) {
-        if (comp >= total_cnt * icer_bin_probability_cutoffs[bin-1]) {
-            return bin;
-        }
-    }
-    return ICER_ENC_BIN_1;
-}
-
 /* calculates the crc32 for the header of each segment of the image */
 uint32_t icer_calculate_packet_crc32(const icer_image_segment_typedef *pkt) {
-    return crc32buf((char*)pkt, sizeof(icer_image_segment_typedef) - 4);
+    return CRC32BUF_FUNCTION((char*)pkt, sizeof(icer_image_segment_typedef) - 4);
 }
 
 /* calculates the crc32 for the data portion of each segment of the image */
 uint32_t icer_calculate_segment_crc32(const icer_image_segment_typedef *pkt) {
-    return crc32buf((char*)pkt + sizeof(icer_image_segment_typedef), icer_ceil_div_uint32(pkt->data_length, 8));
+    return CRC32BUF_FUNCTION((char*)pkt + sizeof(icer_image_segment_typedef), icer_ceil_div_uint32(pkt->data_length, 8));
+}
+
+/*
+ * data crc32 of a segment the encoder has just finished (pkt->data_length already set)
+ * the encoder has covered everything up to data_crc_ind while writing, only the last bytes are left
+ */
+uint32_t icer_finish_segment_crc32(const icer_encoder_context_typedef *encoder_context, const icer_image_segment_typedef *pkt) {
+#ifdef ICER_INCREMENTAL_DATA_CRC
+    size_t data_in_bytes = icer_ceil_div_uint32(pkt->data_length, 8);
+    return crc32_update(encoder_context->data_crc32, encoder_context->output_buffer + encoder_context->data_crc_ind,
+                        data_in_bytes - encoder_context->data_crc_ind);
+#else
+    (void)encoder_context;
+    return icer_calculate_segment_crc32(pkt);
+#endif
 }
 
 #ifdef USE_DECODE_FUNCTIONS
@@ -1,4 +1,5 @@
 #include "icer.h"
+#include "icer_profile.h"
 
 #ifdef USE_UINT8_FUNCTIONS
 int icer_wavelet_transform_stages_uint8(uint8_t * const image, size_t image_w, size_t image_h, uint8_t stages,
@@ -379,6 +380,7 @@ int icer_inverse_wavelet_transform_1d_uint8(uint8_t * const data, size_t N, size
 
 #ifdef USE_UINT16_FUNCTIONS
 int icer_wavelet_transform_1d_uint16(uint16_t * const data, size_t N, size_t stride, enum icer_filter_types filt) {
+    ICER_PROFILE_BEGIN(transform);
     size_t low_N, high_N;
     bool is_odd = false;
     bool overflow = false;
@@ -457,6 +459,7 @@ int icer_wavelet_transform_1d_uint16(uint16_t * const data, size_t N, size_t str
         signed_data[n1] = (int16_t) h;
     }
 
+    ICER_PROFILE_END(transform, ICER_ZONE_WAVELET_1D);
     return overflow ? ICER_INTEGER_OVERFLOW : ICER_RESULT_OK;
 }
 
@@ -0,0 +1,373 @@
+#include "io_stats_filesystem.h"
+#include <Arduino.h>
+#include <stdlib.h>
+#include <string.h>
+
+// I/O accounting layer: forwards every call and records count, bytes and
+// latency per (phase, operation)
+//
+// The async layer may call into this one from its I/O thread while the pipeline
+// calls it from the main thread, so counter updates are serialized with a mutex.
+// Operations executed by the I/O thread are attributed to the phase that is
+// current when they run, which can lag the submitting phase by a buffer or two.
+
+#if defined(__NuttX__) || defined(__unix__) || defined(__APPLE__)
+#define IO_STATS_HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+// Current phase (set by the pipeline, read by every accounting layer)
+static volatile IoPhase current_phase = IO_PHASE_OTHER;
+
+class IoStatsFileSystem;
+
+// The accounting layer ioStatsSnapshot()/ioStatsReset() operate on
+static IoStatsFileSystem* active_layer = NULL;
+
+static const char* const phase_names[IO_PHASE_COUNT] = {
+    "other", "ingest", "wavelet-row", "wavelet-col", "sign-mag", "partition", "rearrange"
+};
+
+static const char* const op_names[IO_OP_COUNT] = {
+    "read", "write", "seek", "open", "close", "flush"
+};
+
+// Histogram bucket for a latency: floor(log2(us)), clamped to the last bucket
+static inline int latencyBucket(uint32_t us) {
+    int bucket = 0;
+    while (us > 1 && bucket < IO_LATENCY_BUCKETS - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+// I/O statistics file system implementation
+class IoStatsFileSystem : public IFileSystem {
+private:
+    IFileSystem* backing;
+    bool owns_backing;
+    IoStats* live;
+    IoStats* snapshot_buf;
+    IoStatsFileSystem* previous_layer;  // Restored as active layer on destruction
+#ifdef IO_STATS_HAVE_PTHREADS
+    pthread_mutex_t lock;
+#endif
+
+public:
+    IoStatsFileSystem(IFileSystem* backing_fs, bool take_ownership)
+        : backing(backing_fs), owns_backing(take_ownership), previous_layer(active_layer) {
+        live = (IoStats*)calloc(1, sizeof(IoStats));
+        snapshot_buf = (IoStats*)calloc(1, sizeof(IoStats));
+#ifdef IO_STATS_HAVE_PTHREADS
+        pthread_mutex_init(&lock, NULL);
+#endif
+        active_layer = this;
+    }
+
+    ~IoStatsFileSystem() override {
+        if (active_layer == this) {
+            active_layer = previous_layer;
+        }
+#ifdef IO_STATS_HAVE_PTHREADS
+        pthread_mutex_destroy(&lock);
+#endif
+        free(live);
+        free(snapshot_buf);
+        if (owns_backing && backing) {
+            delete backing;
+        }
+    }
+
+    bool isValid() const {
+        return live != NULL && snapshot_buf != NULL;
+    }
+
+    void setOwnership(bool take_ownership) {
+        owns_backing = take_ownership;
+    }
+
+    // Record one operation started at start_us against the current phase
+    void record(IoOp op, unsigned long start_us, size_t bytes, uint64_t seek_distance = 0) {
+        uint32_t elapsed = (uint32_t)(micros() - start_us);
+        IoPhase phase = current_phase;
+#ifdef IO_STATS_HAVE_PTHREADS
+        pthread_mutex_lock(&lock);
+#endif
+        IoPhaseStats* p = &live->phases[phase];
+        IoOpStats* s = &p->ops[op];
+        s->count++;
+        s->bytes += bytes;
+        s->total_us += elapsed;
+        if (elapsed > s->max_us) {
+            s->max_us = elapsed;
+        }
+        s->histogram[latencyBucket(elapsed)]++;
+        p->seek_distance += seek_distance;
+#ifdef IO_STATS_HAVE_PTHREADS
+        pthread_mutex_unlock(&lock);
+#endif
+    }
+
+    void reset() {
+#ifdef IO_STATS_HAVE_PTHREADS
+        pthread_mutex_lock(&lock);
+#endif
+        memset(live, 0, sizeof(IoStats));
+#ifdef IO_STATS_HAVE_PTHREADS
+        pthread_mutex_unlock(&lock);
+#endif
+    }
+
+    const IoStats* snapshot() {
+#ifdef IO_STATS_HAVE_PTHREADS
+        pthread_mutex_lock(&lock);
+#endif
+        memcpy(snapshot_buf, live, sizeof(IoStats));
+#ifdef IO_STATS_HAVE_PTHREADS
+        pthread_mutex_unlock(&lock);
+#endif
+        return snapshot_buf;
+    }
+
+    bool begin() override {
+        return backing->begin();
+    }
+
+    IFile* open(const char* filename, int mode) override;
+
+    bool remove(const char* filename) override {
+        return backing->remove(filename);
+    }
+
+    bool exists(const char* filename) override {
+        return backing->exists(filename);
+    }
+
+    void setSizeHint(const char* filename, size_t expected_size) override {
+        backing->setSizeHint(filename, expected_size);
+    }
+
+    IFile* createPreallocated(const char* filename, size_t size) override;
+};
+
+// File wrapper: times every call on the backing file
+class IoStatsFile : public IFile {
+private:
+    IoStatsFileSystem* fs;
+    IFile* inner;
+    size_t pos;  // Tracked here to measure seek distances without extra calls
+
+public:
+    IoStatsFile(IoStatsFileSystem* owner, IFile* file)
+        : fs(owner), inner(file), pos(file->position()) {}
+
+    ~IoStatsFile() override {
+        if (inner) {
+            close();
+        }
+    }
+
+    size_t read(uint8_t* buffer, size_t size) override {
+        if (!inner) {
+            return 0;
+        }
+        unsigned long start = micros();
+        size_t n = inner->read(buffer, size);
+        fs->record(IO_OP_READ, start, n);
+        pos += n;
+        return n;
+    }
+
+    size_t write(const uint8_t* data, size_t size) override {
+        if (!inner) {
+            return 0;
+        }
+        unsigned long start = micros();
+        size_t n = inner->write(data, size);
+        fs->record(IO_OP_WRITE, start, n);
+        pos += n;
+        return n;
+    }
+
+    bool seek(size_t position) override {
+        if (!inner) {
+            return false;
+        }
+        unsigned long start = micros();
+        bool ok = inner->seek(position);
+        fs->record(IO_OP_SEEK, start, 0, (position > pos) ? position - pos : pos - position);
+        if (ok) {
+            pos = position;
+        }
+        return ok;
+    }
+
+    size_t position() override {
+        return inner ? inner->position() : 0;
+    }
+
+    size_t size() override {
+        return inner ? inner->size() : 0;
+    }
+
+    bool flush() override {
+        if (!inner) {
+            return false;
+        }
+        unsigned long start = micros();
+        bool ok = inner->flush();
+        fs->record(IO_OP_FLUSH, start, 0);
+        return ok;
+    }
+
+    bool reserve(size_t size) override {
+        return inner ? inner->reserve(size) : false;
+    }
+
+    bool close() override {
+        if (!inner) {
+            return true;  // Already closed
+        }
+        unsigned long start = micros();
+        bool ok = inner->close();
+        fs->record(IO_OP_CLOSE, start, 0);
+        delete inner;
+        inner = NULL;
+        return ok;
+    }
+
+    bool isOpen() const override {
+        return inner != NULL;
+    }
+
+    operator bool() const override {
+        return inner != NULL;
+    }
+};
+
+IFile* IoStatsFileSystem::open(const char* filename, int mode) {
+    unsigned long start = micros();
+    IFile* file = backing->open(filename, mode);
+    record(IO_OP_OPEN, start, 0);
+    if (!file) {
+        return nullptr;
+    }
+    return new IoStatsFile(this, file);
+}
+
+IFile* IoStatsFileSystem::createPreallocated(const char* filename, size_t size) {
+    // Counted as an open; the space allocation is part of its latency
+    unsigned long start = micros();
+    IFile* file = backing->createPreallocated(filename, size);
+    record(IO_OP_OPEN, start, 0);
+    if (!file) {
+        return nullptr;
+    }
+    return new IoStatsFile(this, file);
+}
+
+// Factory function to create an I/O accounting layer
+IFileSystem* createIoStatsFileSystem(IFileSystem* backing, bool take_ownership) {
+    if (!backing) {
+        return NULL;
+    }
+    IoStatsFileSystem* fs = new IoStatsFileSystem(backing, false);
+    if (!fs->isValid()) {
+        delete fs;  // Backing stays with the caller on failure
+        return NULL;
+    }
+    fs->setOwnership(take_ownership);
+    return fs;
+}
+
+void ioStatsSetPhase(IoPhase phase) {
+    if (phase >= IO_PHASE_OTHER && phase < IO_PHASE_COUNT) {
+        current_phase = phase;
+    }
+}
+
+IoPhase ioStatsGetPhase(void) {
+    return current_phase;
+}
+
+void ioStatsReset(void) {
+    if (active_layer) {
+        active_layer->reset();
+    }
+}
+
+const IoStats* ioStatsSnapshot(void) {
+    return active_layer ? active_layer->snapshot() : NULL;
+}
+
+const char* ioStatsPhaseName(IoPhase phase) {
+    return (phase >= IO_PHASE_OTHER && phase < IO_PHASE_COUNT) ? phase_names[phase] : "?";
+}
+
+const char* ioStatsOpName(IoOp op) {
+    return (op >= IO_OP_READ && op < IO_OP_COUNT) ? op_names[op] : "?";
+}
+
+void printIoStats(const IoStats* stats) {
+    if (!stats) {
+        return;
+    }
+    Serial.println("I/O statistics (count / KB / total ms / max us):");
+    for (int phase = 0; phase < IO_PHASE_COUNT; phase++) {
+        const IoPhaseStats* p = &stats->phases[phase];
+        bool any = false;
+        for (int op = 0; op < IO_OP_COUNT; op++) {
+            if (p->ops[op].count > 0) {
+                any = true;
+            }
+        }
+        if (!any) {
+            continue;
+        }
+        Serial.print("  ");
+        Serial.print(ioStatsPhaseName((IoPhase)phase));
+        Serial.println(":");
+        for (int op = 0; op < IO_OP_COUNT; op++) {
+            const IoOpStats* s = &p->ops[op];
+            if (s->count == 0) {
+                continue;
+            }
+            Serial.print("    ");
+            Serial.print(ioStatsOpName((IoOp)op));
+            Serial.print(": ");
+            Serial.print((unsigned long)s->count);
+            Serial.print(" / ");
+            Serial.print((unsigned long)(s->bytes / 1024));
+            Serial.print(" KB / ");
+            Serial.print((unsigned long)(s->total_us / 1000));
+            Serial.print(" ms / ");
+            Serial.print((unsigned long)s->max_us);
+            Serial.print(" us");
+            if (op == IO_OP_SEEK) {
+                Serial.print(", distance ");
+                Serial.print((unsigned long)(p->seek_distance / 1024));
+                Serial.print(" KB");
+            }
+            Serial.println();
+            // Latency histogram, non-empty buckets only ("<N us: count")
+            Serial.print("      ");
+            for (int b = 0; b < IO_LATENCY_BUCKETS; b++) {
+                if (s->histogram[b] == 0) {
+                    continue;
+                }
+                if (b == IO_LATENCY_BUCKETS - 1) {
+                    Serial.print(">=");
+                    Serial.print((unsigned long)1 << b);
+                } else {
+                    Serial.print("<");
+                    Serial.print((unsigned long)2 << b);
+                }
+                Serial.print("us:");
+                Serial.print((unsigned long)s->histogram[b]);
+                Serial.print(" ");
+            }
+            Serial.println();
+        }
+    }
+}
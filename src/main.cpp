@@ -6,6 +6,17 @@
 #include "flash_icer_compression.h"
 #include "flash_wavelet.h"
 #include "memory_monitor.h"
+#include "memory_arena.h"
+#include "memory_planner.h"
+#include "filesystem_interface.h"
+#include "spresence_sd_filesystem.h"
+#include "tiered_filesystem.h"
+#include "async_filesystem.h"
+#include "handle_cache_filesystem.h"
+#include "io_stats_filesystem.h"
+#include "icer_telemetry.h"
+#include "icer_profile.h"
+#include "icer_log.h"
 
 // Try to use GNSS RAM if available (640 KB additional memory if GNSS not used)
 // Requires SDK 3.2.0+ and bootloader update
@@ -18,6 +29,47 @@
 SDClass theSD;
 int take_picture_count = 0;
 
+// File system used by the pipeline: small intermediates (JPEG copy, late wavelet
+// stages, compressed result) live in GNSS RAM, everything else goes to the SD card.
+// The budget leaves room for the ICER buffers that share the 640 KB GNSS RAM.
+// SD card access goes through a background I/O thread (double-buffered writes,
+// prefetched reads) so the card programs while the pipeline keeps computing; its
+// buffer sizes come from the buffer plan for the largest camera resolution.
+// On top, read handles for the channel files stay open across the per-packet reopens.
+#define TEMP_RAM_BUDGET (192 * 1024)
+#define READ_HANDLE_CACHE 4
+
+// Main heap kept out of every buffer plan: the camera JPEG buffer at QUADVGA
+// (width * height * 2 / jpgbufsize_divisor 8) plus headroom for the drivers
+#define CAMERA_HEAP_RESERVE (1280 * 960 * 2 / 8 + 32 * 1024)
+
+// Count SD card traffic per pipeline phase and print it after each compression
+// (costs ~7 KB of heap for the counters; set to 0 to remove the layer)
+#define IO_STATS_ENABLED 1
+IFileSystem* theFS = NULL;
+
+// RAM-tier files come from the GNSS RAM pool (main heap if it is full)
+static void* temp_ram_alloc(size_t size) {
+    return poolAlloc(size, MEM_POOL_GNSS);
+}
+
+static void temp_ram_free(void* ptr) {
+    poolFree(ptr);
+}
+
+// Pipeline progress: log the halfway point of each pass (deferred, so no Serial
+// time inside the timed loops; the wavelet alone has 24 passes per frame)
+static void report_progress(void* context, IcerPhase phase, uint32_t done, uint32_t total) {
+    bool* half_reported = static_cast<bool*>(context);
+    if (done == 0) {
+        *half_reported = false;
+    } else if (!*half_reported && total > 0 && done * 2 >= total) {
+        *half_reported = true;
+        ICER_LOG_INFO("    %s: 50%%", icerTelemetryPhaseName(phase));
+    }
+}
+static bool progress_half_reported = false;
+
 void setup() {
     Serial.begin(BAUDRATE);
     while (!Serial) { ; }
@@ -58,18 +110,12 @@ void setup() {
     Serial.println("Note: Requires SDK 3.2.0+ and updated bootloader");
     printMemoryStats("After GNSS RAM init");
     
-    // Enable GNSS RAM usage for ICER buffers (frees main RAM for camera)
-    // This moves ~115 KB of ICER buffers to GNSS RAM
-    // Note: Must call for both icer_compression.cpp and flash_icer_compression.cpp
-    // as they are separate compilation units with separate static variables
-    setGnssRamAvailable(true);
-    // Also set for flash_icer_compression (separate function in different compilation unit)
-    // Function is declared in flash_icer_compression.h which is already included
-    setGnssRamAvailable_flash(true);
-    // Also set for flash_wavelet (separate function in different compilation unit)
-    // Function is declared in flash_wavelet.h which is already included
-    setGnssRamAvailable_wavelet(true);
+    // Enable the GNSS RAM pool for ICER buffers, datastream, wavelet column
+    // batches and RAM-tier files (frees main RAM for camera)
+    initMemoryPools(true);
     Serial.println("GNSS RAM enabled for ICER buffer allocation");
+    #else
+    initMemoryPools(false);
     #endif
 
     Serial.println("Initializing SD card...");
@@ -78,6 +124,28 @@ void setup() {
         delay(1000);
     }
     printMemoryStats("After SD card init");
+
+    IFileSystem* card_fs = createSpresenceSDFileSystem(&theSD);
+    #if IO_STATS_ENABLED
+    IFileSystem* stats_fs = createIoStatsFileSystem(card_fs, true);
+    if (stats_fs) {
+        card_fs = stats_fs;
+    }
+    #endif
+    // The RAM tier may fill its budget at any time, so plans never count on it
+    setMemoryReserve(MEM_POOL_GNSS, TEMP_RAM_BUDGET);
+    setMemoryReserve(MEM_POOL_MAIN, CAMERA_HEAP_RESERVE);
+    MemoryBudget budget;
+    getMemoryBudget(&budget);
+    BufferPlan io_plan;
+    if (planBuffers(1280, 960, 6, 400 * 1024, &budget, &io_plan) != 0) {
+        io_plan = *currentBufferPlan();
+    }
+    IFileSystem* sd_fs = createAsyncFileSystem(card_fs, io_plan.write_back_bytes, io_plan.write_back_count, true,
+                                               io_plan.read_ahead_bytes);
+    IFileSystem* tiered_fs = createTieredFileSystem(sd_fs, TEMP_RAM_BUDGET, temp_ram_alloc, temp_ram_free, true);
+    theFS = createHandleCacheFileSystem(tiered_fs, READ_HANDLE_CACHE, true);
+    setIcerProgressCallback(report_progress, &progress_half_reported);
     
     Serial.println("Setup complete. Camera will be initialized in loop() when needed.");
     Serial.println("========================================");
@@ -270,11 +338,24 @@ void loop() {
         size_t img_width = 0;
         size_t img_height = 0;
         
+        // Size the JPEG decoder and other ingest buffers for this frame
+        MemoryBudget budget;
+        getMemoryBudget(&budget);
+        BufferPlan ingest_plan;
+        if (planBuffers(jpeg_img.getWidth(), jpeg_img.getHeight(), 6, 400 * 1024, &budget, &ingest_plan) == 0) {
+            setBufferPlan(&ingest_plan);
+        }
+        
+        ioStatsReset();  // Count this frame only
+        icerProfileReset();
+        unsigned long ingest_start_ms = millis();
         int convert_result = convertJpegToSeparateChannels(
             jpeg_img,
             &img_width, &img_height,
-            y_flash_file, u_flash_file, v_flash_file, &theSD
+            y_flash_file, u_flash_file, v_flash_file, theFS
         );
+        unsigned long ingest_ms = millis() - ingest_start_ms;
+        icerLogFlush();
         Serial.println("Channel Separation Complete");
         
         // CRITICAL FIX: Do NOT use assignment operator to "reset" CamImage
@@ -288,14 +369,6 @@ void loop() {
         // File destructors are called. We need to wait for them to complete safely.
         delay(500);
         
-        // CRITICAL FIX: Clean up temporary RGB file AFTER all File objects are destroyed
-        // The File objects from convertJpegToSeparateChannels are now destroyed,
-        // so it's safe to remove the file they were referencing.
-        const char* temp_rgb_file = "_temp_rgb.tmp";
-        theSD.remove(temp_rgb_file);
-
-        Serial.println("Removed temp file");
-        
         printMemoryStats("After JPEG->YUV conversion");
         
         if (convert_result != 0) {
@@ -339,7 +412,7 @@ void loop() {
         
         const char* icer_flash_file = "_icer_result.tmp";
         IcerCompressionResult icer_result = compressYuvWithIcerFlash(
-            &theSD,
+            theFS,
             y_flash_file, u_flash_file, v_flash_file,
             img_width, img_height,
             stages, filter_type, segments, target_size,
@@ -347,19 +420,24 @@ void loop() {
             false  // Channels are not pre-transformed (we'll do wavelet transform)
         );
         unsigned long icer_elapsed_ms = millis() - icer_start_ms;
+        icerTelemetryAddPhase(ICER_PHASE_INGEST, ingest_ms * 1000);
         
         // Clean up temporary channel files
-        theSD.remove(y_flash_file);
-        theSD.remove(u_flash_file);
-        theSD.remove(v_flash_file);
+        theFS->remove(y_flash_file);
+        theFS->remove(u_flash_file);
+        theFS->remove(v_flash_file);
         
         printMemoryStats("After flash-based ICER compression");
+        printIoStats(icer_result.io_stats);
+        printIcerTelemetry(icer_result.telemetry);
+        printIcerProfile();
+        printPoolStats("After flash-based ICER compression");
         
         if (!icer_result.success) {
             Serial.print("ICER compression failed: ");
             Serial.println(icer_result.error_code);
             if (icer_result.flash_filename) {
-                theSD.remove(icer_result.flash_filename);
+                theFS->remove(icer_result.flash_filename);
             }
             take_picture_count++;
             return;
@@ -386,24 +464,23 @@ void loop() {
         Serial.println(icer_filename);
         
         if (icer_result.flash_filename) {
-            // Result is in flash file, copy to final location
-            File srcFile = theSD.open(icer_result.flash_filename, FILE_READ);
+            // Result is in a pipeline file (RAM tier or SD), copy to final location on SD
+            IFile* srcFile = theFS->open(icer_result.flash_filename, FILE_READ);
             if (srcFile) {
                 theSD.remove(icer_filename);
                 File dstFile = theSD.open(icer_filename, FILE_WRITE);
                 if (dstFile) {
                     size_t total_written = 0;
                     uint8_t buffer[512];
-                    while (srcFile.available()) {
-                        size_t bytes_read = srcFile.read(buffer, sizeof(buffer));
-                        if (bytes_read > 0) {
-                            size_t bytes_written = dstFile.write(buffer, bytes_read);
-                            total_written += bytes_written;
-                        }
+                    size_t bytes_read;
+                    while ((bytes_read = srcFile->read(buffer, sizeof(buffer))) > 0) {
+                        size_t bytes_written = dstFile.write(buffer, bytes_read);
+                        total_written += bytes_written;
                     }
                     dstFile.close();
-                    srcFile.close();
-                    theSD.remove(icer_result.flash_filename);
+                    srcFile->close();
+                    delete srcFile;
+                    theFS->remove(icer_result.flash_filename);
                     
                     if (total_written == icer_result.compressed_size) {
                         Serial.print("Saved: ");
@@ -419,6 +496,8 @@ void loop() {
                         Serial.println(" bytes");
                     }
                 } else {
+                    srcFile->close();
+                    delete srcFile;
                     Serial.println("ERROR: Failed to open destination file");
                 }
             } else {
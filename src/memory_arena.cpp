@@ -0,0 +1,321 @@
+#include "memory_arena.h"
+#include "memory_monitor.h"
+#include <Arduino.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __arm__
+#include <arch/chip/gnssram.h>
+#endif
+
+// Every poolAlloc() block starts with this header, so poolFree() knows which
+// allocator the block came from and how large it was (8 bytes keeps the
+// returned pointer 8-byte aligned)
+typedef struct {
+    uint32_t size;   // Total block size including the header
+    uint16_t magic;  // POOL_MAGIC, catches frees of foreign pointers
+    uint8_t pool;    // MemoryPool the block came from
+    uint8_t reserved;
+} PoolHeader;
+
+#define POOL_MAGIC 0x9E1Bu
+#define POOL_HEADER_SIZE sizeof(PoolHeader)
+
+// Per-pool state
+typedef struct {
+    bool available;
+    size_t capacity;   // 0 = unknown (main heap)
+    size_t used;
+    size_t peak;
+    uint32_t failures;
+} PoolState;
+
+// Before initMemoryPools() only the main heap is used
+static PoolState pools[MEM_POOL_COUNT] = {
+    { false, 0, 0, 0, 0 },  // MEM_POOL_GNSS
+    { true, 0, 0, 0, 0 },   // MEM_POOL_MAIN
+    { false, 0, 0, 0, 0 }   // MEM_POOL_STATIC
+};
+
+// Sum of used over all pools, and its high-water mark
+static size_t total_used = 0;
+static size_t total_peak = 0;
+
+// Static pool region (bump allocated)
+static uint8_t* static_base = NULL;
+static size_t static_top = 0;
+
+static const char* const pool_names[MEM_POOL_COUNT] = {
+    "gnss", "main", "static"
+};
+
+void initMemoryPools(bool gnss_ram_available, void* static_region, size_t static_size) {
+    memset(pools, 0, sizeof(pools));
+    total_used = 0;
+    total_peak = 0;
+
+    pools[MEM_POOL_GNSS].available = gnss_ram_available;
+    pools[MEM_POOL_GNSS].capacity = gnss_ram_available ? MEM_GNSS_RAM_SIZE : 0;
+
+    pools[MEM_POOL_MAIN].available = true;
+
+    // Keep the static region 8-byte aligned
+    static_base = NULL;
+    static_top = 0;
+    if (static_region && static_size > 8) {
+        uintptr_t addr = (uintptr_t)static_region;
+        size_t skew = (size_t)((8 - (addr & 7)) & 7);
+        static_base = (uint8_t*)static_region + skew;
+        pools[MEM_POOL_STATIC].available = true;
+        pools[MEM_POOL_STATIC].capacity = (static_size - skew) & ~(size_t)7;
+    }
+}
+
+// Raw allocation from one pool (size includes the header)
+static void* rawAlloc(MemoryPool pool, size_t size) {
+    PoolState* p = &pools[pool];
+    if (!p->available) {
+        return NULL;
+    }
+    if (p->capacity > 0 && size > p->capacity - p->used) {
+        p->failures++;
+        return NULL;
+    }
+
+    void* ptr = NULL;
+    switch (pool) {
+        case MEM_POOL_GNSS:
+#ifdef __arm__
+            ptr = up_gnssram_malloc(size);
+#else
+            ptr = malloc(size);  // Host: GNSS RAM simulated, limited to capacity above
+#endif
+            break;
+        case MEM_POOL_MAIN:
+            ptr = malloc(size);
+            break;
+        case MEM_POOL_STATIC:
+            ptr = static_base + static_top;
+            static_top += size;
+            break;
+        default:
+            break;
+    }
+    if (!ptr) {
+        p->failures++;
+        return NULL;
+    }
+
+    p->used += size;
+    if (p->used > p->peak) {
+        p->peak = p->used;
+    }
+    total_used += size;
+    if (total_used > total_peak) {
+        total_peak = total_used;
+    }
+    return ptr;
+}
+
+static void rawFree(MemoryPool pool, void* block, size_t size) {
+    PoolState* p = &pools[pool];
+    switch (pool) {
+        case MEM_POOL_GNSS:
+#ifdef __arm__
+            up_gnssram_free(block);
+#else
+            free(block);
+#endif
+            break;
+        case MEM_POOL_MAIN:
+            free(block);
+            break;
+        case MEM_POOL_STATIC:
+            // Bump region: only the most recent allocation can be returned
+            if ((uint8_t*)block + size == static_base + static_top) {
+                static_top -= size;
+            } else {
+                return;  // Stays accounted until resetStaticPool()
+            }
+            break;
+        default:
+            return;
+    }
+    p->used -= size;
+    total_used -= size;
+}
+
+void* poolAlloc(size_t size, MemoryPool preferred) {
+    if (size == 0 || size > 0xFFFFFFF0u - POOL_HEADER_SIZE) {
+        return NULL;
+    }
+    size_t total = bumpAlignedSize(size + POOL_HEADER_SIZE);
+
+    // Preferred pool first, then GNSS RAM, then the main heap
+    MemoryPool order[3] = { preferred, MEM_POOL_GNSS, MEM_POOL_MAIN };
+    for (int i = 0; i < 3; i++) {
+        MemoryPool pool = order[i];
+        if (pool < 0 || pool >= MEM_POOL_COUNT || (i > 0 && pool == preferred)) {
+            continue;
+        }
+        PoolHeader* header = (PoolHeader*)rawAlloc(pool, total);
+        if (header) {
+            header->size = (uint32_t)total;
+            header->magic = POOL_MAGIC;
+            header->pool = (uint8_t)pool;
+            header->reserved = 0;
+            return (uint8_t*)header + POOL_HEADER_SIZE;
+        }
+    }
+    return NULL;
+}
+
+void poolFree(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+    PoolHeader* header = (PoolHeader*)((uint8_t*)ptr - POOL_HEADER_SIZE);
+    if (header->magic != POOL_MAGIC || header->pool >= MEM_POOL_COUNT) {
+        Serial.println("ERROR: poolFree() on a pointer not from poolAlloc()");
+        return;
+    }
+    header->magic = 0;  // Double frees are reported instead of corrupting a heap
+    rawFree((MemoryPool)header->pool, header, header->size);
+}
+
+MemoryPool poolOf(const void* ptr) {
+    if (!ptr) {
+        return MEM_POOL_COUNT;
+    }
+    const PoolHeader* header = (const PoolHeader*)((const uint8_t*)ptr - POOL_HEADER_SIZE);
+    if (header->magic != POOL_MAGIC || header->pool >= MEM_POOL_COUNT) {
+        return MEM_POOL_COUNT;
+    }
+    return (MemoryPool)header->pool;
+}
+
+size_t poolUsed(MemoryPool pool) {
+    return (pool >= 0 && pool < MEM_POOL_COUNT) ? pools[pool].used : 0;
+}
+
+size_t poolPeak(MemoryPool pool) {
+    return (pool >= 0 && pool < MEM_POOL_COUNT) ? pools[pool].peak : 0;
+}
+
+size_t poolTotalUsed(void) {
+    return total_used;
+}
+
+size_t poolTotalPeak(void) {
+    return total_peak;
+}
+
+void poolResetPeaks(void) {
+    for (int i = 0; i < MEM_POOL_COUNT; i++) {
+        pools[i].peak = pools[i].used;
+    }
+    total_peak = total_used;
+}
+
+size_t poolAvailable(MemoryPool pool) {
+    if (pool < 0 || pool >= MEM_POOL_COUNT || !pools[pool].available) {
+        return 0;
+    }
+    if (pool == MEM_POOL_MAIN) {
+        return getFreeHeapMemory();  // No fixed capacity, report the free heap
+    }
+    return pools[pool].capacity - pools[pool].used;
+}
+
+uint32_t poolFailures(MemoryPool pool) {
+    return (pool >= 0 && pool < MEM_POOL_COUNT) ? pools[pool].failures : 0;
+}
+
+void resetStaticPool(void) {
+    static_top = 0;
+    total_used -= pools[MEM_POOL_STATIC].used;
+    pools[MEM_POOL_STATIC].used = 0;
+}
+
+const char* poolName(MemoryPool pool) {
+    return (pool >= 0 && pool < MEM_POOL_COUNT) ? pool_names[pool] : "?";
+}
+
+void printPoolStats(const char* label) {
+    Serial.print("Memory pools (");
+    Serial.print(label ? label : "");
+    Serial.println("):");
+    for (int i = 0; i < MEM_POOL_COUNT; i++) {
+        const PoolState* p = &pools[i];
+        if (!p->available) {
+            continue;
+        }
+        Serial.print("  ");
+        Serial.print(pool_names[i]);
+        Serial.print(": used ");
+        Serial.print((unsigned long)(p->used / 1024));
+        Serial.print(" KB, peak ");
+        Serial.print((unsigned long)(p->peak / 1024));
+        Serial.print(" KB");
+        if (p->capacity > 0) {
+            Serial.print(" of ");
+            Serial.print((unsigned long)(p->capacity / 1024));
+            Serial.print(" KB");
+        }
+        if (p->failures > 0) {
+            Serial.print(", ");
+            Serial.print((unsigned long)p->failures);
+            Serial.print(" failed");
+        }
+        Serial.println();
+    }
+}
+
+bool bumpArenaInit(BumpArena* arena, size_t capacity, MemoryPool preferred) {
+    if (!arena) {
+        return false;
+    }
+    arena->base = NULL;
+    arena->capacity = 0;
+    arena->used = 0;
+    capacity = bumpAlignedSize(capacity);
+    arena->base = (uint8_t*)poolAlloc(capacity, preferred);
+    if (!arena->base) {
+        return false;
+    }
+    arena->capacity = capacity;
+    return true;
+}
+
+void* bumpAlloc(BumpArena* arena, size_t size) {
+    if (!arena || !arena->base) {
+        return NULL;
+    }
+    size_t aligned = bumpAlignedSize(size);
+    if (aligned < size || aligned > arena->capacity - arena->used) {
+        return NULL;
+    }
+    void* ptr = arena->base + arena->used;
+    arena->used += aligned;
+    return ptr;
+}
+
+size_t bumpMark(const BumpArena* arena) {
+    return arena ? arena->used : 0;
+}
+
+void bumpReset(BumpArena* arena, size_t mark) {
+    if (arena && mark <= arena->used) {
+        arena->used = mark;
+    }
+}
+
+void bumpArenaRelease(BumpArena* arena) {
+    if (!arena) {
+        return;
+    }
+    poolFree(arena->base);
+    arena->base = NULL;
+    arena->capacity = 0;
+    arena->used = 0;
+}
@@ -0,0 +1,109 @@
+#ifndef MEMORY_ARENA_H
+#define MEMORY_ARENA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Memory pools used by the pipeline
+//
+// All large pipeline buffers (ICER buffers, datastream, wavelet column batches,
+// RAM-tier files) are allocated through this module instead of calling
+// up_gnssram_malloc()/malloc() directly. Every allocation records the pool it
+// came from, so poolFree() always returns memory to the right allocator, and
+// per-pool usage is tracked for the memory reports and the buffer planner.
+enum MemoryPool {
+    MEM_POOL_GNSS = 0,   // 640 KB GNSS RAM (only if the GNSS core is not used)
+    MEM_POOL_MAIN,       // Main core heap (malloc)
+    MEM_POOL_STATIC,     // Caller-provided static region (bump only, see initMemoryPools)
+    MEM_POOL_COUNT
+};
+
+// Size of the GNSS RAM pool (Spresense SDK 3.2.0+ with updated bootloader)
+#define MEM_GNSS_RAM_SIZE (640 * 1024)
+
+// Single initialization call, after up_gnssram_initialize() on the board
+// gnss_ram_available: allocate from GNSS RAM (on the host the pool is simulated
+//                     with malloc, limited to MEM_GNSS_RAM_SIZE, so fallback
+//                     behaviour matches the board)
+// static_region:      Optional memory for MEM_POOL_STATIC (e.g. a static array);
+//                     static allocations are bump allocated and only returned
+//                     when freed in reverse order or by resetStaticPool()
+void initMemoryPools(bool gnss_ram_available, void* static_region = NULL, size_t static_size = 0);
+
+// Allocate size bytes, trying the preferred pool first and then GNSS RAM and
+// the main heap (8-byte aligned). Returns NULL if no pool has room.
+void* poolAlloc(size_t size, MemoryPool preferred);
+
+// Free memory from poolAlloc() (NULL is ignored)
+void poolFree(void* ptr);
+
+// Pool an allocation came from
+MemoryPool poolOf(const void* ptr);
+
+// Per-pool accounting (bytes, including the small per-allocation header)
+size_t poolUsed(MemoryPool pool);       // Currently allocated
+size_t poolPeak(MemoryPool pool);       // High-water mark since initMemoryPools()
+size_t poolAvailable(MemoryPool pool);  // Estimated free space (0 if the pool is not available)
+uint32_t poolFailures(MemoryPool pool); // Allocations this pool could not satisfy
+
+// Combined accounting over all pools
+size_t poolTotalUsed(void);
+size_t poolTotalPeak(void);             // High-water mark of the sum since initMemoryPools() or poolResetPeaks()
+
+// Restart the high-water marks (per pool and combined) from the current usage,
+// to measure the peak of one operation
+void poolResetPeaks(void);
+
+// Release every static pool allocation at once
+void resetStaticPool(void);
+
+// Name of a pool for reports ("gnss", "main", "static")
+const char* poolName(MemoryPool pool);
+
+// Print per-pool usage to Serial
+void printPoolStats(const char* label);
+
+// Bump allocator for scratch memory
+// One block is taken from a pool up front; allocations are carved out of it
+// with no per-allocation overhead and are released all at once (or back to a
+// mark), so a frame's scratch buffers can never fragment the heaps.
+typedef struct {
+    uint8_t* base;
+    size_t capacity;
+    size_t used;
+} BumpArena;
+
+// Take capacity bytes from the pools for the arena. Returns false if no pool has room.
+bool bumpArenaInit(BumpArena* arena, size_t capacity, MemoryPool preferred);
+
+// Allocate from the arena (8-byte aligned). Returns NULL if the arena is full.
+void* bumpAlloc(BumpArena* arena, size_t size);
+
+// Current fill level, to be passed to bumpReset() later
+size_t bumpMark(const BumpArena* arena);
+
+// Release every allocation made after mark (0 = everything)
+void bumpReset(BumpArena* arena, size_t mark = 0);
+
+// Return the arena's block to its pool
+void bumpArenaRelease(BumpArena* arena);
+
+// Bytes needed for size once rounded up to the arena alignment (for sizing arenas)
+static inline size_t bumpAlignedSize(size_t size) {
+    return (size + 7) & ~(size_t)7;
+}
+
+// Scoped scratch: everything allocated from the arena while the scope object
+// lives is released when it goes out of scope
+class ScopedBump {
+private:
+    BumpArena* arena;
+    size_t mark;
+
+public:
+    explicit ScopedBump(BumpArena* bump_arena) : arena(bump_arena), mark(bumpMark(bump_arena)) {}
+    ~ScopedBump() { bumpReset(arena, mark); }
+};
+
+#endif // MEMORY_ARENA_H
@@ -4,6 +4,15 @@
 
 #ifdef __arm__
 #include <malloc.h>
+#elif defined(__linux__)
+// Host build: heap statistics from glibc, free memory from the kernel
+#include <malloc.h>
+#include <unistd.h>
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#define HOST_MALLINFO() mallinfo2()
+#else
+#define HOST_MALLINFO() mallinfo()
+#endif
 #else
 extern char* __brkval;
 extern char* __heap_start;
@@ -13,6 +22,14 @@ size_t getFreeHeapMemory(void) {
 #ifdef __arm__
     struct mallinfo mi = mallinfo();
     return (size_t)mi.fordblks;
+#elif defined(__linux__)
+    // The host heap grows on demand, so "free heap" is the available physical memory
+    long pages = sysconf(_SC_AVPHYS_PAGES);
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (pages < 0 || page_size < 0) {
+        return 0;
+    }
+    return (size_t)pages * (size_t)page_size;
 #else
     // AVR: Use standard Arduino approach
     char stack_dummy = 0;
@@ -31,6 +48,8 @@ size_t getTotalHeapSize(void) {
 #ifdef __arm__
     struct mallinfo mi = mallinfo();
     return (size_t)mi.arena;
+#elif defined(__linux__)
+    return (size_t)HOST_MALLINFO().arena;
 #else
     return 0;
 #endif
@@ -40,6 +59,8 @@ size_t getUsedHeapMemory(void) {
 #ifdef __arm__
     struct mallinfo mi = mallinfo();
     return (size_t)mi.uordblks;
+#elif defined(__linux__)
+    return (size_t)HOST_MALLINFO().uordblks;
 #else
     // AVR: Use standard Arduino approach
     char* heap_top = (__brkval == 0) ? (char*)&__heap_start : __brkval;
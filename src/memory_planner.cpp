@@ -0,0 +1,185 @@
+#include "memory_planner.h"
+#include "memory_monitor.h"
+#include <Arduino.h>
+#include <string.h>
+
+// Limits of the planned sizes
+#define PLAN_MIN_DATASTREAM_BYTES (16 * 1024)   // Below this ICER cannot hold the segment headers
+#define PLAN_MIN_COPY_BUFFER_BYTES 512
+#define PLAN_MAX_COPY_BUFFER_BYTES (32 * 1024)  // Larger chunks no longer reduce per-call overhead
+#define PLAN_MIN_WRITE_BACK_BYTES 1024
+#define PLAN_MAX_WRITE_BACK_BYTES (16 * 1024)
+#define PLAN_MIN_READ_AHEAD_BYTES 4096
+#define PLAN_MAX_READ_AHEAD_BYTES (64 * 1024)
+#define PLAN_LARGE_JPEG_WORK_BYTES 8192         // Room for JPEGs with extra Huffman/quantization tables
+#define PLAN_DATASTREAM_MARGIN 512              // Same margin as the historical datastream sizing
+
+static const BufferPlan default_plan = {
+    PLAN_DEFAULT_COLUMN_BATCH_BYTES,
+    0,
+    0,
+    PLAN_DEFAULT_DATASTREAM_BYTES,
+    PLAN_DEFAULT_COPY_BUFFER_BYTES,
+    PLAN_DEFAULT_WRITE_BACK_BYTES,
+    PLAN_DEFAULT_WRITE_BACK_COUNT,
+    PLAN_DEFAULT_READ_AHEAD_BYTES,
+    PLAN_DEFAULT_JPEG_WORK_BYTES,
+    false,
+    true
+};
+
+static BufferPlan active_plan = default_plan;
+static size_t reserves[MEM_POOL_COUNT] = { 0 };
+
+// Free memory minus 1/8 slack: a heap with N bytes free rarely has one N byte block
+static inline size_t usable(size_t free_bytes) {
+    return free_bytes - free_bytes / 8;
+}
+
+// Largest power of two <= value (0 for 0)
+static inline size_t floorPow2(size_t value) {
+    size_t p = 1;
+    if (value == 0) {
+        return 0;
+    }
+    while (p <= value / 2) {
+        p <<= 1;
+    }
+    return p;
+}
+
+static inline size_t clampSize(size_t value, size_t lo, size_t hi) {
+    return (value < lo) ? lo : (value > hi) ? hi : value;
+}
+
+void setMemoryReserve(MemoryPool pool, size_t bytes) {
+    if (pool >= 0 && pool < MEM_POOL_COUNT) {
+        reserves[pool] = bytes;
+    }
+}
+
+void getMemoryBudget(MemoryBudget* budget) {
+    if (!budget) {
+        return;
+    }
+    size_t gnss = poolAvailable(MEM_POOL_GNSS);
+    size_t main_heap = getFreeHeapMemory();
+    budget->gnss_free = (gnss > reserves[MEM_POOL_GNSS]) ? gnss - reserves[MEM_POOL_GNSS] : 0;
+    budget->main_free = (main_heap > reserves[MEM_POOL_MAIN]) ? main_heap - reserves[MEM_POOL_MAIN] : 0;
+}
+
+int planBuffers(size_t width, size_t height, uint8_t segments, size_t target_size,
+                const MemoryBudget* budget, BufferPlan* plan) {
+    if (width == 0 || height == 0 || segments == 0 || !budget || !plan) {
+        return -1;
+    }
+    if (height > SIZE_MAX / sizeof(uint16_t) || width > SIZE_MAX / sizeof(uint16_t) / height) {
+        return -1;
+    }
+
+    *plan = default_plan;
+    plan->fits = true;
+
+    size_t gnss = usable(budget->gnss_free);
+    size_t main_heap = usable(budget->main_free);
+    size_t largest = (gnss > main_heap) ? gnss : main_heap;  // Each buffer is one block from one pool
+
+    // Wavelet column pass: buffer as many stage 0 columns as fit, up to the whole channel
+    size_t col_size = height * sizeof(uint16_t);
+    size_t channel_bytes = width * col_size;
+    size_t batch = (largest < channel_bytes) ? largest : channel_bytes;
+    batch -= batch % col_size;
+    if (batch < col_size) {
+        batch = col_size;  // One column at a time is the minimum the transform needs
+        plan->fits = false;
+    }
+    plan->column_batch_bytes = batch;
+    plan->column_batch_cols = batch / col_size;
+
+    // Partition: largest segment of a stage 1 subband plus its 1 pixel border
+    // (estimate; the exact size follows from ICER's partition parameters)
+    size_t sub_w = (width + 1) / 2;
+    size_t sub_h = (height + 1) / 2;
+    size_t seg_pixels = (sub_w * sub_h + segments - 1) / segments + 2 * (sub_w + sub_h) + 4;
+    plan->segment_buffer_bytes = seg_pixels * sizeof(uint16_t);
+
+    // Datastream: byte quota plus margin, limited by what is left next to the
+    // segment buffer (which comes from the main heap at the same time)
+    size_t byte_quota = target_size;
+    if (byte_quota == 0) {
+        byte_quota = (width * height > SIZE_MAX / 6) ? SIZE_MAX : width * height * 6;
+    }
+    size_t wanted = (byte_quota > SIZE_MAX - PLAN_DATASTREAM_MARGIN) ? SIZE_MAX : byte_quota + PLAN_DATASTREAM_MARGIN;
+    size_t main_left = (main_heap > plan->segment_buffer_bytes) ? main_heap - plan->segment_buffer_bytes : 0;
+    size_t stream_room = (gnss > main_left) ? gnss : main_left;
+    plan->datastream_bytes = (wanted < stream_room) ? wanted : stream_room;
+    if (plan->datastream_bytes < PLAN_MIN_DATASTREAM_BYTES) {
+        plan->datastream_bytes = (wanted < PLAN_MIN_DATASTREAM_BYTES) ? wanted : PLAN_MIN_DATASTREAM_BYTES;
+        if (plan->datastream_bytes > stream_room) {
+            plan->fits = false;
+        }
+    }
+    plan->quota_limited = plan->datastream_bytes < wanted;
+
+    // Streaming copies
+    plan->copy_buffer_bytes = clampSize(floorPow2(largest / 64), PLAN_MIN_COPY_BUFFER_BYTES, PLAN_MAX_COPY_BUFFER_BYTES);
+
+    // Async layer buffers live in the main heap for the whole run
+    plan->write_back_bytes = clampSize(floorPow2(main_heap / 64), PLAN_MIN_WRITE_BACK_BYTES, PLAN_MAX_WRITE_BACK_BYTES);
+    plan->write_back_count = (main_heap >= 1024 * 1024) ? 3 : 2;
+    size_t read_ahead = floorPow2(main_heap / 32);
+    size_t row_bytes = width * sizeof(uint16_t);
+    if (read_ahead < row_bytes) {
+        read_ahead = row_bytes;  // Row-by-row reads are the main thing worth prefetching
+    }
+    plan->read_ahead_bytes = clampSize(read_ahead, PLAN_MIN_READ_AHEAD_BYTES, PLAN_MAX_READ_AHEAD_BYTES);
+
+    // JPEG decoder: the minimum for baseline 3 component JPEGs when memory is tight
+    plan->jpeg_work_bytes = (main_heap >= 32 * PLAN_LARGE_JPEG_WORK_BYTES) ? PLAN_LARGE_JPEG_WORK_BYTES
+                                                                          : PLAN_DEFAULT_JPEG_WORK_BYTES;
+    return 0;
+}
+
+const BufferPlan* currentBufferPlan(void) {
+    return &active_plan;
+}
+
+void setBufferPlan(const BufferPlan* plan) {
+    active_plan = plan ? *plan : default_plan;
+}
+
+void printBufferPlan(const BufferPlan* plan) {
+    if (!plan) {
+        return;
+    }
+    Serial.println("Buffer plan:");
+    Serial.print("  Wavelet column batch: ");
+    Serial.print((unsigned long)(plan->column_batch_bytes / 1024));
+    Serial.print(" KB (");
+    Serial.print((unsigned long)plan->column_batch_cols);
+    Serial.println(" columns at stage 0)");
+    Serial.print("  Segment buffer: ~");
+    Serial.print((unsigned long)(plan->segment_buffer_bytes / 1024));
+    Serial.println(" KB");
+    Serial.print("  Datastream: ");
+    Serial.print((unsigned long)(plan->datastream_bytes / 1024));
+    Serial.print(" KB");
+    if (plan->quota_limited) {
+        Serial.print(" (limits the byte quota)");
+    }
+    Serial.println();
+    Serial.print("  Copy buffer: ");
+    Serial.print((unsigned long)plan->copy_buffer_bytes);
+    Serial.print(" B, write-back: ");
+    Serial.print((unsigned long)plan->write_back_count);
+    Serial.print(" x ");
+    Serial.print((unsigned long)plan->write_back_bytes);
+    Serial.print(" B, read-ahead: ");
+    Serial.print((unsigned long)plan->read_ahead_bytes);
+    Serial.print(" B, JPEG work: ");
+    Serial.print((unsigned long)plan->jpeg_work_bytes);
+    Serial.println(" B");
+    if (!plan->fits) {
+        Serial.println("  WARNING: minimum buffer sizes exceed free memory");
+    }
+}
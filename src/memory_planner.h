@@ -0,0 +1,65 @@
+#ifndef MEMORY_PLANNER_H
+#define MEMORY_PLANNER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "memory_arena.h"
+
+// Buffer sizes used when no plan has been made (the historical fixed values)
+#define PLAN_DEFAULT_COLUMN_BATCH_BYTES (150 * 1024)
+#define PLAN_DEFAULT_DATASTREAM_BYTES (400 * 1024)
+#define PLAN_DEFAULT_COPY_BUFFER_BYTES 4096
+#define PLAN_DEFAULT_WRITE_BACK_BYTES 4096
+#define PLAN_DEFAULT_WRITE_BACK_COUNT 2
+#define PLAN_DEFAULT_READ_AHEAD_BYTES 32768
+#define PLAN_DEFAULT_JPEG_WORK_BYTES 3500
+
+// Free memory the planner may hand out, per pool
+typedef struct {
+    size_t gnss_free;   // GNSS RAM pool (0 if not available)
+    size_t main_free;   // Main heap
+} MemoryBudget;
+
+// Buffer plan for one frame
+// Each phase of the pipeline runs on its own (camera ingest, wavelet, sign
+// magnitude, partition), so every phase may use the whole budget; buffers that
+// are alive at the same time (datastream + segment buffer) share it.
+typedef struct {
+    size_t column_batch_bytes;   // Wavelet column pass buffer (columns per batch = bytes / column size)
+    size_t column_batch_cols;    // Columns per batch at stage 0 (for reporting)
+    size_t segment_buffer_bytes; // Estimated partition segment buffer (fixed by geometry)
+    size_t datastream_bytes;     // ICER output buffer, limits the effective byte quota
+    size_t copy_buffer_bytes;    // Chunk size of streaming file copies
+    size_t write_back_bytes;     // Async layer write buffer size
+    uint8_t write_back_count;    // Async layer write buffers per file
+    size_t read_ahead_bytes;     // Largest read the async layer prefetches
+    size_t jpeg_work_bytes;      // tjpgd work buffer
+    bool quota_limited;          // Datastream smaller than byte quota + margin (output is cut short)
+    bool fits;                   // False if even the minimum sizes do not fit the budget
+} BufferPlan;
+
+// Memory kept out of every plan, e.g. the RAM tier budget that shares GNSS RAM
+// or heap headroom for the camera and SD drivers (default 0)
+void setMemoryReserve(MemoryPool pool, size_t bytes);
+
+// Read the current free memory of each pool, minus the reserves
+void getMemoryBudget(MemoryBudget* budget);
+
+// Plan buffer sizes for a width x height frame
+// segments and target_size are the ICER parameters (target_size 0 = lossless,
+// byte quota width * height * 6). Returns 0 on success, -1 on invalid
+// parameters; plan->fits tells whether the minimum sizes fit the budget.
+int planBuffers(size_t width, size_t height, uint8_t segments, size_t target_size,
+                const MemoryBudget* budget, BufferPlan* plan);
+
+// Plan every pipeline stage follows (defaults until setBufferPlan() is called)
+const BufferPlan* currentBufferPlan(void);
+
+// Make plan the current plan (NULL restores the defaults)
+void setBufferPlan(const BufferPlan* plan);
+
+// Print a plan to Serial
+void printBufferPlan(const BufferPlan* plan);
+
+#endif // MEMORY_PLANNER_H
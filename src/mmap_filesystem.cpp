@@ -0,0 +1,263 @@
+#include "mmap_filesystem.h"
+#include "host_path_filesystem.h"
+#include "icer_profile.h"
+
+// mmap backend is for host builds only; the Spresense build uses SDHCI
+#ifndef ARDUINO
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+// Concrete implementation of IFileSystem and IFile on top of mmap(MAP_SHARED)
+//
+// The mapping length (reserved) is independent of the file size: touching
+// mapped pages beyond EOF is never done, and once ftruncate() grows the file
+// those pages become valid inside the existing mapping. This keeps remaps rare
+// (geometric growth) while the on-disk size always equals the bytes written.
+
+// Smallest mapping we create, also used for empty files (mmap of 0 bytes fails)
+static const size_t MMAP_MIN_RESERVE = 64 * 1024;
+
+// mmap file implementation (defined first so it can be used by MmapFileSystem)
+class MmapFile : public IFile {
+private:
+    int fd;
+    bool writable;
+    uint8_t* map;       // Base of the mapping (NULL if not mapped)
+    size_t reserved;    // Length of the mapping
+    size_t file_size;   // Current file size as known by this handle
+    size_t pos;
+
+    // Make sure [0, end) is covered by the mapping, remapping if required
+    bool ensureMapped(size_t end) {
+        if (map && end <= reserved) {
+            return true;
+        }
+        size_t new_reserved = reserved ? reserved : MMAP_MIN_RESERVE;
+        while (new_reserved < end) {
+            new_reserved *= 2;
+        }
+        int prot = writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+        void* new_map = mmap(NULL, new_reserved, prot, MAP_SHARED, fd, 0);
+        if (new_map == MAP_FAILED) {
+            return false;
+        }
+        if (map) {
+            munmap(map, reserved);
+        }
+        map = (uint8_t*)new_map;
+        reserved = new_reserved;
+        return true;
+    }
+
+    // Re-read the file size (another handle may have grown the file)
+    void refreshSize() {
+        struct stat st;
+        if (fstat(fd, &st) == 0) {
+            file_size = (size_t)st.st_size;
+        }
+    }
+
+public:
+    MmapFile(int file_fd, bool is_writable)
+        : fd(file_fd), writable(is_writable), map(NULL), reserved(0), file_size(0), pos(0) {
+        refreshSize();
+        if (writable) {
+            pos = file_size;  // Arduino FILE_WRITE starts at the end of the file
+        }
+    }
+
+    // Map the current file contents, returns false if mmap() is not possible
+    bool init() {
+        if (!ensureMapped(file_size)) {
+            return false;
+        }
+        if (!writable) {
+            madvise(map, reserved, MADV_SEQUENTIAL);
+        }
+        return true;
+    }
+
+    // Destructor: closes file if still open
+    ~MmapFile() override {
+        if (fd >= 0) {
+            close();
+        }
+    }
+
+    // Read data from file
+    size_t read(uint8_t* buffer, size_t size) override {
+        if (fd < 0 || !buffer) {
+            return 0;
+        }
+        ICER_PROFILE_SCOPE(ICER_ZONE_IO_READ);
+        if (pos + size > file_size) {
+            refreshSize();
+        }
+        if (pos >= file_size) {
+            return 0;  // EOF
+        }
+        size_t n = file_size - pos;
+        if (n > size) {
+            n = size;
+        }
+        if (!ensureMapped(pos + n)) {
+            return 0;
+        }
+        memcpy(buffer, map + pos, n);
+        pos += n;
+        return n;
+    }
+
+    // Write data to file, growing it to exactly pos + size if needed
+    size_t write(const uint8_t* data, size_t size) override {
+        if (fd < 0 || !writable || !data) {
+            return 0;
+        }
+        ICER_PROFILE_SCOPE(ICER_ZONE_IO_WRITE);
+        size_t end = pos + size;
+        if (end > file_size) {
+            refreshSize();
+            if (end > file_size) {
+                if (ftruncate(fd, (off_t)end) != 0) {
+                    return 0;
+                }
+                file_size = end;
+            }
+        }
+        if (!ensureMapped(end)) {
+            return 0;
+        }
+        memcpy(map + pos, data, size);
+        pos = end;
+        return size;
+    }
+
+    // Seek to a specific position (seeking past EOF is allowed, like lseek())
+    bool seek(size_t position) override {
+        if (fd < 0) {
+            return false;
+        }
+        pos = position;
+        return true;
+    }
+
+    // Reserve space without writing data
+    // Grows the file once and maps it in full, so the following writes are plain
+    // memcpy() calls with no ftruncate() or remap in between.
+    bool reserve(size_t size) override {
+        if (fd < 0 || !writable) {
+            return false;
+        }
+        refreshSize();
+        if (size > file_size) {
+            #ifdef __linux__
+            if (fallocate(fd, 0, 0, (off_t)size) != 0 && ftruncate(fd, (off_t)size) != 0) {
+                return false;
+            }
+            #else
+            if (ftruncate(fd, (off_t)size) != 0) {
+                return false;
+            }
+            #endif
+            file_size = size;
+        }
+        return ensureMapped(size);
+    }
+
+    // Get current file position
+    size_t position() override {
+        if (fd < 0) {
+            return 0;
+        }
+        return pos;
+    }
+
+    // Get file size
+    size_t size() override {
+        if (fd < 0) {
+            return 0;
+        }
+        refreshSize();
+        return file_size;
+    }
+
+    // Flush buffered data
+    // MAP_SHARED writes are already in the page cache and visible to every other
+    // handle; like the POSIX backend we skip msync() since nothing needs durability.
+    bool flush() override {
+        return fd >= 0;
+    }
+
+    // Close the file
+    bool close() override {
+        if (fd < 0) {
+            return true;  // Already closed
+        }
+        if (map) {
+            munmap(map, reserved);
+            map = NULL;
+            reserved = 0;
+        }
+        int res = ::close(fd);
+        fd = -1;
+        return res == 0;
+    }
+
+    // Check if file is open
+    bool isOpen() const override {
+        return fd >= 0;
+    }
+
+    // Boolean conversion operator
+    operator bool() const override {
+        return fd >= 0;
+    }
+};
+
+// mmap file system implementation
+class MmapFileSystem : public HostPathFileSystem {
+public:
+    MmapFileSystem(const char* root_dir) : HostPathFileSystem(root_dir) {}
+
+    // Open a file
+    IFile* open(const char* filename, int mode) override {
+        char* path = makePath(filename);
+        if (!path) {
+            return nullptr;
+        }
+
+        bool writable = (mode != FILE_READ);
+        // Writers need O_RDWR (not O_WRONLY) for a PROT_WRITE shared mapping
+        int fd = writable ? ::open(path, O_RDWR | O_CREAT, 0644) : ::open(path, O_RDONLY);
+        free(path);
+        if (fd < 0) {
+            return nullptr;
+        }
+
+        MmapFile* file = new MmapFile(fd, writable);
+        if (!file->init()) {
+            delete file;
+            return nullptr;
+        }
+        return file;
+    }
+};
+
+// Factory function to create an mmap file system backend
+IFileSystem* createMmapFileSystem(const char* root_dir) {
+    MmapFileSystem* fs = new MmapFileSystem(root_dir);
+    if (!fs->isValid()) {
+        delete fs;
+        return NULL;
+    }
+    return fs;
+}
+
+#endif // !ARDUINO
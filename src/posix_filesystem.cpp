@@ -0,0 +1,202 @@
+#include "posix_filesystem.h"
+#include "host_path_filesystem.h"
+#include "icer_profile.h"
+
+// POSIX backend is for host builds only; the Spresense build uses SDHCI
+#ifndef ARDUINO
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+// Concrete implementation of IFileSystem and IFile on top of pread()/pwrite()
+// Each file keeps its own position, so reads and writes never go through lseek()
+
+// POSIX file implementation (defined first so it can be used by PosixFileSystem)
+class PosixFile : public IFile {
+private:
+    int fd;
+    size_t pos;
+
+public:
+    // Constructor: takes ownership of an open file descriptor
+    PosixFile(int file_fd, size_t start_pos) : fd(file_fd), pos(start_pos) {}
+
+    // Destructor: closes file if still open
+    ~PosixFile() override {
+        if (fd >= 0) {
+            close();
+        }
+    }
+
+    // Read data from file (loops over short reads, stops at EOF)
+    size_t read(uint8_t* buffer, size_t size) override {
+        if (fd < 0 || !buffer) {
+            return 0;
+        }
+        ICER_PROFILE_SCOPE(ICER_ZONE_IO_READ);
+        size_t total = 0;
+        while (total < size) {
+            ssize_t n = pread(fd, buffer + total, size - total, (off_t)(pos + total));
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            if (n == 0) {
+                break;  // EOF
+            }
+            total += (size_t)n;
+        }
+        pos += total;
+        return total;
+    }
+
+    // Write data to file (loops over short writes)
+    size_t write(const uint8_t* data, size_t size) override {
+        if (fd < 0 || !data) {
+            return 0;
+        }
+        ICER_PROFILE_SCOPE(ICER_ZONE_IO_WRITE);
+        size_t total = 0;
+        while (total < size) {
+            ssize_t n = pwrite(fd, data + total, size - total, (off_t)(pos + total));
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            if (n == 0) {
+                break;
+            }
+            total += (size_t)n;
+        }
+        pos += total;
+        return total;
+    }
+
+    // Seek to a specific position (seeking past EOF is allowed, like lseek())
+    bool seek(size_t position) override {
+        if (fd < 0) {
+            return false;
+        }
+        pos = position;
+        return true;
+    }
+
+    // Get current file position
+    size_t position() override {
+        if (fd < 0) {
+            return 0;
+        }
+        return pos;
+    }
+
+    // Get file size
+    size_t size() override {
+        if (fd < 0) {
+            return 0;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            return 0;
+        }
+        return (size_t)st.st_size;
+    }
+
+    // Flush buffered data
+    // pwrite() goes straight to the page cache, so there is nothing to flush here.
+    // We deliberately do not fsync(): durability is not needed for intermediates
+    // and fsync() would throttle the pipeline far below disk speed.
+    bool flush() override {
+        return fd >= 0;
+    }
+
+    // Reserve space without writing data
+    // fallocate() allocates the blocks up front (contiguous where the file system
+    // can), so later writes and seeks never have to extend the file. File systems
+    // without fallocate() support get a sparse extension through ftruncate().
+    bool reserve(size_t size) override {
+        if (fd < 0) {
+            return false;
+        }
+        if (size <= this->size()) {
+            return true;
+        }
+        #ifdef __linux__
+        if (fallocate(fd, 0, 0, (off_t)size) == 0) {
+            return true;
+        }
+        #endif
+        return ftruncate(fd, (off_t)size) == 0;
+    }
+
+    // Close the file
+    bool close() override {
+        if (fd < 0) {
+            return true;  // Already closed
+        }
+        int res = ::close(fd);
+        fd = -1;
+        return res == 0;
+    }
+
+    // Check if file is open
+    bool isOpen() const override {
+        return fd >= 0;
+    }
+
+    // Boolean conversion operator
+    operator bool() const override {
+        return fd >= 0;
+    }
+};
+
+// POSIX file system implementation
+class PosixFileSystem : public HostPathFileSystem {
+public:
+    PosixFileSystem(const char* root_dir) : HostPathFileSystem(root_dir) {}
+
+    // Open a file
+    IFile* open(const char* filename, int mode) override {
+        char* path = makePath(filename);
+        if (!path) {
+            return nullptr;
+        }
+
+        int fd;
+        size_t start_pos = 0;
+        if (mode == FILE_READ) {
+            fd = ::open(path, O_RDONLY);
+        } else {
+            // Arduino FILE_WRITE: create if missing, keep contents, position at end
+            fd = ::open(path, O_RDWR | O_CREAT, 0644);
+            if (fd >= 0) {
+                struct stat st;
+                if (fstat(fd, &st) == 0) {
+                    start_pos = (size_t)st.st_size;
+                }
+            }
+        }
+        free(path);
+
+        if (fd < 0) {
+            return nullptr;
+        }
+        return new PosixFile(fd, start_pos);
+    }
+};
+
+// Factory function to create a POSIX file system backend
+IFileSystem* createPosixFileSystem(const char* root_dir) {
+    PosixFileSystem* fs = new PosixFileSystem(root_dir);
+    if (!fs->isValid()) {
+        delete fs;
+        return NULL;
+    }
+    return fs;
+}
+
+#endif // !ARDUINO
@@ -0,0 +1,484 @@
+#include "simulated_sd_filesystem.h"
+#include <Arduino.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Simulated SD card layer: forwards every call and charges the card time the
+// call would take to a simulated clock
+//
+// The driver's sector buffer and the bytes since the last program stall are
+// shared by all files, like on the real card. Sequential access is tracked per
+// stream: the card keeps a few open allocation units, so interleaved transfers
+// to a handful of files (channel files, output, scratch) each stay sequential.
+// Files are told apart by a hash of their name, so a file that is reopened
+// still continues sequentially where its last transfer ended.
+//
+// The async layer may call into this one from its I/O thread, so the clock and
+// counters are serialized with a mutex.
+
+#if defined(__NuttX__) || defined(__unix__) || defined(__APPLE__)
+#define SIMULATED_SD_HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+class SimulatedSDFileSystem;
+
+// Streams the card keeps sequential at the same time
+#define SIMULATED_SD_STREAMS 4
+
+typedef struct {
+    uint32_t file;
+    uint64_t sector;    // Last sector of the stream's previous transfer
+} SdStream;
+
+// The simulated card simulatedSdSnapshot()/simulatedSdReset() operate on
+static SimulatedSDFileSystem* active_card = NULL;
+
+// FNV-1a, identifies a file across handles and reopens
+static uint32_t fileId(const char* filename) {
+    uint32_t hash = 2166136261u;
+    for (const char* c = filename; *c; c++) {
+        hash = (hash ^ (uint8_t)*c) * 16777619u;
+    }
+    return hash;
+}
+
+void simulatedSdDefaultParams(SimulatedSdParams* params) {
+    if (!params) {
+        return;
+    }
+    params->command_us = 250;
+    params->sector_size = 512;
+    params->read_kbps = 10000;
+    params->write_kbps = 4000;
+    params->random_ratio = 4;
+    params->lookup_us = 800;
+    params->create_us = 2500;
+    params->sync_us = 1500;
+    params->program_stall_us = 15000;
+    params->program_stall_bytes = 512 * 1024;
+}
+
+// Simulated SD file system implementation
+class SimulatedSDFileSystem : public IFileSystem {
+private:
+    IFileSystem* backing;
+    bool owns_backing;
+    SimulatedSdParams params;
+    SimulatedSdStats live;
+    SimulatedSdStats snapshot_buf;
+    SimulatedSDFileSystem* previous_card;  // Restored as active card on destruction
+
+    // Card and driver state
+    bool have_sector;           // cached_file/cached_sector are valid
+    uint32_t cached_file;
+    uint64_t cached_sector;     // Last sector transferred, held in the driver's sector buffer
+    uint64_t bytes_since_stall;
+    SdStream streams[SIMULATED_SD_STREAMS];  // Most recently used first
+    int stream_count;
+#ifdef SIMULATED_SD_HAVE_PTHREADS
+    pthread_mutex_t lock;
+#endif
+
+    void lockState() {
+#ifdef SIMULATED_SD_HAVE_PTHREADS
+        pthread_mutex_lock(&lock);
+#endif
+    }
+
+    void unlockState() {
+#ifdef SIMULATED_SD_HAVE_PTHREADS
+        pthread_mutex_unlock(&lock);
+#endif
+    }
+
+    // Time to move bytes at kbps (KB/s)
+    static uint64_t transferUs(uint64_t bytes, uint32_t kbps) {
+        return (kbps > 0) ? bytes * 1000000ull / ((uint64_t)kbps * 1024) : 0;
+    }
+
+public:
+    SimulatedSDFileSystem(IFileSystem* backing_fs, const SimulatedSdParams* card, bool take_ownership)
+        : backing(backing_fs), owns_backing(take_ownership), previous_card(active_card),
+          have_sector(false), cached_file(0), cached_sector(0), bytes_since_stall(0), stream_count(0) {
+        if (card) {
+            params = *card;
+        } else {
+            simulatedSdDefaultParams(&params);
+        }
+        if (params.sector_size == 0) {
+            params.sector_size = 512;
+        }
+        if (params.random_ratio == 0) {
+            params.random_ratio = 1;
+        }
+        memset(&live, 0, sizeof(live));
+        memset(&snapshot_buf, 0, sizeof(snapshot_buf));
+#ifdef SIMULATED_SD_HAVE_PTHREADS
+        pthread_mutex_init(&lock, NULL);
+#endif
+        active_card = this;
+    }
+
+    ~SimulatedSDFileSystem() override {
+        if (active_card == this) {
+            active_card = previous_card;
+        }
+#ifdef SIMULATED_SD_HAVE_PTHREADS
+        pthread_mutex_destroy(&lock);
+#endif
+        if (owns_backing && backing) {
+            delete backing;
+        }
+    }
+
+    // Move the stream of file to the front (evicting the least recently used one)
+    // Returns true if [first, last] continues the stream's previous transfer
+    bool continueStream(uint32_t file, uint64_t first, uint64_t last) {
+        int found = -1;
+        for (int i = 0; i < stream_count; i++) {
+            if (streams[i].file == file) {
+                found = i;
+                break;
+            }
+        }
+        bool sequential = false;
+        if (found >= 0) {
+            sequential = (first == streams[found].sector || first == streams[found].sector + 1);
+        } else if (stream_count < SIMULATED_SD_STREAMS) {
+            found = stream_count++;
+        } else {
+            found = SIMULATED_SD_STREAMS - 1;
+        }
+        for (int i = found; i > 0; i--) {
+            streams[i] = streams[i - 1];
+        }
+        streams[0].file = file;
+        streams[0].sector = last;
+        return sequential;
+    }
+
+    // Charge a read or write of bytes at position of file
+    void chargeTransfer(uint32_t file, size_t position, size_t bytes, bool is_write) {
+        if (bytes == 0) {
+            return;
+        }
+        uint64_t first = position / params.sector_size;
+        uint64_t last = (position + bytes - 1) / params.sector_size;
+        lockState();
+        if (is_write) {
+            live.bytes_written += bytes;
+        } else {
+            live.bytes_read += bytes;
+        }
+        if (have_sector && file == cached_file && first == cached_sector && last == cached_sector) {
+            // Inside the driver's sector buffer, no card access
+            live.cached_accesses++;
+            unlockState();
+            return;
+        }
+
+        bool sequential = continueStream(file, first, last);
+        uint64_t sector_bytes = (last - first + 1) * params.sector_size;
+        uint64_t transfer = transferUs(sector_bytes, is_write ? params.write_kbps : params.read_kbps);
+        if (!sequential) {
+            transfer *= params.random_ratio;
+            live.random_commands++;
+        }
+        live.commands++;
+        live.command_us += params.command_us;
+        live.transfer_us += transfer;
+        live.simulated_us += params.command_us + transfer;
+
+        if (is_write && params.program_stall_bytes > 0) {
+            bytes_since_stall += sector_bytes;
+            while (bytes_since_stall >= params.program_stall_bytes) {
+                bytes_since_stall -= params.program_stall_bytes;
+                live.stalls++;
+                live.stall_us += params.program_stall_us;
+                live.simulated_us += params.program_stall_us;
+            }
+        }
+
+        have_sector = true;
+        cached_file = file;
+        cached_sector = last;
+        unlockState();
+    }
+
+    // Charge a directory lookup, optionally with a file creation
+    void chargeLookup(bool create) {
+        uint32_t cost = params.lookup_us + (create ? params.create_us : 0);
+        lockState();
+        live.opens++;
+        live.lookup_us += cost;
+        live.simulated_us += cost;
+        unlockState();
+    }
+
+    // Charge the directory entry / FAT update of a written file
+    void chargeSync() {
+        lockState();
+        live.syncs++;
+        live.lookup_us += params.sync_us;
+        live.simulated_us += params.sync_us;
+        unlockState();
+    }
+
+    // Record real time spent in the backing file system since start_us
+    void recordHost(unsigned long start_us) {
+        uint32_t elapsed = (uint32_t)(micros() - start_us);
+        lockState();
+        live.host_us += elapsed;
+        unlockState();
+    }
+
+    void reset() {
+        lockState();
+        memset(&live, 0, sizeof(live));
+        have_sector = false;
+        bytes_since_stall = 0;
+        unlockState();
+    }
+
+    const SimulatedSdStats* snapshot() {
+        lockState();
+        memcpy(&snapshot_buf, &live, sizeof(live));
+        unlockState();
+        return &snapshot_buf;
+    }
+
+    bool begin() override {
+        return backing->begin();
+    }
+
+    IFile* open(const char* filename, int mode) override;
+
+    bool remove(const char* filename) override {
+        if (!filename) {
+            return false;
+        }
+        unsigned long start = micros();
+        bool ok = backing->remove(filename);
+        recordHost(start);
+        // Freeing the cluster chain is part of the directory update
+        chargeLookup(ok);
+        return ok;
+    }
+
+    bool exists(const char* filename) override {
+        if (!filename) {
+            return false;
+        }
+        unsigned long start = micros();
+        bool found = backing->exists(filename);
+        recordHost(start);
+        chargeLookup(false);
+        return found;
+    }
+
+    void setSizeHint(const char* filename, size_t expected_size) override {
+        backing->setSizeHint(filename, expected_size);
+    }
+
+    IFile* createPreallocated(const char* filename, size_t size) override;
+};
+
+// File wrapper: charges every call on the backing file to the card
+class SimulatedSDFile : public IFile {
+private:
+    SimulatedSDFileSystem* fs;
+    IFile* inner;
+    uint32_t id;
+    size_t pos;      // Tracked here so transfers can be placed without extra calls
+    bool dirty;      // Written since the last flush
+
+public:
+    SimulatedSDFile(SimulatedSDFileSystem* owner, IFile* file, uint32_t file_id)
+        : fs(owner), inner(file), id(file_id), pos(file->position()), dirty(false) {}
+
+    ~SimulatedSDFile() override {
+        if (inner) {
+            close();
+        }
+    }
+
+    size_t read(uint8_t* buffer, size_t size) override {
+        if (!inner) {
+            return 0;
+        }
+        unsigned long start = micros();
+        size_t n = inner->read(buffer, size);
+        fs->recordHost(start);
+        fs->chargeTransfer(id, pos, n, false);
+        pos += n;
+        return n;
+    }
+
+    size_t write(const uint8_t* data, size_t size) override {
+        if (!inner) {
+            return 0;
+        }
+        unsigned long start = micros();
+        size_t n = inner->write(data, size);
+        fs->recordHost(start);
+        fs->chargeTransfer(id, pos, n, true);
+        pos += n;
+        if (n > 0) {
+            dirty = true;
+        }
+        return n;
+    }
+
+    bool seek(size_t position) override {
+        if (!inner) {
+            return false;
+        }
+        unsigned long start = micros();
+        bool ok = inner->seek(position);
+        fs->recordHost(start);
+        if (ok) {
+            pos = position;
+        }
+        return ok;
+    }
+
+    size_t position() override {
+        return inner ? inner->position() : 0;
+    }
+
+    size_t size() override {
+        return inner ? inner->size() : 0;
+    }
+
+    bool flush() override {
+        if (!inner) {
+            return false;
+        }
+        unsigned long start = micros();
+        bool ok = inner->flush();
+        fs->recordHost(start);
+        if (dirty) {
+            fs->chargeSync();
+            dirty = false;
+        }
+        return ok;
+    }
+
+    bool reserve(size_t size) override {
+        return inner ? inner->reserve(size) : false;
+    }
+
+    bool close() override {
+        if (!inner) {
+            return true;  // Already closed
+        }
+        unsigned long start = micros();
+        bool ok = inner->close();
+        fs->recordHost(start);
+        if (dirty) {
+            fs->chargeSync();
+            dirty = false;
+        }
+        delete inner;
+        inner = NULL;
+        return ok;
+    }
+
+    bool isOpen() const override {
+        return inner != NULL;
+    }
+
+    operator bool() const override {
+        return inner != NULL;
+    }
+};
+
+IFile* SimulatedSDFileSystem::open(const char* filename, int mode) {
+    if (!filename) {
+        return nullptr;
+    }
+    unsigned long start = micros();
+    bool create = (mode == FILE_WRITE) && !backing->exists(filename);
+    IFile* file = backing->open(filename, mode);
+    recordHost(start);
+    chargeLookup(create && file != NULL);
+    if (!file) {
+        return nullptr;
+    }
+    return new SimulatedSDFile(this, file, fileId(filename));
+}
+
+IFile* SimulatedSDFileSystem::createPreallocated(const char* filename, size_t size) {
+    if (!filename) {
+        return nullptr;
+    }
+    // The SD backend extends the file with ftruncate(), so only the directory
+    // entry and the FAT chain are written: a create plus a sync
+    unsigned long start = micros();
+    IFile* file = backing->createPreallocated(filename, size);
+    recordHost(start);
+    chargeLookup(true);
+    if (!file) {
+        return nullptr;
+    }
+    chargeSync();
+    return new SimulatedSDFile(this, file, fileId(filename));
+}
+
+// Factory function to create a simulated SD card layer
+IFileSystem* createSimulatedSDFileSystem(IFileSystem* backing, const SimulatedSdParams* params, bool take_ownership) {
+    if (!backing) {
+        return NULL;
+    }
+    return new SimulatedSDFileSystem(backing, params, take_ownership);
+}
+
+void simulatedSdReset(void) {
+    if (active_card) {
+        active_card->reset();
+    }
+}
+
+const SimulatedSdStats* simulatedSdSnapshot(void) {
+    return active_card ? active_card->snapshot() : NULL;
+}
+
+void printSimulatedSdStats(const SimulatedSdStats* stats) {
+    if (!stats) {
+        return;
+    }
+    Serial.print("Simulated SD card: ");
+    Serial.print((unsigned long)(stats->simulated_us / 1000));
+    Serial.print(" ms (host I/O ");
+    Serial.print((unsigned long)(stats->host_us / 1000));
+    Serial.println(" ms)");
+    Serial.print("  commands: ");
+    Serial.print((unsigned long)stats->commands);
+    Serial.print(" (");
+    Serial.print((unsigned long)stats->random_commands);
+    Serial.print(" random, ");
+    Serial.print((unsigned long)stats->cached_accesses);
+    Serial.print(" from sector buffer), ");
+    Serial.print((unsigned long)(stats->command_us / 1000));
+    Serial.println(" ms");
+    Serial.print("  transfer: ");
+    Serial.print((unsigned long)(stats->bytes_read / 1024));
+    Serial.print(" KB read, ");
+    Serial.print((unsigned long)(stats->bytes_written / 1024));
+    Serial.print(" KB written, ");
+    Serial.print((unsigned long)(stats->transfer_us / 1000));
+    Serial.println(" ms");
+    Serial.print("  directory: ");
+    Serial.print((unsigned long)stats->opens);
+    Serial.print(" lookups, ");
+    Serial.print((unsigned long)stats->syncs);
+    Serial.print(" syncs, ");
+    Serial.print((unsigned long)(stats->lookup_us / 1000));
+    Serial.println(" ms");
+    Serial.print("  program stalls: ");
+    Serial.print((unsigned long)stats->stalls);
+    Serial.print(", ");
+    Serial.print((unsigned long)(stats->stall_us / 1000));
+    Serial.println(" ms");
+}
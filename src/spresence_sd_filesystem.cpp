@@ -1,5 +1,19 @@
 #include "filesystem_interface.h"
+#include "icer_profile.h"
 #include <SDHCI.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// The SDHCI library mounts the card here; files opened through SDClass are
+// relative to it, so POSIX calls on the same files need the prefix
+// (the host shim maps SDClass onto the current directory instead)
+#ifdef __NuttX__
+#define SD_MOUNT_POINT "/mnt/sd0/"
+#else
+#define SD_MOUNT_POINT ""
+#endif
 
 // Concrete implementation of IFileSystem and IFile for Spresence SD card library
 // This wraps the SDClass and File classes from SDHCI.h
@@ -26,6 +40,7 @@ public:
         if (!is_open) {
             return 0;
         }
+        ICER_PROFILE_SCOPE(ICER_ZONE_IO_READ);
         return file_handle.read(buffer, size);
     }
     
@@ -34,6 +49,7 @@ public:
         if (!is_open) {
             return 0;
         }
+        ICER_PROFILE_SCOPE(ICER_ZONE_IO_WRITE);
         return file_handle.write(data, size);
     }
     
@@ -105,6 +121,29 @@ private:
     SDClass* sd_card;
     bool owns_sd_card;  // If true, we own the SDClass and should delete it in destructor
     
+    // Create filename with exactly size bytes via open()/ftruncate() on the mount path
+    bool truncateFile(const char* filename, size_t size) {
+        while (*filename == '/') {
+            filename++;
+        }
+        size_t prefix_len = strlen(SD_MOUNT_POINT);
+        size_t name_len = strlen(filename);
+        char* path = (char*)malloc(prefix_len + name_len + 1);
+        if (!path) {
+            return false;
+        }
+        memcpy(path, SD_MOUNT_POINT, prefix_len);
+        memcpy(path + prefix_len, filename, name_len + 1);
+        int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        free(path);
+        if (fd < 0) {
+            return false;
+        }
+        bool ok = (ftruncate(fd, (off_t)size) == 0);
+        ::close(fd);
+        return ok;
+    }
+
 public:
     // Constructor: takes an existing SDClass pointer
     // If take_ownership is true, the SDClass will be deleted in destructor
@@ -166,6 +205,31 @@ public:
         return false;
     }
     
+    // Create a zero-filled file of the given size
+    // The Arduino File API has no way to allocate space, so the file is created
+    // and extended with ftruncate() on its mount path before SDClass opens it.
+    // The FAT driver then builds the whole cluster chain in one pass instead of
+    // updating the FAT every time a write crosses into a new cluster. If the
+    // driver cannot extend files this way, the generic zero-fill is used.
+    IFile* createPreallocated(const char* filename, size_t size) override {
+        if (!sd_card || !filename) {
+            return nullptr;
+        }
+        if (size > 0) {
+            sd_card->remove(filename);
+            if (truncateFile(filename, size)) {
+                File file = sd_card->open(filename, FILE_WRITE);
+                if (file && (size_t)file.size() == size && file.seek(0)) {
+                    return new SpresenceSDFile(file);
+                }
+                if (file) {
+                    file.close();
+                }
+            }
+        }
+        return IFileSystem::createPreallocated(filename, size);
+    }
+
     // Get the underlying SDClass pointer (for compatibility if needed)
     SDClass* getSDClass() const {
         return sd_card;
@@ -0,0 +1,186 @@
+#include "task_pool.h"
+#include <stdlib.h>
+
+#if defined(__NuttX__) || defined(__unix__) || defined(__APPLE__)
+#define TASK_POOL_HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+static ITaskPool* segment_task_pool = NULL;
+
+// Runs every task on the calling thread
+class SerialTaskPool : public ITaskPool {
+public:
+    int workerCount() const { return 1; }
+
+    void run(size_t count, TaskFunction function, void* context) {
+        for (size_t i = 0; i < count; i++) {
+            function(context, i, 0);
+        }
+    }
+};
+
+#ifdef TASK_POOL_HAVE_PTHREADS
+class ThreadTaskPool;
+
+// Start argument of one worker thread
+struct TaskWorker {
+    ThreadTaskPool* pool;
+    int id;
+    pthread_t thread;
+};
+
+// Worker threads waiting for run(); tasks are taken one at a time from a
+// shared counter, so uneven tasks (segments of different sizes) balance out
+class ThreadTaskPool : public ITaskPool {
+private:
+    TaskWorker* workers;
+    int thread_count;    // Started threads (workers 1 .. thread_count)
+    pthread_mutex_t lock;
+    pthread_cond_t work_cond;
+    pthread_cond_t done_cond;
+
+    // Current batch, protected by lock
+    TaskFunction function;
+    void* context;
+    size_t count;
+    size_t next;         // Next task to hand out
+    size_t finished;
+    bool stopping;
+
+    // Take and run tasks until none are left; called and returns with lock held
+    void drain(int worker) {
+        while (next < count) {
+            size_t index = next++;
+            pthread_mutex_unlock(&lock);
+
+            function(context, index, worker);
+
+            pthread_mutex_lock(&lock);
+            if (++finished == count) {
+                pthread_cond_broadcast(&done_cond);
+            }
+        }
+    }
+
+    static void* threadMain(void* arg) {
+        TaskWorker* worker = static_cast<TaskWorker*>(arg);
+        ThreadTaskPool* self = worker->pool;
+        pthread_mutex_lock(&self->lock);
+        for (;;) {
+            while (self->next >= self->count && !self->stopping) {
+                pthread_cond_wait(&self->work_cond, &self->lock);
+            }
+            if (self->stopping) {
+                break;
+            }
+            self->drain(worker->id);
+        }
+        pthread_mutex_unlock(&self->lock);
+        return NULL;
+    }
+
+public:
+    ThreadTaskPool() : workers(NULL), thread_count(0), function(NULL), context(NULL),
+                       count(0), next(0), finished(0), stopping(false) {
+        pthread_mutex_init(&lock, NULL);
+        pthread_cond_init(&work_cond, NULL);
+        pthread_cond_init(&done_cond, NULL);
+    }
+
+    ~ThreadTaskPool() {
+        pthread_mutex_lock(&lock);
+        stopping = true;
+        pthread_cond_broadcast(&work_cond);
+        pthread_mutex_unlock(&lock);
+        for (int i = 0; i < thread_count; i++) {
+            pthread_join(workers[i].thread, NULL);
+        }
+        free(workers);
+        pthread_cond_destroy(&done_cond);
+        pthread_cond_destroy(&work_cond);
+        pthread_mutex_destroy(&lock);
+    }
+
+    // Start up to thread_target threads; returns false only if out of memory
+    bool start(int thread_target) {
+        if (thread_target <= 0) {
+            return true;
+        }
+        workers = (TaskWorker*)malloc(sizeof(TaskWorker) * (size_t)thread_target);
+        if (!workers) {
+            return false;
+        }
+        for (int i = 0; i < thread_target; i++) {
+            workers[i].pool = this;
+            workers[i].id = i + 1;
+            pthread_attr_t attr;
+            pthread_attr_init(&attr);
+#ifdef __NuttX__
+            pthread_attr_setstacksize(&attr, TASK_POOL_STACK_SIZE);
+#endif
+            int created = pthread_create(&workers[i].thread, &attr, threadMain, &workers[i]);
+            pthread_attr_destroy(&attr);
+            if (created != 0) {
+                break;  // Run with the threads we have
+            }
+            thread_count++;
+        }
+        return true;
+    }
+
+    int workerCount() const { return thread_count + 1; }
+
+    void run(size_t task_count, TaskFunction task_function, void* task_context) {
+        if (task_count == 0) {
+            return;
+        }
+        pthread_mutex_lock(&lock);
+        function = task_function;
+        context = task_context;
+        count = task_count;
+        next = 0;
+        finished = 0;
+        pthread_cond_broadcast(&work_cond);
+
+        drain(0);
+        while (finished < count) {
+            pthread_cond_wait(&done_cond, &lock);
+        }
+        count = 0;
+        next = 0;
+        pthread_mutex_unlock(&lock);
+    }
+};
+#endif
+
+ITaskPool* createSerialTaskPool() {
+    return new SerialTaskPool();
+}
+
+ITaskPool* createThreadTaskPool(int worker_count) {
+#ifdef TASK_POOL_HAVE_PTHREADS
+    if (worker_count > 1) {
+        ThreadTaskPool* pool = new ThreadTaskPool();
+        if (!pool) {
+            return NULL;
+        }
+        if (!pool->start(worker_count - 1)) {
+            delete pool;
+            return NULL;
+        }
+        return pool;
+    }
+#else
+    (void)worker_count;
+#endif
+    return createSerialTaskPool();
+}
+
+void setSegmentTaskPool(ITaskPool* pool) {
+    segment_task_pool = pool;
+}
+
+ITaskPool* getSegmentTaskPool(void) {
+    return segment_task_pool;
+}
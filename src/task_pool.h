@@ -0,0 +1,55 @@
+#ifndef TASK_POOL_H
+#define TASK_POOL_H
+
+#include <stddef.h>
+
+// Stack for each worker thread on the board (one ICER bitplane coder call)
+#define TASK_POOL_STACK_SIZE 8192
+
+// Task body: index is the task number (0 .. count - 1), worker the worker
+// running it (0 .. workerCount() - 1, 0 is the thread that called run())
+typedef void (*TaskFunction)(void* context, size_t index, int worker);
+
+// Pool of workers for independent CPU-bound tasks (e.g. ICER segments)
+// run() hands out tasks in index order and blocks until all of them have
+// finished; tasks may finish in any order, so callers that need ordered
+// output commit the results after run() returns.
+class ITaskPool {
+public:
+    virtual ~ITaskPool() {}
+
+    // Number of tasks that can run at the same time
+    virtual int workerCount() const = 0;
+
+    // Run count tasks and wait for them (the calling thread takes tasks too)
+    virtual void run(size_t count, TaskFunction function, void* context) = 0;
+};
+
+// Factory function for a pool that runs every task on the calling thread
+//
+// Returns:
+//   Pointer to ITaskPool implementation, or NULL on failure (out of memory)
+//   Caller is responsible for deleting the returned pointer
+ITaskPool* createSerialTaskPool();
+
+// Factory function for a pthread pool (NuttX tasks on the board, POSIX threads
+// on the host)
+// worker_count - 1 threads are started; the thread calling run() is worker 0.
+// If fewer threads can be created the pool runs with what it got, and without
+// pthread support it is a serial pool.
+//
+// Parameters:
+//   worker_count: Tasks run at the same time (including the caller, >= 1)
+//
+// Returns:
+//   Pointer to ITaskPool implementation, or NULL on failure (out of memory)
+//   Caller is responsible for deleting the returned pointer (not while run() is active)
+ITaskPool* createThreadTaskPool(int worker_count);
+
+// Pool the flash partition encoder spreads segments over
+// NULL (the default) keeps the serial encoder. The pool is not owned; it must
+// outlive the compressions that use it.
+void setSegmentTaskPool(ITaskPool* pool);
+ITaskPool* getSegmentTaskPool(void);
+
+#endif // TASK_POOL_H
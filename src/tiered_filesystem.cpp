@@ -0,0 +1,457 @@
+#include "tiered_filesystem.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// Tiered IFileSystem: RAM tier for small intermediates, backing file system for the rest
+//
+// RAM files are kept in a small fixed table (no dynamic bookkeeping on the device).
+// Each RAM file has one buffer shared by all handles opened on it; every handle
+// keeps its own position, like separate File objects on the SD card.
+
+// Limits for the RAM tier (the pipeline only has a handful of intermediates alive at once)
+#define TIERED_MAX_RAM_FILES 8
+#define TIERED_MAX_HINTS 8
+#define TIERED_MAX_NAME 48
+
+// One file held in RAM
+struct TieredRamEntry {
+    bool used;
+    char name[TIERED_MAX_NAME];
+    uint8_t* data;      // Buffer from the RAM allocator (NULL once spilled)
+    size_t capacity;    // Size of data, counted against the RAM budget
+    size_t size;        // Current file size
+    int refs;           // Open handles on this entry
+    bool unlinked;      // remove() was called while handles were still open
+    bool spilled;       // Contents moved to the backing file system
+};
+
+// Pending size hint set by setSizeHint(), consumed by the next creating open()
+struct TieredSizeHint {
+    bool used;
+    char name[TIERED_MAX_NAME];
+    size_t size;
+};
+
+class TieredRamFile;
+
+// Tiered file system implementation
+class TieredFileSystem : public IFileSystem {
+private:
+    IFileSystem* backing;
+    bool owns_backing;
+    size_t ram_budget;
+    size_t ram_used;
+    TieredRamAlloc ram_alloc;
+    TieredRamFree ram_free;
+    TieredRamEntry entries[TIERED_MAX_RAM_FILES];
+    TieredSizeHint hints[TIERED_MAX_HINTS];
+
+    // Take (and clear) the pending size hint for filename, 0 if none
+    size_t takeHint(const char* filename) {
+        for (int i = 0; i < TIERED_MAX_HINTS; i++) {
+            if (hints[i].used && strcmp(hints[i].name, filename) == 0) {
+                hints[i].used = false;
+                return hints[i].size;
+            }
+        }
+        return 0;
+    }
+
+    void freeEntry(TieredRamEntry* entry) {
+        if (entry->data) {
+            ram_free(entry->data);
+            ram_used -= entry->capacity;
+        }
+        entry->data = NULL;
+        entry->capacity = 0;
+        entry->size = 0;
+        entry->used = false;
+    }
+
+public:
+    TieredFileSystem(IFileSystem* backing_fs, size_t budget, TieredRamAlloc alloc_fn,
+                     TieredRamFree free_fn, bool take_ownership)
+        : backing(backing_fs), owns_backing(take_ownership), ram_budget(budget), ram_used(0),
+          ram_alloc(alloc_fn ? alloc_fn : malloc), ram_free(free_fn ? free_fn : free) {
+        memset(entries, 0, sizeof(entries));
+        memset(hints, 0, sizeof(hints));
+    }
+
+    // Destructor: RAM files still present are discarded
+    ~TieredFileSystem() override {
+        for (int i = 0; i < TIERED_MAX_RAM_FILES; i++) {
+            if (entries[i].used) {
+                freeEntry(&entries[i]);
+            }
+        }
+        if (owns_backing && backing) {
+            delete backing;
+        }
+    }
+
+    IFileSystem* getBacking() const {
+        return backing;
+    }
+
+    // Find a live RAM file by name
+    TieredRamEntry* lookup(const char* filename) {
+        for (int i = 0; i < TIERED_MAX_RAM_FILES; i++) {
+            TieredRamEntry* e = &entries[i];
+            if (e->used && !e->unlinked && !e->spilled && strcmp(e->name, filename) == 0) {
+                return e;
+            }
+        }
+        return NULL;
+    }
+
+    // Grow a RAM file to hold at least min_capacity bytes
+    // Returns false if the budget or the allocator cannot provide the space
+    bool growEntry(TieredRamEntry* entry, size_t min_capacity) {
+        size_t new_capacity = entry->capacity * 2;
+        if (new_capacity < min_capacity) {
+            new_capacity = min_capacity;
+        }
+        // Prefer doubling, but settle for the exact size if doubling exceeds the budget
+        if (ram_used - entry->capacity + new_capacity > ram_budget) {
+            new_capacity = min_capacity;
+        }
+        if (ram_used - entry->capacity + new_capacity > ram_budget) {
+            return false;
+        }
+        uint8_t* new_data = (uint8_t*)ram_alloc(new_capacity);
+        if (!new_data) {
+            return false;
+        }
+        if (entry->data) {
+            memcpy(new_data, entry->data, entry->size);
+            ram_free(entry->data);
+        }
+        ram_used = ram_used - entry->capacity + new_capacity;
+        entry->data = new_data;
+        entry->capacity = new_capacity;
+        return true;
+    }
+
+    // Move a RAM file to the backing file system and release its RAM
+    bool spillEntry(TieredRamEntry* entry) {
+        backing->remove(entry->name);
+        IFile* out = backing->open(entry->name, FILE_WRITE);
+        if (!out) {
+            return false;
+        }
+        size_t written = out->write(entry->data, entry->size);
+        out->close();
+        delete out;
+        if (written != entry->size) {
+            backing->remove(entry->name);
+            return false;
+        }
+        ram_free(entry->data);
+        ram_used -= entry->capacity;
+        entry->data = NULL;
+        entry->capacity = 0;
+        entry->spilled = true;
+        return true;
+    }
+
+    // Drop one handle reference, freeing the entry once nothing refers to it
+    void releaseEntry(TieredRamEntry* entry) {
+        entry->refs--;
+        if (entry->refs <= 0 && (entry->unlinked || entry->spilled)) {
+            freeEntry(entry);
+        }
+    }
+
+    bool begin() override {
+        return backing ? backing->begin() : false;
+    }
+
+    IFile* open(const char* filename, int mode) override;
+
+    IFile* createPreallocated(const char* filename, size_t size) override;
+
+    bool remove(const char* filename) override {
+        if (!filename) {
+            return false;
+        }
+        TieredRamEntry* entry = lookup(filename);
+        if (entry) {
+            entry->unlinked = true;
+            if (entry->refs <= 0) {
+                freeEntry(entry);
+            }
+            return true;
+        }
+        return backing->remove(filename);
+    }
+
+    bool exists(const char* filename) override {
+        if (!filename) {
+            return false;
+        }
+        return lookup(filename) != NULL || backing->exists(filename);
+    }
+
+    void setSizeHint(const char* filename, size_t expected_size) override {
+        if (!filename || strlen(filename) >= TIERED_MAX_NAME) {
+            return;
+        }
+        int free_slot = -1;
+        for (int i = 0; i < TIERED_MAX_HINTS; i++) {
+            if (hints[i].used && strcmp(hints[i].name, filename) == 0) {
+                hints[i].size = expected_size;
+                return;
+            }
+            if (!hints[i].used && free_slot < 0) {
+                free_slot = i;
+            }
+        }
+        if (free_slot < 0) {
+            return;  // Table full: the file simply goes to the backing file system
+        }
+        hints[free_slot].used = true;
+        strcpy(hints[free_slot].name, filename);
+        hints[free_slot].size = expected_size;
+    }
+
+    // Create a RAM file for filename if the hint fits, NULL otherwise
+    TieredRamEntry* createEntry(const char* filename, size_t hint) {
+        if (hint == 0 || hint > ram_budget - ram_used || strlen(filename) >= TIERED_MAX_NAME) {
+            return NULL;
+        }
+        TieredRamEntry* entry = NULL;
+        for (int i = 0; i < TIERED_MAX_RAM_FILES; i++) {
+            if (!entries[i].used) {
+                entry = &entries[i];
+                break;
+            }
+        }
+        if (!entry) {
+            return NULL;
+        }
+        uint8_t* data = (uint8_t*)ram_alloc(hint);
+        if (!data) {
+            return NULL;
+        }
+        memset(entry, 0, sizeof(*entry));
+        entry->used = true;
+        strcpy(entry->name, filename);
+        entry->data = data;
+        entry->capacity = hint;
+        ram_used += hint;
+        return entry;
+    }
+};
+
+// Handle on a RAM file
+// After the entry is spilled, the handle reopens the file on the backing file
+// system at its current position and forwards every call there.
+class TieredRamFile : public IFile {
+private:
+    TieredFileSystem* fs;
+    TieredRamEntry* entry;
+    IFile* spill_handle;
+    bool writable;
+    size_t pos;
+
+    // Follow the entry to the backing file system if it was spilled
+    bool checkSpilled() {
+        if (spill_handle || !entry->spilled) {
+            return true;
+        }
+        spill_handle = fs->getBacking()->open(entry->name, writable ? FILE_WRITE : FILE_READ);
+        if (!spill_handle) {
+            return false;
+        }
+        return spill_handle->seek(pos);
+    }
+
+public:
+    TieredRamFile(TieredFileSystem* owner, TieredRamEntry* ram_entry, bool is_writable)
+        : fs(owner), entry(ram_entry), spill_handle(NULL), writable(is_writable), pos(0) {
+        entry->refs++;
+        if (writable) {
+            pos = entry->size;  // Arduino FILE_WRITE starts at the end of the file
+        }
+    }
+
+    // Destructor: closes file if still open
+    ~TieredRamFile() override {
+        if (entry) {
+            close();
+        }
+    }
+
+    size_t read(uint8_t* buffer, size_t size) override {
+        if (!entry || !buffer || !checkSpilled()) {
+            return 0;
+        }
+        if (spill_handle) {
+            return spill_handle->read(buffer, size);
+        }
+        if (pos >= entry->size) {
+            return 0;  // EOF
+        }
+        size_t n = entry->size - pos;
+        if (n > size) {
+            n = size;
+        }
+        memcpy(buffer, entry->data + pos, n);
+        pos += n;
+        return n;
+    }
+
+    size_t write(const uint8_t* data, size_t size) override {
+        if (!entry || !writable || !data || !checkSpilled()) {
+            return 0;
+        }
+        if (spill_handle) {
+            return spill_handle->write(data, size);
+        }
+        size_t end = pos + size;
+        if (end > entry->capacity && !fs->growEntry(entry, end)) {
+            // Out of RAM: move the file to the backing file system and continue there
+            if (!fs->spillEntry(entry) || !checkSpilled()) {
+                return 0;
+            }
+            return spill_handle->write(data, size);
+        }
+        if (pos > entry->size) {
+            memset(entry->data + entry->size, 0, pos - entry->size);  // Gap after seek past EOF
+        }
+        memcpy(entry->data + pos, data, size);
+        pos = end;
+        if (end > entry->size) {
+            entry->size = end;
+        }
+        return size;
+    }
+
+    bool seek(size_t position) override {
+        if (!entry || !checkSpilled()) {
+            return false;
+        }
+        if (spill_handle) {
+            return spill_handle->seek(position);
+        }
+        pos = position;
+        return true;
+    }
+
+    size_t position() override {
+        if (!entry) {
+            return 0;
+        }
+        return spill_handle ? spill_handle->position() : pos;
+    }
+
+    size_t size() override {
+        if (!entry || !checkSpilled()) {
+            return 0;
+        }
+        return spill_handle ? spill_handle->size() : entry->size;
+    }
+
+    bool flush() override {
+        if (!entry) {
+            return false;
+        }
+        return spill_handle ? spill_handle->flush() : true;
+    }
+
+    // Reserve space: RAM files grow within the budget (never spill for this)
+    bool reserve(size_t size) override {
+        if (!entry || !writable || !checkSpilled()) {
+            return false;
+        }
+        if (spill_handle) {
+            return spill_handle->reserve(size);
+        }
+        if (size <= entry->size) {
+            return true;
+        }
+        if (size > entry->capacity && !fs->growEntry(entry, size)) {
+            return false;
+        }
+        memset(entry->data + entry->size, 0, size - entry->size);
+        entry->size = size;
+        return true;
+    }
+
+    bool close() override {
+        if (!entry) {
+            return true;  // Already closed
+        }
+        bool ok = true;
+        if (spill_handle) {
+            ok = spill_handle->close();
+            delete spill_handle;
+            spill_handle = NULL;
+        }
+        fs->releaseEntry(entry);
+        entry = NULL;
+        return ok;
+    }
+
+    bool isOpen() const override {
+        return entry != NULL;
+    }
+
+    operator bool() const override {
+        return entry != NULL;
+    }
+};
+
+IFile* TieredFileSystem::open(const char* filename, int mode) {
+    if (!filename || !backing) {
+        return nullptr;
+    }
+    bool writable = (mode != FILE_READ);
+
+    TieredRamEntry* entry = lookup(filename);
+    if (!entry && writable) {
+        // New file: RAM tier only when a hint was given and the name is not already on the backing store
+        size_t hint = takeHint(filename);
+        if (hint > 0 && !backing->exists(filename)) {
+            entry = createEntry(filename, hint);
+        }
+    }
+    if (entry) {
+        return new TieredRamFile(this, entry, writable);
+    }
+    return backing->open(filename, mode);
+}
+
+// Preallocated files follow the same placement rule as hinted files: RAM if the
+// whole file fits the budget, otherwise the backing file system preallocates it
+IFile* TieredFileSystem::createPreallocated(const char* filename, size_t size) {
+    if (!filename || !backing) {
+        return nullptr;
+    }
+    remove(filename);
+    takeHint(filename);  // The size given here supersedes any pending hint
+
+    TieredRamEntry* entry = NULL;
+    if (!backing->exists(filename)) {
+        entry = createEntry(filename, size);
+    }
+    if (!entry) {
+        return backing->createPreallocated(filename, size);
+    }
+    memset(entry->data, 0, size);
+    entry->size = size;
+    IFile* file = new TieredRamFile(this, entry, true);
+    file->seek(0);
+    return file;
+}
+
+// Factory function to create a tiered file system
+IFileSystem* createTieredFileSystem(IFileSystem* backing, size_t ram_budget,
+                                    TieredRamAlloc ram_alloc, TieredRamFree ram_free,
+                                    bool take_ownership) {
+    if (!backing) {
+        return NULL;
+    }
+    return new TieredFileSystem(backing, ram_budget, ram_alloc, ram_free, take_ownership);
+}